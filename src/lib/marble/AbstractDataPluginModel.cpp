@@ -12,6 +12,8 @@
 #include "AbstractDataPluginModel.h"
 
 // Qt
+#include <QHash>
+#include <QSet>
 #include <QUrl>
 #include <QTimer>
 #include <QPointF>
@@ -19,6 +21,7 @@
 #include <QVariant>
 #include <QAbstractListModel>
 #include <QMetaProperty>
+#include <qmath.h>
 
 // Marble
 #include "MarbleDebug.h"
@@ -27,6 +30,7 @@
 #include "GeoDataCoordinates.h"
 #include "GeoDataLatLonAltBox.h"
 #include "HttpDownloadManager.h"
+#include "MarbleGlobal.h"
 #include "MarbleModel.h"
 #include "MarbleDirs.h"
 #include "ViewportParams.h"
@@ -50,6 +54,78 @@ const qreal boxComparisonFactor = 16.0;
 // Separator to separate the id of the item from the file type
 const char fileIdSeparator = '_';
 
+// Size of the cells of the geographic item index in degrees
+const int itemCellSize = 2;
+const int itemCellColumns = 360 / itemCellSize;
+const int itemCellRows = 180 / itemCellSize;
+
+// Distance in pixels by which items may lie outside of the viewport and still be visible.
+// The angular resolution of the viewport corresponds to four pixels.
+const qreal viewportMargin = 256.0;
+
+namespace
+{
+
+/**
+ * Screen areas covered by the items accepted so far, sorted into square cells
+ * so that new items are only tested against the items close to them.
+ */
+class CollisionGrid
+{
+public:
+    bool intersects( const QList<QRectF> &rects ) const;
+    void insert( const QList<QRectF> &rects );
+
+private:
+    static quint64 key( int column, int row );
+
+    static const int cellSize = 64;
+    QHash<quint64, QVector<QRectF> > m_cells;
+};
+
+bool CollisionGrid::intersects( const QList<QRectF> &rects ) const
+{
+    foreach( const QRectF &rect, rects ) {
+        int const right = qFloor( rect.right() / cellSize );
+        int const bottom = qFloor( rect.bottom() / cellSize );
+        for ( int column = qFloor( rect.left() / cellSize ); column <= right; ++column ) {
+            for ( int row = qFloor( rect.top() / cellSize ); row <= bottom; ++row ) {
+                QHash<quint64, QVector<QRectF> >::const_iterator cell = m_cells.constFind( key( column, row ) );
+                if ( cell == m_cells.constEnd() ) {
+                    continue;
+                }
+                foreach( const QRectF &other, cell.value() ) {
+                    if ( other.intersects( rect ) ) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void CollisionGrid::insert( const QList<QRectF> &rects )
+{
+    foreach( const QRectF &rect, rects ) {
+        int const right = qFloor( rect.right() / cellSize );
+        int const bottom = qFloor( rect.bottom() / cellSize );
+        for ( int column = qFloor( rect.left() / cellSize ); column <= right; ++column ) {
+            for ( int row = qFloor( rect.top() / cellSize ); row <= bottom; ++row ) {
+                m_cells[key( column, row )].append( rect );
+            }
+        }
+    }
+}
+
+quint64 CollisionGrid::key( int column, int row )
+{
+    return ( quint64( quint32( column ) ) << 32 ) | quint32( row );
+}
+
+}
+
 class FavoritesModel;
 
 class AbstractDataPluginModelPrivate
@@ -66,6 +142,17 @@ public:
 
     void updateFavoriteItems();
 
+    /**
+     * Rebuilds the geographic index of m_itemSet if items were added, removed,
+     * reordered or updated since it was built last.
+     */
+    void updateItemCells();
+
+    /**
+     * Returns the items within @p box extended by @p margin degrees, in the order of m_itemSet.
+     */
+    QList<AbstractDataPluginItem*> itemsInBox( const GeoDataLatLonBox &box, qreal margin );
+
     AbstractDataPluginModel *m_parent;
     const QString m_name;
     const MarbleModel *const m_marbleModel;
@@ -75,6 +162,10 @@ public:
     qint32 m_downloadedNumber;
     QString m_currentPlanetId;
     QList<AbstractDataPluginItem*> m_itemSet;
+    QHash<QString, AbstractDataPluginItem*> m_itemIds;
+    // indexes into m_itemSet by cell of itemCellSize degrees
+    QHash<int, QVector<int> > m_itemCells;
+    bool m_itemCellsDirty;
     QHash<QString, AbstractDataPluginItem*> m_downloadingItems;
     QList<AbstractDataPluginItem*> m_displayedItems;
     QTimer m_downloadTimer;
@@ -123,6 +214,7 @@ AbstractDataPluginModelPrivate::AbstractDataPluginModelPrivate( const QString& n
       m_lastNumber( 0 ),
       m_downloadedNumber( 0 ),
       m_currentPlanetId( marbleModel->planetId() ),
+      m_itemCellsDirty( false ),
       m_downloadTimer( m_parent ),
       m_descriptionFileNumber( 0 ),
       m_itemSettings(),
@@ -162,6 +254,98 @@ void AbstractDataPluginModelPrivate::updateFavoriteItems()
     }
 }
 
+static int itemCellColumn( qreal lon )
+{
+    return qBound( 0, qFloor( ( lon + 180.0 ) / itemCellSize ), itemCellColumns - 1 );
+}
+
+static int itemCellRow( qreal lat )
+{
+    return qBound( 0, qFloor( ( lat + 90.0 ) / itemCellSize ), itemCellRows - 1 );
+}
+
+void AbstractDataPluginModelPrivate::updateItemCells()
+{
+    if ( !m_itemCellsDirty ) {
+        return;
+    }
+
+    m_itemCells.clear();
+    for ( int i = 0; i < m_itemSet.size(); ++i ) {
+        GeoDataCoordinates const coordinate = m_itemSet.at( i )->coordinate();
+        int const column = itemCellColumn( coordinate.longitude( GeoDataCoordinates::Degree ) );
+        int const row = itemCellRow( coordinate.latitude( GeoDataCoordinates::Degree ) );
+        m_itemCells[row * itemCellColumns + column].append( i );
+    }
+
+    m_itemCellsDirty = false;
+}
+
+QList<AbstractDataPluginItem*> AbstractDataPluginModelPrivate::itemsInBox( const GeoDataLatLonBox &box,
+                                                                           qreal margin )
+{
+    if ( box.isEmpty() ) {
+        return m_itemSet;
+    }
+
+    updateItemCells();
+
+    qreal const north = qMin<qreal>( box.north( GeoDataCoordinates::Degree ) + margin, 90.0 );
+    qreal const south = qMax<qreal>( box.south( GeoDataCoordinates::Degree ) - margin, -90.0 );
+    int const firstRow = itemCellRow( south );
+    int const lastRow = itemCellRow( north );
+
+    // Meridians converge towards the poles, so the margin spans more degrees of longitude there
+    qreal const maxLatitude = qMax( qAbs( north ), qAbs( south ) );
+    qreal const lonMargin = maxLatitude < 89.0 ? margin / cos( maxLatitude * DEG2RAD ) : 360.0;
+
+    int firstColumn = 0;
+    int lastColumn = itemCellColumns - 1;
+    if ( !box.containsPole() && box.width( GeoDataCoordinates::Degree ) + 2 * lonMargin < 360.0 ) {
+        qreal const west = GeoDataCoordinates::normalizeLon( box.west( GeoDataCoordinates::Degree ) - lonMargin,
+                                                             GeoDataCoordinates::Degree );
+        qreal const east = GeoDataCoordinates::normalizeLon( box.east( GeoDataCoordinates::Degree ) + lonMargin,
+                                                             GeoDataCoordinates::Degree );
+        firstColumn = itemCellColumn( west );
+        lastColumn = itemCellColumn( east );
+    }
+    // Columns wrap around at the date line
+    int const columns = ( lastColumn - firstColumn + itemCellColumns ) % itemCellColumns + 1;
+
+    QVector<int> indexes;
+    if ( columns * ( lastRow - firstRow + 1 ) > m_itemCells.size() ) {
+        // Fewer occupied cells than cells in the box, so test each of them instead
+        QHash<int, QVector<int> >::const_iterator cell = m_itemCells.constBegin();
+        QHash<int, QVector<int> >::const_iterator const end = m_itemCells.constEnd();
+        for (; cell != end; ++cell ) {
+            int const row = cell.key() / itemCellColumns;
+            int const column = cell.key() % itemCellColumns;
+            if ( row >= firstRow && row <= lastRow
+                 && ( column - firstColumn + itemCellColumns ) % itemCellColumns < columns ) {
+                indexes += cell.value();
+            }
+        }
+    }
+    else {
+        for ( int row = firstRow; row <= lastRow; ++row ) {
+            for ( int i = 0; i < columns; ++i ) {
+                int const column = ( firstColumn + i ) % itemCellColumns;
+                indexes += m_itemCells.value( row * itemCellColumns + column );
+            }
+        }
+    }
+
+    qSort( indexes );
+
+    QList<AbstractDataPluginItem*> result;
+    result.reserve( indexes.size() );
+    foreach( int index, indexes ) {
+        result.append( m_itemSet.at( index ) );
+    }
+
+    return result;
+}
+
 void AbstractDataPluginModel::themeChanged()
 {
     if ( d->m_currentPlanetId != d->m_marbleModel->planetId() ) {
@@ -295,20 +479,36 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
     Q_ASSERT( !d->m_displayedItems.contains( 0 ) && "Null item in m_displayedItems. Please report a bug to marble-devel@kde.org" );
     Q_ASSERT( !d->m_itemSet.contains( 0 ) && "Null item in m_itemSet. Please report a bug to marble-devel@kde.org" );
 
-    QList<AbstractDataPluginItem*> candidates = d->m_displayedItems + d->m_itemSet;
+    if ( d->m_needsSorting ) {
+        qSort( d->m_itemSet.begin(), d->m_itemSet.end(), lessThanByPointer );
+        d->m_itemCellsDirty = true;
+    }
+
+    // Only items near the viewport can be visible
+    qreal const margin = viewportMargin / 4 * viewport->angularResolution() * RAD2DEG;
+    QList<AbstractDataPluginItem*> candidates = d->m_displayedItems + d->itemsInBox( currentBox, margin );
 
     if ( d->m_needsSorting ) {
-        // Both the candidates list and the list of all items need to be sorted
+        // The candidates list needs to be sorted as well
         qSort( candidates.begin(), candidates.end(), lessThanByPointer );
-        qSort( d->m_itemSet.begin(), d->m_itemSet.end(), lessThanByPointer );
         d->m_needsSorting =  false;
     }
 
+    QSet<AbstractDataPluginItem*> const displayedItems = d->m_displayedItems.toSet();
+    QSet<AbstractDataPluginItem*> visitedItems;
+    CollisionGrid collisionGrid;
+
     QList<AbstractDataPluginItem*>::const_iterator i = candidates.constBegin();
     QList<AbstractDataPluginItem*>::const_iterator end = candidates.constEnd();
 
     // Items that are already shown have the highest priority
     for (; i != end && list.size() < number; ++i ) {
+        // Displayed items are candidates twice, but the outcome stays the same
+        if ( visitedItems.contains( *i ) ) {
+            continue;
+        }
+        visitedItems.insert( *i );
+
         // Only show items that are initialized
         if( !(*i)->initialized() ) {
             continue;
@@ -324,26 +524,13 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
             continue;
         }
 
-        if ( list.contains( *i ) ) {
-            continue;
-        }
-
         // If the item was added initially at a nearer position, they don't have priority,
         // because we zoomed out since then.
-        bool const alreadyDisplayed = d->m_displayedItems.contains( *i );
+        bool const alreadyDisplayed = displayedItems.contains( *i );
         if ( !alreadyDisplayed || (*i)->addedAngularResolution() >= viewport->angularResolution() || (*i)->isSticky() ) {
-            bool collides = false;
-            int const length = list.length();
-            for ( int j=0; !collides && j<length; ++j ) {
-                foreach( const QRectF &rect, list[j]->boundingRects() ) {
-                    foreach( const QRectF &itemRect, (*i)->boundingRects() ) {
-                        if ( rect.intersects( itemRect ) )
-                            collides = true;
-                    }
-                }
-            }
-
-            if ( !collides ) {
+            QList<QRectF> const rects = (*i)->boundingRects();
+            if ( !collisionGrid.intersects( rects ) ) {
+                collisionGrid.insert( rects );
                 list.append( *i );
                 (*i)->setSettings( d->m_itemSettings );
 
@@ -428,11 +615,12 @@ void AbstractDataPluginModel::addItemsToList( const QList<AbstractDataPluginItem
         }
 
         // If the item is already in our list, don't add it.
-        if ( d->m_itemSet.contains( item ) ) {
+        AbstractDataPluginItem *const existing = d->m_itemIds.value( item->id() );
+        if ( existing == item ) {
             continue;
         }
 
-        if( itemExists( item->id() ) ) {
+        if( existing ) {
             item->deleteLater();
             continue;
         }
@@ -446,9 +634,13 @@ void AbstractDataPluginModel::addItemsToList( const QList<AbstractDataPluginItem
                                                                   lessThanByPointer );
         // Insert the item on the right position in the list
         d->m_itemSet.insert( i, item );
+        d->m_itemIds.insert( item->id(), item );
+        d->m_itemCellsDirty = true;
 
         connect( item, SIGNAL(stickyChanged()), this, SLOT(scheduleItemSort()) );
         connect( item, SIGNAL(destroyed(QObject*)), this, SLOT(removeItem(QObject*)) );
+        // Items may have moved when they get updated
+        connect( item, SIGNAL(updated()), this, SLOT(scheduleItemIndexUpdate()) );
         connect( item, SIGNAL(updated()), this, SIGNAL(itemsUpdated()) );
         connect( item, SIGNAL(favoriteChanged(QString,bool)), this,
                  SLOT(favoriteItemChanged(QString,bool)) );
@@ -537,6 +729,11 @@ void AbstractDataPluginModel::scheduleItemSort()
     d->m_needsSorting = true;
 }
 
+void AbstractDataPluginModel::scheduleItemIndexUpdate()
+{
+    d->m_itemCellsDirty = true;
+}
+
 QString AbstractDataPluginModelPrivate::generateFilename( const QString& id, const QString& type ) const
 {
     QString name;
@@ -554,13 +751,7 @@ QString AbstractDataPluginModelPrivate::generateFilepath( const QString& id, con
 
 AbstractDataPluginItem *AbstractDataPluginModel::findItem( const QString& id ) const
 {
-    foreach ( AbstractDataPluginItem *item, d->m_itemSet ) {
-        if( item->id() == id ) {
-            return item;
-        }
-    }
-    
-    return 0;
+    return d->m_itemIds.value( id );
 }
 
 bool AbstractDataPluginModel::itemExists( const QString& id ) const
@@ -651,12 +842,28 @@ void AbstractDataPluginModel::processFinishedJob( const QString& relativeUrlStri
 
 void AbstractDataPluginModel::removeItem( QObject *item )
 {
-    AbstractDataPluginItem * pluginItem = qobject_cast<AbstractDataPluginItem*>( item );
-    d->m_itemSet.removeAll( pluginItem );
-    QHash<QString, AbstractDataPluginItem *>::iterator i;
-    for( i = d->m_downloadingItems.begin(); i != d->m_downloadingItems.end(); ++i ) {
+    // The item is being destroyed already, so qobject_cast() would fail and only its address is of use
+    AbstractDataPluginItem * pluginItem = static_cast<AbstractDataPluginItem*>( item );
+    if ( d->m_itemSet.removeAll( pluginItem ) > 0 ) {
+        d->m_itemCellsDirty = true;
+    }
+    d->m_displayedItems.removeAll( pluginItem );
+
+    QHash<QString, AbstractDataPluginItem *>::iterator i = d->m_itemIds.begin();
+    while ( i != d->m_itemIds.end() ) {
+        if( *i == pluginItem ) {
+            i = d->m_itemIds.erase( i );
+        } else {
+            ++i;
+        }
+    }
+
+    i = d->m_downloadingItems.begin();
+    while ( i != d->m_downloadingItems.end() ) {
         if( *i == pluginItem ) {
             i = d->m_downloadingItems.erase( i );
+        } else {
+            ++i;
         }
     }
 }
@@ -670,6 +877,9 @@ void AbstractDataPluginModel::clear()
         (*iter)->deleteLater();
     }
     d->m_itemSet.clear();
+    d->m_itemIds.clear();
+    d->m_itemCells.clear();
+    d->m_itemCellsDirty = false;
     d->m_lastBox = GeoDataLatLonAltBox();
     d->m_downloadedBox = GeoDataLatLonAltBox();
     d->m_downloadedNumber = 0;
@@ -182,6 +182,8 @@ public Q_SLOTS:
 
     void scheduleItemSort();
 
+    void scheduleItemIndexUpdate();
+
     void themeChanged();
 
  Q_SIGNALS:
@@ -0,0 +1,229 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "DocumentSnapshot.h"
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTimeSpan.h"
+#include "GeoDataTimeStamp.h"
+#include "GeoDataTypes.h"
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+
+using namespace Marble;
+
+static const char MAGIC[] = "MRBLDOCS";
+static const int MAGIC_SIZE = 8;
+// increase whenever the pack() methods of the GeoData classes change
+static const quint32 VERSION = 1;
+
+DocumentSnapshot::DocumentSnapshot( const QString &sourceFileName, const QString &directory )
+    : m_sourceSize( -1 )
+{
+    const QFileInfo sourceInfo( sourceFileName );
+    m_sourceFileName = sourceInfo.absoluteFilePath();
+    if ( sourceInfo.exists() ) {
+        m_sourceSize = sourceInfo.size();
+        m_sourceModified = sourceInfo.lastModified();
+    }
+
+    const QString path = directory.isEmpty() ? MarbleDirs::localPath() + "/cache/documents/" : directory + '/';
+    const QByteArray hash = QCryptographicHash::hash( m_sourceFileName.toUtf8(), QCryptographicHash::Md5 );
+    m_fileName = path + QString::fromLatin1( hash.toHex() ) + ".snapshot";
+}
+
+QString DocumentSnapshot::fileName() const
+{
+    return m_fileName;
+}
+
+static bool readHeader( QDataStream &stream, const QString &sourceFileName, qint64 sourceSize,
+                        const QDateTime &sourceModified )
+{
+    char magic[MAGIC_SIZE];
+    if ( stream.readRawData( magic, MAGIC_SIZE ) != MAGIC_SIZE || qstrncmp( magic, MAGIC, MAGIC_SIZE ) != 0 ) {
+        return false;
+    }
+
+    quint32 version;
+    QString path;
+    qint64 size;
+    QDateTime modified;
+    stream >> version;
+    if ( stream.status() != QDataStream::Ok || version != VERSION ) {
+        return false;
+    }
+
+    stream >> path >> size >> modified;
+
+    return stream.status() == QDataStream::Ok
+           && path == sourceFileName
+           && size == sourceSize
+           && modified == sourceModified;
+}
+
+bool DocumentSnapshot::isCurrent() const
+{
+    if ( m_sourceSize < 0 ) {
+        return false;
+    }
+
+    QFile file( m_fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_7 );
+
+    return readHeader( stream, m_sourceFileName, m_sourceSize, m_sourceModified );
+}
+
+GeoDataDocument *DocumentSnapshot::load() const
+{
+    if ( m_sourceSize < 0 ) {
+        return 0;
+    }
+
+    QFile file( m_fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return 0;
+    }
+
+    const qint64 size = file.size();
+    uchar *const data = file.map( 0, size );
+    if ( !data ) {
+        mDebug() << "Cannot map document snapshot" << m_fileName << file.errorString();
+        return 0;
+    }
+
+    GeoDataDocument *document = 0;
+    {
+        // the array must not outlive the mapping
+        const QByteArray bytes = QByteArray::fromRawData( reinterpret_cast<const char *>( data ), size );
+        QDataStream stream( bytes );
+        stream.setVersion( QDataStream::Qt_4_7 );
+
+        if ( readHeader( stream, m_sourceFileName, m_sourceSize, m_sourceModified ) ) {
+            document = new GeoDataDocument;
+            document->unpack( stream );
+            if ( stream.status() != QDataStream::Ok ) {
+                mDebug() << "Invalid document snapshot" << m_fileName;
+                delete document;
+                document = 0;
+            }
+        }
+    }
+
+    file.unmap( data );
+
+    if ( document ) {
+        document->setFileName( m_sourceFileName );
+    }
+
+    return document;
+}
+
+bool DocumentSnapshot::save( const GeoDataDocument &document ) const
+{
+    if ( m_sourceSize < 0 || !isSupported( document ) ) {
+        return false;
+    }
+
+    const QFileInfo info( m_fileName );
+    if ( !QDir().mkpath( info.absolutePath() ) ) {
+        return false;
+    }
+
+    // write to a temporary file first so that readers never see a partial snapshot
+    const QString partFileName = m_fileName + ".part";
+    QFile file( partFileName );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        mDebug() << "Cannot create document snapshot" << partFileName << file.errorString();
+        return false;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_7 );
+    stream.writeRawData( MAGIC, MAGIC_SIZE );
+    stream << VERSION << m_sourceFileName << m_sourceSize << m_sourceModified;
+    document.pack( stream );
+    file.close();
+
+    if ( stream.status() != QDataStream::Ok || file.error() != QFile::NoError ) {
+        mDebug() << "Cannot write document snapshot" << partFileName;
+        QFile::remove( partFileName );
+        return false;
+    }
+
+    QFile::remove( m_fileName );
+    return QFile::rename( partFileName, m_fileName );
+}
+
+bool DocumentSnapshot::isSupported( const GeoDataDocument &document )
+{
+    return isSupported( static_cast<const GeoDataContainer *>( &document ) );
+}
+
+bool DocumentSnapshot::isSupported( const GeoDataContainer *container )
+{
+    foreach ( const GeoDataFeature *feature, container->featureList() ) {
+        if ( feature->abstractView()
+             || feature->timeSpan().isValid()
+             || feature->timeStamp().when().isValid()
+             || !feature->extendedData().schemaDataList().isEmpty() ) {
+            return false;
+        }
+
+        if ( feature->nodeType() == GeoDataTypes::GeoDataDocumentType
+             || feature->nodeType() == GeoDataTypes::GeoDataFolderType ) {
+            if ( !isSupported( static_cast<const GeoDataContainer *>( feature ) ) ) {
+                return false;
+            }
+        } else if ( feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+            const GeoDataGeometry *geometry = static_cast<const GeoDataPlacemark *>( feature )->geometry();
+            if ( geometry && !isSupported( geometry ) ) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DocumentSnapshot::isSupported( const GeoDataGeometry *geometry )
+{
+    if ( geometry->nodeType() == GeoDataTypes::GeoDataMultiGeometryType ) {
+        const GeoDataMultiGeometry *multiGeometry = static_cast<const GeoDataMultiGeometry *>( geometry );
+        for ( int i = 0; i < multiGeometry->size(); ++i ) {
+            if ( !isSupported( multiGeometry->child( i ) ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    return geometry->nodeType() == GeoDataTypes::GeoDataPointType
+           || geometry->nodeType() == GeoDataTypes::GeoDataLineStringType
+           || geometry->nodeType() == GeoDataTypes::GeoDataLinearRingType
+           || geometry->nodeType() == GeoDataTypes::GeoDataPolygonType;
+}
@@ -0,0 +1,105 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_DOCUMENTSNAPSHOT_H
+#define MARBLE_DOCUMENTSNAPSHOT_H
+
+#include <QDateTime>
+#include <QString>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class GeoDataContainer;
+class GeoDataDocument;
+class GeoDataGeometry;
+
+/**
+ * @short Binary snapshot of a document parsed from a file.
+ *
+ * Parsing large KML or OSM files dominates the time needed to load them.
+ * After a file got parsed, its document is stored in binary form using
+ * GeoDataDocument::pack(). The next time the file is opened, the snapshot
+ * is memory mapped and unpacked instead of running the parser again.
+ *
+ * Snapshots are named after the path of the source file and remember its
+ * size and modification time. A snapshot is only used as long as these
+ * still match the source file.
+ *
+ * File layout (QDataStream, Qt 4.7 format):
+ * @code
+ * header:   "MRBLDOCS" version(quint32) sourcePath(QString) sourceSize(qint64) sourceModified(QDateTime)
+ * document: GeoDataDocument::pack()
+ * @endcode
+ */
+class MARBLE_EXPORT DocumentSnapshot
+{
+ public:
+    /**
+     * @brief Refers to the snapshot of @p sourceFileName.
+     *
+     * Remembers the current size and modification time of the source file,
+     * which save() stores in the snapshot. Create the snapshot before parsing
+     * the source file, so that changes during parsing invalidate it.
+     * @param directory where snapshots are stored, defaults to cache/documents/
+     *        in the local Marble directory
+     */
+    explicit DocumentSnapshot( const QString &sourceFileName, const QString &directory = QString() );
+
+    /**
+     * @brief The file name of the snapshot itself.
+     */
+    QString fileName() const;
+
+    /**
+     * @brief Returns whether a snapshot exists that matches the source file.
+     */
+    bool isCurrent() const;
+
+    /**
+     * @brief Restores the document from the snapshot.
+     * @return the document, which the caller takes ownership of, or 0 if
+     *         there is no current snapshot
+     */
+    GeoDataDocument *load() const;
+
+    /**
+     * @brief Stores @p document, replacing an older snapshot.
+     *
+     * Documents which isSupported() rejects are not stored.
+     * @return false if nothing was stored
+     */
+    bool save( const GeoDataDocument &document ) const;
+
+    /**
+     * @brief Returns whether @p document survives a round trip through
+     * GeoDataDocument::pack() and unpack().
+     *
+     * Only documents, folders and placemarks with points, line strings,
+     * polygons and multi geometries are supported, without views, time
+     * primitives or schema data.
+     */
+    static bool isSupported( const GeoDataDocument &document );
+
+ private:
+    static bool isSupported( const GeoDataContainer *container );
+    static bool isSupported( const GeoDataGeometry *geometry );
+
+    QString m_sourceFileName;
+    qint64 m_sourceSize;
+    QDateTime m_sourceModified;
+    QString m_fileName;
+};
+
+}
+
+#endif
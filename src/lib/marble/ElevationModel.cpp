@@ -16,6 +16,7 @@
 #include "GeoSceneTextureTile.h"
 #include "HttpDownloadManager.h"
 #include "Tile.h"
+#include "TileArchive.h"
 #include "TileLoader.h"
 #include "TileLoaderHelper.h"
 #include "MarbleDebug.h"
@@ -28,15 +29,27 @@
 namespace Marble
 {
 
+/**
+ * Heights of one SRTM tile, two bytes per sample instead of the four bytes
+ * of a decoded QImage.
+ */
+typedef QVector<quint16> ElevationTile;
+
 class ElevationModelPrivate
 {
 public:
     ElevationModelPrivate( ElevationModel *_q, HttpDownloadManager *downloadManager )
         : q( _q ),
           m_tileLoader( downloadManager, 0 ),
-          m_textureLayer( 0 )
+          m_textureLayer( 0 ),
+          m_tileZoomLevel( 0 ),
+          m_tileWidth( 0 ),
+          m_tileHeight( 0 ),
+          m_numTilesX( 0 ),
+          m_numTilesY( 0 ),
+          m_lastTile( 0 )
     {
-        m_cache.setMaxCost( 10 ); //keep 10 tiles in memory (~17MB)
+        m_cache.setMaxCost( 32 * 1024 ); // in kilobytes, about 40 tiles
 
         const GeoSceneDocument *srtmTheme = MapThemeManager::loadMapTheme( "earth/srtm2/srtm2.dgml" );
         if ( !srtmTheme ) {
@@ -54,54 +67,102 @@ public:
         Q_ASSERT( sceneLayer );
 
         m_textureLayer = dynamic_cast<GeoSceneTextureTile*>( sceneLayer->datasets().first() );
-        Q_ASSERT( m_textureLayer );
+        if ( !m_textureLayer ) {
+            mDebug() << "Map theme earth/srtm2/srtm2.dgml has no texture layer. No elevation will be returned.";
+            return;
+        }
+
+        m_archive = TileLoader::openTileArchive( m_textureLayer );
+
+        m_tileZoomLevel = TileLoader::maximumTileLevel( *m_textureLayer, m_archive.data() );
+        Q_ASSERT( m_tileZoomLevel == 9 );
+
+        m_tileWidth = m_textureLayer->tileSize().width();
+        m_tileHeight = m_textureLayer->tileSize().height();
+
+        m_numTilesX = TileLoaderHelper::levelToColumn( m_textureLayer->levelZeroColumns(), m_tileZoomLevel );
+        m_numTilesY = TileLoaderHelper::levelToRow( m_textureLayer->levelZeroRows(), m_tileZoomLevel );
+        Q_ASSERT( m_numTilesX > 0 );
+        Q_ASSERT( m_numTilesY > 0 );
     }
 
     void tileCompleted( const TileId & tileId, const QImage &image )
     {
-        m_cache.insert( tileId, new QImage( image ) );
+        insert( tileId, image );
         emit q->updateAvailable();
     }
 
+    const ElevationTile *tile( const TileId &tileId );
+    void insert( const TileId &tileId, const QImage &image );
+
+    qreal height( qreal lon, qreal lat );
+    void heights( const QVector<GeoDataCoordinates> &coordinates, QVector<qreal> &result );
+
 public:
     ElevationModel *q;
 
     TileLoader m_tileLoader;
     const GeoSceneTextureTile *m_textureLayer;
-    QCache<TileId, const QImage> m_cache;
+    QSharedPointer<const TileArchive> m_archive;
+    int m_tileZoomLevel;
+    int m_tileWidth;
+    int m_tileHeight;
+    int m_numTilesX;
+    int m_numTilesY;
+
+    // cost is the size of a tile in kilobytes
+    QCache<TileId, const ElevationTile> m_cache;
+
+    // consecutive lookups mostly hit the same tile
+    TileId m_lastTileId;
+    const ElevationTile *m_lastTile;
 };
 
-ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, QObject *parent ) :
-    QObject( parent ),
-    d( new ElevationModelPrivate( this, downloadManager ) )
+const ElevationTile *ElevationModelPrivate::tile( const TileId &tileId )
 {
-    connect( &d->m_tileLoader, SIGNAL(tileCompleted(TileId,QImage)),
-             this, SLOT(tileCompleted(TileId,QImage)) );
-}
-
+    if ( m_lastTile && tileId == m_lastTileId ) {
+        return m_lastTile;
+    }
 
-qreal ElevationModel::height( qreal lon, qreal lat ) const
-{
-    if ( !d->m_textureLayer ) {
-        return invalidElevationData;
+    if ( !m_cache.contains( tileId ) ) {
+        insert( tileId, m_tileLoader.loadTileImage( m_textureLayer, m_archive.data(), tileId, DownloadBrowse ) );
     }
 
-    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
-    Q_ASSERT( tileZoomLevel == 9 );
+    m_lastTileId = tileId;
+    m_lastTile = m_cache.object( tileId );
 
-    const int width = d->m_textureLayer->tileSize().width();
-    const int height = d->m_textureLayer->tileSize().height();
+    return m_lastTile;
+}
+
+void ElevationModelPrivate::insert( const TileId &tileId, const QImage &image )
+{
+    Q_ASSERT( !image.isNull() );
+    Q_ASSERT( m_tileWidth == image.width() );
+    Q_ASSERT( m_tileHeight == image.height() );
+
+    // heights are stored in the lower bytes of opaque pixels
+    const QImage rgb = image.convertToFormat( QImage::Format_RGB32 );
+    ElevationTile *const tile = new ElevationTile( m_tileWidth * m_tileHeight );
+    quint16 *sample = tile->data();
+    for ( int y = 0; y < m_tileHeight; ++y ) {
+        const QRgb *line = reinterpret_cast<const QRgb *>( rgb.constScanLine( y ) );
+        for ( int x = 0; x < m_tileWidth; ++x ) {
+            *sample++ = quint16( line[x] - 0xFF000000 );
+        }
+    }
 
-    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
-    const int numTilesY = TileLoaderHelper::levelToRow( d->m_textureLayer->levelZeroRows(), tileZoomLevel );
-    Q_ASSERT( numTilesX > 0 );
-    Q_ASSERT( numTilesY > 0 );
+    // inserting may drop the last tile
+    m_lastTile = 0;
+    m_cache.insert( tileId, tile, qMax( 1, tile->size() * int( sizeof( quint16 ) ) / 1024 ) );
+}
 
+qreal ElevationModelPrivate::height( qreal lon, qreal lat )
+{
     qreal textureX = 180 + lon;
-    textureX *= numTilesX * width / 360;
+    textureX *= m_numTilesX * m_tileWidth / 360;
 
     qreal textureY = 90 - lat;
-    textureY *= numTilesY * height / 180;
+    textureY *= m_numTilesY * m_tileHeight / 180;
 
     qreal ret = 0;
     bool hasHeight = false;
@@ -111,37 +172,21 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
         const int x = static_cast<int>( textureX + ( i % 2 ) );
         const int y = static_cast<int>( textureY + ( i / 2 ) );
 
-        //mDebug() << "x" << x << ( x / width );
-        //mDebug() << "y" << y << ( y / height );
+        const TileId id( 0, m_tileZoomLevel, ( x % ( m_numTilesX * m_tileWidth ) ) / m_tileWidth, ( y % ( m_numTilesY * m_tileHeight ) ) / m_tileHeight );
 
-        const TileId id( 0, tileZoomLevel, ( x % ( numTilesX * width ) ) / width, ( y % ( numTilesY * height ) ) / height );
-        //mDebug() << "LAT" << lat << "LON" << lon << "tile" << ( x % ( numTilesX * width ) ) / width << ( y % ( numTilesY * height ) ) / height;
-
-        const QImage *image = d->m_cache[id];
-        if ( image == 0 ) {
-            image = new QImage( d->m_tileLoader.loadTileImage( d->m_textureLayer, id, DownloadBrowse ) );
-            d->m_cache.insert( id, image );
-        }
-        Q_ASSERT( image );
-        Q_ASSERT( !image->isNull() );
-        Q_ASSERT( width == image->width() );
-        Q_ASSERT( height == image->height() );
+        const ElevationTile *const samples = tile( id );
+        Q_ASSERT( samples );
 
         const qreal dx = ( textureX > ( qreal )x ) ? textureX - ( qreal )x : ( qreal )x - textureX;
         const qreal dy = ( textureY > ( qreal )y ) ? textureY - ( qreal )y : ( qreal )y - textureY;
 
         Q_ASSERT( 0 <= dx && dx <= 1 );
         Q_ASSERT( 0 <= dy && dy <= 1 );
-        unsigned int pixel;
-        pixel = image->pixel( x % width, y % height );
-        pixel -= 0xFF000000; //fully opaque
-        //mDebug() << "(1-dx)" << (1-dx) << "(1-dy)" << (1-dy);
-        if ( pixel != invalidElevationData ) { //no data?
-            //mDebug() << "got at x" << x % width << "y" << y % height << "a height of" << pixel << "** RGB" << qRed(pixel) << qGreen(pixel) << qBlue(pixel);
-            ret += ( qreal )pixel * ( 1 - dx ) * ( 1 - dy );
+        const unsigned int sample = samples->at( ( y % m_tileHeight ) * m_tileWidth + x % m_tileWidth );
+        if ( sample != invalidElevationData ) { //no data?
+            ret += ( qreal )sample * ( 1 - dx ) * ( 1 - dy );
             hasHeight = true;
         } else {
-            //mDebug() << "no data at" <<  x % width << "y" << y % height;
             noData += ( 1 - dx ) * ( 1 - dy );
         }
     }
@@ -150,26 +195,118 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
         ret = invalidElevationData; //no data
     } else {
         if ( noData ) {
-            //mDebug() << "NO DATA" << noData;
             ret += ( ret / ( 1 - noData ) ) * noData;
         }
     }
 
-    //mDebug() << ">>>" << lat << lon << "returning an elevation of" << ret;
     return ret;
 }
 
+void ElevationModelPrivate::heights( const QVector<GeoDataCoordinates> &coordinates, QVector<qreal> &result )
+{
+    // same scaling as in height()
+    const qreal scaleX = m_numTilesX * m_tileWidth / 360;
+    const qreal scaleY = m_numTilesY * m_tileHeight / 180;
+
+    // the tile of the previous sample, resolved once for a run of samples
+    int tileX = -1;
+    int tileY = -1;
+    const quint16 *samples = 0;
+
+    for ( int i = 0; i < coordinates.size(); ++i ) {
+        const qreal textureX = ( 180 + coordinates[i].longitude( GeoDataCoordinates::Degree ) ) * scaleX;
+        const qreal textureY = ( 90 - coordinates[i].latitude( GeoDataCoordinates::Degree ) ) * scaleY;
+
+        const int x = static_cast<int>( textureX );
+        const int y = static_cast<int>( textureY );
+        const int column = x % m_tileWidth;
+        const int row = y % m_tileHeight;
+
+        // The four samples around the position span several tiles at their
+        // borders, leave that to height().
+        if ( x < 0 || y < 0 || column + 1 >= m_tileWidth || row + 1 >= m_tileHeight ) {
+            result[i] = height( coordinates[i].longitude( GeoDataCoordinates::Degree ),
+                                coordinates[i].latitude( GeoDataCoordinates::Degree ) );
+            // height() may have dropped the tile from the cache
+            samples = 0;
+            continue;
+        }
+
+        if ( !samples || x / m_tileWidth != tileX || y / m_tileHeight != tileY ) {
+            tileX = x / m_tileWidth;
+            tileY = y / m_tileHeight;
+            const TileId id( 0, m_tileZoomLevel, tileX % m_numTilesX, tileY % m_numTilesY );
+            const ElevationTile *const elevationTile = tile( id );
+            Q_ASSERT( elevationTile );
+            samples = elevationTile->constData();
+        }
+
+        const qreal dx = textureX - x;
+        const qreal dy = textureY - y;
+        const qreal weights[4] = { ( 1 - dx ) * ( 1 - dy ), dx * ( 1 - dy ), ( 1 - dx ) * dy, dx * dy };
+        const quint16 *const topLeft = samples + row * m_tileWidth + column;
+        const quint16 values[4] = { topLeft[0], topLeft[1], topLeft[m_tileWidth], topLeft[m_tileWidth + 1] };
+
+        qreal ret = 0;
+        bool hasHeight = false;
+        qreal noData = 0;
+
+        for ( int j = 0; j < 4; ++j ) {
+            if ( values[j] != invalidElevationData ) {
+                ret += values[j] * weights[j];
+                hasHeight = true;
+            } else {
+                noData += weights[j];
+            }
+        }
+
+        if ( !hasHeight ) {
+            ret = invalidElevationData;
+        } else if ( noData ) {
+            ret += ( ret / ( 1 - noData ) ) * noData;
+        }
+
+        result[i] = ret;
+    }
+}
+
+ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, QObject *parent ) :
+    QObject( parent ),
+    d( new ElevationModelPrivate( this, downloadManager ) )
+{
+    connect( &d->m_tileLoader, SIGNAL(tileCompleted(TileId,QImage)),
+             this, SLOT(tileCompleted(TileId,QImage)) );
+}
+
+
+qreal ElevationModel::height( qreal lon, qreal lat ) const
+{
+    if ( !d->m_textureLayer ) {
+        return invalidElevationData;
+    }
+
+    return d->height( lon, lat );
+}
+
+QVector<qreal> ElevationModel::heights( const QVector<GeoDataCoordinates> &coordinates ) const
+{
+    QVector<qreal> result( coordinates.size(), invalidElevationData );
+    if ( !d->m_textureLayer ) {
+        return result;
+    }
+
+    d->heights( coordinates, result );
+
+    return result;
+}
+
 QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const
 {
     if ( !d->m_textureLayer ) {
         return QList<GeoDataCoordinates>();
     }
 
-    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
-    const int width = d->m_textureLayer->tileSize().width();
-    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
-
-    qreal distPerPixel = ( qreal )360 / ( width * numTilesX );
+    qreal distPerPixel = ( qreal )360 / ( d->m_tileWidth * d->m_numTilesX );
     //mDebug() << "heightProfile" << fromLat << fromLon << toLat << toLon << "distPerPixel" << distPerPixel;
 
     qreal lat = fromLat;
@@ -180,13 +317,10 @@ QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fr
     //mDebug() << "fromLon" << fromLon << "fromLat" << fromLat;
     //mDebug() << "diff lon" << ( fromLon - toLon ) << "diff lat" << ( fromLat - toLat );
     //mDebug() << "dirLon" << QString::number(dirLon) << "dirLat" << QString::number(dirLat) << "k" << k;
-    QList<GeoDataCoordinates> ret;
+    QVector<GeoDataCoordinates> samples;
     while ( lat*dirLat <= toLat*dirLat && lon*dirLon <= toLon * dirLon ) {
         //mDebug() << lat << lon;
-        qreal h = height( lon, lat );
-        if ( h < 32000 ) {
-            ret << GeoDataCoordinates( lon, lat, h, GeoDataCoordinates::Degree );
-        }
+        samples << GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
         if ( k < 0.5 ) {
             //mDebug() << "lon(x) += distPerPixel";
             lat += distPerPixel * k * dirLat;
@@ -197,10 +331,33 @@ QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fr
             lon += distPerPixel / k * dirLon;
         }
     }
+
+    const QVector<qreal> heights = this->heights( samples );
+
+    QList<GeoDataCoordinates> ret;
+    for ( int i = 0; i < samples.size(); ++i ) {
+        if ( heights[i] < 32000 ) {
+            samples[i].setAltitude( heights[i] );
+            ret << samples[i];
+        }
+    }
     //mDebug() << ret;
     return ret;
 }
 
+void ElevationModel::setCacheLimit( int kiloBytes )
+{
+    // the cache must hold at least one tile
+    const int tileCost = qMax( 1, d->m_tileWidth * d->m_tileHeight * int( sizeof( quint16 ) ) / 1024 );
+    d->m_lastTile = 0;
+    d->m_cache.setMaxCost( qMax( tileCost, kiloBytes ) );
+}
+
+int ElevationModel::cacheLimit() const
+{
+    return d->m_cache.maxCost();
+}
+
 }
 
 
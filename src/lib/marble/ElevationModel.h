@@ -18,6 +18,7 @@
 #include <QObject>
 #include <QCache>
 #include <QImage>
+#include <QVector>
 
 namespace Marble
 {
@@ -37,8 +38,25 @@ public:
     explicit ElevationModel( HttpDownloadManager *downloadManager, QObject *parent = 0 );
 
     qreal height( qreal lon, qreal lat ) const;
+
+    /**
+     * @brief Heights at many positions at once, as height() would return them.
+     *
+     * Meant for the positions of a route or track: the tile of consecutive
+     * positions that are close to each other is looked up only once and
+     * the heights are interpolated directly from its samples.
+     */
+    QVector<qreal> heights( const QVector<GeoDataCoordinates> &coordinates ) const;
+
     QList<GeoDataCoordinates> heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const;
 
+    /**
+     * @brief Limits the memory used by elevation tiles kept in memory.
+     * @param kiloBytes the limit, at least one tile is kept in any case
+     */
+    void setCacheLimit( int kiloBytes );
+    int cacheLimit() const;
+
 Q_SIGNALS:
     /**
      * Elevation tiles loaded. You will get more accurate results when querying height
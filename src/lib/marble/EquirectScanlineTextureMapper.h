@@ -15,6 +15,7 @@
 
 
 #include "TextureMapperInterface.h"
+#include "ScanlineBandScheduler.h"
 
 #include "MarbleGlobal.h"
 
@@ -36,8 +37,12 @@ class EquirectScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer );
 
+    virtual QString runtimeTrace() const;
+
  private:
     void mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
+    void renderRegion( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality,
+                       int yTop, int yBottom, int xLeft, int xRight );
 
  private:
     class RenderJob;
@@ -46,7 +51,14 @@ class EquirectScanlineTextureMapper : public TextureMapperInterface
     int m_radius;
     QImage m_canvasImage;
     int    m_oldYPaintedTop;
+    int    m_oldYPaintedBottom;
+    qreal  m_oldCenterLon;
+    int    m_oldYCenterOffset;
+    int    m_oldTileLevel;
+    MapQuality m_oldMapQuality;
+    int    m_scrolledDistance;
     QThreadPool m_threadPool;
+    ScanlineBandScheduler m_scheduler;
 };
 
 }
@@ -48,7 +48,9 @@ public:
           m_style( style ),
           m_documentRole ( role ),
           m_styleMap( new GeoDataStyleMap ),
-          m_document( 0 )
+          m_document( 0 ),
+          m_canceled( false ),
+          m_finished( false )
     {
         if( m_style ) {
             m_styleMap->setId("default-map");
@@ -66,7 +68,9 @@ public:
           m_style( 0 ),
           m_documentRole ( role ),
           m_styleMap( 0 ),
-          m_document( 0 )
+          m_document( 0 ),
+          m_canceled( false ),
+          m_finished( false )
     {
     }
 
@@ -82,6 +86,7 @@ public:
     static int areaPopIdx( qreal area );
 
     void documentParsed( GeoDataDocument *doc, const QString& error);
+    void parsingFinished();
 
     FileLoader *q;
     ParsingRunnerManager m_runner;
@@ -94,6 +99,8 @@ public:
     GeoDataStyleMap* m_styleMap;
     GeoDataDocument *m_document;
     QString m_error;
+    bool m_canceled;
+    bool m_finished;
 };
 
 FileLoader::FileLoader( QObject* parent, const PluginManager *pluginManager, bool recenter,
@@ -169,10 +176,13 @@ void FileLoader::run()
             // use runners: pnt, gpx, osm
             connect( &d->m_runner, SIGNAL(parsingFinished(GeoDataDocument*,QString)),
                     this, SLOT(documentParsed(GeoDataDocument*,QString)) );
+            connect( &d->m_runner, SIGNAL(parsingFinished()),
+                    this, SLOT(parsingFinished()) );
             d->m_runner.parseFile( defaultSourceName, d->m_documentRole );
         }
         else {
             mDebug() << "No Default Placemark Source File for " << name;
+            emit loaderFinished( this );
         }
     // content is not empty, we load from data
     } else {
@@ -211,9 +221,21 @@ bool FileLoader::recenter() const
     return d->m_recenter;
 }
 
+void FileLoader::cancel()
+{
+    d->m_canceled = true;
+    d->m_runner.cancel();
+}
+
 void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& error )
 {
+    if ( m_canceled ) {
+        delete doc;
+        return;
+    }
+
     m_error = error;
+    m_finished = true;
     if ( doc ) {
         m_document = doc;
         doc->setProperty( m_property );
@@ -228,6 +250,16 @@ void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& err
     emit q->loaderFinished( q );
 }
 
+void FileLoaderPrivate::parsingFinished()
+{
+    // no runner delivered a document or an error, e.g. because the loader
+    // got canceled or none of the runners supports the file
+    if ( !m_finished ) {
+        m_finished = true;
+        emit q->loaderFinished( q );
+    }
+}
+
 void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
 {
     QVector<GeoDataFeature*>::Iterator i = container->begin();
@@ -38,12 +38,19 @@ class FileLoader : public QThread
         GeoDataDocument *document();
         QString error() const;
 
+        /**
+         * Stops loading the file. Must not be called before run() returned.
+         * loaderFinished() is still emitted, but there won't be a document.
+         */
+        void cancel();
+
     Q_SIGNALS:
         void loaderFinished( FileLoader* );
         void newGeoDataDocumentAdded( GeoDataDocument* );
 
 private:
         Q_PRIVATE_SLOT ( d, void documentParsed( GeoDataDocument *, QString) )
+        Q_PRIVATE_SLOT ( d, void parsingFinished() )
 
         friend class FileLoaderPrivate;
 
@@ -38,7 +38,9 @@ public:
     FileManagerPrivate( GeoDataTreeModel *treeModel, const PluginManager *pluginManager, FileManager* parent ) :
         q( parent ),
         m_treeModel( treeModel ),
-        m_pluginManager( pluginManager )
+        m_pluginManager( pluginManager ),
+        m_loadedFiles( 0 ),
+        m_totalFiles( 0 )
     {
     }
 
@@ -63,6 +65,8 @@ public:
     QHash < QString, GeoDataDocument* > m_fileItemHash;
     GeoDataLatLonBox m_latLonBox;
     QTime m_timer;
+    int m_loadedFiles;
+    int m_totalFiles;
 };
 }
 
@@ -108,6 +112,8 @@ void FileManagerPrivate::appendLoader( FileLoader *loader )
              q, SLOT(cleanupLoader(FileLoader*)) );
 
     m_loaderList.append( loader );
+    ++m_totalFiles;
+    emit q->loadingProgress( m_loadedFiles, m_totalFiles );
     loader->start();
 }
 
@@ -115,10 +121,11 @@ void FileManager::removeFile( const QString& key )
 {
     foreach ( FileLoader *loader, d->m_loaderList ) {
         if ( loader->path() == key ) {
-            disconnect( loader, 0, this, 0 );
+            // the loader reports being finished once its runners are done,
+            // cleanupLoader() deletes it then
             loader->wait();
+            loader->cancel();
             d->m_loaderList.removeAll( loader );
-            delete loader->document();
             return;
         }
     }
@@ -190,6 +197,8 @@ void FileManagerPrivate::cleanupLoader( FileLoader* loader )
 {
     GeoDataDocument *doc = loader->document();
     m_loaderList.removeAll( loader );
+    ++m_loadedFiles;
+    emit q->loadingProgress( qMin( m_loadedFiles, m_totalFiles ), m_totalFiles );
     if ( loader->isFinished() ) {
         if ( doc ) {
             if ( doc->name().isEmpty() && !doc->fileName().isEmpty() )
@@ -222,6 +231,8 @@ void FileManagerPrivate::cleanupLoader( FileLoader* loader )
             emit q->centeredDocument( m_latLonBox );
         }
         m_latLonBox.clear();
+        m_loadedFiles = 0;
+        m_totalFiles = 0;
     }
 }
 
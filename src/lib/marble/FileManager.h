@@ -81,6 +81,13 @@ class FileManager : public QObject
     void fileRemoved( const QString &key );
     void centeredDocument( const GeoDataLatLonBox& );
 
+    /**
+     * Emitted whenever a file was queued for loading or finished loading.
+     * @p loaded counts the files out of @p total which are done since the
+     * last time no file was pending.
+     */
+    void loadingProgress( int loaded, int total );
+
  private:
 
     Q_PRIVATE_SLOT( d, void cleanupLoader( FileLoader *loader ) )
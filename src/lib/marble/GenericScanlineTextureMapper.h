@@ -13,6 +13,7 @@
 
 
 #include "TextureMapperInterface.h"
+#include "ScanlineBandScheduler.h"
 
 #include <QtCore/QThreadPool>
 #include <QtGui/QImage>
@@ -36,6 +37,8 @@ class GenericScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer );
 
+    virtual QString runtimeTrace() const;
+
  private:
     class RenderJob;
 
@@ -45,6 +48,7 @@ class GenericScanlineTextureMapper : public TextureMapperInterface
     int m_radius;
     QImage m_canvasImage;
     QThreadPool m_threadPool;
+    ScanlineBandScheduler m_scheduler;
 };
 
 }
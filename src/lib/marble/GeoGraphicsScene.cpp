@@ -21,24 +21,25 @@
 #include "GeoDataTypes.h"
 #include "GeoGraphicsItem.h"
 #include "TileId.h"
-#include "TileCoordsPyramid.h"
 #include "MarbleDebug.h"
-#include <QMap>
 
-namespace Marble
-{
+#include <QHash>
+#include <QSet>
+#include <QtAlgorithms>
+#include <QVector>
+
+#include <algorithm>
 
-bool zValueLessThan( GeoGraphicsItem* i1, GeoGraphicsItem* i2 )
+namespace Marble
 {
-    return i1->zValue() < i2->zValue();
-}
 
 class GeoGraphicsScenePrivate
 {
 public:
     GeoGraphicsScene *q;
     GeoGraphicsScenePrivate(GeoGraphicsScene *parent) :
-        q(parent)
+        q(parent),
+        m_serial( 0 )
     {
     }
 
@@ -47,10 +48,52 @@ public:
         q->clear();
     }
 
-    static void mergeItems( QList<GeoGraphicsItem *> &result, const QList<GeoGraphicsItem *> &objects, int maxZoomLevel );
+    /**
+     * An item along with the keys it is painted in order of: its z value
+     * and, for items of equal z value, newest first, so the item added
+     * first is painted on top.
+     */
+    struct Entry
+    {
+        qreal zValue;
+        quint64 serial;
+        GeoGraphicsItem *item;
 
-    QMap<TileId, QList<GeoGraphicsItem*> > m_items;
+        bool operator<( const Entry &other ) const
+        {
+            return zValue < other.zValue || ( zValue == other.zValue && serial > other.serial );
+        }
+    };
+
+    /**
+     * The items whose bounding boxes fit into a single tile, but not into
+     * one of its child tiles at the item's minimum zoom level.
+     */
+    struct Tile
+    {
+        QVector<Entry> entries; // sorted
+    };
+
+    /// Position of a tile list in mergeTiles()
+    struct Cursor
+    {
+        const Entry *current;
+        const Entry *end;
+    };
+
+    static bool cursorGreaterThan( const Cursor &c1, const Cursor &c2 )
+    {
+        return *c2.current < *c1.current;
+    }
+
+    void collectTiles( int level, int x1, int x2, int y1, int y2, QVector<const Tile *> &tiles ) const;
+
+    static void mergeTiles( const QVector<const Tile *> &tiles, const GeoDataLatLonBox &box, int maxZoomLevel,
+                            QList<GeoGraphicsItem *> &result );
+
+    QHash<TileId, Tile> m_tiles;
     QMultiHash<const GeoDataFeature*, TileId> m_features;
+    quint64 m_serial;
 
     // Stores the items which have been clicked;
     QList<GeoGraphicsItem*> m_selectedItems;
@@ -101,58 +144,94 @@ GeoGraphicsScene::~GeoGraphicsScene()
 
 QList< GeoGraphicsItem* > GeoGraphicsScene::items( const GeoDataLatLonBox &box, int zoomLevel ) const
 {
-    if ( box.west() > box.east() ) {
-        // Handle boxes crossing the IDL by splitting it into two separate boxes
-        GeoDataLatLonBox left;
-        left.setWest( -M_PI );
-        left.setEast( box.east() );
-        left.setNorth( box.north() );
-        left.setSouth( box.south() );
-
-        GeoDataLatLonBox right;
-        right.setWest( box.west() );
-        right.setEast( M_PI );
-        right.setNorth( box.north() );
-        right.setSouth( box.south() );
-
-        QList< GeoGraphicsItem* > allItems = items( left, zoomLevel );
-        foreach( GeoGraphicsItem* item, items( right, zoomLevel ) ) {
-            if ( !allItems.contains( item ) ) {
-                allItems << item;
-            }
+    qreal north, south, east, west;
+    box.boundaries( north, south, east, west );
+
+    const TileId topLeft = TileId::fromCoordinates( GeoDataCoordinates( west, north, 0 ), zoomLevel );
+    const TileId bottomRight = TileId::fromCoordinates( GeoDataCoordinates( east, south, 0 ), zoomLevel );
+
+    // Boxes crossing the IDL cover the tile columns from their western
+    // edge up to the IDL and from the IDL up to their eastern edge.
+    const bool crossesDateLine = west > east;
+    const int lastColumn = ( 1 << zoomLevel ) - 1;
+
+    QVector<const GeoGraphicsScenePrivate::Tile *> tiles;
+
+    for ( int level = 0; level <= zoomLevel; ++level ) {
+        const int deltaLevel = zoomLevel - level;
+        const int y1 = topLeft.y() >> deltaLevel;
+        const int y2 = bottomRight.y() >> deltaLevel;
+
+        if ( !crossesDateLine ) {
+            d->collectTiles( level, topLeft.x() >> deltaLevel, bottomRight.x() >> deltaLevel, y1, y2, tiles );
+            continue;
+        }
+
+        const int eastEnd = bottomRight.x() >> deltaLevel;
+        const int westStart = topLeft.x() >> deltaLevel;
+        if ( eastEnd + 1 >= westStart ) {
+            // both parts overlap in the coarse levels, visit each tile once
+            d->collectTiles( level, 0, lastColumn >> deltaLevel, y1, y2, tiles );
+        } else {
+            d->collectTiles( level, 0, eastEnd, y1, y2, tiles );
+            d->collectTiles( level, westStart, lastColumn >> deltaLevel, y1, y2, tiles );
         }
-        return allItems;
     }
 
     QList< GeoGraphicsItem* > result;
-    QRect rect;
-    qreal north, south, east, west;
-    box.boundaries( north, south, east, west );
-    TileId key;
-
-    key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel );
-    rect.setLeft( key.x() );
-    rect.setTop( key.y() );
-
-    key = TileId::fromCoordinates( GeoDataCoordinates(east, south, 0), zoomLevel );
-    rect.setRight( key.x() );
-    rect.setBottom( key.y() );
-    
-    TileCoordsPyramid pyramid( 0, zoomLevel );
-    pyramid.setBottomLevelCoords( rect );
-
-    for ( int level = pyramid.topLevel(); level <= pyramid.bottomLevel(); ++level ) {
-        QRect const coords = pyramid.coords( level );
-        int x1, y1, x2, y2;
-        coords.getCoords( &x1, &y1, &x2, &y2 );
-        for ( int x = x1; x <= x2; ++x ) {
-            for ( int y = y1; y <= y2; ++y ) {
-                const TileId tileId = TileId( 0, level, x, y );
-                GeoGraphicsScenePrivate::mergeItems( result, d->m_items.value( tileId ), zoomLevel );
+    GeoGraphicsScenePrivate::mergeTiles( tiles, box, zoomLevel, result );
+    return result;
+}
+
+void GeoGraphicsScenePrivate::collectTiles( int level, int x1, int x2, int y1, int y2, QVector<const Tile *> &tiles ) const
+{
+    if ( m_tiles.isEmpty() ) {
+        return;
+    }
+
+    for ( int x = x1; x <= x2; ++x ) {
+        for ( int y = y1; y <= y2; ++y ) {
+            const QHash<TileId, Tile>::const_iterator tile = m_tiles.constFind( TileId( 0, level, x, y ) );
+            if ( tile != m_tiles.constEnd() ) {
+                tiles.append( &tile.value() );
             }
         }
     }
-    return result;
+}
+
+void GeoGraphicsScenePrivate::mergeTiles( const QVector<const Tile *> &tiles, const GeoDataLatLonBox &box, int maxZoomLevel,
+                                          QList<GeoGraphicsItem *> &result )
+{
+    // k-way merge of the sorted tile lists, so the result is ordered
+    // without sorting all the items again
+    QVector<Cursor> heap;
+    heap.reserve( tiles.size() );
+    foreach ( const Tile *tile, tiles ) {
+        Cursor cursor;
+        cursor.current = tile->entries.constData();
+        cursor.end = cursor.current + tile->entries.size();
+        heap.append( cursor );
+    }
+
+    std::make_heap( heap.begin(), heap.end(), cursorGreaterThan );
+
+    while ( !heap.isEmpty() ) {
+        std::pop_heap( heap.begin(), heap.end(), cursorGreaterThan );
+        Cursor &cursor = heap.last();
+
+        GeoGraphicsItem *const item = cursor.current->item;
+        if ( item->minZoomLevel() <= maxZoomLevel && item->visible()
+             && item->latLonAltBox().GeoDataLatLonBox::intersects( box ) ) {
+            result.append( item );
+        }
+
+        ++cursor.current;
+        if ( cursor.current != cursor.end ) {
+            std::push_heap( heap.begin(), heap.end(), cursorGreaterThan );
+        } else {
+            heap.pop_back();
+        }
+    }
 }
 
 QList< GeoGraphicsItem* > GeoGraphicsScene::selectedItems() const
@@ -179,19 +258,19 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
      * items to use highlight style
      */
     foreach( const GeoDataPlacemark *placemark, selectedPlacemarks ) {
-        QList<TileId> tiles = d->m_features.values( placemark );
+        const QSet<TileId> tiles = d->m_features.values( placemark ).toSet();
         foreach( const TileId &tileId, tiles ) {
-            QList<GeoGraphicsItem*> clickedItems = d->m_items[tileId];
-            foreach ( GeoGraphicsItem *item, clickedItems ) {
+            foreach ( const GeoGraphicsScenePrivate::Entry &entry, d->m_tiles.value( tileId ).entries ) {
+                GeoGraphicsItem *item = entry.item;
                 if ( item->feature() == placemark ) {
                     GeoDataObject *parent = placemark->parent();
                     if ( parent ) {
                         if ( parent->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
-                            GeoDataDocument *doc = static_cast<GeoDataDocument*>( parent );
+                            const GeoDataDocument *doc = static_cast<const GeoDataDocument*>( parent );
                             QString styleUrl = placemark->styleUrl();
                             styleUrl.remove('#');
-                            if ( !styleUrl.isEmpty() ) {
-                                GeoDataStyleMap const &styleMap = doc->styleMap( styleUrl );
+                            const GeoDataStyleMap styleMap = doc->styleMap( styleUrl );
+                            if ( !styleMap.isEmpty() ) {
                                 GeoDataStyle *style = d->highlightStyle( doc, styleMap );
                                 if ( style ) {
                                     d->selectItem( item );
@@ -200,10 +279,10 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
                             }
 
                             /**
-                            * If a placemark is using an inline style instead of a shared
-                            * style ( e.g in case when theme file specifies the colorMap
-                            * attribute ) then highlight it if any of the style maps have a
-                            * highlight styleId
+                            * If a placemark is using an inline style or a shared style
+                            * instead of a style map ( e.g in case when theme file specifies
+                            * the colorMap attribute ) then highlight it if any of the style
+                            * maps have a highlight styleId
                             */
                             else {
                                 foreach ( const GeoDataStyleMap &styleMap, doc->styleMaps() ) {
@@ -226,27 +305,44 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
 
 void GeoGraphicsScene::removeItem( const GeoDataFeature* feature )
 {
-    QList<TileId> keys = d->m_features.values( feature );
-    foreach( TileId key, keys ) {
-        QList< GeoGraphicsItem* >& tileList = d->m_items[key];
-        foreach( GeoGraphicsItem* item, tileList ) {
-            if( item->feature() == feature ) {
-                d->m_features.remove( feature );
-                tileList.removeAll( item );
+    const QSet<TileId> keys = d->m_features.values( feature ).toSet();
+    foreach( const TileId &key, keys ) {
+        QHash<TileId, GeoGraphicsScenePrivate::Tile>::iterator tile = d->m_tiles.find( key );
+        if ( tile == d->m_tiles.end() ) {
+            continue;
+        }
+
+        // remove the items of the feature in a single pass, keeping the order of the others
+        QVector<GeoGraphicsScenePrivate::Entry> &entries = tile->entries;
+        int kept = 0;
+        for ( int i = 0; i < entries.size(); ++i ) {
+            GeoGraphicsItem *item = entries[i].item;
+            if ( item->feature() == feature ) {
+                d->m_selectedItems.removeAll( item );
                 delete item;
-                break;
+            } else {
+                entries[kept++] = entries[i];
             }
         }
+        entries.resize( kept );
+
+        if ( entries.isEmpty() ) {
+            d->m_tiles.erase( tile );
+        }
     }
+    d->m_features.remove( feature );
 }
 
 void GeoGraphicsScene::clear()
 {
-    foreach(const QList<GeoGraphicsItem*> &list, d->m_items.values()) {
-        qDeleteAll(list);
+    foreach( const GeoGraphicsScenePrivate::Tile &tile, d->m_tiles ) {
+        foreach( const GeoGraphicsScenePrivate::Entry &entry, tile.entries ) {
+            delete entry.item;
+        }
     }
-    d->m_items.clear();
+    d->m_tiles.clear();
     d->m_features.clear();
+    d->m_selectedItems.clear();
 }
 
 void GeoGraphicsScene::addItem( GeoGraphicsItem* item )
@@ -264,28 +360,15 @@ void GeoGraphicsScene::addItem( GeoGraphicsItem* item )
 
     const TileId key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel ); // same as GeoDataCoordinates(east, south, 0), see above
 
-    QList< GeoGraphicsItem* >& tileList = d->m_items[key];
-    QList< GeoGraphicsItem* >::iterator position = qLowerBound( tileList.begin(), tileList.end(), item, zValueLessThan );
-    tileList.insert( position, item );
-    d->m_features.insert( item->feature(), key );
-}
+    GeoGraphicsScenePrivate::Entry entry;
+    entry.zValue = item->zValue();
+    entry.serial = d->m_serial++;
+    entry.item = item;
 
-void GeoGraphicsScenePrivate::mergeItems( QList<GeoGraphicsItem *> &result, const QList<GeoGraphicsItem *> &objects, int maxZoomLevel )
-{
-    QList< GeoGraphicsItem* >::iterator before = result.begin();
-    QList< GeoGraphicsItem* >::const_iterator currentItem = objects.constBegin();
-    while( currentItem != objects.end() ) {
-        while( ( currentItem != objects.end() )
-          && ( ( before == result.end() ) || ( (*currentItem)->zValue() < (*before)->zValue() ) ) ) {
-            if( (*currentItem)->minZoomLevel() <= maxZoomLevel && (*currentItem)->visible() ) {
-                before = result.insert( before, *currentItem );
-            }
-            ++currentItem;
-        }
-        if ( before != result.end() ) {
-            ++before;
-        }
-    }
+    // in front of the items of equal z value, see GeoGraphicsScenePrivate::Entry
+    QVector<GeoGraphicsScenePrivate::Entry> &entries = d->m_tiles[key].entries;
+    entries.insert( qLowerBound( entries.begin(), entries.end(), entry ), entry );
+    d->m_features.insert( item->feature(), key );
 }
 
 }
@@ -67,7 +67,8 @@ public:
      *
      * @param box The box around the items.
      * @param maxZoomLevel The max zoom level of tiling
-     * @return The list of items in the specified box in no specific order.
+     * @return The visible items whose bounding boxes intersect @p box, ordered
+     * by their z value and, for equal z values, by the order they were added in.
      */
     QList<GeoGraphicsItem *> items( const GeoDataLatLonBox &box, int maxZoomLevel ) const;
 
@@ -501,6 +501,16 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
     QVector<QPolygonF*> polygons;
     d->m_viewport->screenCoordinates( lineString, polygons );
 
+    drawPolyline( polygons, labelText, labelPositionFlags );
+
+    qDeleteAll( polygons );
+}
+
+
+void GeoPainter::drawPolyline ( const QVector<QPolygonF*> & polygons,
+                                const QString& labelText,
+                                LabelPositionFlags labelPositionFlags )
+{
     if ( labelText.isEmpty() || labelPositionFlags.testFlag( NoLabel ) ) {
         foreach( QPolygonF* itPolygon, polygons ) {
             ClipPainter::drawPolyline( *itPolygon );
@@ -531,7 +541,6 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
             }
         }
     }
-    qDeleteAll( polygons );
 }
 
 
@@ -16,6 +16,7 @@
 
 #include <QSize>
 #include <QRegion>
+#include <QVector>
 
 // Marble
 #include "MarbleGlobal.h"
@@ -311,6 +312,20 @@ class MARBLE_EXPORT GeoPainter : public ClipPainter
                         LabelPositionFlags labelPositionFlags = LineCenter );
 
 
+/*!
+    \brief Draws polylines that have already been projected onto the screen.
+
+    Does the painting part of drawPolyline( GeoDataLineString ), for callers
+    that keep the screen \a polygons of a line string across repaints.
+    The \a labelText is placed according to the \a labelPositionFlags.
+
+    \see AbstractProjection
+*/
+    void drawPolyline ( const QVector<QPolygonF*> & polygons,
+                        const QString& labelText = QString(),
+                        LabelPositionFlags labelPositionFlags = LineCenter );
+
+
 /*!
     \brief Creates a region for a given line string (a "polyline").
 
@@ -17,6 +17,7 @@
 // Qt
 #include <QtCore/qmath.h>
 #include <QtCore/QRunnable>
+#include <QtCore/QTime>
 #include <QtGui/QImage>
 
 // Marble
@@ -35,7 +36,7 @@ using namespace Marble;
 class GnomonicScanlineTextureMapper::RenderJob : public QRunnable
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, ScanlineBandScheduler *scheduler );
 
     virtual void run();
 
@@ -45,18 +46,16 @@ private:
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    const int m_yPaintedTop;
-    const int m_yPaintedBottom;
+    ScanlineBandScheduler *const m_scheduler;
 };
 
-GnomonicScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
+GnomonicScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, ScanlineBandScheduler *scheduler )
     : m_tileLoader( tileLoader ),
       m_tileLevel( tileLevel ),
       m_canvasImage( canvasImage ),
       m_viewport( viewport ),
       m_mapQuality( mapQuality ),
-      m_yPaintedTop( yTop ),
-      m_yPaintedBottom( yBottom )
+      m_scheduler( scheduler )
 {
 }
 
@@ -103,6 +102,11 @@ void GnomonicScanlineTextureMapper::mapTexture( GeoPainter *painter,
     painter->drawImage( dirtyRect, m_canvasImage, dirtyRect );
 }
 
+QString GnomonicScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.runtimeTrace();
+}
+
 void GnomonicScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
 {
     // Reset backend
@@ -110,12 +114,11 @@ void GnomonicScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
 
     const int imageHeight = viewport->height();
 
+    m_scheduler.reset( 0, imageHeight );
+
     const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = imageHeight / numThreads;
     for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart =  i      * yStep;
-        const int yEnd   = (i + 1) * yStep;
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
+        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, &m_scheduler );
         m_threadPool.start( job );
     }
 
@@ -147,55 +150,68 @@ void GnomonicScanlineTextureMapper::RenderJob::run()
 
 
     // Paint the map.
-    for ( int y = m_yPaintedTop; y < m_yPaintedBottom; ++y ) {
-
-        QRgb * scanLine = (QRgb*)m_canvasImage->scanLine( y );
-
-        for ( int x = 0; x < imageWidth; ++x ) {
-
-            // Prepare for interpolation
-            bool interpolate = false;
-            if ( x >= 1 && x <= maxInterpolationPointX ) {
-                x += n - 1;
-                interpolate = !printQuality;
-            }
-            else {
-                interpolate = false;
+    QTime timer;
+    timer.start();
+
+    int bands = 0;
+    int yStart = 0;
+    int yEnd = 0;
+
+    while ( m_scheduler->nextBand( yStart, yEnd ) ) {
+        for ( int y = yStart; y < yEnd; ++y ) {
+
+            QRgb * scanLine = (QRgb*)m_canvasImage->scanLine( y );
+
+            for ( int x = 0; x < imageWidth; ++x ) {
+
+                // Prepare for interpolation
+                bool interpolate = false;
+                if ( x >= 1 && x <= maxInterpolationPointX ) {
+                    x += n - 1;
+                    interpolate = !printQuality;
+                }
+                else {
+                    interpolate = false;
+                }
+
+                qreal lon;
+                qreal lat;
+                m_viewport->geoCoordinates(x,y, lon, lat, GeoDataCoordinates::Radian);
+
+                if ( interpolate ) {
+                    if ( highQuality )
+                        context.pixelValueApproxF( lon, lat, scanLine, n );
+                    else
+                        context.pixelValueApprox( lon, lat, scanLine, n );
+
+                    scanLine += ( n - 1 );
+                }
+
+                if ( x < imageWidth ) {
+                    if ( highQuality )
+                        context.pixelValueF( lon, lat, scanLine );
+                    else
+                        context.pixelValue( lon, lat, scanLine );
+                }
+
+                ++scanLine;
+                lon += pixel2Rad;
             }
 
-            qreal lon;
-            qreal lat;
-            m_viewport->geoCoordinates(x,y, lon, lat, GeoDataCoordinates::Radian);
+            // copy scanline to improve performance
+            if ( interlaced && y + 1 < yEnd ) {
 
-            if ( interpolate ) {
-                if ( highQuality )
-                    context.pixelValueApproxF( lon, lat, scanLine, n );
-                else
-                    context.pixelValueApprox( lon, lat, scanLine, n );
+                const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
-                scanLine += ( n - 1 );
+                memcpy( m_canvasImage->scanLine( y + 1 ),
+                        m_canvasImage->scanLine( y     ),
+                        imageWidth * pixelByteSize );
+                ++y;
             }
-
-            if ( x < imageWidth ) {
-                if ( highQuality )
-                    context.pixelValueF( lon, lat, scanLine );
-                else
-                    context.pixelValue( lon, lat, scanLine );
-            }
-
-            ++scanLine;
-            lon += pixel2Rad;
         }
 
-        // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yPaintedBottom ) {
-
-            const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
-
-            memcpy( m_canvasImage->scanLine( y + 1 ),
-                    m_canvasImage->scanLine( y     ),
-                    imageWidth * pixelByteSize );
-            ++y;
-        }
+        ++bands;
     }
+
+    m_scheduler->addWorkerStatistics( bands, timer.elapsed() );
 }
@@ -77,6 +77,7 @@
 #include "RouteSimulationPositionProviderPlugin.h"
 #include "BookmarkManager.h"
 #include "ElevationModel.h"
+#include "PlacemarkSearchIndex.h"
 
 namespace Marble
 {
@@ -99,6 +100,7 @@ class MarbleModelPrivate
           m_descendantProxy(),
           m_placemarkProxyModel(),
           m_placemarkSelectionModel( 0 ),
+          m_placemarkSearchIndex( &m_treeModel ),
           m_fileManager( &m_treeModel, &m_pluginManager ),
           m_positionTracking( &m_treeModel ),
           m_trackedPlacemark( 0 ),
@@ -181,6 +183,8 @@ class MarbleModelPrivate
     // Selection handling
     QItemSelectionModel      m_placemarkSelectionModel;
 
+    PlacemarkSearchIndex     m_placemarkSearchIndex;
+
     FileManager              m_fileManager;
 
     //Gps Stuff
@@ -555,6 +559,11 @@ const GeoDataTreeModel *MarbleModel::treeModel() const
     return &d->m_treeModel;
 }
 
+const PlacemarkSearchIndex *MarbleModel::placemarkSearchIndex() const
+{
+    return &d->m_placemarkSearchIndex;
+}
+
 QAbstractItemModel *MarbleModel::placemarkModel()
 {
     return &d->m_placemarkProxyModel;
@@ -851,9 +860,9 @@ void MarbleModelPrivate::assignFillColors( const QString &filePath ) {
                             for ( ; it != itEnd; ++it ) {
                                 GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>( *it );
                                 if ( placemark ) {
-                                    GeoDataStyle *style = new GeoDataStyle;
-                                    style->setId( QString("normal") );
-                                    style->setLineStyle( lineStyle );
+                                    // placemarks with the same color index share their style
+                                    GeoDataStyle style;
+                                    style.setLineStyle( lineStyle );
                                     quint8 colorIndex = placemark->style()->polyStyle().colorIndex();
                                     GeoDataPolyStyle polyStyle;
                                     // Set the colorIndex so that it's not lost after setting new style.
@@ -871,8 +880,8 @@ void MarbleModelPrivate::assignFillColors( const QString &filePath ) {
                                     color.setAlphaF( alpha );
                                     polyStyle.setColor( color );
                                     polyStyle.setFill( true );
-                                    style->setPolyStyle( polyStyle );
-                                    placemark->setStyle( style );
+                                    style.setPolyStyle( polyStyle );
+                                    placemark->setStyleUrl( '#' + doc->addSharedStyle( style ) );
                                 }
                             }
                         }
@@ -50,6 +50,7 @@ class AbstractDataPluginItem;
 class GeoDataPlacemark;
 class GeoPainter;
 class MeasureTool;
+class PlacemarkSearchIndex;
 class PositionTracking;
 class HttpDownloadManager;
 class MarbleModelPrivate;
@@ -125,6 +126,11 @@ class MARBLE_EXPORT MarbleModel : public QObject
     QAbstractItemModel *placemarkModel();
     const QAbstractItemModel *placemarkModel() const;
 
+    /**
+     * @brief Index of the names of all placemarks in the tree model
+     */
+    const PlacemarkSearchIndex *placemarkSearchIndex() const;
+
     QItemSelectionModel *placemarkSelectionModel();
 
     /**
@@ -19,6 +19,7 @@
 
 // Qt
 #include <QRunnable>
+#include <QTime>
 
 // Marble
 #include "GeoPainter.h"
@@ -32,10 +33,14 @@
 
 using namespace Marble;
 
+// Pans are only applied to the previous canvas if they move the map by
+// (almost) whole pixels. Otherwise the reused part would be visibly offset.
+static const qreal MAXIMUM_SUBPIXEL_OFFSET = 0.01;
+
 class MercatorScanlineTextureMapper::RenderJob : public QRunnable
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, ScanlineBandScheduler *scheduler, int xLeft, int xRight );
 
     virtual void run();
 
@@ -45,18 +50,20 @@ private:
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    const int m_yPaintedTop;
-    const int m_yPaintedBottom;
+    ScanlineBandScheduler *const m_scheduler;
+    const int m_xLeft;
+    const int m_xRight;
 };
 
-MercatorScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
+MercatorScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, ScanlineBandScheduler *scheduler, int xLeft, int xRight )
     : m_tileLoader( tileLoader ),
       m_tileLevel( tileLevel ),
       m_canvasImage( canvasImage ),
       m_viewport( viewport ),
       m_mapQuality( mapQuality ),
-      m_yPaintedTop( yTop ),
-      m_yPaintedBottom( yBottom )
+      m_scheduler( scheduler ),
+      m_xLeft( xLeft ),
+      m_xRight( xRight )
 {
 }
 
@@ -64,7 +71,13 @@ MercatorScanlineTextureMapper::MercatorScanlineTextureMapper( StackedTileLoader
     : TextureMapperInterface(),
       m_tileLoader( tileLoader ),
       m_radius( 0 ),
-      m_oldYPaintedTop( 0 )
+      m_oldYPaintedTop( 0 ),
+      m_oldYPaintedBottom( 0 ),
+      m_oldCenterLon( 0.0 ),
+      m_oldYCenterOffset( 0 ),
+      m_oldTileLevel( -1 ),
+      m_oldMapQuality( NormalQuality ),
+      m_scrolledDistance( 0 )
 {
 }
 
@@ -87,6 +100,7 @@ void MercatorScanlineTextureMapper::mapTexture( GeoPainter *painter,
 
         m_radius = viewport->radius();
         m_repaintNeeded = true;
+        m_canvasReusable = false;
     }
 
     if ( m_repaintNeeded ) {
@@ -96,20 +110,26 @@ void MercatorScanlineTextureMapper::mapTexture( GeoPainter *painter,
             texColorizer->colorize( &m_canvasImage, viewport, painter->mapQuality() );
         }
 
+        // The colorizer works on the canvas in place, so its output can't
+        // be used as input of the next pass.
+        m_canvasReusable = ( texColorizer == 0 );
         m_repaintNeeded = false;
     }
 
     painter->drawImage( dirtyRect, m_canvasImage, dirtyRect );
 }
 
-void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
+QString MercatorScanlineTextureMapper::runtimeTrace() const
 {
-    // Reset backend
-    m_tileLoader->resetTilehash();
+    return m_scheduler.runtimeTrace();
+}
 
+void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
+{
     // Initialize needed constants:
 
     const int imageHeight = m_canvasImage.height();
+    const int imageWidth  = m_canvasImage.width();
 
     // Calculate y-range the represented by the center point, yTop and
     // what actually can be painted
@@ -127,13 +147,64 @@ void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     yPaintedTop = qBound(0, yPaintedTop, imageHeight);
     yPaintedBottom = qBound(0, yPaintedBottom, imageHeight);
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = ( yPaintedBottom - yPaintedTop ) / numThreads;
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yPaintedTop +  i      * yStep;
-        const int yEnd   = yPaintedTop + (i + 1) * yStep;
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
+    // The render jobs place the map with the precision below, which
+    // determines how far the content of the canvas actually moves.
+    const qint64 radius = viewport->radius();
+    const float jobRad2Pixel = (float)( 2 * radius ) / M_PI;
+    const qreal jobPixel2Rad = 1.0/jobRad2Pixel;
+
+    const qreal centerLon = viewport->centerLongitude();
+    const int jobYCenterOffset = (int)( asinh( tan( viewport->centerLatitude() ) ) * jobRad2Pixel  );
+
+    qreal deltaLon = centerLon - m_oldCenterLon;
+    if ( deltaLon >  M_PI ) deltaLon -= 2 * M_PI;
+    if ( deltaLon < -M_PI ) deltaLon += 2 * M_PI;
+
+    const qreal exactDx = deltaLon / jobPixel2Rad;
+    const int dx = qRound( exactDx );
+    const int dy = jobYCenterOffset - m_oldYCenterOffset;
+
+    // Lines that still show the right content after scrolling. One line
+    // is dropped at each end to account for rounding at the map border.
+    const int yValidTop    = qMax( yPaintedTop, m_oldYPaintedTop + dy + 1 );
+    const int yValidBottom = qMin( yPaintedBottom, m_oldYPaintedBottom + dy - 1 );
+
+    const bool incremental = m_canvasReusable
+                             && tileZoomLevel == m_oldTileLevel
+                             && mapQuality == m_oldMapQuality
+                             && qAbs( exactDx - dx ) < MAXIMUM_SUBPIXEL_OFFSET
+                             && qAbs( dx ) < imageWidth / 2
+                             && yValidTop < yValidBottom
+                             && m_scrolledDistance + qAbs( dx ) + qAbs( dy ) < ( imageWidth + imageHeight ) / 2;
+
+    if ( incremental ) {
+        // The tiles that were visible before mostly remain visible, so keep
+        // the tile hash as it is instead of collecting the used tiles anew.
+        // Tiles that scrolled out of view only leave the hash on the next
+        // full pass, which the scrolled distance limit above enforces.
+        ScanlineTextureMapperContext::scrollCanvasImage( &m_canvasImage, -dx, dy );
+        m_scrolledDistance += qAbs( dx ) + qAbs( dy );
+
+        // newly exposed lines ...
+        renderRegion( viewport, tileZoomLevel, mapQuality, yPaintedTop, yValidTop, 0, imageWidth );
+        renderRegion( viewport, tileZoomLevel, mapQuality, yValidBottom, yPaintedBottom, 0, imageWidth );
+
+        // ... and columns
+        if ( dx > 0 ) {
+            renderRegion( viewport, tileZoomLevel, mapQuality, yValidTop, yValidBottom, imageWidth - dx, imageWidth );
+        }
+        else if ( dx < 0 ) {
+            renderRegion( viewport, tileZoomLevel, mapQuality, yValidTop, yValidBottom, 0, -dx );
+        }
+    }
+    else {
+        // Reset backend
+        m_tileLoader->resetTilehash();
+
+        renderRegion( viewport, tileZoomLevel, mapQuality, yPaintedTop, yPaintedBottom, 0, imageWidth );
+
+        m_tileLoader->cleanupTilehash();
+        m_scrolledDistance = 0;
     }
 
     // Remove unused lines
@@ -147,11 +218,30 @@ void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
         *(it) = 0;
     }
 
-    m_threadPool.waitForDone();
-
     m_oldYPaintedTop = yPaintedTop;
+    m_oldYPaintedBottom = yPaintedBottom;
+    m_oldCenterLon = centerLon;
+    m_oldYCenterOffset = jobYCenterOffset;
+    m_oldTileLevel = tileZoomLevel;
+    m_oldMapQuality = mapQuality;
+}
+
+void MercatorScanlineTextureMapper::renderRegion( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality,
+                                                  int yTop, int yBottom, int xLeft, int xRight )
+{
+    if ( yTop >= yBottom || xLeft >= xRight ) {
+        return;
+    }
 
-    m_tileLoader->cleanupTilehash();
+    m_scheduler.reset( yTop, yBottom );
+
+    const int numThreads = m_threadPool.maxThreadCount();
+    for ( int i = 0; i < numThreads; ++i ) {
+        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, &m_scheduler, xLeft, xRight );
+        m_threadPool.start( job );
+    }
+
+    m_threadPool.waitForDone();
 }
 
 
@@ -180,11 +270,11 @@ void MercatorScanlineTextureMapper::RenderJob::run()
 
     const int yCenterOffset = (int)( asinh( tan( centerLat ) ) * rad2Pixel  );
 
-    qreal leftLon = + centerLon - ( imageWidth / 2 * pixel2Rad );
+    qreal leftLon = + centerLon - ( ( imageWidth / 2 - m_xLeft ) * pixel2Rad );
     while ( leftLon < -M_PI ) leftLon += 2 * M_PI;
     while ( leftLon >  M_PI ) leftLon -= 2 * M_PI;
 
-    const int maxInterpolationPointX = n * (int)( imageWidth / n - 1 ) + 1;
+    const int maxInterpolationPointX = m_xLeft + n * (int)( ( m_xRight - m_xLeft ) / n - 1 ) + 1;
 
 
     // initialize needed variables that are modified during texture mapping:
@@ -194,58 +284,71 @@ void MercatorScanlineTextureMapper::RenderJob::run()
 
     // Scanline based algorithm to do texture mapping
 
-    for ( int y = m_yPaintedTop; y < m_yPaintedBottom; ++y ) {
-
-        QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) );
-
-        qreal lon = leftLon;
-        const qreal lat = gd ( ( (imageHeight / 2 + yCenterOffset) - y )
-                    * pixel2Rad );
-
-        for ( int x = 0; x < imageWidth; ++x ) {
-            // Prepare for interpolation
-            bool interpolate = false;
-            if ( x > 0 && x <= maxInterpolationPointX ) {
-                x += n - 1;
-                lon += (n - 1) * pixel2Rad;
-                interpolate = !printQuality;
-            }
-            else {
-                interpolate = false;
+    QTime timer;
+    timer.start();
+
+    int bands = 0;
+    int yStart = 0;
+    int yEnd = 0;
+
+    while ( m_scheduler->nextBand( yStart, yEnd ) ) {
+        for ( int y = yStart; y < yEnd; ++y ) {
+
+            QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) ) + m_xLeft;
+
+            qreal lon = leftLon;
+            const qreal lat = gd ( ( (imageHeight / 2 + yCenterOffset) - y )
+                        * pixel2Rad );
+
+            for ( int x = m_xLeft; x < m_xRight; ++x ) {
+                // Prepare for interpolation
+                bool interpolate = false;
+                if ( x > m_xLeft && x <= maxInterpolationPointX ) {
+                    x += n - 1;
+                    lon += (n - 1) * pixel2Rad;
+                    interpolate = !printQuality;
+                }
+                else {
+                    interpolate = false;
+                }
+
+                if ( lon < -M_PI ) lon += 2 * M_PI;
+                if ( lon >  M_PI ) lon -= 2 * M_PI;
+
+                if ( interpolate ) {
+                    if (highQuality)
+                        context.pixelValueApproxF( lon, lat, scanLine, n );
+                    else
+                        context.pixelValueApprox( lon, lat, scanLine, n );
+
+                    scanLine += ( n - 1 );
+                }
+
+                if ( x < m_xRight ) {
+                    if ( highQuality )
+                        context.pixelValueF( lon, lat, scanLine );
+                    else
+                        context.pixelValue( lon, lat, scanLine );
+                }
+
+                ++scanLine;
+                lon += pixel2Rad;
             }
 
-            if ( lon < -M_PI ) lon += 2 * M_PI;
-            if ( lon >  M_PI ) lon -= 2 * M_PI;
+            // copy scanline to improve performance
+            if ( interlaced && y + 1 < yEnd ) { 
 
-            if ( interpolate ) {
-                if (highQuality)
-                    context.pixelValueApproxF( lon, lat, scanLine, n );
-                else
-                    context.pixelValueApprox( lon, lat, scanLine, n );
+                const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
-                scanLine += ( n - 1 );
+                memcpy( m_canvasImage->scanLine( y + 1 ) + m_xLeft * pixelByteSize,
+                        m_canvasImage->scanLine( y     ) + m_xLeft * pixelByteSize,
+                        ( m_xRight - m_xLeft ) * pixelByteSize );
+                ++y;
             }
-
-            if ( x < imageWidth ) {
-                if ( highQuality )
-                    context.pixelValueF( lon, lat, scanLine );
-                else
-                    context.pixelValue( lon, lat, scanLine );
-            }
-
-            ++scanLine;
-            lon += pixel2Rad;
         }
 
-        // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yPaintedBottom ) { 
-
-            const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
-
-            memcpy( m_canvasImage->scanLine( y + 1 ),
-                    m_canvasImage->scanLine( y     ),
-                    imageWidth * pixelByteSize );
-            ++y;
-        }
+        ++bands;
     }
+
+    m_scheduler->addWorkerStatistics( bands, timer.elapsed() );
 }
@@ -30,10 +30,13 @@
 #include "StackedTile.h"
 #include "TileLoaderHelper.h"
 #include "TextureTile.h"
+#include "TileArchive.h"
 #include "TileLoader.h"
 
 #include "GeoDataCoordinates.h"
 
+#include <QHash>
+#include <QMutex>
 #include <QMutexLocker>
 #include <QPointer>
 #include <QPainter>
@@ -43,48 +46,70 @@ using namespace Marble;
 class MergedLayerDecorator::Private
 {
 public:
+    /**
+     * The settings tiles are composed from. Tiles are prefetched in other
+     * threads while the GUI thread may change the settings, so tiles are
+     * created from a copy taken by state().
+     */
+    struct State
+    {
+        State();
+
+        QVector<const GeoSceneTextureTile *> textureLayers;
+        // the archives of packed texture layers, shared with the copies
+        QHash<const GeoSceneTiled *, QSharedPointer<const TileArchive> > archives;
+        QList<const GeoDataGroundOverlay *> groundOverlays;
+        QString themeId;
+        int levelZeroRows;
+        bool showTileId;
+    };
+
     Private( TileLoader *tileLoader, const SunLocator *sunLocator );
 
-    static int maxDivisor( int maximum, int fullLength );
+    State state() const;
 
-    StackedTile *createTile( const QVector<QSharedPointer<TextureTile> > &tiles ) const;
+    StackedTile *loadTile( const TileId &stackedTileId, bool localOnly );
+    StackedTile *createTile( const State &state, const QVector<QSharedPointer<TextureTile> > &tiles ) const;
 
-    void renderGroundOverlays( QImage *tileImage, const QVector<QSharedPointer<TextureTile> > &tiles ) const;
-    void paintSunShading( QImage *tileImage, const TileId &id ) const;
-    void paintTileId( QImage *tileImage, const TileId &id ) const;
+    static void renderGroundOverlays( const State &state, QImage *tileImage, const QVector<QSharedPointer<TextureTile> > &tiles );
+    static void paintTileId( const State &state, QImage *tileImage, const TileId &id );
 
     void detectMaxTileLevel();
-    QVector<const GeoSceneTextureTile *> findRelevantTextureLayers( const TileId &stackedTileId ) const;
+    static QVector<const GeoSceneTextureTile *> findRelevantTextureLayers( const State &state, const TileId &stackedTileId );
 
     TileLoader *const m_tileLoader;
-    const SunLocator *const m_sunLocator;
     BlendingFactory m_blendingFactory;
-    QVector<const GeoSceneTextureTile *> m_textureLayers;
-    QList<const GeoDataGroundOverlay *> m_groundOverlays;
     int m_maxTileLevel;
-    QString m_themeId;
-    int m_levelZeroColumns;
-    int m_levelZeroRows;
-    bool m_showSunShading;
-    bool m_showCityLights;
-    bool m_showTileId;
+
+    // written by the GUI thread only, which therefore reads it without locking
+    State m_state;
+    mutable QMutex m_stateMutex;
 };
 
+MergedLayerDecorator::Private::State::State() :
+    textureLayers(),
+    archives(),
+    groundOverlays(),
+    themeId(),
+    levelZeroRows( 0 ),
+    showTileId( false )
+{
+}
+
 MergedLayerDecorator::Private::Private( TileLoader *tileLoader, const SunLocator *sunLocator ) :
     m_tileLoader( tileLoader ),
-    m_sunLocator( sunLocator ),
     m_blendingFactory( sunLocator ),
-    m_textureLayers(),
     m_maxTileLevel( 0 ),
-    m_themeId(),
-    m_levelZeroColumns( 0 ),
-    m_levelZeroRows( 0 ),
-    m_showSunShading( false ),
-    m_showCityLights( false ),
-    m_showTileId( false )
+    m_state()
 {
 }
 
+MergedLayerDecorator::Private::State MergedLayerDecorator::Private::state() const
+{
+    QMutexLocker locker( &m_stateMutex );
+    return m_state;
+}
+
 MergedLayerDecorator::MergedLayerDecorator( TileLoader * const tileLoader,
                                             const SunLocator* sunLocator )
     : d( new Private( tileLoader, sunLocator ) )
@@ -100,28 +125,43 @@ void MergedLayerDecorator::setTextureLayers( const QVector<const GeoSceneTexture
 {
     mDebug() << Q_FUNC_INFO;
 
-    if ( textureLayers.count() > 0 ) {
-        const GeoSceneTiled *const firstTexture = textureLayers.at( 0 );
-        d->m_levelZeroColumns = firstTexture->levelZeroColumns();
-        d->m_levelZeroRows = firstTexture->levelZeroRows();
-        d->m_blendingFactory.setLevelZeroLayout( d->m_levelZeroColumns, d->m_levelZeroRows );
-        d->m_themeId = "maps/" + firstTexture->sourceDir();
+    // Archives are looked up each time the layers are set, so an archive
+    // installed in the meantime is used from the next theme change on.
+    QHash<const GeoSceneTiled *, QSharedPointer<const TileArchive> > archives;
+    foreach ( const GeoSceneTextureTile *layer, textureLayers ) {
+        const QSharedPointer<const TileArchive> archive = TileLoader::openTileArchive( layer );
+        if ( archive ) {
+            archives.insert( layer, archive );
+        }
     }
 
-    d->m_textureLayers = textureLayers;
+    {
+        QMutexLocker locker( &d->m_stateMutex );
+
+        if ( textureLayers.count() > 0 ) {
+            const GeoSceneTiled *const firstTexture = textureLayers.at( 0 );
+            d->m_state.levelZeroRows = firstTexture->levelZeroRows();
+            d->m_blendingFactory.setLevelZeroLayout( firstTexture->levelZeroColumns(), d->m_state.levelZeroRows );
+            d->m_state.themeId = "maps/" + firstTexture->sourceDir();
+        }
+
+        d->m_state.textureLayers = textureLayers;
+        d->m_state.archives = archives;
+    }
 
     d->detectMaxTileLevel();
 }
 
 void MergedLayerDecorator::updateGroundOverlays(const QList<const GeoDataGroundOverlay *> &groundOverlays )
 {
-    d->m_groundOverlays = groundOverlays;
+    QMutexLocker locker( &d->m_stateMutex );
+    d->m_state.groundOverlays = groundOverlays;
 }
 
 
 int MergedLayerDecorator::textureLayersSize() const
 {
-    return d->m_textureLayers.size();
+    return d->m_state.textureLayers.size();
 }
 
 int MergedLayerDecorator::maximumTileLevel() const
@@ -131,37 +171,37 @@ int MergedLayerDecorator::maximumTileLevel() const
 
 int MergedLayerDecorator::tileColumnCount( int level ) const
 {
-    Q_ASSERT( !d->m_textureLayers.isEmpty() );
+    Q_ASSERT( !d->m_state.textureLayers.isEmpty() );
 
-    const int levelZeroColumns = d->m_textureLayers.at( 0 )->levelZeroColumns();
+    const int levelZeroColumns = d->m_state.textureLayers.at( 0 )->levelZeroColumns();
 
     return TileLoaderHelper::levelToColumn( levelZeroColumns, level );
 }
 
 int MergedLayerDecorator::tileRowCount( int level ) const
 {
-    Q_ASSERT( !d->m_textureLayers.isEmpty() );
+    Q_ASSERT( !d->m_state.textureLayers.isEmpty() );
 
-    const int levelZeroRows = d->m_textureLayers.at( 0 )->levelZeroRows();
+    const int levelZeroRows = d->m_state.textureLayers.at( 0 )->levelZeroRows();
 
     return TileLoaderHelper::levelToRow( levelZeroRows, level );
 }
 
 GeoSceneTiled::Projection MergedLayerDecorator::tileProjection() const
 {
-    Q_ASSERT( !d->m_textureLayers.isEmpty() );
+    Q_ASSERT( !d->m_state.textureLayers.isEmpty() );
 
-    return d->m_textureLayers.at( 0 )->projection();
+    return d->m_state.textureLayers.at( 0 )->projection();
 }
 
 QSize MergedLayerDecorator::tileSize() const
 {
-    Q_ASSERT( !d->m_textureLayers.isEmpty() );
+    Q_ASSERT( !d->m_state.textureLayers.isEmpty() );
 
-    return d->m_textureLayers.at( 0 )->tileSize();
+    return d->m_state.textureLayers.at( 0 )->tileSize();
 }
 
-StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPointer<TextureTile> > &tiles ) const
+StackedTile *MergedLayerDecorator::Private::createTile( const State &state, const QVector<QSharedPointer<TextureTile> > &tiles ) const
 {
     Q_ASSERT( !tiles.isEmpty() );
 
@@ -173,7 +213,7 @@ StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPoi
 
     // if there are more than one active texture layers, we have to convert the
     // result tile into QImage::Format_ARGB32_Premultiplied to make blending possible
-    const bool withConversion = tiles.count() > 1 || m_showSunShading || m_showTileId || !m_groundOverlays.isEmpty();
+    const bool withConversion = tiles.count() > 1 || state.showTileId || !state.groundOverlays.isEmpty();
     foreach ( const QSharedPointer<TextureTile> &tile, tiles ) {
 
         // Image blending. If there are several images in the same tile (like clouds
@@ -200,31 +240,27 @@ StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPoi
         }
     }
 
-    renderGroundOverlays( &resultImage, tiles );
+    renderGroundOverlays( state, &resultImage, tiles );
 
-    if ( m_showSunShading && !m_showCityLights ) {
-        paintSunShading( &resultImage, id );
-    }
-
-    if ( m_showTileId ) {
-        paintTileId( &resultImage, id );
+    if ( state.showTileId ) {
+        paintTileId( state, &resultImage, id );
     }
 
     return new StackedTile( id, resultImage, tiles );
 }
 
-void MergedLayerDecorator::Private::renderGroundOverlays( QImage *tileImage, const QVector<QSharedPointer<TextureTile> > &tiles ) const
+void MergedLayerDecorator::Private::renderGroundOverlays( const State &state, QImage *tileImage, const QVector<QSharedPointer<TextureTile> > &tiles )
 {
 
     /* All tiles are covering the same area. Pick one. */
     const TileId tileId = tiles.first()->id();
 
-    GeoDataLatLonBox tileLatLonBox = tileId.toLatLonBox( findRelevantTextureLayers( tileId ).first() );
+    GeoDataLatLonBox tileLatLonBox = tileId.toLatLonBox( findRelevantTextureLayers( state, tileId ).first() );
 
     /* Map the ground overlay to the image. */
-    for ( int i =  0; i < m_groundOverlays.size(); ++i ) {
+    for ( int i =  0; i < state.groundOverlays.size(); ++i ) {
 
-        const GeoDataGroundOverlay* overlay = m_groundOverlays.at( i );
+        const GeoDataGroundOverlay* overlay = state.groundOverlays.at( i );
 
         const GeoDataLatLonBox overlayLatLonBox = overlay->latLonBox();
 
@@ -244,7 +280,7 @@ void MergedLayerDecorator::Private::renderGroundOverlays( QImage *tileImage, con
         const qreal lonToPixel = overlay->icon().width() / overlayLatLonBox.width();
 
         const qreal  global_height = tileImage->height()
-                * TileLoaderHelper::levelToRow( m_levelZeroRows, tileId.zoomLevel() );
+                * TileLoaderHelper::levelToRow( state.levelZeroRows, tileId.zoomLevel() );
         const qreal pixel2Rad = M_PI / global_height;
         const qreal rad2Pixel = global_height / M_PI;
 
@@ -254,7 +290,7 @@ void MergedLayerDecorator::Private::renderGroundOverlays( QImage *tileImage, con
              QRgb *scanLine = ( QRgb* ) ( tileImage->scanLine( y ) );
              qreal lat = 0;
 
-             if (m_textureLayers.at( 0 )->projection() ==  GeoSceneTiled::Mercator) {
+             if (state.textureLayers.at( 0 )->projection() ==  GeoSceneTiled::Mercator) {
                   lat = gd(2 * (latPixelPosition - y) * pixel2Rad );
              }
              else {
@@ -301,7 +337,18 @@ void MergedLayerDecorator::Private::renderGroundOverlays( QImage *tileImage, con
 
 StackedTile *MergedLayerDecorator::loadTile( const TileId &stackedTileId )
 {
-    const QVector<const GeoSceneTextureTile *> textureLayers = d->findRelevantTextureLayers( stackedTileId );
+    return d->loadTile( stackedTileId, false );
+}
+
+StackedTile *MergedLayerDecorator::loadLocalTile( const TileId &stackedTileId )
+{
+    return d->loadTile( stackedTileId, true );
+}
+
+StackedTile *MergedLayerDecorator::Private::loadTile( const TileId &stackedTileId, bool localOnly )
+{
+    const State state = this->state();
+    const QVector<const GeoSceneTextureTile *> textureLayers = findRelevantTextureLayers( state, stackedTileId );
     QVector<QSharedPointer<TextureTile> > tiles;
 
     foreach ( const GeoSceneTextureTile *layer, textureLayers ) {
@@ -311,13 +358,19 @@ StackedTile *MergedLayerDecorator::loadTile( const TileId &stackedTileId )
         mDebug() << Q_FUNC_INFO << layer->sourceDir() << tileId << layer->tileSize() << layer->fileFormat();
 
         // Blending (how to merge the images into an only image)
-        const Blending *blending = d->m_blendingFactory.findBlending( layer->blending() );
+        const Blending *blending = m_blendingFactory.findBlending( layer->blending() );
         if ( blending == 0 && !layer->blending().isEmpty() ) {
             mDebug() << Q_FUNC_INFO << "could not find blending" << layer->blending();
         }
 
         const GeoSceneTextureTile *const textureLayer = static_cast<const GeoSceneTextureTile *>( layer );
-        const QImage tileImage = d->m_tileLoader->loadTileImage( textureLayer, tileId, DownloadBrowse );
+        const TileArchive *const archive = state.archives.value( textureLayer ).data();
+        const QImage tileImage = localOnly ? m_tileLoader->loadLocalTileImage( textureLayer, archive, tileId )
+                                           : m_tileLoader->loadTileImage( textureLayer, archive, tileId, DownloadBrowse );
+        if ( tileImage.isNull() ) {
+            Q_ASSERT( localOnly );
+            return 0;
+        }
 
         QSharedPointer<TextureTile> tile( new TextureTile( tileId, tileImage, blending ) );
         tiles.append( tile );
@@ -325,7 +378,7 @@ StackedTile *MergedLayerDecorator::loadTile( const TileId &stackedTileId )
 
     Q_ASSERT( !tiles.isEmpty() );
 
-    return d->createTile( tiles );
+    return createTile( state, tiles );
 }
 
 RenderState MergedLayerDecorator::renderState( const TileId &stackedTileId ) const
@@ -334,12 +387,12 @@ RenderState MergedLayerDecorator::renderState( const TileId &stackedTileId ) con
     RenderState state( nameTemplate.arg( stackedTileId.zoomLevel() )
                        .arg( stackedTileId.x() )
                        .arg( stackedTileId.y() ) );
-    const QVector<const GeoSceneTextureTile *> textureLayers = d->findRelevantTextureLayers( stackedTileId );
+    const QVector<const GeoSceneTextureTile *> textureLayers = d->findRelevantTextureLayers( d->m_state, stackedTileId );
     foreach ( const GeoSceneTextureTile *layer, textureLayers ) {
         const TileId tileId( layer->sourceDir(), stackedTileId.zoomLevel(),
                              stackedTileId.x(), stackedTileId.y() );
         RenderStatus tileStatus = Complete;
-        switch ( TileLoader::tileStatus( layer, tileId ) ) {
+        switch ( TileLoader::tileStatus( layer, d->m_state.archives.value( layer ).data(), tileId ) ) {
         case TileLoader::Available:
             tileStatus = Complete;
             break;
@@ -373,127 +426,28 @@ StackedTile *MergedLayerDecorator::updateTile( const StackedTile &stackedTile, c
         }
     }
 
-    return d->createTile( tiles );
+    return d->createTile( d->m_state, tiles );
 }
 
 void MergedLayerDecorator::downloadStackedTile( const TileId &id, DownloadUsage usage )
 {
-    const QVector<const GeoSceneTextureTile *> textureLayers = d->findRelevantTextureLayers( id );
+    const QVector<const GeoSceneTextureTile *> textureLayers = d->findRelevantTextureLayers( d->m_state, id );
 
     foreach ( const GeoSceneTextureTile *textureLayer, textureLayers ) {
-        if ( TileLoader::tileStatus( textureLayer, id ) != TileLoader::Available || usage == DownloadBrowse ) {
+        const TileArchive *const archive = d->m_state.archives.value( textureLayer ).data();
+        if ( TileLoader::tileStatus( textureLayer, archive, id ) != TileLoader::Available || usage == DownloadBrowse ) {
             d->m_tileLoader->downloadTile( textureLayer, id, usage );
         }
     }
 }
 
-void MergedLayerDecorator::setShowSunShading( bool show )
-{
-    d->m_showSunShading = show;
-}
-
-bool MergedLayerDecorator::showSunShading() const
-{
-    return d->m_showSunShading;
-}
-
-void MergedLayerDecorator::setShowCityLights( bool show )
-{
-    d->m_showCityLights = show;
-}
-
-bool MergedLayerDecorator::showCityLights() const
-{
-    return d->m_showCityLights;
-}
-
 void MergedLayerDecorator::setShowTileId( bool visible )
 {
-    d->m_showTileId = visible;
+    QMutexLocker locker( &d->m_stateMutex );
+    d->m_state.showTileId = visible;
 }
 
-void MergedLayerDecorator::Private::paintSunShading( QImage *tileImage, const TileId &id ) const
-{
-    if ( tileImage->depth() != 32 )
-        return;
-
-    // TODO add support for 8-bit maps?
-    // add sun shading
-    const qreal  global_width  = tileImage->width()
-            * TileLoaderHelper::levelToColumn( m_levelZeroColumns, id.zoomLevel() );
-    const qreal  global_height = tileImage->height()
-            * TileLoaderHelper::levelToRow( m_levelZeroRows, id.zoomLevel() );
-    const qreal lon_scale = 2*M_PI / global_width;
-    const qreal lat_scale = -M_PI / global_height;
-    const int tileHeight = tileImage->height();
-    const int tileWidth = tileImage->width();
-
-    // First we determine the supporting point interval for the interpolation.
-    const int n = maxDivisor( 30, tileWidth );
-    const int ipRight = n * (int)( tileWidth / n );
-
-    for ( int cur_y = 0; cur_y < tileHeight; ++cur_y ) {
-        const qreal lat = lat_scale * ( id.y() * tileHeight + cur_y ) - 0.5*M_PI;
-        const qreal a = sin( (lat+DEG2RAD * m_sunLocator->getLat() )/2.0 );
-        const qreal c = cos(lat)*cos( -DEG2RAD * m_sunLocator->getLat() );
-
-        QRgb* scanline = (QRgb*)tileImage->scanLine( cur_y );
-
-        qreal lastShade = -10.0;
-
-        int cur_x = 0;
-
-        while ( cur_x < tileWidth ) {
-
-            const bool interpolate = ( cur_x != 0 && cur_x < ipRight && cur_x + n < tileWidth );
-
-            qreal shade = 0;
-
-            if ( interpolate ) {
-                const int check = cur_x + n;
-                const qreal checklon   = lon_scale * ( id.x() * tileWidth + check );
-                shade = m_sunLocator->shading( checklon, a, c );
-
-                // if the shading didn't change across the interpolation
-                // interval move on and don't change anything.
-                if ( shade == lastShade && shade == 1.0 ) {
-                    scanline += n;
-                    cur_x += n;
-                    continue;
-                }
-                if ( shade == lastShade && shade == 0.0 ) {
-                    for ( int t = 0; t < n; ++t ) {
-                        m_sunLocator->shadePixel( *scanline, shade );
-                        ++scanline;
-                    }
-                    cur_x += n;
-                    continue;
-                }
-                for ( int t = 0; t < n ; ++t ) {
-                    const qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
-                    shade = m_sunLocator->shading( lon, a, c );
-                    m_sunLocator->shadePixel( *scanline, shade );
-                    ++scanline;
-                    ++cur_x;
-                }
-            }
-
-            else {
-                // Make sure we don't exceed the image memory
-                if ( cur_x < tileWidth ) {
-                    const qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
-                    shade = m_sunLocator->shading( lon, a, c );
-                    m_sunLocator->shadePixel( *scanline, shade );
-                    ++scanline;
-                    ++cur_x;
-                }
-            }
-            lastShade = shade;
-        }
-    }
-}
-
-void MergedLayerDecorator::Private::paintTileId( QImage *tileImage, const TileId &id ) const
+void MergedLayerDecorator::Private::paintTileId( const State &state, QImage *tileImage, const TileId &id )
 {
     QString filename = QString( "%1_%2.jpg" )
             .arg( id.x(), tileDigits, 10, QChar('0') )
@@ -547,7 +501,7 @@ void MergedLayerDecorator::Private::paintTileId( QImage *tileImage, const TileId
 
     QPointF  baseline3( ( tileImage->width() - testFm.boundingRect(filename).width() ) / 2,
                         tileImage->height() * 0.75 );
-    outlinepath.addText( baseline3, testFont, m_themeId );
+    outlinepath.addText( baseline3, testFont, state.themeId );
 
     painter.drawPath( outlinepath );
 
@@ -557,19 +511,20 @@ void MergedLayerDecorator::Private::paintTileId( QImage *tileImage, const TileId
 
 void MergedLayerDecorator::Private::detectMaxTileLevel()
 {
-    if ( m_textureLayers.isEmpty() ) {
+    if ( m_state.textureLayers.isEmpty() ) {
         m_maxTileLevel = -1;
         return;
     }
 
-    m_maxTileLevel = TileLoader::maximumTileLevel( *m_textureLayers.at( 0 ) );
+    const GeoSceneTextureTile *const firstTexture = m_state.textureLayers.at( 0 );
+    m_maxTileLevel = TileLoader::maximumTileLevel( *firstTexture, m_state.archives.value( firstTexture ).data() );
 }
 
-QVector<const GeoSceneTextureTile *> MergedLayerDecorator::Private::findRelevantTextureLayers( const TileId &stackedTileId ) const
+QVector<const GeoSceneTextureTile *> MergedLayerDecorator::Private::findRelevantTextureLayers( const State &state, const TileId &stackedTileId )
 {
     QVector<const GeoSceneTextureTile *> result;
 
-    foreach ( const GeoSceneTextureTile *candidate, m_textureLayers ) {
+    foreach ( const GeoSceneTextureTile *candidate, state.textureLayers ) {
         Q_ASSERT( candidate );
         // check, if layer provides tiles for the current level
         if ( !candidate->hasMaximumTileLevel() ||
@@ -580,25 +535,3 @@ QVector<const GeoSceneTextureTile *> MergedLayerDecorator::Private::findRelevant
 
     return result;
 }
-
-// TODO: This should likely go into a math class in the future ...
-
-int MergedLayerDecorator::Private::maxDivisor( int maximum, int fullLength )
-{
-    // Find the optimal interpolation interval n for the
-    // current image canvas width
-    int best = 2;
-
-    int  nEvalMin = fullLength;
-    for ( int it = 1; it <= maximum; ++it ) {
-        // The optimum is the interval which results in the least amount
-        // supporting points taking into account the rest which can't
-        // get used for interpolation.
-        int nEval = fullLength / it + fullLength % it;
-        if ( nEval < nEvalMin ) {
-            nEvalMin = nEval;
-            best = it;
-        }
-    }
-    return best;
-}
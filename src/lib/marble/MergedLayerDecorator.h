@@ -63,16 +63,16 @@ class MergedLayerDecorator
 
     StackedTile *loadTile( const TileId &id );
 
+    /**
+     * Like loadTile(), but never triggers a download. Returns 0 unless the
+     * tiles of all texture layers are locally available and up to date.
+     */
+    StackedTile *loadLocalTile( const TileId &id );
+
     StackedTile *updateTile( const StackedTile &stackedTile, const TileId &tileId, const QImage &tileImage );
 
     void downloadStackedTile( const TileId &id, DownloadUsage usage );
 
-    void setShowSunShading( bool show );
-    bool showSunShading() const;
-
-    void setShowCityLights( bool show );
-    bool showCityLights() const;
-
     void setShowTileId(bool show);
 
     RenderState renderState( const TileId &stackedTileId ) const;
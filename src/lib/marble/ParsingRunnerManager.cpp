@@ -12,11 +12,13 @@
 
 #include "ParsingRunnerManager.h"
 
+#include "DocumentSnapshot.h"
 #include "MarbleDebug.h"
 #include "GeoDataDocument.h"
 #include "GeoDataPlacemark.h"
 #include "PluginManager.h"
 #include "ParseRunnerPlugin.h"
+#include "ParsingRunner.h"
 #include "RunnerTask.h"
 
 #include <QFileInfo>
@@ -29,6 +31,29 @@ namespace Marble
 
 class MarbleModel;
 
+namespace
+{
+
+/**
+ * Restores a document from its snapshot instead of parsing the file again.
+ */
+class SnapshotRunner : public ParsingRunner
+{
+public:
+    void parseFile( const QString &fileName, DocumentRole role )
+    {
+        GeoDataDocument *document = DocumentSnapshot( fileName ).load();
+        if ( document ) {
+            document->setDocumentRole( role );
+            emit parsingFinished( document );
+        } else {
+            emit parsingFinished( 0, QObject::tr( "Cannot read the snapshot of %1" ).arg( fileName ) );
+        }
+    }
+};
+
+}
+
 class ParsingRunnerManager::Private
 {
 public:
@@ -39,16 +64,21 @@ public:
     void addParsingResult( GeoDataDocument *document, const QString &error = QString() );
     void cleanupParsingTask( ParsingTask *task );
 
+    static QThreadPool *threadPool();
+    static int priority( DocumentRole role );
+
     ParsingRunnerManager *const q;
     const PluginManager *const m_pluginManager;
     QList<ParsingTask *> m_parsingTasks;
     GeoDataDocument *m_fileResult;
+    bool m_canceled;
 };
 
 ParsingRunnerManager::Private::Private( ParsingRunnerManager *parent, const PluginManager *pluginManager ) :
     q( parent ),
     m_pluginManager( pluginManager ),
-    m_fileResult( 0 )
+    m_fileResult( 0 ),
+    m_canceled( false )
 {
     qRegisterMetaType<GeoDataDocument*>( "GeoDataDocument*" );
 }
@@ -60,6 +90,11 @@ ParsingRunnerManager::Private::~Private()
 
 void ParsingRunnerManager::Private::addParsingResult( GeoDataDocument *document, const QString &error )
 {
+    if ( m_canceled ) {
+        delete document;
+        return;
+    }
+
     if ( document || !error.isEmpty() ) {
         if (document) {
             m_fileResult = document;
@@ -72,23 +107,50 @@ void ParsingRunnerManager::Private::cleanupParsingTask( ParsingTask *task )
 {
     m_parsingTasks.removeAll( task );
     mDebug() << "removing task" << m_parsingTasks.size() << " " << (quintptr)task;
+    delete task;
 
     if ( m_parsingTasks.isEmpty() ) {
         emit q->parsingFinished();
     }
 }
 
+QThreadPool *ParsingRunnerManager::Private::threadPool()
+{
+    // Shared by all managers, so that loading many files at once doesn't use
+    // more threads than there are cores. Parsing stays out of the global pool,
+    // which is used by search, routing and reverse geocoding tasks.
+    static QThreadPool pool;
+    return &pool;
+}
+
+int ParsingRunnerManager::Private::priority( DocumentRole role )
+{
+    // the data of the map theme is needed first, bookmarks can wait
+    switch ( role ) {
+    case MapDocument:
+        return 3;
+    case UserDocument:
+    case TrackingDocument:
+        return 2;
+    case UnknownDocument:
+    case SearchResultDocument:
+        return 1;
+    case BookmarkDocument:
+        return 0;
+    }
+
+    return 0;
+}
+
 ParsingRunnerManager::ParsingRunnerManager( const PluginManager *pluginManager, QObject *parent ) :
     QObject( parent ),
     d( new Private( this, pluginManager ) )
 {
-    if ( QThreadPool::globalInstance()->maxThreadCount() < 4 ) {
-        QThreadPool::globalInstance()->setMaxThreadCount( 4 );
-    }
 }
 
 ParsingRunnerManager::~ParsingRunnerManager()
 {
+    cancel();
     delete d;
 }
 
@@ -98,19 +160,36 @@ void ParsingRunnerManager::parseFile( const QString &fileName, DocumentRole role
     const QFileInfo fileInfo( fileName );
     const QString suffix = fileInfo.suffix().toLower();
     const QString completeSuffix = fileInfo.completeSuffix().toLower();
-
-    foreach( const ParseRunnerPlugin *plugin, plugins ) {
-        QStringList const extensions = plugin->fileExtensions();
-        if ( extensions.isEmpty() || extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
-            ParsingTask *task = new ParsingTask( plugin->newRunner(), this, fileName, role );
-            connect( task, SIGNAL(finished(ParsingTask*)), this, SLOT(cleanupParsingTask(ParsingTask*)) );
-            mDebug() << "parse task " << plugin->nameId() << " " << (quintptr)task;
-            d->m_parsingTasks << task;
+    d->m_canceled = false;
+
+    QList<ParsingTask *> tasks;
+    if ( DocumentSnapshot( fileName ).isCurrent() ) {
+        mDebug() << "using the snapshot of" << fileName;
+        tasks << new ParsingTask( new SnapshotRunner, this, fileName, role, true );
+    } else {
+        foreach( const ParseRunnerPlugin *plugin, plugins ) {
+            QStringList const extensions = plugin->fileExtensions();
+            if ( extensions.isEmpty() || extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
+                ParsingTask *task = new ParsingTask( plugin->newRunner(), this, fileName, role );
+                mDebug() << "parse task " << plugin->nameId() << " " << (quintptr)task;
+                tasks << task;
+            }
         }
     }
 
-    foreach ( ParsingTask *task, d->m_parsingTasks ) {
-        QThreadPool::globalInstance()->start( task );
+    // The tasks are created in the thread calling parseFile(), e.g. a FileLoader
+    // which exits right afterwards. cleanupParsingTask() deletes them in the
+    // thread of the manager instead, as cancel() may access them until then.
+    foreach ( ParsingTask *task, tasks ) {
+        task->setAutoDelete( false );
+        task->moveToThread( thread() );
+        connect( task, SIGNAL(finished(ParsingTask*)), this, SLOT(cleanupParsingTask(ParsingTask*)) );
+    }
+
+    // register all tasks before the first one can finish
+    d->m_parsingTasks << tasks;
+    foreach ( ParsingTask *task, tasks ) {
+        Private::threadPool()->start( task, Private::priority( role ) );
     }
 
     if ( d->m_parsingTasks.isEmpty() ) {
@@ -118,6 +197,14 @@ void ParsingRunnerManager::parseFile( const QString &fileName, DocumentRole role
     }
 }
 
+void ParsingRunnerManager::cancel()
+{
+    d->m_canceled = true;
+    foreach ( ParsingTask *task, d->m_parsingTasks ) {
+        task->cancel();
+    }
+}
+
 GeoDataDocument *ParsingRunnerManager::openFile( const QString &fileName, DocumentRole role, int timeout ) {
     QEventLoop localEventLoop;
     QTimer watchdog;
@@ -52,6 +52,13 @@ public:
     void parseFile( const QString &fileName, DocumentRole role = UserDocument );
     GeoDataDocument *openFile( const QString &fileName, DocumentRole role = UserDocument, int timeout = 30000 );
 
+    /**
+     * Stops parsing the file passed to parseFile(). Runners that didn't start
+     * yet are skipped, documents of runners that already started are deleted
+     * instead of being reported. parsingFinished() is emitted as usual.
+     */
+    void cancel();
+
 Q_SIGNALS:
     /**
      * The file was parsed and potential error message
@@ -41,6 +41,9 @@
 namespace Marble
 {
 
+// width of the cells of the label collision grid, their height is the maximum label height
+static const int s_labelGridCellWidth = 128;
+
 QVector<GeoDataFeature::GeoDataVisualCategory> sortedVisualCategories()
 {
     QVector<GeoDataFeature::GeoDataVisualCategory> visualCategories;
@@ -148,8 +151,13 @@ PlacemarkLayout::PlacemarkLayout( QAbstractItemModel  *placemarkModel,
       m_showLandingSites( false ),
       m_showCraters( false ),
       m_showMaria( false ),
+      m_labelGridColumns( 0 ),
+      m_labelGridRows( 0 ),
       m_maxLabelHeight( 0 ),
-      m_styleResetRequested( true )
+      m_styleResetRequested( true ),
+      m_layoutValid( false ),
+      m_layoutRadius( 0 ),
+      m_layoutProjection( Spherical )
 {
     m_placemarkModel.setSourceModel( placemarkModel );
     m_placemarkModel.setDynamicSortFilter( true );
@@ -178,36 +186,43 @@ PlacemarkLayout::~PlacemarkLayout()
 void PlacemarkLayout::setShowPlaces( bool show )
 {
     m_showPlaces = show;
+    m_layoutValid = false;
 }
 
 void PlacemarkLayout::setShowCities( bool show )
 {
     m_showCities = show;
+    m_layoutValid = false;
 }
 
 void PlacemarkLayout::setShowTerrain( bool show )
 {
     m_showTerrain = show;
+    m_layoutValid = false;
 }
 
 void PlacemarkLayout::setShowOtherPlaces( bool show )
 {
     m_showOtherPlaces = show;
+    m_layoutValid = false;
 }
 
 void PlacemarkLayout::setShowLandingSites( bool show )
 {
     m_showLandingSites = show;
+    m_layoutValid = false;
 }
 
 void PlacemarkLayout::setShowCraters( bool show )
 {
     m_showCraters = show;
+    m_layoutValid = false;
 }
 
 void PlacemarkLayout::setShowMaria( bool show )
 {
     m_showMaria = show;
+    m_layoutValid = false;
 }
 
 void PlacemarkLayout::requestStyleReset()
@@ -216,6 +231,12 @@ void PlacemarkLayout::requestStyleReset()
     m_styleResetRequested = true;
 }
 
+void PlacemarkLayout::invalidateLayout()
+{
+    // the symbol size determines the hot spot of the placemark
+    m_layoutValid = false;
+}
+
 void PlacemarkLayout::styleReset()
 {
     m_paintOrder.clear();
@@ -224,6 +245,7 @@ void PlacemarkLayout::styleReset()
     m_visiblePlacemarks.clear();
     m_maxLabelHeight = maxLabelHeight();
     m_styleResetRequested = false;
+    m_layoutValid = false;
 }
 
 QVector<const GeoDataFeature*> PlacemarkLayout::whichPlacemarkAt( const QPoint& curpos )
@@ -303,6 +325,8 @@ void PlacemarkLayout::removePlacemarks( QModelIndex parent, int first, int last
         TileId key = TileId::fromCoordinates( coordinates, zoomLevel );
         m_placemarkCache[key].removeAll( placemark );
     }
+    // The cached layout still refers to the placemarks about to be deleted.
+    requestStyleReset();
     emit repaintNeeded();
 }
 
@@ -370,21 +394,30 @@ QSet<TileId> PlacemarkLayout::visibleTiles( const ViewportParams *viewport )
 
 QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParams *viewport )
 {
-    m_runtimeTrace.clear();
-    if ( m_placemarkModel.rowCount() <= 0 )
+    if ( m_placemarkModel.rowCount() <= 0 ) {
+        m_runtimeTrace.clear();
         return QVector<VisiblePlacemark *>();
+    }
 
     if ( m_styleResetRequested ) {
         styleReset();
     }
 
     if ( m_maxLabelHeight == 0 ) {
+        m_runtimeTrace.clear();
         return QVector<VisiblePlacemark *>();
     }
 
-    const int secnumber = viewport->height() / m_maxLabelHeight + 1;
-    m_rowsection.clear();
-    m_rowsection.resize(secnumber);
+    // Repaints which are not caused by the map moving, e.g. by tiles being
+    // loaded, get the same layout as the previous frame.
+    if ( isLayoutValid( viewport ) ) {
+        return m_paintOrder;
+    }
+
+    m_labelGridColumns = viewport->width() / s_labelGridCellWidth + 1;
+    m_labelGridRows = viewport->height() / m_maxLabelHeight + 1;
+    m_labelGrid.clear();
+    m_labelGrid.resize( m_labelGridColumns * m_labelGridRows );
 
     m_paintOrder.clear();
     m_labelArea = 0;
@@ -393,10 +426,17 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
 
     const QModelIndexList selectedIndexes = m_selectionModel->selection().indexes();
 
+    QSet<const GeoDataPlacemark *> selectedPlacemarks;
     for ( int i = 0; i < selectedIndexes.count(); ++i ) {
         const QModelIndex index = selectedIndexes.at( i );
         const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
         Q_ASSERT(placemark);
+        selectedPlacemarks.insert( placemark );
+    }
+
+    for ( int i = 0; i < selectedIndexes.count(); ++i ) {
+        const QModelIndex index = selectedIndexes.at( i );
+        const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
         const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
 
         if ( !coordinates.isValid() ) {
@@ -424,8 +464,6 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
 
     // Now handle all other placemarks...
 
-    const QItemSelection selection = m_selectionModel->selection();
-
     QList<TileId> tileIdList = visibleTiles( viewport ).toList();
     qSort( tileIdList );
     QList<const GeoDataPlacemark*> placemarkList;
@@ -499,20 +537,10 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
             continue;
 
         // We handled selected placemarks already, so we skip them here...
-        // Assuming that only a small amount of places is selected
-        // we check for the selected state after all other filters
-        bool isSelected = false;
-        foreach ( const QModelIndex &index, selection.indexes() ) {
-            const GeoDataPlacemark *mark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
-            if (mark == placemark ) {
-                isSelected = true;
-                break;
-            }
-        }
-        if ( isSelected )
+        if ( selectedPlacemarks.contains( placemark ) )
             continue;
 
-        if( layoutPlacemark( placemark, x, y, isSelected ) ) {
+        if( layoutPlacemark( placemark, x, y, false ) ) {
             // Make sure not to draw more placemarks on the screen than
             // specified by placemarksOnScreenLimit().
             if ( placemarksOnScreenLimit( viewport->size() ) )
@@ -521,9 +549,27 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
     }
 
     m_runtimeTrace = QString("Placemarks: %1 Drawn: %2").arg( placemarkList.count() ).arg( m_paintOrder.size() );
+
+    m_layoutValid = true;
+    m_layoutSize = viewport->size();
+    m_layoutRadius = viewport->radius();
+    m_layoutPlanetAxis = viewport->planetAxis();
+    m_layoutProjection = viewport->projection();
+    m_layoutDateTime = m_clock->dateTime();
+
     return m_paintOrder;
 }
 
+bool PlacemarkLayout::isLayoutValid( const ViewportParams *viewport ) const
+{
+    return m_layoutValid
+        && m_layoutSize == viewport->size()
+        && m_layoutRadius == viewport->radius()
+        && m_layoutPlanetAxis == viewport->planetAxis()
+        && m_layoutProjection == viewport->projection()
+        && m_layoutDateTime == m_clock->dateTime();
+}
+
 QString PlacemarkLayout::runtimeTrace() const
 {
     return m_runtimeTrace;
@@ -552,6 +598,7 @@ bool PlacemarkLayout::layoutPlacemark( const GeoDataPlacemark *placemark, qreal
         // create a new one...
         mark = new VisiblePlacemark( placemark );
         m_visiblePlacemarks.insert( placemark, mark );
+        connect( mark, SIGNAL(updateNeeded()), this, SLOT(invalidateLayout()) );
         connect( mark, SIGNAL(updateNeeded()), this, SIGNAL(repaintNeeded()) );
     }
 
@@ -566,14 +613,13 @@ bool PlacemarkLayout::layoutPlacemark( const GeoDataPlacemark *placemark, qreal
     mark->setLabelRect( labelRect );
 
     if ( !labelRect.isEmpty() ) {
-        // Add the current placemark to the matching row and its
-        // direct neighbors.
-        int idx = y / m_maxLabelHeight;
-        if ( idx - 1 >= 0 )
-            m_rowsection[ idx - 1 ].append( mark );
-        m_rowsection[ idx ].append( mark );
-        if ( idx + 1 < m_rowsection.size() )
-            m_rowsection[ idx + 1 ].append( mark );
+        // Add the current placemark to all grid cells its label covers.
+        const QRect cells = labelGridCells( labelRect );
+        for ( int row = cells.top(); row <= cells.bottom(); ++row ) {
+            for ( int column = cells.left(); column <= cells.right(); ++column ) {
+                m_labelGrid[ row * m_labelGridColumns + column ].append( mark );
+            }
+        }
     }
 
     m_paintOrder.append( mark );
@@ -613,8 +659,6 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
         textWidth = ( QFontMetrics( labelFont ).width( labelText ) );
     }
 
-    const QVector<VisiblePlacemark*> currentsec = m_rowsection.at( y / m_maxLabelHeight );
-
     if ( style->labelStyle().alignment() == GeoDataLabelStyle::Corner ) {
         const int symbolWidth = style->iconStyle().icon().width();
 
@@ -627,40 +671,18 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
             const QRectF labelRect = QRectF( xPos, yPos, textWidth, textHeight );
 
             // Check if there is another label or symbol that overlaps.
-            bool isRoom = true;
-            QVector<VisiblePlacemark*>::const_iterator beforeItEnd = currentsec.constEnd();
-            for ( QVector<VisiblePlacemark*>::ConstIterator beforeIt = currentsec.constBegin();
-                  beforeIt != beforeItEnd;
-                  ++beforeIt ) {
-                if ( labelRect.intersects( (*beforeIt)->labelRect()) ) {
-                    isRoom = false;
-                    break;
-                }
-            }
-
-            if ( isRoom ) {
+            if ( hasRoomForLabel( labelRect ) ) {
                 // claim the place immediately if it hasn't been used yet
                 return labelRect;
             }
         }
     }
     else if ( style->labelStyle().alignment() == GeoDataLabelStyle::Center ) {
-        bool isRoom = true;
         QRectF  labelRect( x - textWidth / 2, y - textHeight / 2,
                           textWidth, textHeight );
 
         // Check if there is another label or symbol that overlaps.
-        QVector<VisiblePlacemark*>::const_iterator beforeItEnd = currentsec.constEnd();
-        for ( QVector<VisiblePlacemark*>::ConstIterator beforeIt = currentsec.constBegin();
-              beforeIt != beforeItEnd; ++beforeIt )
-        {
-            if ( labelRect.intersects( (*beforeIt)->labelRect() ) ) {
-                isRoom = false;
-                break;
-            }
-        }
-
-        if ( isRoom ) {
+        if ( hasRoomForLabel( labelRect ) ) {
             // claim the place immediately if it hasn't been used yet 
             return labelRect;
         }
@@ -670,6 +692,36 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
                      // for the rectangle anymore.
 }
 
+QRect PlacemarkLayout::labelGridCells( const QRectF &labelRect ) const
+{
+    // Labels reaching beyond the viewport are kept in the cells at its border.
+    const int left = qBound( 0, int( labelRect.left() ) / s_labelGridCellWidth, m_labelGridColumns - 1 );
+    const int right = qBound( 0, int( labelRect.right() ) / s_labelGridCellWidth, m_labelGridColumns - 1 );
+    const int top = qBound( 0, int( labelRect.top() ) / m_maxLabelHeight, m_labelGridRows - 1 );
+    const int bottom = qBound( 0, int( labelRect.bottom() ) / m_maxLabelHeight, m_labelGridRows - 1 );
+
+    return QRect( QPoint( left, top ), QPoint( right, bottom ) );
+}
+
+bool PlacemarkLayout::hasRoomForLabel( const QRectF &labelRect ) const
+{
+    const QRect cells = labelGridCells( labelRect );
+    for ( int row = cells.top(); row <= cells.bottom(); ++row ) {
+        for ( int column = cells.left(); column <= cells.right(); ++column ) {
+            const QVector<VisiblePlacemark*> &cell = m_labelGrid.at( row * m_labelGridColumns + column );
+            QVector<VisiblePlacemark*>::const_iterator beforeItEnd = cell.constEnd();
+            for ( QVector<VisiblePlacemark*>::ConstIterator beforeIt = cell.constBegin();
+                  beforeIt != beforeItEnd; ++beforeIt ) {
+                if ( labelRect.intersects( (*beforeIt)->labelRect() ) ) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
 bool PlacemarkLayout::placemarksOnScreenLimit( const QSize &screenSize ) const
 {
     int ratio = ( m_labelArea * 100 ) / ( screenSize.width() * screenSize.height() );
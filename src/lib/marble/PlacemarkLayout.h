@@ -18,6 +18,7 @@
 #define MARBLE_PLACEMARKLAYOUT_H
 
 
+#include <QDateTime>
 #include <QHash>
 #include <QModelIndex>
 #include <QRect>
@@ -26,6 +27,9 @@
 #include <QSortFilterProxyModel>
 
 #include "GeoDataFeature.h"
+#include "MarbleGlobal.h"
+#include "marble_export.h"
+#include "Quaternion.h"
 
 class QAbstractItemModel;
 class QItemSelectionModel;
@@ -51,7 +55,7 @@ class ViewportParams;
 
 
 
-class PlacemarkLayout : public QObject
+class MARBLE_EXPORT PlacemarkLayout : public QObject
 {
     Q_OBJECT
 
@@ -101,6 +105,9 @@ class PlacemarkLayout : public QObject
  Q_SIGNALS:
     void repaintNeeded();
 
+ private Q_SLOTS:
+    void invalidateLayout();
+
  private:
     /**
      * Returns a the maximum height of all possible labels.
@@ -127,6 +134,22 @@ class PlacemarkLayout : public QObject
                          const qreal x, const qreal y,
                          const QString &labelText ) const;
 
+    /**
+     * Returns the range of cells of the label collision grid which @p labelRect covers.
+     */
+    QRect labelGridCells( const QRectF &labelRect ) const;
+
+    /**
+     * Returns true if @p labelRect doesn't overlap any label placed so far.
+     */
+    bool hasRoomForLabel( const QRectF &labelRect ) const;
+
+    /**
+     * Returns true if the layout of the previous call of generateLayout()
+     * still applies to @p viewport.
+     */
+    bool isLayoutValid( const ViewportParams *viewport ) const;
+
     bool    placemarksOnScreenLimit( const QSize &screenSize ) const;
 
  private:
@@ -139,7 +162,11 @@ class PlacemarkLayout : public QObject
     QString m_runtimeTrace;
     int m_labelArea;
     QHash<const GeoDataPlacemark*, VisiblePlacemark*> m_visiblePlacemarks;
-    QVector< QVector< VisiblePlacemark* > >  m_rowsection;
+
+    /// labels placed so far, by the cells of a uniform grid over the viewport they cover
+    QVector< QVector< VisiblePlacemark* > >  m_labelGrid;
+    int m_labelGridColumns;
+    int m_labelGridRows;
 
     /// map providing the list of placemark belonging in TileId as key
     QMap<TileId, QList<const GeoDataPlacemark*> > m_placemarkCache;
@@ -159,6 +186,14 @@ class PlacemarkLayout : public QObject
 
     int     m_maxLabelHeight;
     bool    m_styleResetRequested;
+
+    // the state m_paintOrder was laid out for
+    bool    m_layoutValid;
+    QSize   m_layoutSize;
+    int     m_layoutRadius;
+    Quaternion m_layoutPlanetAxis;
+    Projection m_layoutProjection;
+    QDateTime m_layoutDateTime;
 };
 
 }
@@ -0,0 +1,350 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "PlacemarkSearchIndex.h"
+
+#include "GeoDataContainer.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTreeModel.h"
+#include "GeoDataTypes.h"
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <iterator>
+
+namespace Marble
+{
+
+namespace
+{
+
+struct Entry
+{
+    QString name;
+    GeoDataPlacemark *placemark;
+};
+
+bool nameLessThan( const Entry &one, const Entry &two )
+{
+    return one.name < two.name;
+}
+
+/**
+ * Updates of at most this many placemarks, like the ones caused by
+ * GeoDataTreeModel::updateFeature(), insert and remove single entries
+ * instead of rebuilding the sorted entries.
+ */
+const int maxIncrementalUpdate = 16;
+
+}
+
+}
+
+Q_DECLARE_TYPEINFO( Marble::Entry, Q_MOVABLE_TYPE );
+
+namespace Marble
+{
+
+namespace
+{
+
+/**
+ * The distinct trigrams of @p name, each packed into a single number.
+ */
+QVector<quint64> trigrams( const QString &name )
+{
+    QVector<quint64> result;
+    if ( name.size() < 3 ) {
+        return result;
+    }
+
+    result.reserve( name.size() - 2 );
+    for ( int i = 0; i + 2 < name.size(); ++i ) {
+        result.append( ( quint64( name.at( i ).unicode() ) << 32 )
+                       | ( quint64( name.at( i + 1 ).unicode() ) << 16 )
+                       | quint64( name.at( i + 2 ).unicode() ) );
+    }
+
+    qSort( result );
+    result.erase( std::unique( result.begin(), result.end() ), result.end() );
+
+    return result;
+}
+
+void collectPlacemarks( GeoDataObject *object, QVector<GeoDataPlacemark *> &placemarks )
+{
+    if ( object->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+        placemarks.append( static_cast<GeoDataPlacemark *>( object ) );
+    } else if ( object->nodeType() == GeoDataTypes::GeoDataDocumentType
+                || object->nodeType() == GeoDataTypes::GeoDataFolderType ) {
+        foreach ( GeoDataFeature *feature, static_cast<GeoDataContainer *>( object )->featureList() ) {
+            collectPlacemarks( feature, placemarks );
+        }
+    }
+}
+
+}
+
+class PlacemarkSearchIndexPrivate
+{
+ public:
+    explicit PlacemarkSearchIndexPrivate( GeoDataTreeModel *treeModel );
+
+    void addObject( GeoDataObject *object );
+    void removeObject( GeoDataObject *object );
+    void clear();
+    void reset();
+
+    GeoDataTreeModel *const m_treeModel;
+
+    mutable QReadWriteLock m_lock;
+    // sorted by name
+    QVector<Entry> m_entries;
+    QHash<const GeoDataPlacemark *, QString> m_names;
+    QHash<quint64, QVector<GeoDataPlacemark *> > m_trigrams;
+};
+
+PlacemarkSearchIndexPrivate::PlacemarkSearchIndexPrivate( GeoDataTreeModel *treeModel )
+    : m_treeModel( treeModel )
+{
+}
+
+void PlacemarkSearchIndexPrivate::addObject( GeoDataObject *object )
+{
+    QVector<GeoDataPlacemark *> placemarks;
+    collectPlacemarks( object, placemarks );
+
+    QVector<Entry> entries;
+    entries.reserve( placemarks.size() );
+    foreach ( GeoDataPlacemark *placemark, placemarks ) {
+        Entry entry;
+        entry.name = PlacemarkSearchIndex::normalized( placemark->name() );
+        entry.placemark = placemark;
+        if ( !entry.name.isEmpty() ) {
+            entries.append( entry );
+        }
+    }
+
+    if ( entries.isEmpty() ) {
+        return;
+    }
+
+    qSort( entries.begin(), entries.end(), nameLessThan );
+
+    QWriteLocker locker( &m_lock );
+
+    if ( entries.size() <= maxIncrementalUpdate ) {
+        foreach ( const Entry &entry, entries ) {
+            m_entries.insert( qUpperBound( m_entries.begin(), m_entries.end(), entry, nameLessThan ), entry );
+        }
+    } else {
+        QVector<Entry> merged;
+        merged.reserve( m_entries.size() + entries.size() );
+        std::merge( m_entries.constBegin(), m_entries.constEnd(), entries.constBegin(), entries.constEnd(),
+                    std::back_inserter( merged ), nameLessThan );
+        m_entries = merged;
+    }
+
+    foreach ( const Entry &entry, entries ) {
+        m_names.insert( entry.placemark, entry.name );
+        foreach ( quint64 trigram, trigrams( entry.name ) ) {
+            m_trigrams[trigram].append( entry.placemark );
+        }
+    }
+}
+
+void PlacemarkSearchIndexPrivate::removeObject( GeoDataObject *object )
+{
+    QVector<GeoDataPlacemark *> placemarks;
+    collectPlacemarks( object, placemarks );
+
+    QWriteLocker locker( &m_lock );
+
+    // look up the names as they were indexed, they may have changed since
+    QVector<Entry> removedEntries;
+    foreach ( GeoDataPlacemark *placemark, placemarks ) {
+        if ( m_names.contains( placemark ) ) {
+            Entry entry;
+            entry.name = m_names.take( placemark );
+            entry.placemark = placemark;
+            removedEntries.append( entry );
+        }
+    }
+
+    if ( removedEntries.isEmpty() ) {
+        return;
+    }
+
+    if ( removedEntries.size() <= maxIncrementalUpdate ) {
+        foreach ( const Entry &entry, removedEntries ) {
+            QVector<Entry>::iterator it = qLowerBound( m_entries.begin(), m_entries.end(), entry, nameLessThan );
+            while ( it->placemark != entry.placemark ) {
+                ++it;
+            }
+            m_entries.erase( it );
+
+            foreach ( quint64 trigram, trigrams( entry.name ) ) {
+                QHash<quint64, QVector<GeoDataPlacemark *> >::iterator list = m_trigrams.find( trigram );
+                list.value().remove( list.value().indexOf( entry.placemark ) );
+                if ( list.value().isEmpty() ) {
+                    m_trigrams.erase( list );
+                }
+            }
+        }
+
+        return;
+    }
+
+    QSet<const GeoDataPlacemark *> removed;
+    QSet<quint64> affectedTrigrams;
+    foreach ( const Entry &entry, removedEntries ) {
+        removed.insert( entry.placemark );
+        foreach ( quint64 trigram, trigrams( entry.name ) ) {
+            affectedTrigrams.insert( trigram );
+        }
+    }
+
+    QVector<Entry> entries;
+    entries.reserve( m_entries.size() - removedEntries.size() );
+    foreach ( const Entry &entry, m_entries ) {
+        if ( !removed.contains( entry.placemark ) ) {
+            entries.append( entry );
+        }
+    }
+    m_entries = entries;
+
+    foreach ( quint64 trigram, affectedTrigrams ) {
+        const QVector<GeoDataPlacemark *> list = m_trigrams.value( trigram );
+        QVector<GeoDataPlacemark *> remaining;
+        foreach ( GeoDataPlacemark *placemark, list ) {
+            if ( !removed.contains( placemark ) ) {
+                remaining.append( placemark );
+            }
+        }
+
+        if ( remaining.isEmpty() ) {
+            m_trigrams.remove( trigram );
+        } else {
+            m_trigrams.insert( trigram, remaining );
+        }
+    }
+}
+
+void PlacemarkSearchIndexPrivate::clear()
+{
+    QWriteLocker locker( &m_lock );
+    m_entries.clear();
+    m_names.clear();
+    m_trigrams.clear();
+}
+
+void PlacemarkSearchIndexPrivate::reset()
+{
+    clear();
+    addObject( m_treeModel->rootDocument() );
+}
+
+PlacemarkSearchIndex::PlacemarkSearchIndex( GeoDataTreeModel *treeModel, QObject *parent )
+    : QObject( parent ),
+      d( new PlacemarkSearchIndexPrivate( treeModel ) )
+{
+    connect( treeModel, SIGNAL(added(GeoDataObject*)), this, SLOT(addObject(GeoDataObject*)) );
+    connect( treeModel, SIGNAL(removed(GeoDataObject*)), this, SLOT(removeObject(GeoDataObject*)) );
+    connect( treeModel, SIGNAL(modelAboutToBeReset()), this, SLOT(clear()) );
+    connect( treeModel, SIGNAL(modelReset()), this, SLOT(reset()) );
+
+    d->reset();
+}
+
+PlacemarkSearchIndex::~PlacemarkSearchIndex()
+{
+    delete d;
+}
+
+QVector<GeoDataPlacemark *> PlacemarkSearchIndex::search( const QString &searchTerm,
+                                                          const GeoDataLatLonBox &preferred ) const
+{
+    QVector<GeoDataPlacemark *> result;
+
+    Entry key;
+    key.name = normalized( searchTerm );
+    key.placemark = 0;
+    if ( key.name.isEmpty() ) {
+        return result;
+    }
+
+    // copy the placemarks before unlocking, they may get deleted once removed from the index
+    QReadLocker locker( &d->m_lock );
+
+    QVector<Entry>::const_iterator it = qLowerBound( d->m_entries.constBegin(), d->m_entries.constEnd(),
+                                                     key, nameLessThan );
+    for ( ; it != d->m_entries.constEnd() && it->name.startsWith( key.name ); ++it ) {
+        if ( preferred.isEmpty() || preferred.contains( it->placemark->coordinate() ) ) {
+            result.append( new GeoDataPlacemark( *it->placemark ) );
+        }
+    }
+
+    const QVector<quint64> keyTrigrams = trigrams( key.name );
+    if ( keyTrigrams.isEmpty() ) {
+        return result;
+    }
+
+    // all names containing the search term are in the shortest list of one of its trigrams
+    QHash<quint64, QVector<GeoDataPlacemark *> >::const_iterator shortest = d->m_trigrams.constEnd();
+    foreach ( quint64 trigram, keyTrigrams ) {
+        QHash<quint64, QVector<GeoDataPlacemark *> >::const_iterator list = d->m_trigrams.constFind( trigram );
+        if ( list == d->m_trigrams.constEnd() ) {
+            return result;
+        }
+        if ( shortest == d->m_trigrams.constEnd() || list.value().size() < shortest.value().size() ) {
+            shortest = list;
+        }
+    }
+
+    foreach ( GeoDataPlacemark *placemark, shortest.value() ) {
+        const QString name = d->m_names.value( placemark );
+        if ( !name.startsWith( key.name ) && name.contains( key.name )
+             && ( preferred.isEmpty() || preferred.contains( placemark->coordinate() ) ) ) {
+            result.append( new GeoDataPlacemark( *placemark ) );
+        }
+    }
+
+    return result;
+}
+
+int PlacemarkSearchIndex::size() const
+{
+    QReadLocker locker( &d->m_lock );
+    return d->m_names.size();
+}
+
+QString PlacemarkSearchIndex::normalized( const QString &name )
+{
+    const QString decomposed = name.normalized( QString::NormalizationForm_KD );
+
+    QString result;
+    result.reserve( decomposed.size() );
+    foreach ( const QChar &character, decomposed ) {
+        if ( character.category() != QChar::Mark_NonSpacing ) {
+            result.append( character.toCaseFolded() );
+        }
+    }
+
+    return result;
+}
+
+}
+
+#include "PlacemarkSearchIndex.moc"
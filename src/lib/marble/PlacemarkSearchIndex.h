@@ -0,0 +1,83 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_PLACEMARKSEARCHINDEX_H
+#define MARBLE_PLACEMARKSEARCHINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+class GeoDataObject;
+class GeoDataPlacemark;
+class GeoDataTreeModel;
+class PlacemarkSearchIndexPrivate;
+
+/**
+ * @short Name index of the placemarks in a GeoDataTreeModel.
+ *
+ * Keeps the names of all placemarks in the tree model sorted, so that
+ * placemarks whose name starts with a search term are found by a binary
+ * search instead of a scan of the whole model. Names are additionally
+ * split into trigrams to find placemarks whose name contains the search
+ * term elsewhere. Names and search terms are compared case insensitive
+ * and without diacritics, so "zur" finds "Zürich".
+ *
+ * The index follows documents being added to or removed from the tree
+ * model. It may be searched from any thread.
+ */
+class MARBLE_EXPORT PlacemarkSearchIndex : public QObject
+{
+    Q_OBJECT
+
+ public:
+    explicit PlacemarkSearchIndex( GeoDataTreeModel *treeModel, QObject *parent = 0 );
+    ~PlacemarkSearchIndex();
+
+    /**
+     * @brief Searches placemarks by name.
+     *
+     * Placemarks whose name starts with @p searchTerm come first, sorted
+     * by name, followed by placemarks whose name contains it elsewhere.
+     * @param preferred if not empty, only placemarks within are returned
+     * @return copies of the placemarks found, owned by the caller
+     */
+    QVector<GeoDataPlacemark *> search( const QString &searchTerm, const GeoDataLatLonBox &preferred ) const;
+
+    /**
+     * @brief The number of placemarks in the index.
+     */
+    int size() const;
+
+    /**
+     * @brief Returns @p name in the form used for comparisons, that is
+     * case folded and without diacritics.
+     */
+    static QString normalized( const QString &name );
+
+ private:
+    Q_PRIVATE_SLOT( d, void addObject( GeoDataObject * ) )
+    Q_PRIVATE_SLOT( d, void removeObject( GeoDataObject * ) )
+    Q_PRIVATE_SLOT( d, void clear() )
+    Q_PRIVATE_SLOT( d, void reset() )
+
+    friend class PlacemarkSearchIndexPrivate;
+    PlacemarkSearchIndexPrivate *const d;
+};
+
+}
+
+#endif
@@ -11,6 +11,12 @@
 
 #include "RunnerTask.h"
 
+#include "GeoDataContainer.h"
+#include "GeoDataLineString.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataTypes.h"
 #include "MarbleDebug.h"
 #include "ParsingRunner.h"
 #include "ParsingRunnerManager.h"
@@ -81,24 +87,90 @@ void RoutingTask::run()
     emit finished( this );
 }
 
-ParsingTask::ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager, const QString& fileName, DocumentRole role ) :
+ParsingTask::ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager, const QString& fileName, DocumentRole role,
+                          bool fromSnapshot ) :
     QObject(),
     m_runner( runner ),
     m_fileName( fileName ),
-    m_role( role )
+    m_role( role ),
+    m_snapshot( fileName ),
+    m_fromSnapshot( fromSnapshot ),
+    m_state( Pending )
 {
+    // deleted along with the task, in the thread of the manager
+    m_runner->setParent( this );
+
+    // the runner emits its result from within run(), in the thread of the pool
     connect( m_runner, SIGNAL(parsingFinished(GeoDataDocument*,QString)),
+             this, SLOT(prepareDocument(GeoDataDocument*,QString)), Qt::DirectConnection );
+    connect( this, SIGNAL(parsed(GeoDataDocument*,QString)),
              manager, SLOT(addParsingResult(GeoDataDocument*,QString)) );
 }
 
 void ParsingTask::run()
 {
-    m_runner->parseFile( m_fileName, m_role );
-    m_runner->deleteLater();
+    if ( m_state.testAndSetOrdered( Pending, Running ) ) {
+        m_runner->parseFile( m_fileName, m_role );
+    }
 
     emit finished( this );
 }
 
+void ParsingTask::cancel()
+{
+    m_state.testAndSetOrdered( Pending, Canceled );
+}
+
+void ParsingTask::prepareDocument( GeoDataDocument *document, const QString &error )
+{
+    if ( document && !m_fromSnapshot ) {
+        assignDetailLevels( document );
+        if ( !m_snapshot.isCurrent() ) {
+            m_snapshot.save( *document );
+        }
+    }
+
+    emit parsed( document, error );
+}
+
+void ParsingTask::assignDetailLevels( GeoDataContainer *container )
+{
+    foreach ( GeoDataFeature *feature, container->featureList() ) {
+        if ( feature->nodeType() == GeoDataTypes::GeoDataDocumentType
+             || feature->nodeType() == GeoDataTypes::GeoDataFolderType ) {
+            assignDetailLevels( static_cast<GeoDataContainer*>( feature ) );
+        } else if ( feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+            GeoDataPlacemark *placemark = static_cast<GeoDataPlacemark*>( feature );
+            if ( placemark->geometry() ) {
+                assignDetailLevels( placemark->geometry() );
+            }
+        }
+    }
+}
+
+void ParsingTask::assignDetailLevels( GeoDataGeometry *geometry )
+{
+    if ( geometry->nodeType() == GeoDataTypes::GeoDataLineStringType
+         || geometry->nodeType() == GeoDataTypes::GeoDataLinearRingType ) {
+        static_cast<GeoDataLineString*>( geometry )->assignDetailLevels();
+    } else if ( geometry->nodeType() == GeoDataTypes::GeoDataPolygonType ) {
+        GeoDataPolygon *polygon = static_cast<GeoDataPolygon*>( geometry );
+        polygon->outerBoundary().assignDetailLevels();
+        QVector<GeoDataLinearRing>::Iterator it = polygon->innerBoundaries().begin();
+        QVector<GeoDataLinearRing>::Iterator const end = polygon->innerBoundaries().end();
+        for ( ; it != end; ++it ) {
+            it->assignDetailLevels();
+        }
+    } else if ( geometry->nodeType() == GeoDataTypes::GeoDataMultiGeometryType ) {
+        GeoDataMultiGeometry *multiGeometry = static_cast<GeoDataMultiGeometry*>( geometry );
+        QVector<GeoDataGeometry*>::Iterator it = multiGeometry->begin();
+        QVector<GeoDataGeometry*>::Iterator const end = multiGeometry->end();
+        for ( ; it != end; ++it ) {
+            assignDetailLevels( *it );
+        }
+    }
+}
+
 }
 
 #include "RunnerTask.moc"
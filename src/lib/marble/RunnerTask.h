@@ -11,16 +11,20 @@
 #ifndef MARBLE_RUNNERTASK_H
 #define MARBLE_RUNNERTASK_H
 
+#include "DocumentSnapshot.h"
 #include "GeoDataCoordinates.h"
 #include "GeoDataDocument.h"
 #include "GeoDataLatLonBox.h"
 
+#include <QAtomicInt>
 #include <QRunnable>
 #include <QString>
 
 namespace Marble
 {
 
+class GeoDataContainer;
+class GeoDataGeometry;
 class MarbleModel;
 class ParsingRunner;
 class SearchRunner;
@@ -103,20 +107,54 @@ class ParsingTask : public QObject, public QRunnable
     Q_OBJECT
 
 public:
-    ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager, const QString& fileName, DocumentRole role );
+    /**
+     * @param fromSnapshot whether @p runner restores the document from its
+     *        DocumentSnapshot, which already carries the detail levels
+     */
+    ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager, const QString& fileName, DocumentRole role,
+                 bool fromSnapshot = false );
 
     /**
      * @reimp
      */
     void run();
 
+    /**
+     * Skips parsing if the task didn't start yet. finished() is emitted
+     * nevertheless once the thread pool runs the task.
+     */
+    void cancel();
+
 Q_SIGNALS:
+    void parsed( GeoDataDocument *document, const QString &error );
+
     void finished( ParsingTask *task );
 
+private Q_SLOTS:
+    /**
+     * Prepares the geometries of @p document for drawing before it leaves
+     * the thread of this task and stores a snapshot of it for the next
+     * time the file gets opened. Documents restored from a snapshot are
+     * passed on unchanged.
+     */
+    void prepareDocument( GeoDataDocument *document, const QString &error );
+
 private:
+    static void assignDetailLevels( GeoDataContainer *container );
+    static void assignDetailLevels( GeoDataGeometry *geometry );
+
+    enum State {
+        Pending,
+        Running,
+        Canceled
+    };
+
     ParsingRunner *const m_runner;
     QString m_fileName;
     DocumentRole m_role;
+    const DocumentSnapshot m_snapshot;
+    const bool m_fromSnapshot;
+    QAtomicInt m_state;
 };
 
 }
@@ -0,0 +1,74 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "ScanlineBandScheduler.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+
+using namespace Marble;
+
+// Small enough to balance the load between threads, large enough to keep
+// the per-band overhead (atomic fetch, tile lookup at the band start) low.
+// Must be even to keep interlaced scanline pairs within one band.
+static const int BAND_HEIGHT = 16;
+
+ScanlineBandScheduler::ScanlineBandScheduler()
+    : m_yTop( 0 ),
+      m_yBottom( 0 ),
+      m_nextBand( 0 )
+{
+}
+
+void ScanlineBandScheduler::reset( int yTop, int yBottom )
+{
+    m_yTop = yTop;
+    m_yBottom = yBottom;
+    m_nextBand.fetchAndStoreOrdered( 0 );
+
+    QMutexLocker locker( &m_mutex );
+    m_statistics.clear();
+}
+
+bool ScanlineBandScheduler::nextBand( int &yStart, int &yEnd )
+{
+    const int band = m_nextBand.fetchAndAddOrdered( 1 );
+
+    yStart = m_yTop + band * BAND_HEIGHT;
+    if ( yStart >= m_yBottom ) {
+        return false;
+    }
+
+    yEnd = qMin( yStart + BAND_HEIGHT, m_yBottom );
+
+    return true;
+}
+
+void ScanlineBandScheduler::addWorkerStatistics( int bands, int elapsedMilliseconds )
+{
+    WorkerStatistics statistics;
+    statistics.bands = bands;
+    statistics.elapsed = elapsedMilliseconds;
+
+    QMutexLocker locker( &m_mutex );
+    m_statistics.append( statistics );
+}
+
+QString ScanlineBandScheduler::runtimeTrace() const
+{
+    QMutexLocker locker( &m_mutex );
+
+    QStringList workers;
+    foreach ( const WorkerStatistics &statistics, m_statistics ) {
+        workers << QString( "%1/%2 ms" ).arg( statistics.bands ).arg( statistics.elapsed );
+    }
+
+    return QString( "Bands/Time: %1" ).arg( workers.join( ", " ) );
+}
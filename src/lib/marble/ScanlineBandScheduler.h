@@ -0,0 +1,81 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_SCANLINEBANDSCHEDULER_H
+#define MARBLE_SCANLINEBANDSCHEDULER_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace Marble
+{
+
+/**
+ * @short Distributes the scanlines of a texture mapping pass among threads.
+ *
+ * Instead of assigning one fixed stripe of the canvas to each thread, the
+ * visible y-range is cut into small bands that the render jobs fetch one
+ * after another until none is left. Threads working on cheap parts of the
+ * map (e.g. the thin top and bottom of the globe) simply process more bands,
+ * so all threads finish at roughly the same time.
+ *
+ * Bands always start at an even offset from the top of the range, so
+ * interlaced rendering that copies every other scanline yields the same
+ * result as a single-threaded pass.
+ */
+class ScanlineBandScheduler
+{
+ public:
+    ScanlineBandScheduler();
+
+    /**
+     * @brief Prepares a new texture mapping pass over [yTop, yBottom).
+     * Must not be called while render jobs are running.
+     */
+    void reset( int yTop, int yBottom );
+
+    /**
+     * @brief Hands out the next unprocessed band. Thread-safe.
+     * @return false if all bands have been handed out already
+     */
+    bool nextBand( int &yStart, int &yEnd );
+
+    /**
+     * @brief Records how many bands a render job processed and how long it
+     * was busy. Thread-safe.
+     */
+    void addWorkerStatistics( int bands, int elapsedMilliseconds );
+
+    /**
+     * @brief Returns the per-thread statistics of the last pass in a form
+     * suitable for a runtime trace.
+     */
+    QString runtimeTrace() const;
+
+ private:
+    struct WorkerStatistics
+    {
+        int bands;
+        int elapsed;
+    };
+
+    int m_yTop;
+    int m_yBottom;
+    QAtomicInt m_nextBand;
+
+    mutable QMutex m_mutex;
+    QVector<WorkerStatistics> m_statistics;
+};
+
+}
+
+#endif
@@ -11,6 +11,8 @@
 
 #include "ScanlineTextureMapperContext.h"
 
+#include <cstring>
+
 #include <QImage>
 
 #include "MarbleDebug.h"
@@ -438,6 +440,39 @@ QImage::Format ScanlineTextureMapperContext::optimalCanvasImageFormat( const Vie
 }
 
 
+void ScanlineTextureMapperContext::scrollCanvasImage( QImage *canvasImage, int dx, int dy )
+{
+    const int imageWidth = canvasImage->width();
+    const int imageHeight = canvasImage->height();
+
+    if ( qAbs( dx ) >= imageWidth || qAbs( dy ) >= imageHeight ) {
+        return;
+    }
+
+    const int pixelByteSize = canvasImage->bytesPerLine() / imageWidth;
+    const int destinationX = qMax( dx, 0 ) * pixelByteSize;
+    const int sourceX = qMax( -dx, 0 ) * pixelByteSize;
+    const int lineBytes = ( imageWidth - qAbs( dx ) ) * pixelByteSize;
+
+    // Process the lines in an order that never overwrites a source line
+    // before it got moved.
+    if ( dy > 0 ) {
+        for ( int y = imageHeight - 1; y >= dy; --y ) {
+            memmove( canvasImage->scanLine( y ) + destinationX,
+                     canvasImage->scanLine( y - dy ) + sourceX,
+                     lineBytes );
+        }
+    }
+    else {
+        for ( int y = 0; y < imageHeight + dy; ++y ) {
+            memmove( canvasImage->scanLine( y ) + destinationX,
+                     canvasImage->scanLine( y - dy ) + sourceX,
+                     lineBytes );
+        }
+    }
+}
+
+
 void ScanlineTextureMapperContext::nextTile( int &posX, int &posY )
 {
     // Move from tile coordinates to global texture coordinates 
@@ -46,6 +46,14 @@ public:
 
     static QImage::Format optimalCanvasImageFormat( const ViewportParams *viewport );
 
+    /**
+     * @brief Moves the content of @p canvasImage by @p dx, @p dy pixels.
+     *
+     * The areas that get uncovered keep their previous content and need to
+     * be mapped again by the caller.
+     */
+    static void scrollCanvasImage( QImage *canvasImage, int dx, int dy );
+
     int globalWidth() const;
     int globalHeight() const;
 
@@ -0,0 +1,243 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "SphericalScanlineKernel.h"
+
+#include <cmath>
+
+// The vectorized code paths are restricted to x86-64, where qreal is a double
+// and scalar floating point math is done in SSE registers as well. This is
+// what makes the results of all implementations bitwise identical.
+#if ( defined( __x86_64__ ) || defined( _M_X64 ) ) && !defined( QT_COORD_TYPE )
+#define MARBLE_SCANLINE_SSE2
+#include <emmintrin.h>
+#if defined( __clang__ ) || ( defined( __GNUC__ ) && __GNUC__ >= 5 )
+// AVX is not part of the x86-64 baseline, so it is compiled per function
+// and selected at runtime.
+#define MARBLE_SCANLINE_AVX
+#include <immintrin.h>
+#endif
+#endif
+
+using namespace Marble;
+
+namespace
+{
+
+// Same as Quaternion::getSpherical() for a rotated unit vector.
+inline void toSpherical( qreal x, qreal y, qreal z, qreal &lon, qreal &lat )
+{
+    if ( y > 1.0 )
+        y = 1.0;
+    else if ( y < -1.0 )
+        y = -1.0;
+
+    lat = asin( y );
+
+    if ( x * x + z * z > 0.00005 )
+        lon = atan2( x, z );
+    else
+        lon = 0.0;
+}
+
+}
+
+SphericalScanlineKernel::Implementation SphericalScanlineKernel::bestImplementation()
+{
+    static const Implementation best = isSupported( Avx ) ? Avx
+                                     : isSupported( Sse2 ) ? Sse2
+                                     : Scalar;
+    return best;
+}
+
+bool SphericalScanlineKernel::isSupported( Implementation implementation )
+{
+    switch ( implementation ) {
+    case Scalar:
+        return true;
+    case Sse2:
+#ifdef MARBLE_SCANLINE_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case Avx:
+#ifdef MARBLE_SCANLINE_AVX
+        return __builtin_cpu_supports( "avx" );
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+SphericalScanlineKernel::SphericalScanlineKernel( const matrix &planetAxisMatrix,
+                                                  Implementation implementation )
+    : m_implementation( isSupported( implementation ) ? implementation : Scalar )
+{
+    for ( int i = 0; i < 3; ++i ) {
+        for ( int j = 0; j < 4; ++j ) {
+            m_planetAxisMatrix[i][j] = planetAxisMatrix[i][j];
+        }
+    }
+}
+
+SphericalScanlineKernel::Implementation SphericalScanlineKernel::implementation() const
+{
+    return m_implementation;
+}
+
+void SphericalScanlineKernel::sphericalCoordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                                                    int step, qreal *lon, qreal *lat ) const
+{
+    switch ( m_implementation ) {
+    case Avx:
+        avxCoordinates( qy, inverseRadius, xOffset, count, step, lon, lat );
+        break;
+    case Sse2:
+        sse2Coordinates( qy, inverseRadius, xOffset, count, step, lon, lat );
+        break;
+    case Scalar:
+        scalarCoordinates( qy, inverseRadius, xOffset, count, step, lon, lat );
+        break;
+    }
+}
+
+void SphericalScanlineKernel::scalarCoordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                                                 int step, qreal *lon, qreal *lat ) const
+{
+    const qreal qr = 1.0 - qy * qy;
+
+    for ( int i = 0; i < count; ++i ) {
+        const qreal qx = (qreal)( xOffset + i * step ) * inverseRadius;
+        const qreal qr2z = qr - qx * qx;
+        const qreal qz = ( qr2z > 0.0 ) ? sqrt( qr2z ) : 0.0;
+
+        Quaternion qpos( 0.0, qx, qy, qz );
+        qpos.rotateAroundAxis( m_planetAxisMatrix );
+        qpos.getSpherical( lon[i], lat[i] );
+    }
+}
+
+#ifdef MARBLE_SCANLINE_SSE2
+
+void SphericalScanlineKernel::sse2Coordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                                               int step, qreal *lon, qreal *lat ) const
+{
+    const matrix &m = m_planetAxisMatrix;
+    const qreal qr = 1.0 - qy * qy;
+
+    const __m128d vqr = _mm_set1_pd( qr );
+    const __m128d vInverseRadius = _mm_set1_pd( inverseRadius );
+    const __m128d zero = _mm_setzero_pd();
+
+    // The y component is constant along the scanline.
+    const __m128d yx = _mm_set1_pd( m[1][0] * qy );
+    const __m128d yy = _mm_set1_pd( m[1][1] * qy );
+    const __m128d yz = _mm_set1_pd( m[1][2] * qy );
+
+    const __m128d m00 = _mm_set1_pd( m[0][0] );
+    const __m128d m01 = _mm_set1_pd( m[0][1] );
+    const __m128d m02 = _mm_set1_pd( m[0][2] );
+    const __m128d m20 = _mm_set1_pd( m[2][0] );
+    const __m128d m21 = _mm_set1_pd( m[2][1] );
+    const __m128d m22 = _mm_set1_pd( m[2][2] );
+
+    double rx[2];
+    double ry[2];
+    double rz[2];
+
+    int i = 0;
+    for ( ; i + 2 <= count; i += 2 ) {
+        const __m128d qx = _mm_mul_pd( _mm_set_pd( xOffset + ( i + 1 ) * step, xOffset + i * step ), vInverseRadius );
+        const __m128d qr2z = _mm_sub_pd( vqr, _mm_mul_pd( qx, qx ) );
+        // maxpd returns the second operand for NaN and signed zeros,
+        // which matches the ( qr2z > 0.0 ) test of the scalar code
+        const __m128d qz = _mm_sqrt_pd( _mm_max_pd( qr2z, zero ) );
+
+        _mm_storeu_pd( rx, _mm_add_pd( _mm_add_pd( _mm_mul_pd( m00, qx ), yx ), _mm_mul_pd( m20, qz ) ) );
+        _mm_storeu_pd( ry, _mm_add_pd( _mm_add_pd( _mm_mul_pd( m01, qx ), yy ), _mm_mul_pd( m21, qz ) ) );
+        _mm_storeu_pd( rz, _mm_add_pd( _mm_add_pd( _mm_mul_pd( m02, qx ), yz ), _mm_mul_pd( m22, qz ) ) );
+
+        toSpherical( rx[0], ry[0], rz[0], lon[i],     lat[i] );
+        toSpherical( rx[1], ry[1], rz[1], lon[i + 1], lat[i + 1] );
+    }
+
+    scalarCoordinates( qy, inverseRadius, xOffset + i * step, count - i, step, lon + i, lat + i );
+}
+
+#else
+
+void SphericalScanlineKernel::sse2Coordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                                               int step, qreal *lon, qreal *lat ) const
+{
+    scalarCoordinates( qy, inverseRadius, xOffset, count, step, lon, lat );
+}
+
+#endif
+
+#ifdef MARBLE_SCANLINE_AVX
+
+__attribute__(( target( "avx" ) ))
+void SphericalScanlineKernel::avxCoordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                                              int step, qreal *lon, qreal *lat ) const
+{
+    const matrix &m = m_planetAxisMatrix;
+    const qreal qr = 1.0 - qy * qy;
+
+    const __m256d vqr = _mm256_set1_pd( qr );
+    const __m256d vInverseRadius = _mm256_set1_pd( inverseRadius );
+    const __m256d zero = _mm256_setzero_pd();
+
+    const __m256d yx = _mm256_set1_pd( m[1][0] * qy );
+    const __m256d yy = _mm256_set1_pd( m[1][1] * qy );
+    const __m256d yz = _mm256_set1_pd( m[1][2] * qy );
+
+    const __m256d m00 = _mm256_set1_pd( m[0][0] );
+    const __m256d m01 = _mm256_set1_pd( m[0][1] );
+    const __m256d m02 = _mm256_set1_pd( m[0][2] );
+    const __m256d m20 = _mm256_set1_pd( m[2][0] );
+    const __m256d m21 = _mm256_set1_pd( m[2][1] );
+    const __m256d m22 = _mm256_set1_pd( m[2][2] );
+
+    double rx[4];
+    double ry[4];
+    double rz[4];
+
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        const __m256d x = _mm256_set_pd( xOffset + ( i + 3 ) * step, xOffset + ( i + 2 ) * step,
+                                             xOffset + ( i + 1 ) * step, xOffset + i * step );
+        const __m256d qx = _mm256_mul_pd( x, vInverseRadius );
+        const __m256d qr2z = _mm256_sub_pd( vqr, _mm256_mul_pd( qx, qx ) );
+        const __m256d qz = _mm256_sqrt_pd( _mm256_max_pd( qr2z, zero ) );
+
+        _mm256_storeu_pd( rx, _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( m00, qx ), yx ), _mm256_mul_pd( m20, qz ) ) );
+        _mm256_storeu_pd( ry, _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( m01, qx ), yy ), _mm256_mul_pd( m21, qz ) ) );
+        _mm256_storeu_pd( rz, _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( m02, qx ), yz ), _mm256_mul_pd( m22, qz ) ) );
+
+        for ( int j = 0; j < 4; ++j ) {
+            toSpherical( rx[j], ry[j], rz[j], lon[i + j], lat[i + j] );
+        }
+    }
+
+    sse2Coordinates( qy, inverseRadius, xOffset + i * step, count - i, step, lon + i, lat + i );
+}
+
+#else
+
+void SphericalScanlineKernel::avxCoordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                                              int step, qreal *lon, qreal *lat ) const
+{
+    sse2Coordinates( qy, inverseRadius, xOffset, count, step, lon, lat );
+}
+
+#endif
@@ -0,0 +1,88 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_SPHERICALSCANLINEKERNEL_H
+#define MARBLE_SPHERICALSCANLINEKERNEL_H
+
+#include "marble_export.h"
+#include "Quaternion.h"
+
+namespace Marble
+{
+
+/**
+ * @short Batched screen-to-sphere transformation for one scanline.
+ *
+ * Computes the geographic position of a run of consecutive pixels on a
+ * scanline of the globe disc: the position on the unit sphere, the rotation
+ * by the planet axis and the conversion to longitude and latitude.
+ *
+ * The vectorized implementations evaluate the sphere position and the
+ * rotation of several pixels at once using the same sequence of IEEE
+ * operations as Quaternion::rotateAroundAxis(), so their results are bitwise
+ * identical to the scalar path. The trigonometric conversion is done per pixel
+ * with the C library functions used by Quaternion::getSpherical().
+ */
+class MARBLE_EXPORT SphericalScanlineKernel
+{
+ public:
+    enum Implementation {
+        Scalar,     ///< Quaternion based reference implementation
+        Sse2,       ///< two pixels per instruction
+        Avx         ///< four pixels per instruction
+    };
+
+    /**
+     * @brief Returns the fastest implementation supported by the CPU
+     * the code is running on.
+     */
+    static Implementation bestImplementation();
+
+    /**
+     * @brief Returns whether @p implementation is compiled in and supported
+     * by the CPU the code is running on.
+     */
+    static bool isSupported( Implementation implementation );
+
+    explicit SphericalScanlineKernel( const matrix &planetAxisMatrix,
+                                      Implementation implementation = bestImplementation() );
+
+    Implementation implementation() const;
+
+    /**
+     * @brief Calculates lon/lat of @p count pixels of a scanline, @p step pixels apart.
+     * @param qy the normalized y coordinate of the scanline
+     * @param inverseRadius the inverse of the globe radius in pixels
+     * @param xOffset the x coordinate of the first pixel relative to the
+     *                center of the globe
+     * @param count the number of pixels
+     * @param step the distance between two pixels, 1 for consecutive pixels
+     *             and the interpolation step for interpolation anchors
+     * @param lon output buffer with room for @p count values
+     * @param lat output buffer with room for @p count values
+     */
+    void sphericalCoordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                               int step, qreal *lon, qreal *lat ) const;
+
+ private:
+    void scalarCoordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                            int step, qreal *lon, qreal *lat ) const;
+    void sse2Coordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                          int step, qreal *lon, qreal *lat ) const;
+    void avxCoordinates( qreal qy, qreal inverseRadius, int xOffset, int count,
+                         int step, qreal *lon, qreal *lat ) const;
+
+    matrix m_planetAxisMatrix;
+    Implementation m_implementation;
+};
+
+}
+
+#endif
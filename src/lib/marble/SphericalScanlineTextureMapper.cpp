@@ -16,6 +16,8 @@
 
 #include <QtCore/qmath.h>
 #include <QRunnable>
+#include <QTime>
+#include <QVector>
 
 #include "MarbleGlobal.h"
 #include "GeoPainter.h"
@@ -24,6 +26,7 @@
 #include "MarbleDebug.h"
 #include "Quaternion.h"
 #include "ScanlineTextureMapperContext.h"
+#include "SphericalScanlineKernel.h"
 #include "StackedTileLoader.h"
 #include "StackedTile.h"
 #include "TextureColorizer.h"
@@ -36,7 +39,7 @@ using namespace Marble;
 class SphericalScanlineTextureMapper::RenderJob : public QRunnable
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, ScanlineBandScheduler *scheduler );
 
     virtual void run();
 
@@ -46,18 +49,16 @@ private:
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    int const m_yTop;
-    int const m_yBottom;
+    ScanlineBandScheduler *const m_scheduler;
 };
 
-SphericalScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
+SphericalScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, ScanlineBandScheduler *scheduler )
     : m_tileLoader( tileLoader ),
       m_tileLevel( tileLevel ),
       m_canvasImage( canvasImage ),
       m_viewport( viewport ),
       m_mapQuality( mapQuality ),
-      m_yTop( yTop ),
-      m_yBottom( yBottom )
+      m_scheduler( scheduler )
 {
 }
 
@@ -112,6 +113,11 @@ void SphericalScanlineTextureMapper::mapTexture( GeoPainter *painter,
     painter->drawImage( rect, m_canvasImage, rect );
 }
 
+QString SphericalScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.runtimeTrace();
+}
+
 void SphericalScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
 {
     // Reset backend
@@ -130,12 +136,11 @@ void SphericalScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     const int yBottom = ( yTop == 0 ) ? imageHeight - skip
                                       : yTop + radius + radius - skip;
 
+    m_scheduler.reset( yTop, yBottom );
+
     const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = qCeil(qreal( yBottom - yTop ) / qreal(numThreads));
     for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yTop +  i      * yStep;
-        const int yEnd   = qMin(yBottom, yTop + (i + 1) * yStep);
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
+        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, &m_scheduler );
         m_threadPool.start( job );
     }
 
@@ -175,130 +180,184 @@ void SphericalScanlineTextureMapper::RenderJob::run()
     qreal  lon = 0.0;
     qreal  lat = 0.0;
 
+    // Exact positions are transformed in batches: every pixel of a scanline
+    // without interpolation, the interpolation anchors otherwise.
+    const SphericalScanlineKernel kernel( planetAxisMatrix );
+    QVector<qreal> lonBuffer( imageWidth );
+    QVector<qreal> latBuffer( imageWidth );
+
+    QTime timer;
+    timer.start();
+
+    int bands = 0;
+    int yStart = 0;
+    int yEnd = 0;
+
     // Scanline based algorithm to texture map a sphere
-    for ( int y = m_yTop; y < m_yBottom ; ++y ) {
-
-        // Evaluate coordinates for the 3D position vector of the current pixel
-        const qreal qy = inverseRadius * (qreal)( imageHeight / 2 - y );
-        const qreal qr = 1.0 - qy * qy;
-
-        // rx is the radius component in x direction
-        const int rx = (int)sqrt( (qreal)( radius * radius
-                                      - ( ( y - imageHeight / 2 )
-                                          * ( y - imageHeight / 2 ) ) ) );
-
-        // Calculate the actual x-range of the map within the current scanline.
-        // 
-        // If the circular border of the earth disk is still visible then xLeft
-        // equals the scanline position of the most left pixel that gets covered
-        // by the earth disk. In terms of math this equals the half image width minus 
-        // the radius component on the current scanline in x direction ("rx").
-        //
-        // If the zoom factor is high enough then the whole screen gets covered
-        // by the earth and the border of the earth disk isn't visible anymore.
-        // In that situation xLeft equals zero.
-        // For xRight the situation is similar.
-
-        const int xLeft  = ( imageWidth / 2 - rx > 0 ) ? imageWidth / 2 - rx
-                                                       : 0;
-        const int xRight = ( imageWidth / 2 - rx > 0 ) ? xLeft + rx + rx
-                                                       : imageWidth;
-
-        QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) ) + xLeft;
-
-        const int xIpLeft  = ( imageWidth / 2 - rx > 0 ) ? n * (int)( xLeft / n + 1 )
-                                                         : 1;
-        const int xIpRight = ( imageWidth / 2 - rx > 0 ) ? n * (int)( xRight / n - 1 )
-                                                         : n * (int)( xRight / n - 1 ) + 1; 
-
-        // Decrease pole distortion due to linear approximation ( y-axis )
-        bool crossingPoleArea = false;
-        if ( northPole.v[Q_Z] > 0
-             && northPoleY - ( n * 0.75 ) <= y
-             && northPoleY + ( n * 0.75 ) >= y ) 
-        {
-            crossingPoleArea = true;
-        }
+    while ( m_scheduler->nextBand( yStart, yEnd ) ) {
+        for ( int y = yStart; y < yEnd; ++y ) {
+
+            // Evaluate coordinates for the 3D position vector of the current pixel
+            const qreal qy = inverseRadius * (qreal)( imageHeight / 2 - y );
+            const qreal qr = 1.0 - qy * qy;
+
+            // rx is the radius component in x direction
+            const int rx = (int)sqrt( (qreal)( radius * radius
+                                          - ( ( y - imageHeight / 2 )
+                                              * ( y - imageHeight / 2 ) ) ) );
+
+            // Calculate the actual x-range of the map within the current scanline.
+            // 
+            // If the circular border of the earth disk is still visible then xLeft
+            // equals the scanline position of the most left pixel that gets covered
+            // by the earth disk. In terms of math this equals the half image width minus 
+            // the radius component on the current scanline in x direction ("rx").
+            //
+            // If the zoom factor is high enough then the whole screen gets covered
+            // by the earth and the border of the earth disk isn't visible anymore.
+            // In that situation xLeft equals zero.
+            // For xRight the situation is similar.
+
+            const int xLeft  = ( imageWidth / 2 - rx > 0 ) ? imageWidth / 2 - rx
+                                                           : 0;
+            const int xRight = ( imageWidth / 2 - rx > 0 ) ? xLeft + rx + rx
+                                                           : imageWidth;
+
+            QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) ) + xLeft;
+
+            const int xIpLeft  = ( imageWidth / 2 - rx > 0 ) ? n * (int)( xLeft / n + 1 )
+                                                             : 1;
+            const int xIpRight = ( imageWidth / 2 - rx > 0 ) ? n * (int)( xRight / n - 1 )
+                                                             : n * (int)( xRight / n - 1 ) + 1; 
+
+            // Decrease pole distortion due to linear approximation ( y-axis )
+            bool crossingPoleArea = false;
+            if ( northPole.v[Q_Z] > 0
+                 && northPoleY - ( n * 0.75 ) <= y
+                 && northPoleY + ( n * 0.75 ) >= y ) 
+            {
+                crossingPoleArea = true;
+            }
 
-        int ncount = 0;
+            if ( n == 1 ) {
+                // Only used for print quality, which is never interlaced
+                kernel.sphericalCoordinates( qy, inverseRadius, xLeft - imageWidth / 2, xRight - xLeft,
+                                             1, lonBuffer.data(), latBuffer.data() );
 
-        for ( int x = xLeft; x < xRight; ++x ) {
-            // Prepare for interpolation
+                for ( int i = 0; i < xRight - xLeft; ++i ) {
+                    if ( highQuality )
+                        context.pixelValueF( lonBuffer[i], latBuffer[i], scanLine );
+                    else
+                        context.pixelValue( lonBuffer[i], latBuffer[i], scanLine );
+
+                    ++scanLine;
+                }
 
-            const int leftInterval = xIpLeft + ncount * n;
+                continue;
+            }
 
-            bool interpolate = false;
-            if ( x >= xIpLeft && x <= xIpRight ) {
+            // Away from the pole the anchors lie n pixels apart, starting at
+            // the end of the first interval. Around the pole they are shifted
+            // by exact pixels and get transformed one by one below.
+            const int anchors = ( !crossingPoleArea && xIpLeft <= xIpRight ) ? ( xIpRight - xIpLeft ) / n + 1
+                                                                            : 0;
+            if ( anchors > 0 ) {
+                kernel.sphericalCoordinates( qy, inverseRadius, xIpLeft + n - 1 - imageWidth / 2, anchors,
+                                             n, lonBuffer.data(), latBuffer.data() );
+            }
 
-                // Decrease pole distortion due to linear approximation ( x-axis )
-//                mDebug() << QString("NorthPole X: %1, LeftInterval: %2").arg( northPoleX ).arg( leftInterval );
-                if ( crossingPoleArea
-                     && northPoleX >= leftInterval + n
-                     && northPoleX < leftInterval + 2 * n
-                     && x < leftInterval + 3 * n )
-                {
+            int ncount = 0;
+
+            for ( int x = xLeft; x < xRight; ++x ) {
+                // Prepare for interpolation
+
+                const int leftInterval = xIpLeft + ncount * n;
+
+                bool interpolate = false;
+                bool anchor = false;
+                if ( x >= xIpLeft && x <= xIpRight ) {
+
+                    // Decrease pole distortion due to linear approximation ( x-axis )
+    //                mDebug() << QString("NorthPole X: %1, LeftInterval: %2").arg( northPoleX ).arg( leftInterval );
+                    if ( crossingPoleArea
+                         && northPoleX >= leftInterval + n
+                         && northPoleX < leftInterval + 2 * n
+                         && x < leftInterval + 3 * n )
+                    {
+                        interpolate = false;
+                    }
+                    else {
+                        x += n - 1;
+                        interpolate = !printQuality;
+                        anchor = ncount < anchors;
+                        ++ncount;
+                    } 
+                }
+                else
                     interpolate = false;
+
+                if ( anchor ) {
+                    lon = lonBuffer[ncount - 1];
+                    lat = latBuffer[ncount - 1];
                 }
                 else {
-                    x += n - 1;
-                    interpolate = !printQuality;
-                    ++ncount;
-                } 
-            }
-            else
-                interpolate = false;
-
-            // Evaluate more coordinates for the 3D position vector of
-            // the current pixel.
-            const qreal qx = (qreal)( x - imageWidth / 2 ) * inverseRadius;
-            const qreal qr2z = qr - qx * qx;
-            const qreal qz = ( qr2z > 0.0 ) ? sqrt( qr2z ) : 0.0;
-
-            // Create Quaternion from vector coordinates and rotate it
-            // around globe axis
-            Quaternion qpos( 0.0, qx, qy, qz );
-            qpos.rotateAroundAxis( planetAxisMatrix );
-
-            qpos.getSpherical( lon, lat );
-//            mDebug() << QString("lon: %1 lat: %2").arg(lon).arg(lat);
-            // Approx for n-1 out of n pixels within the boundary of
-            // xIpLeft to xIpRight
-
-            if ( interpolate ) {
-                if (highQuality)
-                    context.pixelValueApproxF( lon, lat, scanLine, n );
-                else
-                    context.pixelValueApprox( lon, lat, scanLine, n );
+                    // Evaluate more coordinates for the 3D position vector of
+                    // the current pixel.
+                    const qreal qx = (qreal)( x - imageWidth / 2 ) * inverseRadius;
+                    const qreal qr2z = qr - qx * qx;
+                    const qreal qz = ( qr2z > 0.0 ) ? sqrt( qr2z ) : 0.0;
+
+                    // Create Quaternion from vector coordinates and rotate it
+                    // around globe axis
+                    Quaternion qpos( 0.0, qx, qy, qz );
+                    qpos.rotateAroundAxis( planetAxisMatrix );
+
+                    qpos.getSpherical( lon, lat );
+                }
+    //            mDebug() << QString("lon: %1 lat: %2").arg(lon).arg(lat);
+                // Approx for n-1 out of n pixels within the boundary of
+                // xIpLeft to xIpRight
 
-                scanLine += ( n - 1 );
-            }
+                if ( interpolate ) {
+                    if (highQuality)
+                        context.pixelValueApproxF( lon, lat, scanLine, n );
+                    else
+                        context.pixelValueApprox( lon, lat, scanLine, n );
 
-//          Comment out the pixelValue line and run Marble if you want
-//          to understand the interpolation:
+                    scanLine += ( n - 1 );
+                }
 
-//          Uncomment the crossingPoleArea line to check precise 
-//          rendering around north pole:
+    //          Comment out the pixelValue line and run Marble if you want
+    //          to understand the interpolation:
 
-//            if ( !crossingPoleArea )
-            if ( x < imageWidth ) {
-                if ( highQuality )
-                    context.pixelValueF( lon, lat, scanLine );
-                else
-                    context.pixelValue( lon, lat, scanLine );
-            }
+    //          Uncomment the crossingPoleArea line to check precise 
+    //          rendering around north pole:
 
-            ++scanLine;
-        }
+    //            if ( !crossingPoleArea )
+                if ( x < imageWidth ) {
+                    if ( highQuality )
+                        context.pixelValueF( lon, lat, scanLine );
+                    else
+                        context.pixelValue( lon, lat, scanLine );
+                }
+
+                ++scanLine;
+            }
 
-        // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yBottom ) { 
+            // copy scanline to improve performance
+            if ( interlaced && y + 1 < yEnd ) { 
 
-            const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
+                const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
-            memcpy( m_canvasImage->scanLine( y + 1 ) + xLeft * pixelByteSize, 
-                    m_canvasImage->scanLine( y ) + xLeft * pixelByteSize, 
-                    ( xRight - xLeft ) * pixelByteSize );
-            ++y;
+                memcpy( m_canvasImage->scanLine( y + 1 ) + xLeft * pixelByteSize, 
+                        m_canvasImage->scanLine( y ) + xLeft * pixelByteSize, 
+                        ( xRight - xLeft ) * pixelByteSize );
+                ++y;
+            }
         }
+
+        ++bands;
     }
+
+    m_scheduler->addWorkerStatistics( bands, timer.elapsed() );
 }
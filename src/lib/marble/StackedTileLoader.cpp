@@ -31,9 +31,14 @@
 #include "TileLoaderHelper.h"
 #include "MarbleGlobal.h"
 
+#include <QAtomicInt>
 #include <QCache>
 #include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QReadWriteLock>
+#include <QSet>
+#include <QWaitCondition>
 #include <QImage>
 
 
@@ -43,18 +48,54 @@ namespace Marble
 class StackedTileLoaderPrivate
 {
 public:
+    /**
+     * The tiles on display are distributed over several independently locked
+     * shards, so render jobs working on different parts of the map don't
+     * contend for a single lock.
+     */
+    struct Shard
+    {
+        QReadWriteLock m_lock;
+        QHash <TileId, StackedTile*>  m_tilesOnDisplay;
+        // tiles currently being loaded by some thread, guarded by m_lock
+        QSet <TileId>  m_pendingLoads;
+        QWaitCondition m_loadFinished;
+    };
+
+    enum { ShardCount = 16 };
+
     StackedTileLoaderPrivate( MergedLayerDecorator *mergedLayerDecorator )
-        : m_layerDecorator( mergedLayerDecorator )
+        : m_layerDecorator( mergedLayerDecorator ),
+      m_generation( 0 )
     {
         m_tileCache.setMaxCost( 20000 * 1024 ); // Cache size measured in bytes
     }
 
+    Shard &shard( const TileId &stackedTileId )
+    {
+        // Spreads neighboring tiles over different shards, which is not
+        // the case for the lower bits of qHash( TileId ).
+        const uint index = uint( stackedTileId.x() * 31 + stackedTileId.y() );
+        return m_shards[ index % ShardCount ];
+    }
+
+    StackedTile *takeFromCache( const TileId &stackedTileId );
+
     MergedLayerDecorator *const m_layerDecorator;
-    QHash <TileId, StackedTile*>  m_tilesOnDisplay;
+    Shard m_shards[ShardCount];
     QCache <TileId, StackedTile>  m_tileCache;
-    QReadWriteLock m_cacheLock;
+    QMutex m_cacheMutex;
+    // incremented by clear() and updateTile(), so prefetched tiles that are
+    // outdated by the time their loading finishes get dropped
+    QAtomicInt m_generation;
 };
 
+StackedTile *StackedTileLoaderPrivate::takeFromCache( const TileId &stackedTileId )
+{
+    QMutexLocker locker( &m_cacheMutex );
+    return m_tileCache.take( stackedTileId );
+}
+
 StackedTileLoader::StackedTileLoader( MergedLayerDecorator *mergedLayerDecorator, QObject *parent )
     : QObject( parent ),
       d( new StackedTileLoaderPrivate( mergedLayerDecorator ) )
@@ -63,7 +104,9 @@ StackedTileLoader::StackedTileLoader( MergedLayerDecorator *mergedLayerDecorator
 
 StackedTileLoader::~StackedTileLoader()
 {
-    qDeleteAll( d->m_tilesOnDisplay );
+    for ( int i = 0; i < StackedTileLoaderPrivate::ShardCount; ++i ) {
+        qDeleteAll( d->m_shards[i].m_tilesOnDisplay );
+    }
     delete d;
 }
 
@@ -89,11 +132,14 @@ QSize StackedTileLoader::tileSize() const
 
 void StackedTileLoader::resetTilehash()
 {
-    QHash<TileId, StackedTile*>::const_iterator it = d->m_tilesOnDisplay.constBegin();
-    QHash<TileId, StackedTile*>::const_iterator const end = d->m_tilesOnDisplay.constEnd();
-    for (; it != end; ++it ) {
-        Q_ASSERT( it.value()->used() && "contained in m_tilesOnDisplay should imply used()" );
-        it.value()->setUsed( false );
+    for ( int i = 0; i < StackedTileLoaderPrivate::ShardCount; ++i ) {
+        const QHash<TileId, StackedTile*> &tilesOnDisplay = d->m_shards[i].m_tilesOnDisplay;
+        QHash<TileId, StackedTile*>::const_iterator it = tilesOnDisplay.constBegin();
+        QHash<TileId, StackedTile*>::const_iterator const end = tilesOnDisplay.constEnd();
+        for (; it != end; ++it ) {
+            Q_ASSERT( it.value()->used() && "contained in m_tilesOnDisplay should imply used()" );
+            it.value()->setUsed( false );
+        }
     }
 }
 
@@ -102,86 +148,173 @@ void StackedTileLoader::cleanupTilehash()
     // Make sure that tiles which haven't been used during the last
     // rendering of the map at all get removed from the tile hash.
 
-    QHashIterator<TileId, StackedTile*> it( d->m_tilesOnDisplay );
-    while ( it.hasNext() ) {
-        it.next();
-        if ( !it.value()->used() ) {
-            // If insert call result is false then the cache is too small to store the tile
-            // but the item will get deleted nevertheless and the pointer we have
-            // doesn't get set to zero (so don't delete it in this case or it will crash!)
-            d->m_tileCache.insert( it.key(), it.value(), it.value()->byteCount() );
-            d->m_tilesOnDisplay.remove( it.key() );
+    for ( int i = 0; i < StackedTileLoaderPrivate::ShardCount; ++i ) {
+        StackedTileLoaderPrivate::Shard &shard = d->m_shards[i];
+        // always lock the shard before the cache
+        QWriteLocker shardLocker( &shard.m_lock );
+        QMutexLocker locker( &d->m_cacheMutex );
+
+        QMutableHashIterator<TileId, StackedTile*> it( shard.m_tilesOnDisplay );
+        while ( it.hasNext() ) {
+            it.next();
+            if ( !it.value()->used() ) {
+                // If insert call result is false then the cache is too small to store the tile
+                // but the item will get deleted nevertheless and the pointer we have
+                // doesn't get set to zero (so don't delete it in this case or it will crash!)
+                d->m_tileCache.insert( it.key(), it.value(), it.value()->byteCount() );
+                it.remove();
+            }
         }
     }
 }
 
 const StackedTile* StackedTileLoader::loadTile( TileId const & stackedTileId )
 {
+    StackedTileLoaderPrivate::Shard &shard = d->shard( stackedTileId );
+
     // check if the tile is in the hash
-    d->m_cacheLock.lockForRead();
-    StackedTile * stackedTile = d->m_tilesOnDisplay.value( stackedTileId, 0 );
-    d->m_cacheLock.unlock();
+    shard.m_lock.lockForRead();
+    StackedTile * stackedTile = shard.m_tilesOnDisplay.value( stackedTileId, 0 );
+    shard.m_lock.unlock();
     if ( stackedTile ) {
         stackedTile->setUsed( true );
         return stackedTile;
     }
     // here ends the performance critical section of this method
 
-    d->m_cacheLock.lockForWrite();
+    shard.m_lock.lockForWrite();
+
+    // Has another thread loaded our tile due to a race condition or is it
+    // still busy loading it? In the latter case wait for its result instead
+    // of loading the tile a second time.
+    forever {
+        stackedTile = shard.m_tilesOnDisplay.value( stackedTileId, 0 );
+        if ( stackedTile ) {
+            stackedTile->setUsed( true );
+            shard.m_lock.unlock();
+            return stackedTile;
+        }
 
-    // has another thread loaded our tile due to a race condition?
-    stackedTile = d->m_tilesOnDisplay.value( stackedTileId, 0 );
-    if ( stackedTile ) {
-        Q_ASSERT( stackedTile->used() && "other thread should have marked tile as used" );
-        d->m_cacheLock.unlock();
-        return stackedTile;
+        if ( !shard.m_pendingLoads.contains( stackedTileId ) ) {
+            break;
+        }
+
+        shard.m_loadFinished.wait( &shard.m_lock );
     }
 
+    shard.m_pendingLoads.insert( stackedTileId );
+    shard.m_lock.unlock();
+
+    // The tile is loaded without holding any lock, so other threads can
+    // keep on rendering and loading other tiles in the meantime.
+
     // the tile was not in the hash so check if it is in the cache
-    stackedTile = d->m_tileCache.take( stackedTileId );
+    stackedTile = d->takeFromCache( stackedTileId );
+    const bool fromDisk = ( stackedTile == 0 );
+
     if ( stackedTile ) {
         Q_ASSERT( !stackedTile->used() && "tiles in m_tileCache are invisible and should thus be marked as unused" );
-        stackedTile->setUsed( true );
-        d->m_tilesOnDisplay[ stackedTileId ] = stackedTile;
-        d->m_cacheLock.unlock();
-        return stackedTile;
     }
+    else {
+        // tile (valid) has not been found in hash or cache, so load it from disk
+        // and place it in the hash from where it will get transferred to the cache
 
-    // tile (valid) has not been found in hash or cache, so load it from disk
-    // and place it in the hash from where it will get transferred to the cache
+        mDebug() << "load tile from disk:" << stackedTileId;
 
-    mDebug() << "load tile from disk:" << stackedTileId;
+        stackedTile = d->m_layerDecorator->loadTile( stackedTileId );
+        Q_ASSERT( stackedTile );
+    }
 
-    stackedTile = d->m_layerDecorator->loadTile( stackedTileId );
-    Q_ASSERT( stackedTile );
     stackedTile->setUsed( true );
 
-    d->m_tilesOnDisplay[ stackedTileId ] = stackedTile;
-    d->m_cacheLock.unlock();
+    shard.m_lock.lockForWrite();
+    shard.m_tilesOnDisplay[ stackedTileId ] = stackedTile;
+    shard.m_pendingLoads.remove( stackedTileId );
+    shard.m_loadFinished.wakeAll();
+    shard.m_lock.unlock();
 
-    emit tileLoaded( stackedTileId );
+    if ( fromDisk ) {
+        emit tileLoaded( stackedTileId );
+    }
 
     return stackedTile;
 }
 
+void StackedTileLoader::prefetchTile( TileId const &stackedTileId )
+{
+    StackedTileLoaderPrivate::Shard &shard = d->shard( stackedTileId );
+
+    {
+        QWriteLocker locker( &shard.m_lock );
+        if ( shard.m_tilesOnDisplay.contains( stackedTileId ) || shard.m_pendingLoads.contains( stackedTileId ) ) {
+            return;
+        }
+
+        QMutexLocker cacheLocker( &d->m_cacheMutex );
+        if ( d->m_tileCache.contains( stackedTileId ) ) {
+            return;
+        }
+
+        shard.m_pendingLoads.insert( stackedTileId );
+    }
+
+    const int generation = d->m_generation;
+
+    mDebug() << "prefetch tile from disk:" << stackedTileId;
+
+    // Missing or expired tiles are left to the render path, which triggers
+    // their download once they actually become visible.
+    StackedTile *const stackedTile = d->m_layerDecorator->loadLocalTile( stackedTileId );
+    if ( stackedTile ) {
+        stackedTile->setUsed( false );
+
+        QMutexLocker cacheLocker( &d->m_cacheMutex );
+        if ( generation == d->m_generation ) {
+            d->m_tileCache.insert( stackedTileId, stackedTile, stackedTile->byteCount() );
+        }
+        else {
+            delete stackedTile;
+        }
+    }
+
+    QWriteLocker locker( &shard.m_lock );
+    shard.m_pendingLoads.remove( stackedTileId );
+    shard.m_loadFinished.wakeAll();
+}
+
 quint64 StackedTileLoader::volatileCacheLimit() const
 {
+    QMutexLocker locker( &d->m_cacheMutex );
     return d->m_tileCache.maxCost() / 1024;
 }
 
 QList<TileId> StackedTileLoader::visibleTiles() const
 {
-    return d->m_tilesOnDisplay.keys();
+    QList<TileId> result;
+    for ( int i = 0; i < StackedTileLoaderPrivate::ShardCount; ++i ) {
+        QReadLocker locker( &d->m_shards[i].m_lock );
+        result += d->m_shards[i].m_tilesOnDisplay.keys();
+    }
+
+    return result;
 }
 
 int StackedTileLoader::tileCount() const
 {
-    return d->m_tileCache.count() + d->m_tilesOnDisplay.count();
+    int count = 0;
+    for ( int i = 0; i < StackedTileLoaderPrivate::ShardCount; ++i ) {
+        QReadLocker locker( &d->m_shards[i].m_lock );
+        count += d->m_shards[i].m_tilesOnDisplay.count();
+    }
+
+    QMutexLocker locker( &d->m_cacheMutex );
+    return d->m_tileCache.count() + count;
 }
 
 void StackedTileLoader::setVolatileCacheLimit( quint64 kiloBytes )
 {
     mDebug() << QString("Setting tile cache to %1 kilobytes.").arg( kiloBytes );
+    QMutexLocker locker( &d->m_cacheMutex );
     d->m_tileCache.setMaxCost( kiloBytes * 1024 );
 }
 
@@ -189,19 +322,40 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
 {
     const TileId stackedTileId( 0, tileId.zoomLevel(), tileId.x(), tileId.y() );
 
-    StackedTile * displayedTile = d->m_tilesOnDisplay.take( stackedTileId );
+    StackedTileLoaderPrivate::Shard &shard = d->shard( stackedTileId );
+
+    shard.m_lock.lockForWrite();
+    StackedTile * displayedTile = shard.m_tilesOnDisplay.take( stackedTileId );
     if ( displayedTile ) {
-        Q_ASSERT( !d->m_tileCache.contains( stackedTileId ) );
+        // Keeps loadTile() and prefetchTile() from loading the outdated
+        // tile again while it is off display.
+        shard.m_pendingLoads.insert( stackedTileId );
+    }
+    shard.m_lock.unlock();
+
+    if ( displayedTile ) {
+        {
+            QMutexLocker locker( &d->m_cacheMutex );
+            d->m_tileCache.remove( stackedTileId );
+        }
 
         StackedTile *const stackedTile = d->m_layerDecorator->updateTile( *displayedTile, tileId, tileImage );
         stackedTile->setUsed( true );
-        d->m_tilesOnDisplay.insert( stackedTileId, stackedTile );
+
+        shard.m_lock.lockForWrite();
+        shard.m_tilesOnDisplay.insert( stackedTileId, stackedTile );
+        shard.m_pendingLoads.remove( stackedTileId );
+        shard.m_loadFinished.wakeAll();
+        shard.m_lock.unlock();
 
         delete displayedTile;
         displayedTile = 0;
 
         emit tileLoaded( stackedTileId );
     } else {
+        QMutexLocker locker( &d->m_cacheMutex );
+        // drops a prefetched copy of the outdated tile that is still being loaded
+        d->m_generation.ref();
         d->m_tileCache.remove( stackedTileId );
     }
 }
@@ -209,10 +363,13 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
 RenderState StackedTileLoader::renderState() const
 {
     RenderState renderState( "Stacked Tiles" );
-    QHash<TileId, StackedTile*>::const_iterator it = d->m_tilesOnDisplay.constBegin();
-    QHash<TileId, StackedTile*>::const_iterator const end = d->m_tilesOnDisplay.constEnd();
-    for (; it != end; ++it ) {
-        renderState.addChild( d->m_layerDecorator->renderState( it.key() ) );
+    for ( int i = 0; i < StackedTileLoaderPrivate::ShardCount; ++i ) {
+        QReadLocker locker( &d->m_shards[i].m_lock );
+        QHash<TileId, StackedTile*>::const_iterator it = d->m_shards[i].m_tilesOnDisplay.constBegin();
+        QHash<TileId, StackedTile*>::const_iterator const end = d->m_shards[i].m_tilesOnDisplay.constEnd();
+        for (; it != end; ++it ) {
+            renderState.addChild( d->m_layerDecorator->renderState( it.key() ) );
+        }
     }
     return renderState;
 }
@@ -221,9 +378,17 @@ void StackedTileLoader::clear()
 {
     mDebug() << Q_FUNC_INFO;
 
-    qDeleteAll( d->m_tilesOnDisplay );
-    d->m_tilesOnDisplay.clear();
-    d->m_tileCache.clear(); // clear the tile cache in physical memory
+    for ( int i = 0; i < StackedTileLoaderPrivate::ShardCount; ++i ) {
+        QWriteLocker locker( &d->m_shards[i].m_lock );
+        qDeleteAll( d->m_shards[i].m_tilesOnDisplay );
+        d->m_shards[i].m_tilesOnDisplay.clear();
+    }
+
+    {
+        QMutexLocker locker( &d->m_cacheMutex );
+        d->m_generation.ref();
+        d->m_tileCache.clear(); // clear the tile cache in physical memory
+    }
 
     emit cleared();
 }
@@ -86,6 +86,16 @@ class StackedTileLoader : public QObject
          */
         const StackedTile* loadTile( TileId const &stackedTileId );
 
+        /**
+         * Loads a tile into the volatile cache unless it is already in memory,
+         * so a later call of loadTile() doesn't need to wait for its decoding.
+         * Thread-safe; does not mark the tile as being on display. Tiles that
+         * are not locally available are skipped rather than downloaded.
+         *
+         * @param stackedTileId The Id of the tile that is likely to be needed soon.
+         */
+        void prefetchTile( TileId const &stackedTileId );
+
         /**
          * Resets the internal tile hash.
          */
@@ -44,19 +44,55 @@ public:
     SunLocatorPrivate( const MarbleClock *clock, const Planet *planet )
         : m_lon( 0.0 ),
           m_lat( 0.0 ),
+          m_twilightZone( twilightZone( planet ) ),
           m_clock( clock ),
           m_planet( planet )
     {
     }
 
+    static qreal twilightZone( const Planet *planet );
+
+    qreal brightness( qreal h ) const;
+
     qreal m_lon;
     qreal m_lat;
+    qreal m_twilightZone;
 
     const MarbleClock *const m_clock;
     const Planet *m_planet;
 };
 
 
+qreal SunLocatorPrivate::twilightZone( const Planet *planet )
+{
+    const QString planetId = planet->id();
+    if ( planetId == "earth" || planetId == "venus") {
+        return 0.1; // this equals 18 deg astronomical twilight.
+    }
+    else if ( planetId == "mars" ) {
+        return 0.05;
+    }
+
+    return 0.0;
+}
+
+qreal SunLocatorPrivate::brightness( qreal h ) const
+{
+    /*
+      h = 0.0 // directly beneath sun
+      h = 0.5 // sunrise/sunset line
+      h = 1.0 // opposite side of earth to the sun
+      theta = 2*asin(sqrt(h))
+    */
+
+    if ( h <= 0.5 - m_twilightZone / 2.0 )
+        return 1.0;
+    else if ( h >= 0.5 + m_twilightZone / 2.0 )
+        return 0.0;
+    else
+        return ( 0.5 + m_twilightZone/2.0 - h ) / m_twilightZone;
+}
+
 SunLocator::SunLocator( const MarbleClock *clock, const Planet *planet )
   : QObject(),
     d( new SunLocatorPrivate( clock, planet ))
@@ -101,32 +137,17 @@ qreal SunLocator::shading(qreal lon, qreal a, qreal c) const
 //    qreal h = (g*g)+cos(lat)*cos(d->m_lat)*(b*b); 
     qreal h = (a*a) + c * (b*b); 
 
-    /*
-      h = 0.0 // directly beneath sun
-      h = 0.5 // sunrise/sunset line
-      h = 1.0 // opposite side of earth to the sun
-      theta = 2*asin(sqrt(h))
-    */
-
-    qreal twilightZone = 0.0;
-
-    QString planetId = d->m_planet->id();
-    if ( planetId == "earth" || planetId == "venus") {
-        twilightZone = 0.1; // this equals 18 deg astronomical twilight.
-    }
-    else if ( planetId == "mars" ) {
-        twilightZone = 0.05;
-    }
+    return d->brightness( h );
+}
 
-    qreal brightness;
-    if ( h <= 0.5 - twilightZone / 2.0 )
-        brightness = 1.0;
-    else if ( h >= 0.5 + twilightZone / 2.0 )
-        brightness = 0.0;
-    else
-        brightness = ( 0.5 + twilightZone/2.0 - h ) / twilightZone;
+qreal SunLocator::shading( qreal lon, qreal lat ) const
+{
+    // haversine of the angular distance to the subsolar point,
+    // derived from the spherical law of cosines
+    const qreal cosDistance = sin( lat ) * sin( d->m_lat )
+                            + cos( lat ) * cos( d->m_lat ) * cos( lon - d->m_lon );
 
-    return brightness;
+    return d->brightness( 0.5 * ( 1.0 - cosDistance ) );
 }
 
 void SunLocator::shadePixel(QRgb& pixcol, qreal brightness) const
@@ -200,6 +221,7 @@ void SunLocator::setPlanet( const Planet *planet )
 
     mDebug() << "SunLocator::setPlanet(Planet*)";
     d->m_planet = planet;
+    d->m_twilightZone = SunLocatorPrivate::twilightZone( planet );
     updatePosition();
 
     // Initially there might be no planet set.
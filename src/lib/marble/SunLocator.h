@@ -39,6 +39,14 @@ class MARBLE_EXPORT SunLocator : public QObject
     virtual ~SunLocator();
 
     qreal shading(qreal lon, qreal a, qreal c) const;
+
+    /**
+     * Returns the brightness at the given position, 1.0 at daylight and 0.0 at night.
+     *
+     * @param lon longitude in radians
+     * @param lat latitude in radians
+     */
+    qreal shading( qreal lon, qreal lat ) const;
     void  shadePixel(QRgb& pixcol, qreal shade) const;
     void  shadePixelComposite(QRgb& pixcol, const QRgb& dpixcol, qreal shade) const;
 
@@ -0,0 +1,143 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "SunShadingOverlay.h"
+
+#include <QVector>
+
+#include "GeoPainter.h"
+#include "SunLocator.h"
+#include "ViewportParams.h"
+
+namespace Marble
+{
+
+SunShadingOverlay::SunShadingOverlay( const SunLocator *sunLocator )
+    : m_sunLocator( sunLocator ),
+      m_hasShade( false ),
+      m_shadeImageValid( false ),
+      m_shadeImageRadius( 0 ),
+      m_shadeImageProjection( Spherical ),
+      m_shadeImageSunLon( 0.0 ),
+      m_shadeImageSunLat( 0.0 )
+{
+}
+
+void SunShadingOverlay::paint( GeoPainter *painter, const ViewportParams *viewport )
+{
+    if ( isShadeImageOutdated( viewport ) ) {
+        updateShadeImage( viewport );
+    }
+
+    if ( !m_hasShade ) {
+        return;
+    }
+
+    painter->save();
+
+    if ( !viewport->mapCoversViewport() ) {
+        painter->setClipPath( viewport->mapShape() );
+    }
+
+    // The center of grid cell (i, j) is stretched onto the pixel the sample
+    // was taken at, (i * CellSize, j * CellSize).
+    const QRectF target( -0.5 * CellSize, -0.5 * CellSize,
+                         m_shadeImage.width() * CellSize, m_shadeImage.height() * CellSize );
+
+    painter->setRenderHint( QPainter::SmoothPixmapTransform, true );
+    painter->drawImage( target, m_shadeImage );
+
+    painter->restore();
+}
+
+bool SunShadingOverlay::isShadeImageOutdated( const ViewportParams *viewport ) const
+{
+    return !m_shadeImageValid
+        || m_shadeImageSize != viewport->size()
+        || m_shadeImageRadius != viewport->radius()
+        || !( m_shadeImagePlanetAxis == viewport->planetAxis() )
+        || m_shadeImageProjection != viewport->projection()
+        || m_shadeImageSunLon != m_sunLocator->getLon()
+        || m_shadeImageSunLat != m_sunLocator->getLat();
+}
+
+void SunShadingOverlay::updateShadeImage( const ViewportParams *viewport )
+{
+    const int gridWidth = viewport->width() / CellSize + 2;
+    const int gridHeight = viewport->height() / CellSize + 2;
+
+    // brightness of each sample, -1 for samples beyond the edge of the map
+    QVector<qreal> brightness( gridWidth * gridHeight, -1.0 );
+
+    for ( int j = 0; j < gridHeight; ++j ) {
+        for ( int i = 0; i < gridWidth; ++i ) {
+            qreal lon;
+            qreal lat;
+            if ( viewport->geoCoordinates( i * CellSize, j * CellSize, lon, lat, GeoDataCoordinates::Radian ) ) {
+                brightness[j * gridWidth + i] = m_sunLocator->shading( lon, lat );
+            }
+        }
+    }
+
+    // Samples just beyond the edge of the map still contribute to the
+    // interpolated pixels next to the edge, so give them the brightness
+    // of a neighbouring sample on the map.
+    QVector<qreal> extended = brightness;
+    for ( int j = 0; j < gridHeight; ++j ) {
+        for ( int i = 0; i < gridWidth; ++i ) {
+            if ( brightness[j * gridWidth + i] >= 0.0 ) {
+                continue;
+            }
+
+            for ( int dj = -1; dj <= 1 && extended[j * gridWidth + i] < 0.0; ++dj ) {
+                for ( int di = -1; di <= 1; ++di ) {
+                    const int ni = i + di;
+                    const int nj = j + dj;
+                    if ( ni < 0 || ni >= gridWidth || nj < 0 || nj >= gridHeight ) {
+                        continue;
+                    }
+                    if ( brightness[nj * gridWidth + ni] >= 0.0 ) {
+                        extended[j * gridWidth + i] = brightness[nj * gridWidth + ni];
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    if ( m_shadeImage.size() != QSize( gridWidth, gridHeight ) ) {
+        m_shadeImage = QImage( gridWidth, gridHeight, QImage::Format_ARGB32_Premultiplied );
+    }
+
+    m_hasShade = false;
+
+    for ( int j = 0; j < gridHeight; ++j ) {
+        QRgb *scanLine = reinterpret_cast<QRgb *>( m_shadeImage.scanLine( j ) );
+        for ( int i = 0; i < gridWidth; ++i ) {
+            const qreal shade = extended[j * gridWidth + i];
+
+            // Painting black with an opacity of 1 - d scales the colors of
+            // the map by d, see SunLocator::shadePixel().
+            const int alpha = shade < 0.0 ? 0 : qRound( 255 * 0.65 * ( 1.0 - shade ) );
+            scanLine[i] = qRgba( 0, 0, 0, alpha );
+            m_hasShade |= ( alpha != 0 );
+        }
+    }
+
+    m_shadeImageValid = true;
+    m_shadeImageSize = viewport->size();
+    m_shadeImageRadius = viewport->radius();
+    m_shadeImagePlanetAxis = viewport->planetAxis();
+    m_shadeImageProjection = viewport->projection();
+    m_shadeImageSunLon = m_sunLocator->getLon();
+    m_shadeImageSunLat = m_sunLocator->getLat();
+}
+
+}
@@ -0,0 +1,72 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_SUNSHADINGOVERLAY_H
+#define MARBLE_SUNSHADINGOVERLAY_H
+
+#include <QImage>
+#include <QSize>
+
+#include "MarbleGlobal.h"
+#include "Quaternion.h"
+
+namespace Marble
+{
+
+class GeoPainter;
+class SunLocator;
+class ViewportParams;
+
+/**
+ * @short Darkens the night side of the map after the texture has been mapped.
+ *
+ * The brightness is sampled on a coarse grid in screen space, one sample
+ * every CellSize pixels. The grid is kept as a small translucent black
+ * image which is stretched over the viewport with bilinear filtering, so
+ * painting it costs a single drawImage() call. The grid is only sampled
+ * again when the viewport or the position of the sun changes.
+ *
+ * Because the shading isn't part of the texture tiles any longer, the tiles
+ * in the tile cache stay valid when the time of day changes.
+ */
+class SunShadingOverlay
+{
+ public:
+    explicit SunShadingOverlay( const SunLocator *sunLocator );
+
+    /**
+     * @brief Paints the shading of @p viewport on top of the texture.
+     */
+    void paint( GeoPainter *painter, const ViewportParams *viewport );
+
+ private:
+    enum { CellSize = 8 };
+
+    bool isShadeImageOutdated( const ViewportParams *viewport ) const;
+    void updateShadeImage( const ViewportParams *viewport );
+
+    const SunLocator *const m_sunLocator;
+
+    QImage m_shadeImage;
+    bool m_hasShade;
+
+    // the state m_shadeImage was sampled for
+    bool m_shadeImageValid;
+    QSize m_shadeImageSize;
+    int m_shadeImageRadius;
+    Quaternion m_shadeImagePlanetAxis;
+    Projection m_shadeImageProjection;
+    qreal m_shadeImageSunLon;
+    qreal m_shadeImageSunLat;
+};
+
+}
+
+#endif
@@ -15,6 +15,7 @@
 
 #include <qmath.h>
 #include <QFile>
+#include <QRunnable>
 #include <QSharedPointer>
 #include <QString>
 #include <QVector>
@@ -38,6 +39,22 @@
 namespace Marble
 {
 
+// Blends two colors with integer arithmetics, processing two channels per
+// operation: red and blue as well as alpha and green share a 32 bit integer,
+// each in its own 16 bit lane. Division by 255 is rounded.
+static inline QRgb blend( QRgb landColor, QRgb waterColor, uint alpha )
+{
+    const uint beta = 255 - alpha;
+
+    uint redBlue = ( landColor & 0xff00ff ) * alpha + ( waterColor & 0xff00ff ) * beta + 0x800080;
+    redBlue = ( ( redBlue + ( ( redBlue >> 8 ) & 0xff00ff ) ) >> 8 ) & 0xff00ff;
+
+    uint green = ( ( landColor >> 8 ) & 0xff ) * alpha + ( ( waterColor >> 8 ) & 0xff ) * beta + 0x80;
+    green = ( ( green + ( green >> 8 ) ) >> 8 ) & 0xff;
+
+    return 0xff000000 | redBlue | ( green << 8 );
+}
+
 class EmbossFifo
 {
 public:
@@ -68,9 +85,57 @@ private:
 };
 
 
+class TextureColorizer::ColorizeJob : public QRunnable
+{
+public:
+    ColorizeJob( const TextureColorizer *colorizer, QImage *canvasImage, ScanlineBandScheduler *scheduler,
+                 qint64 radius, bool clippedToDisc );
+
+    virtual void run();
+
+private:
+    const TextureColorizer *const m_colorizer;
+    QImage *const m_canvasImage;
+    ScanlineBandScheduler *const m_scheduler;
+    const qint64 m_radius;
+    const bool m_clippedToDisc;
+};
+
+TextureColorizer::ColorizeJob::ColorizeJob( const TextureColorizer *colorizer, QImage *canvasImage, ScanlineBandScheduler *scheduler,
+                                            qint64 radius, bool clippedToDisc )
+    : m_colorizer( colorizer ),
+      m_canvasImage( canvasImage ),
+      m_scheduler( scheduler ),
+      m_radius( radius ),
+      m_clippedToDisc( clippedToDisc )
+{
+}
+
+void TextureColorizer::ColorizeJob::run()
+{
+    QTime timer;
+    timer.start();
+
+    int bands = 0;
+    int yStart = 0;
+    int yEnd = 0;
+
+    while ( m_scheduler->nextBand( yStart, yEnd ) ) {
+        m_colorizer->colorizeLines( m_canvasImage, yStart, yEnd, m_radius, m_clippedToDisc );
+        ++bands;
+    }
+
+    m_scheduler->addWorkerStatistics( bands, timer.elapsed() );
+}
+
+
 TextureColorizer::TextureColorizer( const QString &seafile,
                                     const QString &landfile )
-    : m_showRelief( false ),
+    : m_coastImageValid( false ),
+      m_coastImageRadius( 0 ),
+      m_coastImageProjection( Spherical ),
+      m_coastImageMapQuality( NormalQuality ),
+      m_showRelief( false ),
       m_landColor(qRgb( 255, 0, 0 ) ),
       m_seaColor( qRgb( 0, 255, 0 ) )
 {
@@ -151,11 +216,13 @@ TextureColorizer::TextureColorizer( const QString &seafile,
 void TextureColorizer::addSeaDocument( const GeoDataDocument *seaDocument )
 {
     m_seaDocuments.append( seaDocument );
+    m_coastImageValid = false;
 }
 
 void TextureColorizer::addLandDocument( const GeoDataDocument *landDocument )
 {
     m_landDocuments.append( landDocument );
+    m_coastImageValid = false;
 }
 
 void TextureColorizer::setShowRelief( bool show )
@@ -226,12 +293,32 @@ void TextureColorizer::drawTextureMap( GeoPainter *painter )
     }
 }
 
-void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality )
+bool TextureColorizer::isCoastImageOutdated( const ViewportParams *viewport, MapQuality mapQuality ) const
+{
+    if ( !m_coastImageValid
+         || m_coastImageSize != viewport->size()
+         || m_coastImageRadius != viewport->radius()
+         || !( m_coastImagePlanetAxis == viewport->planetAxis() )
+         || m_coastImageProjection != viewport->projection()
+         || m_coastImageMapQuality != mapQuality
+         || m_coastImageSeaVisibility.size() != m_seaDocuments.size() ) {
+        return true;
+    }
+
+    for ( int i = 0; i < m_seaDocuments.size(); ++i ) {
+        if ( m_coastImageSeaVisibility[i] != m_seaDocuments[i]->isVisible() ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TextureColorizer::updateCoastImage( const ViewportParams *viewport, MapQuality mapQuality )
 {
     if ( m_coastImage.size() != viewport->size() )
         m_coastImage = QImage( viewport->size(), QImage::Format_RGB32 );
 
-    // update coast image
     m_coastImage.fill( QColor( 0, 0, 255, 0).rgb() );
 
     const bool antialiased =    mapQuality == HighQuality
@@ -242,6 +329,26 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
 
     drawTextureMap( &painter );
 
+    m_coastImageValid = true;
+    m_coastImageSize = viewport->size();
+    m_coastImageRadius = viewport->radius();
+    m_coastImagePlanetAxis = viewport->planetAxis();
+    m_coastImageProjection = viewport->projection();
+    m_coastImageMapQuality = mapQuality;
+    m_coastImageSeaVisibility.resize( m_seaDocuments.size() );
+    for ( int i = 0; i < m_seaDocuments.size(); ++i ) {
+        m_coastImageSeaVisibility[i] = m_seaDocuments[i]->isVisible();
+    }
+}
+
+void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality )
+{
+    // The coast image only depends on the viewport, so repaints caused by
+    // e.g. newly loaded tiles don't need to paint the coast lines again.
+    if ( isCoastImageOutdated( viewport, mapQuality ) ) {
+        updateCoastImage( viewport, mapQuality );
+    }
+
     const qint64 radius = viewport->radius() * viewport->currentProjection()->clippingRadius();
 
     const int  imgheight = origimg->height();
@@ -251,14 +358,13 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
     // This variable is not used anywhere..
     const int  imgradius = imgrx * imgrx + imgry * imgry;
 
-    int     bump = 8;
+    int yTop = 0;
+    int yBottom = imgheight;
+    bool clippedToDisc = false;
 
     if ( radius * radius > imgradius
          || !viewport->currentProjection()->isClippedToSphere() )
     {
-        int yTop = 0;
-        int yBottom = imgheight;
-
         if( !viewport->currentProjection()->isClippedToSphere() && !viewport->currentProjection()->traversablePoles() )
         {
             qreal realYTop, realYBottom, dummyX;
@@ -269,103 +375,82 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
             yTop = qBound(qreal(0.0), realYTop, qreal(imgheight));
             yBottom = qBound(qreal(0.0), realYBottom, qreal(imgheight));
         }
+    }
+    else {
+        yTop    = ( imgry-radius < 0 ) ? 0 : imgry-radius;
+        yBottom = ( yTop == 0 ) ? imgheight : imgry + radius;
+        clippedToDisc = true;
+    }
 
-        const int itEnd = yBottom;
-
-        for (int y = yTop; y < itEnd; ++y) {
-
-            QRgb  *writeData         = (QRgb*)( origimg->scanLine( y ) );
-            const QRgb  *coastData   = (QRgb*)( m_coastImage.scanLine( y ) );
-
-            uchar *readDataStart     = origimg->scanLine( y );
-            const uchar *readDataEnd = readDataStart + imgwidth*4;
+    m_scheduler.reset( yTop, yBottom );
 
-            EmbossFifo  emboss;
+    const int numThreads = m_threadPool.maxThreadCount();
+    for ( int i = 0; i < numThreads; ++i ) {
+        m_threadPool.start( new ColorizeJob( this, origimg, &m_scheduler, radius, clippedToDisc ) );
+    }
 
-            for ( uchar* readData = readDataStart; 
-                  readData < readDataEnd;
-                  readData += 4, ++writeData, ++coastData )
-            {
+    m_threadPool.waitForDone();
+}
 
-                // Cheap Emboss / Bumpmapping
-                uchar&  grey = *readData; // qBlue(*data);
+void TextureColorizer::colorizeLines( QImage *origimg, int yStart, int yEnd, qint64 radius, bool clippedToDisc ) const
+{
+    const int  imgwidth  = origimg->width();
+    const int  imgrx     = imgwidth / 2;
+    const int  imgry     = origimg->height() / 2;
 
-                if ( m_showRelief ) {
-                    emboss << grey;
-                    bump = ( emboss.head() + 8 - grey );
-                    if ( bump  < 0 )  bump = 0;
-                    if ( bump  > 15 ) bump = 15;
-                }
-                setPixel( coastData, writeData, bump, grey );
-            }
-        }
-    }
-    else {
-        int yTop    = ( imgry-radius < 0 ) ? 0 : imgry-radius;
-        const int yBottom = ( yTop == 0 ) ? imgheight : imgry + radius;
+    // The emboss effect is a little weaker on the globe.
+    const int bumpOffset = clippedToDisc ? 16 : 8;
+    const int bumpShift  = clippedToDisc ? 1 : 0;
 
-        EmbossFifo  emboss;
+    for ( int y = yStart; y < yEnd; ++y ) {
+        int  xLeft  = 0;
+        int  xRight = imgwidth;
 
-        for ( int y = yTop; y < yBottom; ++y ) {
+        if ( clippedToDisc ) {
             const int  dy = imgry - y;
-            int  rx = (int)sqrt( (qreal)( radius * radius - dy * dy ) );
-            int  xLeft  = 0; 
-            int  xRight = imgwidth;
+            const int  rx = (int)sqrt( (qreal)( radius * radius - dy * dy ) );
 
             if ( imgrx-rx > 0 ) {
-                xLeft  = imgrx - rx; 
+                xLeft  = imgrx - rx;
                 xRight = imgrx + rx;
             }
+        }
 
-            QRgb  *writeData         = (QRgb*)( origimg->scanLine( y ) )  + xLeft;
-            const QRgb *coastData    = (QRgb*)( m_coastImage.scanLine( y ) ) + xLeft;
-
-            uchar *readDataStart     = origimg->scanLine( y ) + xLeft * 4;
-            const uchar *readDataEnd = origimg->scanLine( y ) + xRight * 4;
+        // The canvas is colorized in place: the grey value of each pixel is
+        // read from its blue channel right before the pixel gets overwritten.
+        QRgb  *writeData         = (QRgb*)( origimg->scanLine( y ) ) + xLeft;
+        const QRgb *const writeEnd = (QRgb*)( origimg->scanLine( y ) ) + xRight;
+        const QRgb  *coastData   = (const QRgb*)( m_coastImage.scanLine( y ) ) + xLeft;
 
- 
-            for ( uchar* readData = readDataStart;
-                  readData < readDataEnd;
-                  readData += 4, ++writeData, ++coastData )
-            {
-                // Cheap Emboss / Bumpmapping
+        EmbossFifo  emboss;
+        int     bump = 8;
 
-                uchar& grey = *readData; // qBlue(*data);
+        for ( ; writeData < writeEnd; ++writeData, ++coastData ) {
+            const uchar grey = qBlue( *writeData );
 
-                if ( m_showRelief ) {
-                    emboss << grey;
-                    bump = ( emboss.head() + 16 - grey ) >> 1;
-                    if ( bump > 15 ) bump = 15;
-                    if ( bump < 0 )  bump = 0;
-                }
-                setPixel( coastData, writeData, bump, grey );
+            // Cheap Emboss / Bumpmapping
+            if ( m_showRelief ) {
+                emboss << grey;
+                bump = ( emboss.head() + bumpOffset - grey ) >> bumpShift;
+                if ( bump < 0 )  bump = 0;
+                if ( bump > 15 ) bump = 15;
             }
+
+            setPixel( coastData, writeData, bump, grey );
         }
     }
 }
 
-void TextureColorizer::setPixel( const QRgb *coastData, QRgb *writeData, int bump, uchar grey )
+void TextureColorizer::setPixel( const QRgb *coastData, QRgb *writeData, int bump, uchar grey ) const
 {
-    int alpha = qRed( *coastData );
+    const uint alpha = qRed( *coastData );
     if ( alpha == 255 )
         *writeData = texturepalette[bump][grey + 0x100];
     else if( alpha == 0 ){
         *writeData = texturepalette[bump][grey];
     }
     else {
-        qreal c = 1.0 / 255.0;
-
-        QRgb landcolor  = (QRgb)(texturepalette[bump][grey + 0x100]);
-        QRgb watercolor = (QRgb)(texturepalette[bump][grey]);
-
-        *writeData = qRgb(
-                    (int) ( c * ( alpha * qRed( landcolor )
-                                  + ( 255 - alpha ) * qRed( watercolor ) ) ),
-                    (int) ( c * ( alpha * qGreen( landcolor )
-                                  + ( 255 - alpha ) * qGreen( watercolor ) ) ),
-                    (int) ( c * ( alpha * qBlue( landcolor )
-                                  + ( 255 - alpha ) * qBlue( watercolor ) ) )
-                    );
+        *writeData = blend( texturepalette[bump][grey + 0x100], texturepalette[bump][grey], alpha );
     }
 }
 }
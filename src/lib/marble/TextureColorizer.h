@@ -19,11 +19,15 @@
 #include "MarbleGlobal.h"
 #include "GeoDataDocument.h"
 #include "GeoPainter.h"
+#include "Quaternion.h"
+#include "ScanlineBandScheduler.h"
 
 #include <QString>
 #include <QImage>
 #include <QPen>
 #include <QBrush>
+#include <QThreadPool>
+#include <QVector>
 
 namespace Marble
 {
@@ -50,14 +54,31 @@ class TextureColorizer
 
     void colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality );
 
-    void setPixel( const QRgb *coastData, QRgb *writeData, int bump, uchar grey );
+    void setPixel( const QRgb *coastData, QRgb *writeData, int bump, uchar grey ) const;
 
  private:
+    class ColorizeJob;
+
+    bool isCoastImageOutdated( const ViewportParams *viewport, MapQuality mapQuality ) const;
+    void updateCoastImage( const ViewportParams *viewport, MapQuality mapQuality );
+    void colorizeLines( QImage *origimg, int yStart, int yEnd, qint64 radius, bool clippedToDisc ) const;
+
     QString m_seafile;
     QString m_landfile;
     QList<const GeoDataDocument*> m_seaDocuments;
     QList<const GeoDataDocument*> m_landDocuments;
     QImage m_coastImage;
+    // The viewport the coast image was painted for. As long as it doesn't
+    // change, the coast image is reused by subsequent calls of colorize().
+    bool m_coastImageValid;
+    QSize m_coastImageSize;
+    int m_coastImageRadius;
+    Quaternion m_coastImagePlanetAxis;
+    Projection m_coastImageProjection;
+    MapQuality m_coastImageMapQuality;
+    QVector<bool> m_coastImageSeaVisibility;
+    QThreadPool m_threadPool;
+    ScanlineBandScheduler m_scheduler;
     uint texturepalette[16][512];
     bool m_showRelief;
     QRgb      m_landColor;
@@ -14,7 +14,8 @@
 using namespace Marble;
 
 TextureMapperInterface::TextureMapperInterface() :
-    m_repaintNeeded( true )
+    m_repaintNeeded( true ),
+    m_canvasReusable( false )
 {
 }
 
@@ -26,4 +27,15 @@ TextureMapperInterface::~TextureMapperInterface()
 void TextureMapperInterface::setRepaintNeeded()
 {
     m_repaintNeeded = true;
+    m_canvasReusable = false;
+}
+
+void TextureMapperInterface::setViewportMoved()
+{
+    m_repaintNeeded = true;
+}
+
+QString TextureMapperInterface::runtimeTrace() const
+{
+    return QString();
 }
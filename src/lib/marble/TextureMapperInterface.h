@@ -12,6 +12,8 @@
 #ifndef MARBLE_TEXTUREMAPPERINTERFACE_H
 #define MARBLE_TEXTUREMAPPERINTERFACE_H
 
+#include <QString>
+
 class QRect;
 
 namespace Marble
@@ -38,8 +40,26 @@ public:
 
     void setRepaintNeeded();
 
+    /**
+     * @brief Requests a repaint because the viewport moved.
+     *
+     * In contrast to setRepaintNeeded() the texture data is still the same,
+     * so mappers that can move the previously mapped canvas only need to
+     * map the newly exposed parts of the map.
+     */
+    void setViewportMoved();
+
+    /**
+     * @brief Returns statistics about the last texture mapping pass,
+     * e.g. how the work was distributed among threads.
+     */
+    virtual QString runtimeTrace() const;
+
 protected:
     bool m_repaintNeeded;
+
+    /// false if the texture data changed since the last mapping pass
+    bool m_canvasReusable;
 };
 
 }
@@ -0,0 +1,260 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "TileArchive.h"
+
+#include <cstring>
+
+#include <QFileInfo>
+#include <QtAlgorithms>
+#include <QtEndian>
+
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+
+using namespace Marble;
+
+static const char MAGIC[] = "MRBLTILE";
+static const int MAGIC_SIZE = 8;
+static const quint32 VERSION = 1;
+static const int HEADER_SIZE = MAGIC_SIZE + 4 + 4 + 8;
+static const int ENTRY_SIZE = 4 + 4 + 4 + 4 + 8;
+
+TileArchive::TileArchive( const QString &fileName )
+    : m_file( fileName ),
+      m_data( 0 ),
+      m_size( 0 ),
+      m_index( 0 ),
+      m_tileCount( 0 )
+{
+    if ( !m_file.open( QIODevice::ReadOnly ) ) {
+        return;
+    }
+
+    m_size = m_file.size();
+    if ( m_size < HEADER_SIZE ) {
+        mDebug() << "Tile archive" << fileName << "is truncated";
+        return;
+    }
+
+    m_data = m_file.map( 0, m_size );
+    if ( !m_data ) {
+        mDebug() << "Cannot map tile archive" << fileName << m_file.errorString();
+        return;
+    }
+
+    const quint32 version = qFromLittleEndian<quint32>( m_data + MAGIC_SIZE );
+    const quint32 tileCount = qFromLittleEndian<quint32>( m_data + MAGIC_SIZE + 4 );
+    const quint64 indexOffset = qFromLittleEndian<quint64>( m_data + MAGIC_SIZE + 8 );
+
+    if ( qstrncmp( reinterpret_cast<const char *>( m_data ), MAGIC, MAGIC_SIZE ) != 0 || version != VERSION
+         || indexOffset < quint64( HEADER_SIZE )
+         || indexOffset + quint64( tileCount ) * ENTRY_SIZE > quint64( m_size ) ) {
+        mDebug() << "Invalid tile archive" << fileName;
+        m_file.unmap( const_cast<uchar *>( m_data ) );
+        m_data = 0;
+        return;
+    }
+
+    m_index = m_data + indexOffset;
+    m_tileCount = tileCount;
+}
+
+TileArchive::~TileArchive()
+{
+    if ( m_data ) {
+        m_file.unmap( const_cast<uchar *>( m_data ) );
+    }
+}
+
+QString TileArchive::themeFileName()
+{
+    return "tiles.marbletiles";
+}
+
+QString TileArchive::themeFilePath( const QString &themeStr )
+{
+    const QString fileName = themeStr + '/' + themeFileName();
+    return QFileInfo( fileName ).isAbsolute() ? fileName : MarbleDirs::path( fileName );
+}
+
+bool TileArchive::isValid() const
+{
+    return m_data != 0;
+}
+
+quint32 TileArchive::tileCount() const
+{
+    return m_tileCount;
+}
+
+int TileArchive::maximumTileLevel() const
+{
+    if ( m_tileCount == 0 ) {
+        return -1;
+    }
+
+    // the index is sorted by level first
+    return qFromLittleEndian<quint32>( m_index + quint64( m_tileCount - 1 ) * ENTRY_SIZE );
+}
+
+bool TileArchive::contains( int level, int x, int y ) const
+{
+    return findEntry( level, x, y ) != 0;
+}
+
+QByteArray TileArchive::tileData( int level, int x, int y ) const
+{
+    const uchar *const entry = findEntry( level, x, y );
+    if ( !entry ) {
+        return QByteArray();
+    }
+
+    const quint32 size = qFromLittleEndian<quint32>( entry + 12 );
+    const quint64 offset = qFromLittleEndian<quint64>( entry + 16 );
+    if ( offset + size > quint64( m_size ) ) {
+        mDebug() << "Invalid tile archive entry" << level << x << y;
+        return QByteArray();
+    }
+
+    return QByteArray::fromRawData( reinterpret_cast<const char *>( m_data + offset ), size );
+}
+
+const uchar *TileArchive::findEntry( int level, int x, int y ) const
+{
+    if ( level < 0 || x < 0 || y < 0 ) {
+        return 0;
+    }
+
+    const quint32 key[3] = { quint32( level ), quint32( y ), quint32( x ) };
+
+    qint64 low = 0;
+    qint64 high = qint64( m_tileCount ) - 1;
+    while ( low <= high ) {
+        const qint64 middle = low + ( high - low ) / 2;
+        const uchar *const entry = m_index + middle * ENTRY_SIZE;
+
+        int comparison = 0;
+        for ( int i = 0; i < 3 && comparison == 0; ++i ) {
+            const quint32 value = qFromLittleEndian<quint32>( entry + 4 * i );
+            comparison = value < key[i] ? -1 : ( value > key[i] ? 1 : 0 );
+        }
+
+        if ( comparison < 0 ) {
+            low = middle + 1;
+        }
+        else if ( comparison > 0 ) {
+            high = middle - 1;
+        }
+        else {
+            return entry;
+        }
+    }
+
+    return 0;
+}
+
+
+bool TileArchiveWriter::Entry::operator<( const Entry &other ) const
+{
+    if ( level != other.level ) {
+        return level < other.level;
+    }
+    if ( y != other.y ) {
+        return y < other.y;
+    }
+    return x < other.x;
+}
+
+TileArchiveWriter::TileArchiveWriter( const QString &fileName )
+    : m_file( fileName )
+{
+}
+
+TileArchiveWriter::~TileArchiveWriter()
+{
+    if ( m_file.isOpen() ) {
+        finish();
+    }
+}
+
+bool TileArchiveWriter::open()
+{
+    m_entries.clear();
+
+    if ( !m_file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        mDebug() << "Cannot create tile archive" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    // the header is completed by finish()
+    const QByteArray header( HEADER_SIZE, '\0' );
+    return m_file.write( header ) == HEADER_SIZE;
+}
+
+bool TileArchiveWriter::addTile( int level, int x, int y, const QByteArray &data )
+{
+    Q_ASSERT( m_file.isOpen() );
+
+    Entry entry;
+    entry.level = level;
+    entry.y = y;
+    entry.x = x;
+    entry.size = data.size();
+    entry.offset = m_file.pos();
+
+    if ( m_file.write( data ) != data.size() ) {
+        mDebug() << "Error while writing tile archive" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    m_entries.append( entry );
+    return true;
+}
+
+bool TileArchiveWriter::finish()
+{
+    Q_ASSERT( m_file.isOpen() );
+
+    qSort( m_entries );
+
+    const quint64 indexOffset = m_file.pos();
+
+    QByteArray index( m_entries.size() * ENTRY_SIZE, '\0' );
+    uchar *it = reinterpret_cast<uchar *>( index.data() );
+    foreach ( const Entry &entry, m_entries ) {
+        qToLittleEndian<quint32>( entry.level, it );
+        qToLittleEndian<quint32>( entry.y, it + 4 );
+        qToLittleEndian<quint32>( entry.x, it + 8 );
+        qToLittleEndian<quint32>( entry.size, it + 12 );
+        qToLittleEndian<quint64>( entry.offset, it + 16 );
+        it += ENTRY_SIZE;
+    }
+
+    QByteArray header( HEADER_SIZE, '\0' );
+    uchar *const headerData = reinterpret_cast<uchar *>( header.data() );
+    memcpy( headerData, MAGIC, MAGIC_SIZE );
+    qToLittleEndian<quint32>( VERSION, headerData + MAGIC_SIZE );
+    qToLittleEndian<quint32>( m_entries.size(), headerData + MAGIC_SIZE + 4 );
+    qToLittleEndian<quint64>( indexOffset, headerData + MAGIC_SIZE + 8 );
+
+    const bool ok = m_file.write( index ) == index.size()
+                    && m_file.seek( 0 )
+                    && m_file.write( header ) == header.size();
+
+    m_file.close();
+    m_entries.clear();
+
+    if ( !ok ) {
+        mDebug() << "Error while writing tile archive" << m_file.fileName() << m_file.errorString();
+    }
+
+    return ok;
+}
@@ -0,0 +1,145 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_TILEARCHIVE_H
+#define MARBLE_TILEARCHIVE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+/**
+ * @short Read access to all tiles of a map theme packed into a single file.
+ *
+ * Instead of one file per tile in the level/row directories, a tile archive
+ * holds the encoded images (e.g. JPEG or PNG data) of all tiles back to back,
+ * followed by an index sorted by tile level, row and column. The file is
+ * memory mapped, so looking up a tile is a binary search in the index and
+ * neither requires a file system access nor any locking.
+ *
+ * File layout (all numbers little endian):
+ * @code
+ * header:  "MRBLTILE" version(quint32) tileCount(quint32) indexOffset(quint64)
+ * data:    the encoded tile images
+ * index:   tileCount times level(quint32) y(quint32) x(quint32) size(quint32) offset(quint64)
+ * @endcode
+ *
+ * @see TileArchiveWriter
+ */
+class MARBLE_EXPORT TileArchive
+{
+ public:
+    /**
+     * @brief Opens and maps the archive @p fileName.
+     * Use isValid() to find out whether this succeeded.
+     */
+    explicit TileArchive( const QString &fileName );
+    ~TileArchive();
+
+    /**
+     * @brief The name of the archive within the directory of a map theme,
+     * i.e. next to the tile level directories.
+     */
+    static QString themeFileName();
+
+    /**
+     * @brief The path of the archive of the map theme @p themeStr (e.g.
+     * "maps/earth/srtm2"), whether it exists or not.
+     */
+    static QString themeFilePath( const QString &themeStr );
+
+    bool isValid() const;
+
+    quint32 tileCount() const;
+
+    /**
+     * @brief Returns the highest tile level contained in the archive or -1
+     * if the archive is empty.
+     */
+    int maximumTileLevel() const;
+
+    bool contains( int level, int x, int y ) const;
+
+    /**
+     * @brief Returns the encoded image of a tile or an empty array if the
+     * archive doesn't contain the tile.
+     *
+     * The returned array doesn't copy the data, so it must not outlive the archive.
+     */
+    QByteArray tileData( int level, int x, int y ) const;
+
+ private:
+    Q_DISABLE_COPY( TileArchive )
+
+    const uchar *findEntry( int level, int x, int y ) const;
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    const uchar *m_index;
+    quint32 m_tileCount;
+};
+
+/**
+ * @short Creates a tile archive that can be read by TileArchive.
+ *
+ * Tiles can be added in any order. The index is sorted and written by finish().
+ */
+class MARBLE_EXPORT TileArchiveWriter
+{
+ public:
+    explicit TileArchiveWriter( const QString &fileName );
+    ~TileArchiveWriter();
+
+    /**
+     * @brief Creates the file, replacing an existing one.
+     * @return false if the file couldn't be created
+     */
+    bool open();
+
+    /**
+     * @brief Appends the encoded image @p data of a tile.
+     * @return false on write errors
+     */
+    bool addTile( int level, int x, int y, const QByteArray &data );
+
+    /**
+     * @brief Writes the index and closes the archive.
+     * @return false on write errors
+     */
+    bool finish();
+
+ private:
+    Q_DISABLE_COPY( TileArchiveWriter )
+
+    struct Entry
+    {
+        quint32 level;
+        quint32 y;
+        quint32 x;
+        quint32 size;
+        quint64 offset;
+
+        bool operator<( const Entry &other ) const;
+    };
+
+    QFile m_file;
+    QVector<Entry> m_entries;
+};
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include "MarbleGlobal.h"
 #include "MarbleDirs.h"
 #include "MarbleDebug.h"
+#include "TileArchive.h"
 #include "TileLoaderHelper.h"
 
 namespace Marble
@@ -42,6 +43,7 @@ class TileCreatorPrivate
          m_tileFormat( "jpg" ),
          m_resume( false ),
          m_verify( false ),
+         m_archive( false ),
          m_source( source )
      {
         if ( m_dem == "true" ) {
@@ -56,6 +58,9 @@ class TileCreatorPrivate
         delete m_source;
     }
 
+    QString tileFileName( int level, int row, int column ) const;
+    bool packTiles( int maxTileLevel );
+
  public:
     QString  m_dem;
     QString  m_targetDir;
@@ -64,10 +69,69 @@ class TileCreatorPrivate
     int      m_tileQuality;
     bool     m_resume;
     bool     m_verify;
+    bool     m_archive;
 
     TileCreatorSource  *m_source;
 };
 
+QString TileCreatorPrivate::tileFileName( int level, int row, int column ) const
+{
+    return m_targetDir + ( QString("%1/%2/%2_%3.%4")
+                           .arg( level )
+                           .arg( row, tileDigits, 10, QChar('0') )
+                           .arg( column, tileDigits, 10, QChar('0') ) )
+                           .arg( m_tileFormat );
+}
+
+bool TileCreatorPrivate::packTiles( int maxTileLevel )
+{
+    const QString archiveName = m_targetDir + TileArchive::themeFileName();
+    mDebug() << "Packing tiles into" << archiveName;
+
+    TileArchiveWriter writer( archiveName );
+    if ( !writer.open() ) {
+        return false;
+    }
+
+    for ( int tileLevel = 0; tileLevel <= maxTileLevel; ++tileLevel ) {
+        const int nmaxit = TileLoaderHelper::levelToRow( defaultLevelZeroRows, tileLevel );
+        const int mmaxit = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, tileLevel );
+        for ( int n = 0; n < nmaxit; ++n ) {
+            for ( int m = 0; m < mmaxit; ++m ) {
+                QFile file( tileFileName( tileLevel, n, m ) );
+                if ( m_cancelled || !file.open( QIODevice::ReadOnly )
+                     || !writer.addTile( tileLevel, m, n, file.readAll() ) ) {
+                    mDebug() << "Error while packing Tile: " << file.fileName();
+                    writer.finish();
+                    QFile::remove( archiveName );
+                    return false;
+                }
+            }
+        }
+    }
+
+    if ( !writer.finish() ) {
+        QFile::remove( archiveName );
+        return false;
+    }
+
+    // The archive replaces the individual tiles.
+    QDir targetDir( m_targetDir );
+    for ( int tileLevel = 0; tileLevel <= maxTileLevel; ++tileLevel ) {
+        const int nmaxit = TileLoaderHelper::levelToRow( defaultLevelZeroRows, tileLevel );
+        const int mmaxit = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, tileLevel );
+        for ( int n = 0; n < nmaxit; ++n ) {
+            for ( int m = 0; m < mmaxit; ++m ) {
+                QFile::remove( tileFileName( tileLevel, n, m ) );
+            }
+            targetDir.rmdir( QString( "%1/%2" ).arg( tileLevel ).arg( n, tileDigits, 10, QChar('0') ) );
+        }
+        targetDir.rmdir( QString::number( tileLevel ) );
+    }
+
+    return true;
+}
+
 class TileCreatorSourceImage : public TileCreatorSource
 {
 public:
@@ -572,6 +636,10 @@ void TileCreator::run()
         }
     }
 
+    if ( d->m_archive && !d->packTiles( maxTileLevel ) ) {
+        mDebug() << "Tile archive creation failed, keeping the individual tiles.";
+    }
+
     percentCompleted = 100;
     emit progress( percentCompleted );
 
@@ -618,6 +686,16 @@ bool TileCreator::verifyExactResult() const
     return d->m_verify;
 }
 
+void TileCreator::setTileArchive( bool archive )
+{
+    d->m_archive = archive;
+}
+
+bool TileCreator::tileArchive() const
+{
+    return d->m_archive;
+}
+
 
 }
 
@@ -76,10 +76,17 @@ class MARBLE_EXPORT TileCreator : public QThread
     void setTileQuality( int quality );
     void setResume( bool resume );
     void setVerifyExactResult( bool verify );
+
+    /**
+     * Packs the created tiles into a single TileArchive in the target
+     * directory instead of keeping one file per tile.
+     */
+    void setTileArchive( bool archive );
     QString tileFormat() const;
     int tileQuality() const;
     bool resume() const;
     bool verifyExactResult() const;
+    bool tileArchive() const;
 
  protected:
     virtual void run();
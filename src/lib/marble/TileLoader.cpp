@@ -24,6 +24,7 @@
 #include <QFileInfo>
 #include <QMetaType>
 #include <QImage>
+#include <QMutexLocker>
 
 #include "GeoSceneTextureTile.h"
 #include "GeoSceneTiled.h"
@@ -33,6 +34,7 @@
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
 #include "ParsingRunnerManager.h"
+#include "TileArchive.h"
 #include "TileLoaderHelper.h"
 
 Q_DECLARE_METATYPE( Marble::DownloadUsage )
@@ -43,6 +45,8 @@ namespace Marble
 TileLoader::TileLoader(HttpDownloadManager * const downloadManager, const PluginManager *pluginManager) :
       m_pluginManager( pluginManager )
 {
+    m_lowerLevelTileCache.setMaxCost( 4096 ); // measured in kilobytes
+
     qRegisterMetaType<DownloadUsage>( "DownloadUsage" );
     connect( this, SIGNAL(downloadTile(QUrl,QString,QString,DownloadUsage)),
              downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage)));
@@ -53,11 +57,17 @@ TileLoader::TileLoader(HttpDownloadManager * const downloadManager, const Plugin
 // If the tile image file is locally available:
 //     - if not expired: create ImageTile, set state to "uptodate", return it => done
 //     - if expired: create TextureTile, state is set to Expired by default, trigger dl,
-QImage TileLoader::loadTileImage( GeoSceneTextureTile const *textureLayer, TileId const & tileId, DownloadUsage const usage )
+QImage TileLoader::loadTileImage( GeoSceneTextureTile const *textureLayer, const TileArchive *archive,
+                                  TileId const & tileId, DownloadUsage const usage )
 {
+    QImage const archivedImage = archivedTileImage( archive, tileId );
+    if ( !archivedImage.isNull() ) {
+        return archivedImage;
+    }
+
     QString const fileName = tileFileName( textureLayer, tileId );
 
-    TileStatus status = tileStatus( textureLayer, tileId );
+    TileStatus status = tileStatus( textureLayer, archive, tileId );
     if ( status != Missing ) {
         // check if an update should be triggered
 
@@ -78,7 +88,7 @@ QImage TileLoader::loadTileImage( GeoSceneTextureTile const *textureLayer, TileI
 
     // tile was not locally available => trigger download and look for tiles in other levels
     // for scaling
-    QImage replacementTile = scaledLowerLevelTile( textureLayer, tileId );
+    QImage replacementTile = scaledLowerLevelTile( textureLayer, archive, tileId );
     Q_ASSERT( !replacementTile.isNull() );
 
     triggerDownload( textureLayer, tileId, usage );
@@ -86,6 +96,20 @@ QImage TileLoader::loadTileImage( GeoSceneTextureTile const *textureLayer, TileI
     return replacementTile;
 }
 
+QImage TileLoader::loadLocalTileImage( GeoSceneTextureTile const *textureLayer, const TileArchive *archive,
+                                       TileId const & tileId )
+{
+    QImage const archivedImage = archivedTileImage( archive, tileId );
+    if ( !archivedImage.isNull() ) {
+        return archivedImage;
+    }
+
+    if ( tileStatus( textureLayer, archive, tileId ) != Available ) {
+        return QImage();
+    }
+
+    return QImage( tileFileName( textureLayer, tileId ) );
+}
 
 GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneVectorTile const *textureLayer, TileId const & tileId, DownloadUsage const usage )
 {
@@ -93,7 +117,8 @@ GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneVectorTile const *textu
 
     QString const fileName = tileFileName( textureLayer, tileId );
 
-    TileStatus status = tileStatus( textureLayer, tileId );
+    // vector tiles are never packed into archives
+    TileStatus status = tileStatus( textureLayer, 0, tileId );
     if ( status != Missing ) {
         // check if an update should be triggered
 
@@ -135,7 +160,7 @@ void TileLoader::downloadTile( GeoSceneTiled const *textureLayer, TileId const &
     triggerDownload( textureLayer, tileId, usage );
 }
 
-int TileLoader::maximumTileLevel( GeoSceneTiled const & texture )
+int TileLoader::maximumTileLevel( GeoSceneTiled const & texture, const TileArchive *archive )
 {
     // if maximum tile level is configured in the DGML files,
     // then use it, otherwise use old detection code.
@@ -160,6 +185,10 @@ int TileLoader::maximumTileLevel( GeoSceneTiled const & texture )
             maximumTileLevel = value;
     }
 
+    if ( archive ) {
+        maximumTileLevel = qMax( maximumTileLevel, archive->maximumTileLevel() );
+    }
+
     //    mDebug() << "Detected maximum tile level that contains data: "
     //             << maxtilelevel;
     return maximumTileLevel + 1;
@@ -172,13 +201,15 @@ bool TileLoader::baseTilesAvailable( GeoSceneTiled const & texture )
 
     bool result = true;
 
+    const QSharedPointer<const TileArchive> archive = openTileArchive( &texture );
+
     // Check whether the tiles from the lowest texture level are available
     //
     for ( int column = 0; result && column < levelZeroColumns; ++column ) {
         for ( int row = 0; result && row < levelZeroRows; ++row ) {
             const TileId id( 0, 0, column, row );
             const QString tilepath = tileFileName( &texture, id );
-            result &= QFile::exists( tilepath );
+            result &= ( archive && archive->contains( 0, column, row ) ) || QFile::exists( tilepath );
             if (!result) {
                 mDebug() << "Base tile " << texture.relativeTileFileName( id ) << " is missing for source dir " << texture.sourceDir();
             }
@@ -188,8 +219,14 @@ bool TileLoader::baseTilesAvailable( GeoSceneTiled const & texture )
     return result;
 }
 
-TileLoader::TileStatus TileLoader::tileStatus( GeoSceneTiled const *textureLayer, const TileId &tileId )
+TileLoader::TileStatus TileLoader::tileStatus( GeoSceneTiled const *textureLayer, const TileArchive *archive,
+                                               const TileId &tileId )
 {
+    // archived tiles are part of the installed map theme and never expire
+    if ( archive && archive->contains( tileId.zoomLevel(), tileId.x(), tileId.y() ) ) {
+        return Available;
+    }
+
     QString const fileName = tileFileName( textureLayer, tileId );
     QFileInfo fileInfo( fileName );
     if ( !fileInfo.exists() ) {
@@ -214,6 +251,12 @@ void TileLoader::updateTile( QByteArray const & data, QString const & idStr )
 
     TileId const id = TileId( sourceDir, zoomLevel, tileX, tileY );
 
+    {
+        // a lower level tile used for scaling may have been replaced
+        QMutexLocker locker( &m_lowerLevelTileMutex );
+        m_lowerLevelTileCache.remove( id );
+    }
+
     QImage const tileImage = QImage::fromData( data );
     if ( tileImage.isNull() )
         return;
@@ -228,6 +271,36 @@ QString TileLoader::tileFileName( GeoSceneTiled const * textureLayer, TileId con
     return dirInfo.isAbsolute() ? fileName : MarbleDirs::path( fileName );
 }
 
+QSharedPointer<const TileArchive> TileLoader::openTileArchive( GeoSceneTiled const * textureLayer )
+{
+    const QString fileName = TileArchive::themeFilePath( textureLayer->themeStr() );
+    if ( !QFile::exists( fileName ) ) {
+        return QSharedPointer<const TileArchive>();
+    }
+
+    QSharedPointer<const TileArchive> archive( new TileArchive( fileName ) );
+    if ( !archive->isValid() ) {
+        return QSharedPointer<const TileArchive>();
+    }
+
+    mDebug() << "Using tile archive" << fileName << "with" << archive->tileCount() << "tiles";
+    return archive;
+}
+
+QImage TileLoader::archivedTileImage( const TileArchive *archive, TileId const & tileId )
+{
+    if ( !archive ) {
+        return QImage();
+    }
+
+    const QByteArray data = archive->tileData( tileId.zoomLevel(), tileId.x(), tileId.y() );
+    if ( data.isEmpty() ) {
+        return QImage();
+    }
+
+    return QImage::fromData( data );
+}
+
 void TileLoader::triggerDownload( GeoSceneTiled const *textureLayer, TileId const &id, DownloadUsage const usage )
 {
     QUrl const sourceUrl = textureLayer->downloadUrl( id );
@@ -236,7 +309,8 @@ void TileLoader::triggerDownload( GeoSceneTiled const *textureLayer, TileId cons
     emit downloadTile( sourceUrl, destFileName, idStr, usage );
 }
 
-QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTile * textureLayer, TileId const & id )
+QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTile * textureLayer, const TileArchive *archive,
+                                         TileId const & id )
 {
     mDebug() << Q_FUNC_INFO << id;
 
@@ -244,9 +318,7 @@ QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTile * textureLaye
         int const deltaLevel = id.zoomLevel() - level;
         TileId const replacementTileId( id.mapThemeIdHash(), level,
                                         id.x() >> deltaLevel, id.y() >> deltaLevel );
-        QString const fileName = tileFileName( textureLayer, replacementTileId );
-        mDebug() << "TileLoader::scaledLowerLevelTile" << "trying" << fileName;
-        QImage toScale = QFile::exists(fileName) ? QImage(fileName) : QImage();
+        QImage toScale = lowerLevelTile( textureLayer, archive, replacementTileId );
 
         if ( level == 0 && toScale.isNull() ) {
             mDebug() << "No level zero tile installed in map theme dir. Falling back to a transparent image for now.";
@@ -275,6 +347,35 @@ QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTile * textureLaye
     return QImage();
 }
 
+QImage TileLoader::lowerLevelTile( const GeoSceneTextureTile * textureLayer, const TileArchive *archive,
+                                   TileId const & id )
+{
+    // Replacement tiles are requested for each missing tile of a higher level,
+    // so keep them decoded instead of reading the same file over and over.
+    {
+        QMutexLocker locker( &m_lowerLevelTileMutex );
+        const QImage *const cached = m_lowerLevelTileCache.object( id );
+        if ( cached ) {
+            return *cached;
+        }
+    }
+
+    QImage image = archivedTileImage( archive, id );
+
+    if ( image.isNull() ) {
+        QString const fileName = tileFileName( textureLayer, id );
+        mDebug() << "TileLoader::scaledLowerLevelTile" << "trying" << fileName;
+        image = QFile::exists(fileName) ? QImage(fileName) : QImage();
+    }
+
+    if ( !image.isNull() ) {
+        QMutexLocker locker( &m_lowerLevelTileMutex );
+        m_lowerLevelTileCache.insert( id, new QImage( image ), image.byteCount() / 1024 );
+    }
+
+    return image;
+}
+
 }
 
 #include "TileLoader.moc"
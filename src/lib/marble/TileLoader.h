@@ -20,7 +20,10 @@
 #ifndef MARBLE_TILELOADER_H
 #define MARBLE_TILELOADER_H
 
+#include <QCache>
+#include <QMutex>
 #include <QObject>
+#include <QSharedPointer>
 #include <QString>
 #include <QImage>
 
@@ -36,6 +39,7 @@ class QUrl;
 namespace Marble
 {
 class HttpDownloadManager;
+class TileArchive;
 class GeoDataDocument;
 class GeoSceneTiled;
 class GeoSceneTextureTile;
@@ -54,11 +58,27 @@ class TileLoader: public QObject
 
     explicit TileLoader(HttpDownloadManager * const, const PluginManager * );
 
-    QImage loadTileImage( GeoSceneTextureTile const *textureLayer, TileId const & tileId, DownloadUsage const );
+    /**
+     * Opens the tile archive of the map theme of @p textureLayer. Returns a null
+     * pointer if the theme has no archive. The file is looked up on each call,
+     * so this is meant to be called when a layer is set up. The archive is then
+     * passed to the tile loading methods below, where 0 means no archive.
+     */
+    static QSharedPointer<const TileArchive> openTileArchive( GeoSceneTiled const *textureLayer );
+
+    QImage loadTileImage( GeoSceneTextureTile const *textureLayer, const TileArchive *archive,
+                          TileId const & tileId, DownloadUsage const );
+
+    /**
+     * Returns the tile image if it is locally available and not expired,
+     * a null image otherwise. Never triggers a download.
+     */
+    static QImage loadLocalTileImage( GeoSceneTextureTile const *textureLayer, const TileArchive *archive,
+                                      TileId const & tileId );
     GeoDataDocument* loadTileVectorData( GeoSceneVectorTile const *textureLayer, TileId const & tileId, DownloadUsage const usage );
     void downloadTile( GeoSceneTiled const *textureLayer, TileId const &, DownloadUsage const );
 
-    static int maximumTileLevel( GeoSceneTiled const & texture );
+    static int maximumTileLevel( GeoSceneTiled const & texture, const TileArchive *archive );
 
     /**
      * Returns whether the mandatory most basic tile level is fully available for
@@ -72,7 +92,7 @@ class TileLoader: public QObject
       * - Expired when it has been downloaded, but is too old (as per .dgml expiration time)
       * - Available when it has been downloaded and is not expired
       */
-    static TileStatus tileStatus( GeoSceneTiled const *textureLayer, const TileId &tileId );
+    static TileStatus tileStatus( GeoSceneTiled const *textureLayer, const TileArchive *archive, const TileId &tileId );
 
  public Q_SLOTS:
     void updateTile( QByteArray const & imageData, QString const & tileId );
@@ -87,11 +107,18 @@ class TileLoader: public QObject
 
  private:
     static QString tileFileName( GeoSceneTiled const * textureLayer, TileId const & );
+    static QImage archivedTileImage( const TileArchive *archive, TileId const & tileId );
     void triggerDownload( GeoSceneTiled const *textureLayer, TileId const &, DownloadUsage const );
-    static QImage scaledLowerLevelTile( GeoSceneTextureTile const * textureLayer, TileId const & );
+    QImage scaledLowerLevelTile( GeoSceneTextureTile const * textureLayer, const TileArchive *archive, TileId const & );
+    QImage lowerLevelTile( GeoSceneTextureTile const * textureLayer, const TileArchive *archive, TileId const & );
 
     // For vectorTile parsing
     const PluginManager * m_pluginManager;
+
+    // decoded lower level tiles for scaledLowerLevelTile(), may be used by
+    // several render threads at once
+    QCache<TileId, QImage> m_lowerLevelTileCache;
+    QMutex m_lowerLevelTileMutex;
 };
 
 }
@@ -0,0 +1,205 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "TilePrefetcher.h"
+
+#include <cmath>
+
+#include <qmath.h>
+#include <QRunnable>
+
+#include "MathHelper.h"
+#include "StackedTileLoader.h"
+#include "ViewportParams.h"
+
+using namespace Marble;
+
+// Only few threads, the render threads should get the bulk of the CPU.
+static const int PREFETCH_THREAD_COUNT = 2;
+
+// Upper bound of tiles queued per frame, so the prefetched tiles don't
+// push the tiles on display out of the volatile cache.
+static const int MAXIMUM_PREFETCH_TILES = 24;
+
+// Minimum movement of the center (in tiles per frame) that is considered a pan.
+static const qreal MINIMUM_PAN_VELOCITY = 0.01;
+
+class TilePrefetcher::PrefetchJob : public QRunnable
+{
+public:
+    PrefetchJob( StackedTileLoader *tileLoader, const TileId &stackedTileId, const QAtomicInt *generation, int jobGeneration );
+
+    virtual void run();
+
+private:
+    StackedTileLoader *const m_tileLoader;
+    const TileId m_stackedTileId;
+    const QAtomicInt *const m_generation;
+    const int m_jobGeneration;
+};
+
+TilePrefetcher::PrefetchJob::PrefetchJob( StackedTileLoader *tileLoader, const TileId &stackedTileId, const QAtomicInt *generation, int jobGeneration )
+    : m_tileLoader( tileLoader ),
+      m_stackedTileId( stackedTileId ),
+      m_generation( generation ),
+      m_jobGeneration( jobGeneration )
+{
+}
+
+void TilePrefetcher::PrefetchJob::run()
+{
+    // dropped in favor of a newer guess?
+    if ( *m_generation != m_jobGeneration ) {
+        return;
+    }
+
+    m_tileLoader->prefetchTile( m_stackedTileId );
+}
+
+
+TilePrefetcher::TilePrefetcher( StackedTileLoader *tileLoader )
+    : m_tileLoader( tileLoader ),
+      m_generation( 0 ),
+      m_lastTileLevel( -1 ),
+      m_lastCenterX( 0.0 ),
+      m_lastCenterY( 0.0 )
+{
+    m_threadPool.setMaxThreadCount( PREFETCH_THREAD_COUNT );
+}
+
+TilePrefetcher::~TilePrefetcher()
+{
+    cancel();
+
+    // the jobs refer to m_generation
+    m_threadPool.waitForDone();
+}
+
+void TilePrefetcher::prefetch( const ViewportParams *viewport, int tileZoomLevel, int maximumTileLevel )
+{
+    // forget about the tiles queued for the previous frame
+    m_generation.ref();
+    const int generation = m_generation;
+
+    if ( tileZoomLevel < 0 ) {
+        return;
+    }
+
+    const int columns = m_tileLoader->tileColumnCount( tileZoomLevel );
+
+    qreal centerX, centerY;
+    tileCoordinates( viewport->centerLongitude(), viewport->centerLatitude(), tileZoomLevel, centerX, centerY );
+
+    qreal velocityX = 0.0;
+    qreal velocityY = 0.0;
+    if ( tileZoomLevel == m_lastTileLevel ) {
+        velocityX = centerX - m_lastCenterX;
+        velocityY = centerY - m_lastCenterY;
+
+        // moved across the date line?
+        if ( velocityX > columns / 2.0 ) velocityX -= columns;
+        if ( velocityX < -columns / 2.0 ) velocityX += columns;
+    }
+
+    m_lastTileLevel = tileZoomLevel;
+    m_lastCenterX = centerX;
+    m_lastCenterY = centerY;
+
+    // range of the tiles on display
+    int xLeft = columns;
+    int xRight = -1;
+    int yTop = m_tileLoader->tileRowCount( tileZoomLevel );
+    int yBottom = -1;
+    foreach ( const TileId &id, m_tileLoader->visibleTiles() ) {
+        if ( id.zoomLevel() != tileZoomLevel ) {
+            continue;
+        }
+        xLeft = qMin( xLeft, id.x() );
+        xRight = qMax( xRight, id.x() );
+        yTop = qMin( yTop, id.y() );
+        yBottom = qMax( yBottom, id.y() );
+    }
+
+    QList<TileId> tiles;
+
+    if ( xLeft <= xRight && yTop <= yBottom ) {
+        // The faster the map moves, the further ahead the tiles are needed.
+        const int aheadX = qBound( 1, qCeil( qAbs( velocityX ) ), 2 );
+        const int aheadY = qBound( 1, qCeil( qAbs( velocityY ) ), 2 );
+
+        if ( velocityX > MINIMUM_PAN_VELOCITY ) {
+            addTiles( tileZoomLevel, xRight + 1, yTop, xRight + aheadX, yBottom, tiles );
+        }
+        else if ( velocityX < -MINIMUM_PAN_VELOCITY ) {
+            addTiles( tileZoomLevel, xLeft - aheadX, yTop, xLeft - 1, yBottom, tiles );
+        }
+
+        if ( velocityY > MINIMUM_PAN_VELOCITY ) {
+            addTiles( tileZoomLevel, xLeft, yBottom + 1, xRight, yBottom + aheadY, tiles );
+        }
+        else if ( velocityY < -MINIMUM_PAN_VELOCITY ) {
+            addTiles( tileZoomLevel, xLeft, yTop - aheadY, xRight, yTop - 1, tiles );
+        }
+    }
+
+    // zooming in usually happens around the center
+    if ( tileZoomLevel < maximumTileLevel ) {
+        qreal x, y;
+        tileCoordinates( viewport->centerLongitude(), viewport->centerLatitude(), tileZoomLevel + 1, x, y );
+        addTiles( tileZoomLevel + 1, (int)x - 1, (int)y - 1, (int)x + 1, (int)y + 1, tiles );
+    }
+
+    for ( int i = 0; i < tiles.size() && i < MAXIMUM_PREFETCH_TILES; ++i ) {
+        m_threadPool.start( new PrefetchJob( m_tileLoader, tiles[i], &m_generation, generation ) );
+    }
+}
+
+void TilePrefetcher::cancel()
+{
+    // Queued jobs return as soon as they see the new generation. Tiles being
+    // loaded right now are dropped by the StackedTileLoader if its tiles
+    // became outdated meanwhile, so there is no need to wait for them.
+    m_generation.ref();
+#if QT_VERSION >= 0x050200
+    m_threadPool.clear();
+#endif
+}
+
+void TilePrefetcher::tileCoordinates( qreal lon, qreal lat, int level, qreal &x, qreal &y ) const
+{
+    const int columns = m_tileLoader->tileColumnCount( level );
+    const int rows = m_tileLoader->tileRowCount( level );
+
+    x = ( 0.5 + 0.5 * lon / M_PI ) * columns;
+
+    if ( m_tileLoader->tileProjection() == GeoSceneTiled::Mercator ) {
+        y = ( 0.5 - 0.5 * asinh( tan( lat ) ) / M_PI ) * rows;
+    }
+    else {
+        y = ( 0.5 - lat / M_PI ) * rows;
+    }
+
+    x = qBound<qreal>( 0.0, x, columns - 1 );
+    y = qBound<qreal>( 0.0, y, rows - 1 );
+}
+
+void TilePrefetcher::addTiles( int level, int xLeft, int yTop, int xRight, int yBottom, QList<TileId> &tiles ) const
+{
+    const int columns = m_tileLoader->tileColumnCount( level );
+    const int rows = m_tileLoader->tileRowCount( level );
+
+    for ( int y = qMax( 0, yTop ); y <= qMin( yBottom, rows - 1 ); ++y ) {
+        for ( int x = xLeft; x <= xRight; ++x ) {
+            // the map wraps around horizontally
+            const int tileX = ( ( x % columns ) + columns ) % columns;
+            tiles << TileId( 0, level, tileX, y );
+        }
+    }
+}
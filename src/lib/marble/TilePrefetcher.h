@@ -0,0 +1,76 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_TILEPREFETCHER_H
+#define MARBLE_TILEPREFETCHER_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QThreadPool>
+
+#include "TileId.h"
+
+namespace Marble
+{
+
+class StackedTileLoader;
+class ViewportParams;
+
+/**
+ * @short Decodes texture tiles in the background before they become visible.
+ *
+ * After each frame the prefetcher guesses which tiles will be needed next:
+ * the tiles beyond the border of the viewport in the direction the map is
+ * moving and the tiles of the next zoom level around the center. These are
+ * loaded by a small pool of worker threads into the volatile cache of the
+ * StackedTileLoader, so the render threads find them there instead of
+ * decoding them while the map is being painted. Only tiles that are
+ * available on disk are prefetched; guessing never causes a download.
+ *
+ * Queued tiles that haven't been loaded yet are dropped as soon as a newer
+ * guess is available.
+ */
+class TilePrefetcher
+{
+ public:
+    explicit TilePrefetcher( StackedTileLoader *tileLoader );
+    ~TilePrefetcher();
+
+    /**
+     * @brief Queues the tiles that are likely needed after @p viewport.
+     * @param tileZoomLevel the tile level currently displayed
+     * @param maximumTileLevel the highest tile level the texture provides
+     */
+    void prefetch( const ViewportParams *viewport, int tileZoomLevel, int maximumTileLevel );
+
+    /**
+     * @brief Drops all queued tiles without waiting for the tiles being loaded.
+     * Should be called before the tile loader or its layer decorator change.
+     */
+    void cancel();
+
+ private:
+    class PrefetchJob;
+
+    void tileCoordinates( qreal lon, qreal lat, int level, qreal &x, qreal &y ) const;
+    void addTiles( int level, int xLeft, int yTop, int xRight, int yBottom, QList<TileId> &tiles ) const;
+
+    StackedTileLoader *const m_tileLoader;
+    QThreadPool m_threadPool;
+    QAtomicInt m_generation;
+
+    int m_lastTileLevel;
+    qreal m_lastCenterX;
+    qreal m_lastCenterY;
+};
+
+}
+
+#endif
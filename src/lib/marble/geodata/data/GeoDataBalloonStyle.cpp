@@ -118,9 +118,10 @@ void GeoDataBalloonStyle::pack( QDataStream& stream ) const
 {
     GeoDataColorStyle::pack( stream );
 
-    stream << d->m_bgColor.name();
-    stream << d->m_textColor.name();
+    stream << d->m_bgColor;
+    stream << d->m_textColor;
     stream << d->m_text;
+    stream << int( d->m_mode );
 }
 
 void GeoDataBalloonStyle::unpack( QDataStream& stream )
@@ -130,6 +131,10 @@ void GeoDataBalloonStyle::unpack( QDataStream& stream )
     stream >> d->m_bgColor;
     stream >> d->m_textColor;
     stream >> d->m_text;
+
+    int mode;
+    stream >> mode;
+    d->m_mode = GeoDataBalloonStyle::DisplayMode( mode );
 }
 
 }
@@ -360,13 +360,20 @@ void GeoDataContainer::pack( QDataStream& stream ) const
 {
     GeoDataFeature::pack( stream );
 
-    stream << p()->m_vector.count();
+    // unpack() only knows how to restore documents, folders and placemarks
+    QVector<const GeoDataFeature*> features;
+    features.reserve( p()->m_vector.size() );
+    foreach ( const GeoDataFeature *feature, p()->m_vector ) {
+        if ( feature->featureId() == GeoDataDocumentId
+             || feature->featureId() == GeoDataFolderId
+             || feature->featureId() == GeoDataPlacemarkId ) {
+            features.append( feature );
+        }
+    }
 
-    for ( QVector <GeoDataFeature*>::const_iterator iterator = p()->m_vector.constBegin();
-          iterator != p()->m_vector.constEnd();
-          ++iterator )
-    {
-        const GeoDataFeature *feature = *iterator;
+    stream << features.count();
+
+    foreach ( const GeoDataFeature *feature, features ) {
         stream << feature->featureId();
         feature->pack( stream );
     }
@@ -385,10 +392,17 @@ void GeoDataContainer::unpack( QDataStream& stream )
         stream >> featureId;
         switch( featureId ) {
             case GeoDataDocumentId:
-                /* not usable!!!! */ break;
+                {
+                GeoDataDocument *document = new GeoDataDocument;
+                document->setParent( this );
+                document->unpack( stream );
+                p()->m_vector.append( document );
+                }
+                break;
             case GeoDataFolderId:
                 {
                 GeoDataFolder *folder = new GeoDataFolder;
+                folder->setParent( this );
                 folder->unpack( stream );
                 p()->m_vector.append( folder );
                 }
@@ -396,6 +410,7 @@ void GeoDataContainer::unpack( QDataStream& stream )
             case GeoDataPlacemarkId:
                 {
                 GeoDataPlacemark *placemark = new GeoDataPlacemark;
+                placemark->setParent( this );
                 placemark->unpack( stream );
                 p()->m_vector.append( placemark );
                 }
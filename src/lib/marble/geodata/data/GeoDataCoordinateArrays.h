@@ -0,0 +1,171 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_GEODATACOORDINATEARRAYS_H
+#define MARBLE_GEODATACOORDINATEARRAYS_H
+
+#include <QVector>
+
+#include "GeoDataCoordinates.h"
+
+namespace Marble
+{
+
+/**
+ * @short Coordinates stored as separate arrays of longitudes, latitudes and altitudes.
+ *
+ * GeoDataLineString keeps its nodes as GeoDataCoordinates, which carry a
+ * quaternion and a detail level besides the position. Code that walks over
+ * all nodes of a line string and only needs the position, like batch
+ * projection or bounding box computation, runs faster on three tightly
+ * packed arrays which it can read sequentially.
+ *
+ * Longitudes and latitudes are stored in radians. Use
+ * GeoDataCoordinateArrays<float> where memory matters more than precision.
+ *
+ * The arrays are implicitly shared, so copying them is cheap.
+ *
+ * @see GeoDataLineString::coordinateArrays()
+ */
+template<typename Real>
+class GeoDataCoordinateArrays
+{
+ public:
+    /**
+     * @short Iterates over the arrays, yielding GeoDataCoordinates by value.
+     */
+    class ConstIterator
+    {
+     public:
+        ConstIterator( const GeoDataCoordinateArrays *arrays, int index )
+            : m_arrays( arrays ),
+              m_index( index )
+        {
+        }
+
+        GeoDataCoordinates operator*() const { return m_arrays->coordinates( m_index ); }
+
+        ConstIterator &operator++() { ++m_index; return *this; }
+        ConstIterator operator++( int ) { ConstIterator it = *this; ++m_index; return it; }
+        ConstIterator &operator--() { --m_index; return *this; }
+        ConstIterator operator--( int ) { ConstIterator it = *this; --m_index; return it; }
+
+        bool operator==( const ConstIterator &other ) const { return m_index == other.m_index; }
+        bool operator!=( const ConstIterator &other ) const { return m_index != other.m_index; }
+
+        int index() const { return m_index; }
+
+     private:
+        const GeoDataCoordinateArrays *m_arrays;
+        int m_index;
+    };
+
+    GeoDataCoordinateArrays()
+    {
+    }
+
+    explicit GeoDataCoordinateArrays( const QVector<GeoDataCoordinates> &coordinates )
+    {
+        reserve( coordinates.size() );
+        const GeoDataCoordinates *it = coordinates.constData();
+        const GeoDataCoordinates *const end = it + coordinates.size();
+        for ( ; it != end; ++it ) {
+            append( *it );
+        }
+    }
+
+    int size() const { return m_longitudes.size(); }
+    bool isEmpty() const { return m_longitudes.isEmpty(); }
+
+    void reserve( int size )
+    {
+        m_longitudes.reserve( size );
+        m_latitudes.reserve( size );
+        m_altitudes.reserve( size );
+    }
+
+    void clear()
+    {
+        m_longitudes.clear();
+        m_latitudes.clear();
+        m_altitudes.clear();
+    }
+
+    void append( Real lon, Real lat, Real alt = 0 )
+    {
+        m_longitudes.append( lon );
+        m_latitudes.append( lat );
+        m_altitudes.append( alt );
+    }
+
+    void append( const GeoDataCoordinates &coordinates )
+    {
+        append( Real( coordinates.longitude() ), Real( coordinates.latitude() ), Real( coordinates.altitude() ) );
+    }
+
+    void insert( int i, const GeoDataCoordinates &coordinates )
+    {
+        m_longitudes.insert( i, Real( coordinates.longitude() ) );
+        m_latitudes.insert( i, Real( coordinates.latitude() ) );
+        m_altitudes.insert( i, Real( coordinates.altitude() ) );
+    }
+
+    void remove( int i, int count = 1 )
+    {
+        m_longitudes.remove( i, count );
+        m_latitudes.remove( i, count );
+        m_altitudes.remove( i, count );
+    }
+
+    void set( int i, const GeoDataCoordinates &coordinates )
+    {
+        m_longitudes[i] = Real( coordinates.longitude() );
+        m_latitudes[i] = Real( coordinates.latitude() );
+        m_altitudes[i] = Real( coordinates.altitude() );
+    }
+
+    Real longitude( int i ) const { return m_longitudes.at( i ); }
+    Real latitude( int i ) const { return m_latitudes.at( i ); }
+    Real altitude( int i ) const { return m_altitudes.at( i ); }
+
+    /**
+     * Direct access to the arrays, each of which has size() elements.
+     */
+    const Real *longitudes() const { return m_longitudes.constData(); }
+    const Real *latitudes() const { return m_latitudes.constData(); }
+    const Real *altitudes() const { return m_altitudes.constData(); }
+
+    GeoDataCoordinates coordinates( int i ) const
+    {
+        return GeoDataCoordinates( m_longitudes.at( i ), m_latitudes.at( i ), m_altitudes.at( i ) );
+    }
+
+    ConstIterator constBegin() const { return ConstIterator( this, 0 ); }
+    ConstIterator constEnd() const { return ConstIterator( this, size() ); }
+
+    QVector<GeoDataCoordinates> toVector() const
+    {
+        QVector<GeoDataCoordinates> result;
+        result.reserve( size() );
+        for ( int i = 0; i < size(); ++i ) {
+            result.append( coordinates( i ) );
+        }
+        return result;
+    }
+
+ private:
+    QVector<Real> m_longitudes;
+    QVector<Real> m_latitudes;
+    QVector<Real> m_altitudes;
+};
+
+}
+
+#endif
@@ -14,7 +14,6 @@
 
 
 #include "GeoDataCoordinates.h"
-#include "GeoDataCoordinates_p.h"
 
 #include <qmath.h>
 #include <QRegExp>
@@ -22,7 +21,6 @@
 #include <QString>
 #include <QStringList>
 #include <QCoreApplication>
-#include <QAtomicInt>
 
 #include "MarbleGlobal.h"
 #include "MarbleDebug.h"
@@ -585,37 +583,54 @@ GeoDataCoordinates::Notation GeoDataCoordinates::s_notation = GeoDataCoordinates
 const GeoDataCoordinates GeoDataCoordinates::null = GeoDataCoordinates( 0, 0, 0 ); // don't use default constructor!
 
 GeoDataCoordinates::GeoDataCoordinates( qreal _lon, qreal _lat, qreal _alt, GeoDataCoordinates::Unit unit, int _detail )
-  : d( new GeoDataCoordinatesPrivate( _lon, _lat, _alt, unit, _detail ) )
+  : m_altitude( _alt ),
+    m_detail( _detail ),
+    m_valid( true )
 {
-    d->ref.ref();
+    switch( unit ){
+    default:
+    case Radian:
+        m_q = Quaternion::fromSpherical( _lon, _lat );
+        m_lon = _lon;
+        m_lat = _lat;
+        break;
+    case Degree:
+        m_q = Quaternion::fromSpherical( _lon * DEG2RAD , _lat * DEG2RAD  );
+        m_lon = _lon * DEG2RAD;
+        m_lat = _lat * DEG2RAD;
+        break;
+    }
 }
 
-/* simply copy the d pointer
-* it will be replaced in the detach function instead
-*/
+/*
+ * the coordinates are stored inline, so copying is a plain member-wise copy
+ * without any heap allocation
+ */
 GeoDataCoordinates::GeoDataCoordinates( const GeoDataCoordinates& other )
-  : d( other.d )
+  : m_q( other.m_q ),
+    m_lon( other.m_lon ),
+    m_lat( other.m_lat ),
+    m_altitude( other.m_altitude ),
+    m_detail( other.m_detail ),
+    m_valid( other.m_valid )
 {
-    d->ref.ref();
 }
 
-/* simply copy null's d pointer
- * it will be replaced in the detach function
+/*
+ * an invalid position at 0, 0 - Quaternion::fromSpherical( 0, 0 ) spelled out
  */
 GeoDataCoordinates::GeoDataCoordinates()
-  : d( null.d )
+  : m_q( 0.0, 0.0, 0.0, 1.0 ),
+    m_lon( 0 ),
+    m_lat( 0 ),
+    m_altitude( 0 ),
+    m_detail( 0 ),
+    m_valid( false )
 {
-    d->ref.ref();
 }
 
-/*
- * only delete the private d pointer if the number of references is 0
- * remember that all copies share the same d pointer!
- */
 GeoDataCoordinates::~GeoDataCoordinates()
 {
-    if (!d->ref.deref())
-        delete d;
 #ifdef DEBUG_GEODATA
 //    mDebug() << "delete coordinates";
 #endif
@@ -623,90 +638,74 @@ GeoDataCoordinates::~GeoDataCoordinates()
 
 bool GeoDataCoordinates::isValid() const
 {
-    return d != null.d;
+    return m_valid;
 }
 
 /*
- * if only one copy exists, return
- * else make a new private d pointer object and assign the values of the current
- * one to it
- * at the end, if the number of references thus reaches 0 delete it
- * this state shouldn't happen, but if it does, we have to clean up behind us.
+ * There is no shared data to detach from any longer. Like before, a
+ * detached default constructed object counts as valid though.
  */
 void GeoDataCoordinates::detach()
 {
-#if QT_VERSION < 0x050000
-    if(d->ref == 1)
-#else
-    if(d->ref.load() == 1)
-#endif
-        return;
-
-    GeoDataCoordinatesPrivate *new_d = new GeoDataCoordinatesPrivate( *d );
-
-    if (!d->ref.deref())
-        delete d;
-
-    d = new_d;
-    d->ref.ref();
+    m_valid = true;
 }
 
 /*
- * call detach() at the start of all non-static, non-const functions
+ * all non-static, non-const functions make the coordinates valid
  */
 void GeoDataCoordinates::set( qreal _lon, qreal _lat, qreal _alt, GeoDataCoordinates::Unit unit )
 {
-    detach();
-    d->m_altitude = _alt;
+    m_valid = true;
+    m_altitude = _alt;
     switch( unit ){
     default:
     case Radian:
-        d->m_q = Quaternion::fromSpherical( _lon, _lat );
-        d->m_lon = _lon;
-        d->m_lat = _lat;
+        m_q = Quaternion::fromSpherical( _lon, _lat );
+        m_lon = _lon;
+        m_lat = _lat;
         break;
     case Degree:
-        d->m_q = Quaternion::fromSpherical( _lon * DEG2RAD , _lat * DEG2RAD  );
-        d->m_lon = _lon * DEG2RAD;
-        d->m_lat = _lat * DEG2RAD;
+        m_q = Quaternion::fromSpherical( _lon * DEG2RAD , _lat * DEG2RAD  );
+        m_lon = _lon * DEG2RAD;
+        m_lat = _lat * DEG2RAD;
         break;
     }
 }
 
 /*
- * call detach() at the start of all non-static, non-const functions
+ * all non-static, non-const functions make the coordinates valid
  */
 void GeoDataCoordinates::setLongitude( qreal _lon, GeoDataCoordinates::Unit unit )
 {
-    detach();
+    m_valid = true;
     switch( unit ){
     default:
     case Radian:
-        d->m_q = Quaternion::fromSpherical( _lon, d->m_lat );
-        d->m_lon = _lon;
+        m_q = Quaternion::fromSpherical( _lon, m_lat );
+        m_lon = _lon;
         break;
     case Degree:
-        d->m_q = Quaternion::fromSpherical( _lon * DEG2RAD , d->m_lat  );
-        d->m_lon = _lon * DEG2RAD;
+        m_q = Quaternion::fromSpherical( _lon * DEG2RAD , m_lat  );
+        m_lon = _lon * DEG2RAD;
         break;
     }
 }
 
 
 /*
- * call detach() at the start of all non-static, non-const functions
+ * all non-static, non-const functions make the coordinates valid
  */
 void GeoDataCoordinates::setLatitude( qreal _lat, GeoDataCoordinates::Unit unit )
 {
-    detach();
+    m_valid = true;
     switch( unit ){
     case Radian:
-        d->m_q = Quaternion::fromSpherical( d->m_lon, _lat );
-        d->m_lat = _lat;
+        m_q = Quaternion::fromSpherical( m_lon, _lat );
+        m_lat = _lat;
         break;
     case Degree:
-        d->m_q = Quaternion::fromSpherical( d->m_lon, _lat * DEG2RAD   );
-        d->m_lat = _lat * DEG2RAD;
+        m_q = Quaternion::fromSpherical( m_lon, _lat * DEG2RAD   );
+        m_lat = _lat * DEG2RAD;
         break;
     }
 }
@@ -719,12 +718,12 @@ void GeoDataCoordinates::geoCoordinates( qreal& lon, qreal& lat,
     {
     default:
     case Radian:
-            lon = d->m_lon;
-            lat = d->m_lat;
+            lon = m_lon;
+            lat = m_lat;
         break;
     case Degree:
-            lon = d->m_lon * RAD2DEG;
-            lat = d->m_lat * RAD2DEG;
+            lon = m_lon * RAD2DEG;
+            lat = m_lat * RAD2DEG;
         break;
     }
 }
@@ -733,7 +732,7 @@ void GeoDataCoordinates::geoCoordinates( qreal& lon, qreal& lat, qreal& alt,
                                          GeoDataCoordinates::Unit unit ) const
 {
     geoCoordinates( lon, lat, unit );
-    alt = d->m_altitude;
+    alt = m_altitude;
 }
 
 qreal GeoDataCoordinates::longitude( GeoDataCoordinates::Unit unit ) const
@@ -742,9 +741,9 @@ qreal GeoDataCoordinates::longitude( GeoDataCoordinates::Unit unit ) const
     {
     default:
     case Radian:
-        return d->m_lon;
+        return m_lon;
     case Degree:
-        return d->m_lon * RAD2DEG;
+        return m_lon * RAD2DEG;
     }
 }
 
@@ -754,9 +753,9 @@ qreal GeoDataCoordinates::latitude( GeoDataCoordinates::Unit unit ) const
     {
     default:
     case Radian:
-        return d->m_lat;
+        return m_lat;
     case Degree:
-        return d->m_lat * RAD2DEG;
+        return m_lat * RAD2DEG;
     }
 }
 
@@ -925,9 +924,9 @@ QString GeoDataCoordinates::toString() const
 
 QString GeoDataCoordinates::toString( GeoDataCoordinates::Notation notation, int precision ) const
 {
-        return  lonToString( d->m_lon, notation, Radian, precision )
+        return  lonToString( m_lon, notation, Radian, precision )
                 + QString(", ")
-                + latToString( d->m_lat, notation, Radian, precision );
+                + latToString( m_lat, notation, Radian, precision );
 }
 
 QString GeoDataCoordinates::lonToString( qreal lon, GeoDataCoordinates::Notation notation,  
@@ -1074,7 +1073,7 @@ QString GeoDataCoordinates::lonToString( qreal lon, GeoDataCoordinates::Notation
 
 QString GeoDataCoordinates::lonToString() const
 {
-    return GeoDataCoordinates::lonToString( d->m_lon , s_notation );
+    return GeoDataCoordinates::lonToString( m_lon , s_notation );
 }
 
 QString GeoDataCoordinates::latToString( qreal lat, GeoDataCoordinates::Notation notation,
@@ -1175,39 +1174,41 @@ QString GeoDataCoordinates::latToString( qreal lat, GeoDataCoordinates::Notation
 
 QString GeoDataCoordinates::latToString() const
 {
-    return GeoDataCoordinates::latToString( d->m_lat, s_notation );
+    return GeoDataCoordinates::latToString( m_lat, s_notation );
 }
 
 bool GeoDataCoordinates::operator==( const GeoDataCoordinates &rhs ) const
 {
-    return *d == *rhs.d;
+    // do not compare the m_detail member as it does not really belong to
+    // GeoDataCoordinates and should be removed
+    return m_lon == rhs.m_lon && m_lat == rhs.m_lat && m_altitude == rhs.m_altitude;
 }
 
 bool GeoDataCoordinates::operator!=( const GeoDataCoordinates &rhs ) const
 {
-    return *d != *rhs.d;
+    return !( *this == rhs );
 }
 
 void GeoDataCoordinates::setAltitude( const qreal altitude )
 {
-    detach();
-    d->m_altitude = altitude;
+    m_valid = true;
+    m_altitude = altitude;
 }
 
 qreal GeoDataCoordinates::altitude() const
 {
-    return d->m_altitude;
+    return m_altitude;
 }
 
 int GeoDataCoordinates::detail() const
 {
-    return d->m_detail;
+    return m_detail;
 }
 
 void GeoDataCoordinates::setDetail( const int det )
 {
-    detach();
-    d->m_detail = det;
+    m_valid = true;
+    m_detail = det;
 }
 
 qreal GeoDataCoordinates::bearing( const GeoDataCoordinates &other, Unit unit, BearingType type ) const
@@ -1217,49 +1218,49 @@ qreal GeoDataCoordinates::bearing( const GeoDataCoordinates &other, Unit unit, B
         return offset + other.bearing( *this, unit, InitialBearing );
     }
 
-    qreal const delta = other.d->m_lon - d->m_lon;
-    double const bearing = atan2( sin ( delta ) * cos ( other.d->m_lat ),
-                 cos( d->m_lat ) * sin( other.d->m_lat ) - sin( d->m_lat ) * cos( other.d->m_lat ) * cos ( delta ) );
+    qreal const delta = other.m_lon - m_lon;
+    double const bearing = atan2( sin ( delta ) * cos ( other.m_lat ),
+                 cos( m_lat ) * sin( other.m_lat ) - sin( m_lat ) * cos( other.m_lat ) * cos ( delta ) );
     return unit == Radian ? bearing : bearing * RAD2DEG;
 }
 
 GeoDataCoordinates GeoDataCoordinates::moveByBearing( qreal bearing, qreal distance ) const
 {
-    qreal newLat = asin( sin(d->m_lat) * cos(distance) +
-                         cos(d->m_lat) * sin(distance) * cos(bearing) );
-    qreal newLon = d->m_lon + atan2( sin(bearing) * sin(distance) * cos(d->m_lat),
-                                     cos(distance) - sin(d->m_lat) * sin(newLat) );
+    qreal newLat = asin( sin(m_lat) * cos(distance) +
+                         cos(m_lat) * sin(distance) * cos(bearing) );
+    qreal newLon = m_lon + atan2( sin(bearing) * sin(distance) * cos(m_lat),
+                                     cos(distance) - sin(m_lat) * sin(newLat) );
 
     return GeoDataCoordinates( newLon, newLat );
 }
 
 const Quaternion& GeoDataCoordinates::quaternion() const
 {
-    return d->m_q;
+    return m_q;
 }
 
 GeoDataCoordinates GeoDataCoordinates::interpolate( const GeoDataCoordinates &target, double t_ ) const
 {
     double const t = qBound( 0.0, t_, 1.0 );
-    Quaternion const quat = Quaternion::slerp( d->m_q, target.d->m_q, t );
+    Quaternion const quat = Quaternion::slerp( m_q, target.m_q, t );
     qreal lon, lat;
     quat.getSpherical( lon, lat );
-    double const alt = (1.0-t) * d->m_altitude + t * target.d->m_altitude;
+    double const alt = (1.0-t) * m_altitude + t * target.m_altitude;
     return GeoDataCoordinates( lon, lat, alt );
 }
 
 GeoDataCoordinates GeoDataCoordinates::interpolate( const GeoDataCoordinates &before, const GeoDataCoordinates &target, const GeoDataCoordinates &after, double t_ ) const
 {
     double const t = qBound( 0.0, t_, 1.0 );
-    Quaternion const b1 = GeoDataCoordinatesPrivate::basePoint( before.d->m_q, d->m_q, target.d->m_q );
-    Quaternion const a2 = GeoDataCoordinatesPrivate::basePoint( d->m_q, target.d->m_q, after.d->m_q );
-    Quaternion const a = Quaternion::slerp( d->m_q, target.d->m_q, t );
+    Quaternion const b1 = basePoint( before.m_q, m_q, target.m_q );
+    Quaternion const a2 = basePoint( m_q, target.m_q, after.m_q );
+    Quaternion const a = Quaternion::slerp( m_q, target.m_q, t );
     Quaternion const b = Quaternion::slerp( b1, a2, t );
     Quaternion c = Quaternion::slerp( a, b, 2 * t * (1.0-t) );
     qreal lon, lat;
     c.getSpherical( lon, lat );
     // @todo spline interpolation of altitude?
-    double const alt = (1.0-t) * d->m_altitude + t * target.d->m_altitude;
+    double const alt = (1.0-t) * m_altitude + t * target.m_altitude;
     return GeoDataCoordinates( lon, lat, alt );
 }
 
@@ -1268,20 +1269,20 @@ bool GeoDataCoordinates::isPole( Pole pole ) const
     // Evaluate the most likely case first:
     // The case where we haven't hit the pole and where our latitude is normalized
     // to the range of 90 deg S ... 90 deg N
-    if ( fabs( (qreal) 2.0 * d->m_lat ) < M_PI ) {
+    if ( fabs( (qreal) 2.0 * m_lat ) < M_PI ) {
         return false;
     }
     else {
-        if ( fabs( (qreal) 2.0 * d->m_lat ) == M_PI ) {
+        if ( fabs( (qreal) 2.0 * m_lat ) == M_PI ) {
             // Ok, we have hit a pole. Now let's check whether it's the one we've asked for:
             if ( pole == AnyPole ){
                 return true;
             }
             else {
-                if ( pole == NorthPole && 2.0 * d->m_lat == +M_PI ) {
+                if ( pole == NorthPole && 2.0 * m_lat == +M_PI ) {
                     return true;
                 }
-                if ( pole == SouthPole && 2.0 * d->m_lat == -M_PI ) {
+                if ( pole == SouthPole && 2.0 * m_lat == -M_PI ) {
                     return true;
                 }
                 return false;
@@ -1297,7 +1298,7 @@ bool GeoDataCoordinates::isPole( Pole pole ) const
             // Only as a last resort we cover the unlikely case where
             // the latitude is not normalized to the range of 
             // 90 deg S ... 90 deg N
-            if ( fabs( (qreal) 2.0 * normalizeLat( d->m_lat ) ) < M_PI  ) {
+            if ( fabs( (qreal) 2.0 * normalizeLat( m_lat ) ) < M_PI  ) {
                 return false;
             }
             else {
@@ -1306,10 +1307,10 @@ bool GeoDataCoordinates::isPole( Pole pole ) const
                     return true;
                 }
                 else {
-                    if ( pole == NorthPole && 2.0 * d->m_lat == +M_PI ) {
+                    if ( pole == NorthPole && 2.0 * m_lat == +M_PI ) {
                         return true;
                     }
-                    if ( pole == SouthPole && 2.0 * d->m_lat == -M_PI ) {
+                    if ( pole == SouthPole && 2.0 * m_lat == -M_PI ) {
                         return true;
                     }
                     return false;
@@ -1321,29 +1322,37 @@ bool GeoDataCoordinates::isPole( Pole pole ) const
 
 GeoDataCoordinates& GeoDataCoordinates::operator=( const GeoDataCoordinates &other )
 {
-    qAtomicAssign(d, other.d);
+    m_q = other.m_q;
+    m_lon = other.m_lon;
+    m_lat = other.m_lat;
+    m_altitude = other.m_altitude;
+    m_detail = other.m_detail;
+    m_valid = other.m_valid;
     return *this;
 }
 
 void GeoDataCoordinates::pack( QDataStream& stream ) const
 {
-    stream << d->m_lon;
-    stream << d->m_lat;
-    stream << d->m_altitude;
+    stream << m_lon;
+    stream << m_lat;
+    stream << m_altitude;
+    stream << (quint8)m_detail;
 }
 
 void GeoDataCoordinates::unpack( QDataStream& stream )
 {
-    // call detach even though it shouldn't be needed - one never knows
-    detach();
-    stream >> d->m_lon;
-    stream >> d->m_lat;
-    stream >> d->m_altitude;
+    m_valid = true;
+    stream >> m_lon;
+    stream >> m_lat;
+    stream >> m_altitude;
+    quint8 detail;
+    stream >> detail;
+    m_detail = detail;
 
-    d->m_q = Quaternion::fromSpherical( d->m_lon, d->m_lat );
+    m_q = Quaternion::fromSpherical( m_lon, m_lat );
 }
 
-Quaternion GeoDataCoordinatesPrivate::basePoint( const Quaternion &q1, const Quaternion &q2, const Quaternion &q3 )
+Quaternion GeoDataCoordinates::basePoint( const Quaternion &q1, const Quaternion &q2, const Quaternion &q3 )
 {
     Quaternion const a = (q2.inverse() * q3).log();
     Quaternion const b = (q2.inverse() * q1).log();
@@ -28,15 +28,13 @@
 
 #include "geodata_export.h"
 #include "MarbleGlobal.h"
+#include "Quaternion.h"
 
 namespace Marble
 {
 
 const qreal TWOPI = 2 * M_PI;
 
-class GeoDataCoordinatesPrivate;
-class Quaternion;
-
 /**
  * @short A 3d point representation
  *
@@ -378,9 +376,20 @@ class GEODATA_EXPORT GeoDataCoordinates
 
     virtual void detach();
  protected:
-    GeoDataCoordinatesPrivate* d;
+    // The coordinates are stored inline rather than in a shared private
+    // object: they are copied far more often than they are modified, and
+    // a copy of a few qreals is cheaper than a heap allocation and an
+    // atomic reference count. m_q is kept in sync by every setter.
+    Quaternion m_q;
+    qreal m_lon;
+    qreal m_lat;
+    qreal m_altitude;
+    int m_detail;
+    bool m_valid;
 
  private:
+    static Quaternion basePoint( const Quaternion &q1, const Quaternion &q2, const Quaternion &q3 );
+
     static GeoDataCoordinates::Notation s_notation;
     static const GeoDataCoordinates null;
 };
@@ -99,6 +99,7 @@ void GeoDataData::pack( QDataStream& stream ) const
 {
     GeoDataObject::pack( stream );
 
+    stream << d->m_name;
     stream << d->m_value;
     stream << d->m_displayName;
 }
@@ -107,6 +108,7 @@ void GeoDataData::unpack( QDataStream& stream )
 {
     GeoDataObject::unpack( stream );
 
+    stream >> d->m_name;
     stream >> d->m_value;
     stream >> d->m_displayName;
 }
@@ -29,13 +29,39 @@
 #include "GeoDataStyleMap.h"
 #include "GeoDataNetworkLinkControl.h"
 #include "GeoDataSchema.h"
+#include "GeoDataTypes.h"
 
 #include "MarbleDebug.h"
 
+#include <QDataStream>
+
 
 namespace Marble
 {
 
+namespace
+{
+
+/**
+ * Points the features below @p container to the styles of their document
+ * again, which unpack() restores after the features.
+ */
+void resolveStyleUrls( GeoDataContainer *container )
+{
+    foreach ( GeoDataFeature *feature, container->featureList() ) {
+        if ( !feature->styleUrl().isEmpty() && !feature->customStyle() ) {
+            feature->setStyleUrl( feature->styleUrl() );
+        }
+
+        // nested documents resolve their own styles when being unpacked
+        if ( feature->nodeType() == GeoDataTypes::GeoDataFolderType ) {
+            resolveStyleUrls( static_cast<GeoDataContainer*>( feature ) );
+        }
+    }
+}
+
+}
+
 GeoDataDocument::GeoDataDocument()
     : GeoDataContainer( new GeoDataDocumentPrivate )
 {
@@ -142,6 +168,15 @@ void GeoDataDocument::removeStyle( const QString& styleId )
 {
     detach();
     p()->m_styleHash.remove( styleId );
+
+    QMultiHash<uint, QString>::iterator it = p()->m_sharedStyleIds.begin();
+    while ( it != p()->m_sharedStyleIds.end() ) {
+        if ( it.value() == styleId ) {
+            it = p()->m_sharedStyleIds.erase( it );
+        } else {
+            ++it;
+        }
+    }
 }
 
 GeoDataStyle& GeoDataDocument::style( const QString& styleId )
@@ -163,6 +198,38 @@ QList<GeoDataStyle> GeoDataDocument::styles() const
     return p()->m_styleHash.values();
 }
 
+QString GeoDataDocument::addSharedStyle( const GeoDataStyle& style )
+{
+    GeoDataStyle candidate( style );
+    candidate.setId( QString() );
+
+    // pack() covers nearly all properties, operator==() settles the rest
+    QByteArray content;
+    QDataStream stream( &content, QIODevice::WriteOnly );
+    candidate.pack( stream );
+    const uint key = qHash( content );
+
+    foreach ( const QString &id, p()->m_sharedStyleIds.values( key ) ) {
+        candidate.setId( id );
+        if ( p()->m_styleHash.value( id ) == candidate ) {
+            return id;
+        }
+    }
+
+    detach();
+    QString id;
+    int index = p()->m_sharedStyleIds.size();
+    do {
+        id = QString( "shared-style-%1" ).arg( ++index );
+    } while ( p()->m_styleHash.contains( id ) );
+
+    candidate.setId( id );
+    addStyle( candidate );
+    p()->m_sharedStyleIds.insert( key, id );
+
+    return id;
+}
+
 void GeoDataDocument::addStyleMap( const GeoDataStyleMap& map )
 {
     detach();
@@ -233,6 +300,15 @@ void GeoDataDocument::pack( QDataStream& stream ) const
         ++iterator ) {
         iterator.value().pack( stream );
     }
+
+    stream << p()->m_styleMapHash.size();
+
+    for( QMap<QString, GeoDataStyleMap>::const_iterator iterator
+          = p()->m_styleMapHash.constBegin();
+        iterator != p()->m_styleMapHash.constEnd();
+        ++iterator ) {
+        iterator.value().pack( stream );
+    }
 }
 
 
@@ -247,8 +323,17 @@ void GeoDataDocument::unpack( QDataStream& stream )
     for( int i = 0; i < size; i++ ) {
         GeoDataStyle style;
         style.unpack( stream );
-        p()->m_styleHash.insert( style.id(), style );
+        addStyle( style );
+    }
+
+    stream >> size;
+    for( int i = 0; i < size; i++ ) {
+        GeoDataStyleMap styleMap;
+        styleMap.unpack( stream );
+        addStyleMap( styleMap );
     }
+
+    resolveStyleUrls( this );
 }
 
 }
@@ -142,6 +142,18 @@ public:
     */
     QList<GeoDataStyle> styles() const;
 
+    /**
+     * @brief Add a style to the style storage unless an equal one exists
+     *
+     * Use this instead of setting a new style on each of many features
+     * that look alike. The features then refer to a single style via
+     * GeoDataFeature::setStyleUrl() with the returned id. Its own id is
+     * ignored when comparing @p style to the stored styles.
+     * @param style  the style to share
+     * @return the id of the stored style
+     */
+    QString addSharedStyle( const GeoDataStyle& style );
+
     /**
     * @brief Add a stylemap to the stylemap storage
     * @param map  the new stylemap
@@ -11,6 +11,8 @@
 #ifndef MARBLE_GEODATADOCUMENTPRIVATE_H
 #define MARBLE_GEODATADOCUMENTPRIVATE_H
 
+#include <QMultiHash>
+
 #include "GeoDataStyle.h"
 #include "GeoDataNetworkLinkControl.h"
 #include "GeoDataStyleMap.h"
@@ -50,6 +52,8 @@ class GeoDataDocumentPrivate : public GeoDataContainerPrivate
     QMap<QString, GeoDataStyle> m_styleHash;
     QMap<QString, GeoDataStyleMap> m_styleMapHash;
     QMap<QString, GeoDataSchema> m_schemaHash;
+    // ids of the styles added by addSharedStyle(), by content hash
+    QMultiHash<uint, QString> m_sharedStyleIds;
     QString m_filename;
     QString m_baseUri;
     GeoDataNetworkLinkControl m_networkLinkControl;
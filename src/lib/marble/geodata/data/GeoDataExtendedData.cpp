@@ -134,11 +134,26 @@ QList<GeoDataSchemaData> GeoDataExtendedData::schemaDataList() const
 void GeoDataExtendedData::pack( QDataStream& stream ) const
 {
     GeoDataObject::pack( stream );
+
+    stream << d->hash.size();
+    QHash<QString, GeoDataData>::const_iterator it = d->hash.constBegin();
+    QHash<QString, GeoDataData>::const_iterator const end = d->hash.constEnd();
+    for ( ; it != end; ++it ) {
+        it.value().pack( stream );
+    }
 }
 
 void GeoDataExtendedData::unpack( QDataStream& stream )
 {
     GeoDataObject::unpack( stream );
+
+    int size = 0;
+    stream >> size;
+    for ( int i = 0; i < size; ++i ) {
+        GeoDataData data;
+        data.unpack( stream );
+        d->hash.insert( data.name(), data );
+    }
 }
 
 }
@@ -640,7 +640,8 @@ void GeoDataFeature::setStyleUrl( const QString &value)
     while ( object && !found ) {
         if( object->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
             GeoDataDocument *doc = static_cast<GeoDataDocument*> ( object );
-            GeoDataStyleMap &styleMap = doc->styleMap( styleUrl );
+            // const lookup, styles must not get an empty style map of their own
+            const GeoDataStyleMap styleMap = static_cast<const GeoDataDocument*>( doc )->styleMap( styleUrl );
             if( !styleMap.value( QString( "normal" ) ).isEmpty() ) {
                 styleUrl = styleMap.value( QString( "normal" ) );
                 styleUrl.remove('#');
@@ -854,11 +855,26 @@ void GeoDataFeature::pack( QDataStream& stream ) const
     stream << d->m_address;
     stream << d->m_phoneNumber;
     stream << d->m_description;
+    stream << d->m_descriptionCDATA;
+    stream << d->m_snippet.text();
+    stream << d->m_snippet.maxLines();
     stream << d->m_visible;
-//    stream << d->m_visualCategory;
+    stream << (qint32)d->m_visualCategory;
     stream << d->m_role;
     stream << d->m_popularity;
     stream << d->m_zoomLevel;
+    stream << d->m_styleUrl;
+
+    // Styles referenced by the style url belong to the document and get
+    // resolved again by setStyleUrl(). Only inline styles are stored here.
+    const bool hasInlineStyle = d->m_style
+        && ( !d->m_style->parent() || d->m_style->parent()->nodeType() != GeoDataTypes::GeoDataDocumentType );
+    stream << hasInlineStyle;
+    if ( hasInlineStyle ) {
+        d->m_style->pack( stream );
+    }
+
+    d->m_extendedData.pack( stream );
 }
 
 void GeoDataFeature::unpack( QDataStream& stream )
@@ -870,11 +886,30 @@ void GeoDataFeature::unpack( QDataStream& stream )
     stream >> d->m_address;
     stream >> d->m_phoneNumber;
     stream >> d->m_description;
+    stream >> d->m_descriptionCDATA;
+    QString snippetText;
+    int snippetMaxLines;
+    stream >> snippetText;
+    stream >> snippetMaxLines;
+    d->m_snippet = GeoDataSnippet( snippetText, snippetMaxLines );
     stream >> d->m_visible;
-//    stream >> (int)d->m_visualCategory;
+    qint32 visualCategory;
+    stream >> visualCategory;
+    d->m_visualCategory = (GeoDataVisualCategory)visualCategory;
     stream >> d->m_role;
     stream >> d->m_popularity;
     stream >> d->m_zoomLevel;
+    stream >> d->m_styleUrl;
+
+    bool hasInlineStyle;
+    stream >> hasInlineStyle;
+    if ( hasInlineStyle ) {
+        GeoDataStyle *style = new GeoDataStyle;
+        style->unpack( stream );
+        setStyle( style );
+    }
+
+    d->m_extendedData.unpack( stream );
 }
 
 GeoDataFeature::GeoDataVisualCategory GeoDataFeature::OsmVisualCategory(const QString &keyValue )
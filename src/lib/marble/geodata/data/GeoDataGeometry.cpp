@@ -25,6 +25,8 @@
 namespace Marble
 {
 
+QAtomicInt GeoDataGeometryPrivate::s_revisionCounter;
+
 GeoDataGeometry::GeoDataGeometry()
     : d( new GeoDataGeometryPrivate() )
 {
@@ -58,7 +60,10 @@ void GeoDataGeometry::detach()
 #else
     if(d->ref.load() == 1)
 #endif
+    {
+        d->m_revision = GeoDataGeometryPrivate::nextRevision();
         return;
+    }
 
      GeoDataGeometryPrivate* new_d = d->copy();
 
@@ -119,6 +124,11 @@ const GeoDataLatLonAltBox& GeoDataGeometry::latLonAltBox() const
     return d->m_latLonAltBox;
 }
 
+int GeoDataGeometry::revision() const
+{
+    return d->m_revision;
+}
+
 void GeoDataGeometry::pack( QDataStream& stream ) const
 {
     GeoDataObject::pack( stream );
@@ -65,6 +65,15 @@ class GEODATA_EXPORT GeoDataGeometry : public GeoDataObject
 
     virtual const GeoDataLatLonAltBox& latLonAltBox() const;
 
+    /**
+     * @brief Returns a number which changes whenever the geometry may have been modified.
+     *
+     * Every call to detach(), which all non-const methods do before changing the
+     * data, assigns a new revision. Caches of data derived from the geometry
+     * compare it to notice changes made in place.
+     */
+    int revision() const;
+
     /// Serialize the contents of the feature to @p stream.
     virtual void pack( QDataStream& stream ) const;
     /// Unserialize the contents of the feature from @p stream.
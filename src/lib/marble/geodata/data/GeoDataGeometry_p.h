@@ -28,6 +28,7 @@ class GeoDataGeometryPrivate
     GeoDataGeometryPrivate()
         : m_extrude( false ),
           m_altitudeMode( ClampToGround ),
+          m_revision( nextRevision() ),
           ref( 0 )
     {
     }
@@ -36,6 +37,7 @@ class GeoDataGeometryPrivate
         : m_extrude( other.m_extrude ),
           m_altitudeMode( other.m_altitudeMode ),
           m_latLonAltBox(),
+          m_revision( nextRevision() ),
           ref( 0 )
     {
     }
@@ -69,10 +71,19 @@ class GeoDataGeometryPrivate
         return InvalidGeometryId;
     }
 
+    static int nextRevision()
+    {
+        return s_revisionCounter.fetchAndAddRelaxed( 1 ) + 1;
+    }
+
     bool         m_extrude;
     AltitudeMode m_altitudeMode;
     mutable GeoDataLatLonAltBox m_latLonAltBox;
 
+    // not copied by operator=, every copy of the data gets a new revision
+    int          m_revision;
+    static QAtomicInt s_revisionCounter;
+
     QAtomicInt  ref;
 };
 
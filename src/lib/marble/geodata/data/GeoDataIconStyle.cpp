@@ -199,6 +199,8 @@ void GeoDataIconStyle::pack( QDataStream& stream ) const
     stream << d->m_scale;
     stream << d->m_icon;
     d->m_hotSpot.pack( stream );
+    // the icon is loaded lazily from its path and may not be set yet
+    stream << d->m_iconPath;
 }
 
 void GeoDataIconStyle::unpack( QDataStream& stream )
@@ -208,6 +210,7 @@ void GeoDataIconStyle::unpack( QDataStream& stream )
     stream >> d->m_scale;
     stream >> d->m_icon;
     d->m_hotSpot.unpack( stream );
+    stream >> d->m_iconPath;
 }
 
 }
@@ -11,6 +11,8 @@
 #include "GeoDataItemIcon.h"
 #include "GeoDataTypes.h"
 
+#include <QDataStream>
+
 namespace Marble
 {
 
@@ -113,4 +115,25 @@ QImage GeoDataItemIcon::icon() const
     }
 }
 
+void GeoDataItemIcon::pack( QDataStream& stream ) const
+{
+    GeoDataObject::pack( stream );
+
+    stream << int( d->m_state );
+    // the icon is loaded lazily from its path and may not be set yet
+    stream << d->m_iconPath;
+    stream << d->m_icon;
+}
+
+void GeoDataItemIcon::unpack( QDataStream& stream )
+{
+    GeoDataObject::unpack( stream );
+
+    int state;
+    stream >> state;
+    d->m_state = ItemIconStates( state );
+    stream >> d->m_iconPath;
+    stream >> d->m_icon;
+}
+
 }
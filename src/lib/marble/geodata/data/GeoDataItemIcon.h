@@ -57,6 +57,18 @@ public:
     QImage icon() const;
     void setIcon( const QImage &icon );
 
+    /**
+     * @brief Serialize the item icon to a stream
+     * @param stream the stream
+     */
+    virtual void pack( QDataStream& stream ) const;
+
+    /**
+     * @brief Unserialize the item icon from a stream
+     * @param stream the stream
+     */
+    virtual void unpack( QDataStream& stream );
+
 private:
     GeoDataItemIconPrivate* const d;
 };
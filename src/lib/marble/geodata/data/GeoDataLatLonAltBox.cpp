@@ -219,7 +219,11 @@ GeoDataLatLonAltBox GeoDataLatLonAltBox::fromLineString(  const GeoDataLineStrin
         return GeoDataLatLonAltBox();
     }
 
-    const qreal altitude = lineString.first().altitude();
+    const GeoDataCoordinateArrays<qreal> arrays = lineString.coordinateArrays();
+    const qreal *const altitudes = arrays.altitudes();
+    const int nodeCount = arrays.size();
+
+    const qreal altitude = altitudes[0];
 
     GeoDataLatLonAltBox temp ( GeoDataLatLonBox::fromLineString( lineString ), altitude, altitude );
 
@@ -227,19 +231,15 @@ GeoDataLatLonAltBox GeoDataLatLonAltBox::fromLineString(  const GeoDataLineStrin
     qreal minAltitude = altitude;
 
     // If there's only a single node stored then the boundingbox only contains that point
-    if ( lineString.size() == 1 ) {
+    if ( nodeCount == 1 ) {
         temp.setMinAltitude( minAltitude );
         temp.setMaxAltitude( maxAltitude );
         return temp;
     }
 
-    QVector<GeoDataCoordinates>::ConstIterator it( lineString.constBegin() );
-    QVector<GeoDataCoordinates>::ConstIterator itEnd( lineString.constEnd() );
-
-    for ( ; it != itEnd; ++it )
+    for ( int i = 1; i < nodeCount; ++i )
     {
-        // Get coordinates and normalize them to the desired range.
-        const qreal altitude = (it)->altitude();
+        const qreal altitude = altitudes[i];
 
         // Determining the maximum and minimum latitude
         if ( altitude > maxAltitude ) maxAltitude = altitude;
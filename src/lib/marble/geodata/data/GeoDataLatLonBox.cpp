@@ -624,8 +624,13 @@ GeoDataLatLonBox GeoDataLatLonBox::fromLineString(  const GeoDataLineString& lin
         return GeoDataLatLonBox();
     }
 
-    qreal lon, lat;
-    lineString.first().geoCoordinates( lon, lat );
+    const GeoDataCoordinateArrays<qreal> arrays = lineString.coordinateArrays();
+    const qreal *const longitudes = arrays.longitudes();
+    const qreal *const latitudes = arrays.latitudes();
+    const int nodeCount = arrays.size();
+
+    qreal lon = longitudes[0];
+    qreal lat = latitudes[0];
     GeoDataCoordinates::normalizeLonLat( lon, lat );
 
     qreal north = lat;
@@ -634,7 +639,7 @@ GeoDataLatLonBox GeoDataLatLonBox::fromLineString(  const GeoDataLineString& lin
     qreal east =  lon;
 
     // If there's only a single node stored then the boundingbox only contains that point
-    if ( lineString.size() == 1 )
+    if ( nodeCount == 1 )
         return GeoDataLatLonBox( north, south, east, west );
 
     // Specifies whether the polygon crosses the IDL
@@ -660,14 +665,13 @@ GeoDataLatLonBox GeoDataLatLonBox::fromLineString(  const GeoDataLineString& lin
     int currentSign = ( lon < 0 ) ? -1 : +1;
     int previousSign = currentSign;
 
-    QVector<GeoDataCoordinates>::ConstIterator it( lineString.constBegin() );
-    QVector<GeoDataCoordinates>::ConstIterator itEnd( lineString.constEnd() );
+    // Linear rings get the first node processed once more at the end.
+    const int lastIndex = lineString.isClosed() ? nodeCount : nodeCount - 1;
 
-    bool processingLastNode = false;
-
-    while( it != itEnd ) {
+    for ( int i = 0; i <= lastIndex; ++i ) {
         // Get coordinates and normalize them to the desired range.
-        (it)->geoCoordinates( lon, lat );
+        lon = longitudes[ i < nodeCount ? i : 0 ];
+        lat = latitudes[ i < nodeCount ? i : 0 ];
         GeoDataCoordinates::normalizeLonLat( lon, lat );
 
         // Determining the maximum and minimum latitude
@@ -721,16 +725,6 @@ GeoDataLatLonBox GeoDataLatLonBox::fromLineString(  const GeoDataLineString& lin
 
         previousLon = lon;
         previousSign = currentSign;
-
-        if ( processingLastNode ) {
-            break;
-        }
-        ++it;
-
-        if( lineString.isClosed() && it == itEnd ) {
-                it = lineString.constBegin();
-                processingLastNode = true;
-        }
     }
 
     if ( idlCrossed ) {
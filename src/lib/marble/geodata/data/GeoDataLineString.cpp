@@ -21,6 +21,20 @@
 
 namespace Marble
 {
+
+namespace
+{
+
+/// A range of nodes which GeoDataLineString::assignDetailLevels() simplifies
+struct DetailRange
+{
+    int first;
+    int last;
+    qreal significance;
+};
+
+}
+
 GeoDataLineString::GeoDataLineString( TessellationFlags f )
   : GeoDataGeometry( new GeoDataLineStringPrivate( f ) )
 {
@@ -145,6 +159,7 @@ GeoDataCoordinates& GeoDataLineString::at( int pos )
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    p()->markArraysStale( pos, pos + 1 );
     return p()->m_vector[ pos ];
 }
 
@@ -158,6 +173,7 @@ GeoDataCoordinates& GeoDataLineString::operator[]( int pos )
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    p()->markArraysStale( pos, pos + 1 );
     return p()->m_vector[ pos ];
 }
 
@@ -171,12 +187,14 @@ GeoDataCoordinates& GeoDataLineString::last()
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    p()->markArraysStale( size() - 1, size() );
     return p()->m_vector.last();
 }
 
 GeoDataCoordinates& GeoDataLineString::first()
 {
     GeoDataGeometry::detach();
+    p()->markArraysStale( 0, 1 );
     return p()->m_vector.first();
 }
 
@@ -193,6 +211,7 @@ const GeoDataCoordinates& GeoDataLineString::first() const
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::begin()
 {
     GeoDataGeometry::detach();
+    p()->markArraysStale( 0, size() );
     return p()->m_vector.begin();
 }
 
@@ -204,6 +223,7 @@ QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::begin() const
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::end()
 {
     GeoDataGeometry::detach();
+    p()->markArraysStale( 0, size() );
     return p()->m_vector.end();
 }
 
@@ -230,7 +250,9 @@ void GeoDataLineString::insert( int index, const GeoDataCoordinates& value )
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->updateArrays();
     d->m_vector.insert( index, value );
+    d->m_arrays.insert( index, value );
 }
 
 void GeoDataLineString::append ( const GeoDataCoordinates& value )
@@ -241,7 +263,9 @@ void GeoDataLineString::append ( const GeoDataCoordinates& value )
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->updateArrays();
     d->m_vector.append( value );
+    d->m_arrays.append( value );
 }
 
 GeoDataLineString& GeoDataLineString::operator << ( const GeoDataCoordinates& value )
@@ -252,7 +276,9 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataCoordinates& va
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->updateArrays();
     d->m_vector.append( value );
+    d->m_arrays.append( value );
     return *this;
 }
 
@@ -264,12 +290,17 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataLineString& val
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->updateArrays();
+
+    d->m_vector.reserve( d->m_vector.size() + value.size() );
+    d->m_arrays.reserve( d->m_vector.size() + value.size() );
 
     QVector<GeoDataCoordinates>::const_iterator itCoords = value.constBegin();
     QVector<GeoDataCoordinates>::const_iterator itEnd = value.constEnd();
 
     for( ; itCoords != itEnd; ++itCoords ) {
         d->m_vector.append( *itCoords );
+        d->m_arrays.append( *itCoords );
     }
 
     return *this;
@@ -316,6 +347,9 @@ void GeoDataLineString::clear()
     d->m_dirtyBox = true;
 
     d->m_vector.clear();
+    d->m_arrays.clear();
+    d->m_staleArraysBegin = 0;
+    d->m_staleArraysEnd = 0;
 }
 
 bool GeoDataLineString::isClosed() const
@@ -352,6 +386,7 @@ TessellationFlags GeoDataLineString::tessellationFlags() const
 
 void GeoDataLineString::setTessellationFlags( TessellationFlags f )
 {
+    GeoDataGeometry::detach();
     p()->m_tessellationFlags = f;
 }
 
@@ -496,10 +531,11 @@ void GeoDataLineStringPrivate::toDateLineCorrected(
 {
     const bool isClosed = q.isClosed();
 
-    const QVector<GeoDataCoordinates>::const_iterator itStartPoint = q.constBegin();
-    const QVector<GeoDataCoordinates>::const_iterator itEndPoint = q.constEnd();
-    QVector<GeoDataCoordinates>::const_iterator itPoint = itStartPoint;
-    QVector<GeoDataCoordinates>::const_iterator itPreviousPoint = itPoint;
+    // Only nodes next to a crossing of the date line are needed as a
+    // whole, finding the crossings just takes the longitudes.
+    const GeoDataCoordinateArrays<qreal> arrays = q.coordinateArrays();
+    const qreal *const longitudes = arrays.longitudes();
+    const int nodeCount = arrays.size();
 
     TessellationFlags f = q.tessellationFlags();
 
@@ -514,12 +550,12 @@ void GeoDataLineStringPrivate::toDateLineCorrected(
 
     bool unfinished = false;
 
-    for (; itPoint != itEndPoint; ++itPoint ) {
-        currentLon = itPoint->longitude();
+    for ( int i = 0; i < nodeCount; ++i ) {
+        currentLon = longitudes[i];
 
         int currentSign = ( currentLon < 0.0 ) ? -1 : +1 ;
 
-        if( itPoint == q.constBegin() ) {
+        if( i == 0 ) {
             previousSign = currentSign;
             previousLon  = currentLon;
         }
@@ -532,7 +568,7 @@ void GeoDataLineStringPrivate::toDateLineCorrected(
             GeoDataCoordinates previousTemp;
             GeoDataCoordinates currentTemp;
 
-            interpolateDateLine( *itPreviousPoint, *itPoint,
+            interpolateDateLine( m_vector.at( i - 1 ), m_vector.at( i ),
                                  previousTemp, currentTemp, q.tessellationFlags() );
 
             *dateLineCorrected << previousTemp;
@@ -566,16 +602,15 @@ void GeoDataLineStringPrivate::toDateLineCorrected(
             }
 
             *dateLineCorrected << currentTemp;
-            *dateLineCorrected << *itPoint;
+            *dateLineCorrected << m_vector.at( i );
 
         }
         else {
-            *dateLineCorrected << *itPoint;
+            *dateLineCorrected << m_vector.at( i );
         }
 
         previousSign = currentSign;
         previousLon  = currentLon;
-        itPreviousPoint = itPoint;
     }
 
     // If the line string doesn't cross the dateline an even number of times
@@ -602,24 +637,124 @@ const GeoDataLatLonAltBox& GeoDataLineString::latLonAltBox() const
     return p()->m_latLonAltBox;
 }
 
+GeoDataCoordinateArrays<qreal> GeoDataLineString::coordinateArrays() const
+{
+    if ( p()->m_staleArraysBegin < p()->m_staleArraysEnd ) {
+        // Nodes were handed out for modification since the last change.
+        // Don't write to the shared arrays from a const method, which may
+        // be called from several threads at once.
+        return GeoDataCoordinateArrays<qreal>( p()->m_vector );
+    }
+
+    return p()->m_arrays;
+}
+
 qreal GeoDataLineString::length( qreal planetRadius, int offset ) const
 {
     if( offset < 0 || offset >= size() ) {
         return 0;
     }
 
+    const GeoDataCoordinateArrays<qreal> arrays = coordinateArrays();
+    const qreal *const longitudes = arrays.longitudes();
+    const qreal *const latitudes = arrays.latitudes();
+    const int end = arrays.size();
+
     qreal length = 0.0;
-    QVector<GeoDataCoordinates> const & vector = p()->m_vector;
-    int const start = qMax(offset+1, 1);
-    int const end = p()->m_vector.size();
-    for( int i=start; i<end; ++i )
-    {
-        length += distanceSphere( vector[i-1], vector[i] );
+    for ( int i = offset + 1; i < end; ++i ) {
+        length += distanceSphere( longitudes[i-1], latitudes[i-1], longitudes[i], latitudes[i] );
     }
 
     return planetRadius * length;
 }
 
+void GeoDataLineString::assignDetailLevels()
+{
+    // Keep in sync with the radius thresholds in
+    // AbstractProjectionPrivate::resolvedNodes(): nodes of detail level d
+    // are drawn at radii above s_detailRadius[d-1].
+    static const qreal s_detailRadius[] = { 50, 600, 1000, 2500, 5000 };
+    static const int s_maximumDetail = 5;
+
+    const int nodeCount = p()->m_vector.size();
+    if ( nodeCount <= 50 ) {
+        return;
+    }
+
+    const GeoDataCoordinates *const nodes = p()->m_vector.constData();
+    for ( int i = 0; i < nodeCount; ++i ) {
+        if ( nodes[i].detail() != 0 ) {
+            return;
+        }
+    }
+
+    // Run Douglas-Peucker once and remember for each node the tolerance
+    // up to which it gets kept. Limiting it by the tolerance of the
+    // enclosing range makes the simplifications of all levels nested.
+    QVector<qreal> significance( nodeCount, 0.0 );
+    significance[0] = significance[nodeCount-1] = M_PI;
+
+    QVector<DetailRange> ranges;
+    DetailRange const all = { 0, nodeCount - 1, M_PI };
+    ranges.append( all );
+
+    while ( !ranges.isEmpty() ) {
+        const DetailRange range = ranges.last();
+        ranges.pop_back();
+
+        if ( range.last - range.first < 2 ) {
+            continue;
+        }
+
+        const GeoDataCoordinates &first = nodes[range.first];
+        const GeoDataCoordinates &last = nodes[range.last];
+
+        // distances on a plate carrée that is locally scaled to the chord
+        const qreal scale = cos( 0.5 * ( first.latitude() + last.latitude() ) );
+        const qreal x0 = first.longitude() * scale;
+        const qreal y0 = first.latitude();
+        const qreal dx = last.longitude() * scale - x0;
+        const qreal dy = last.latitude() - y0;
+        const qreal chordLength = sqrt( dx * dx + dy * dy );
+
+        int farthest = range.first + 1;
+        qreal maximumDistance = -1.0;
+        for ( int i = range.first + 1; i < range.last; ++i ) {
+            const qreal x = nodes[i].longitude() * scale - x0;
+            const qreal y = nodes[i].latitude() - y0;
+            const qreal distance = chordLength > 0.0 ? fabs( x * dy - y * dx ) / chordLength
+                                                     : sqrt( x * x + y * y );
+            if ( distance > maximumDistance ) {
+                maximumDistance = distance;
+                farthest = i;
+            }
+        }
+
+        const qreal nodeSignificance = qMin( maximumDistance, range.significance );
+        significance[farthest] = nodeSignificance;
+
+        DetailRange const before = { range.first, farthest, nodeSignificance };
+        DetailRange const after = { farthest, range.last, nodeSignificance };
+        ranges.append( before );
+        ranges.append( after );
+    }
+
+    GeoDataGeometry::detach();
+    GeoDataLineStringPrivate* d = p();
+    delete d->m_rangeCorrected;
+    d->m_rangeCorrected = 0;
+    d->m_dirtyRange = true;
+
+    for ( int i = 0; i < nodeCount; ++i ) {
+        int detail = 0;
+        // half a pixel at the largest radius the detail level is drawn at
+        while ( detail < s_maximumDetail && significance[i] <= 0.5 / s_detailRadius[detail] ) {
+            ++detail;
+        }
+        d->m_vector[i].setDetail( detail );
+    }
+}
+
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoDataCoordinates>::Iterator pos )
 {
     GeoDataGeometry::detach();
@@ -628,6 +763,8 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->updateArrays();
+    d->m_arrays.remove( pos - d->m_vector.begin() );
     return d->m_vector.erase( pos );
 }
 
@@ -640,6 +777,8 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->updateArrays();
+    d->m_arrays.remove( begin - d->m_vector.begin(), end - begin );
     return d->m_vector.erase( begin, end );
 }
 
@@ -649,7 +788,9 @@ void GeoDataLineString::remove ( int i )
     GeoDataLineStringPrivate* d = p();
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->updateArrays();
     d->m_vector.remove( i );
+    d->m_arrays.remove( i );
 }
 
 void GeoDataLineString::pack( QDataStream& stream ) const
@@ -663,9 +804,7 @@ void GeoDataLineString::pack( QDataStream& stream ) const
           = p()->m_vector.constBegin();
          iterator != p()->m_vector.constEnd();
          ++iterator ) {
-        mDebug() << "innerRing: size" << p()->m_vector.size();
-        GeoDataCoordinates coord = ( *iterator );
-        coord.pack( stream );
+        iterator->pack( stream );
     }
 
 }
@@ -681,11 +820,17 @@ void GeoDataLineString::unpack( QDataStream& stream )
     stream >> tessellationFlags;
 
     p()->m_tessellationFlags = (TessellationFlags)(tessellationFlags);
+    p()->m_dirtyRange = true;
+    p()->m_dirtyBox = true;
+    p()->updateArrays();
 
+    p()->m_vector.reserve( p()->m_vector.size() + size );
+    p()->m_arrays.reserve( p()->m_vector.size() + size );
     for(qint32 i = 0; i < size; i++ ) {
         GeoDataCoordinates coord;
         coord.unpack( stream );
         p()->m_vector.append( coord );
+        p()->m_arrays.append( coord );
     }
 }
 
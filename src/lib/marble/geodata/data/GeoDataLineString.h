@@ -22,6 +22,7 @@
 #include "geodata_export.h"
 #include "GeoDataGeometry.h"
 #include "GeoDataCoordinates.h"
+#include "GeoDataCoordinateArrays.h"
 #include "GeoDataLatLonAltBox.h"
 
 
@@ -146,6 +147,20 @@ class GEODATA_EXPORT GeoDataLineString : public GeoDataGeometry
 
    virtual const GeoDataLatLonAltBox& latLonAltBox() const;
 
+/*!
+    \brief Returns the nodes as separate arrays of longitudes, latitudes and altitudes.
+
+    The LineString keeps these arrays up to date whenever it changes, so
+    the call is cheap and safe to use from several threads. Only nodes
+    modified through a non-const reference since the last change get picked
+    up by the next change; until then the arrays are created on each call.
+    They are meant for code that processes all nodes in one go, e.g.
+    computing the bounding box or projecting the nodes onto the screen.
+
+    \see GeoDataCoordinateArrays
+*/
+    GeoDataCoordinateArrays<qreal> coordinateArrays() const;
+
 /**
   * @brief Returns the length of LineString across a sphere starting from a coordinate in LineString
   * This method can be used as an approximation for distances along LineStrings.
@@ -156,6 +171,24 @@ class GEODATA_EXPORT GeoDataLineString : public GeoDataGeometry
   */
     virtual qreal length( qreal planetRadius, int offset = 0 ) const;
 
+/*!
+    \brief Assigns detail levels to the nodes of the LineString.
+
+    The projections skip nodes whose detail level is too high for the
+    current radius of the viewport (see GeoDataCoordinates::detail()).
+    This method simplifies the LineString with the Douglas-Peucker
+    algorithm once for each detail level, using a tolerance of half a
+    pixel at the largest radius the level is drawn at, and gives each node
+    the lowest level it survives in. This way zoomed out views only
+    project and paint a fraction of the nodes.
+
+    The first and the last node always get detail level 0. LineStrings of
+    at most 50 nodes, which the projections never simplify, and LineStrings
+    that already carry detail levels, e.g. from .pn2 files, are left as
+    they are.
+*/
+    void assignDetailLevels();
+
 /*!
     \brief Provides a more generic representation of the LineString.
 
@@ -13,6 +13,7 @@
 
 #include "GeoDataGeometry_p.h"
 
+#include "GeoDataCoordinateArrays.h"
 #include "GeoDataTypes.h"
 
 namespace Marble
@@ -25,14 +26,18 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
         :  m_rangeCorrected( 0 ),
            m_dirtyRange( true ),
            m_dirtyBox( true ),
-           m_tessellationFlags( f )
+           m_tessellationFlags( f ),
+           m_staleArraysBegin( 0 ),
+           m_staleArraysEnd( 0 )
     {
     }
 
     GeoDataLineStringPrivate()
          : m_rangeCorrected( 0 ),
            m_dirtyRange( true ),
-           m_dirtyBox( true )
+           m_dirtyBox( true ),
+           m_staleArraysBegin( 0 ),
+           m_staleArraysEnd( 0 )
     {
     }
 
@@ -49,6 +54,9 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
         m_dirtyRange = true;
         m_dirtyBox = other.m_dirtyBox;
         m_tessellationFlags = other.m_tessellationFlags;
+        m_arrays = other.m_arrays;
+        m_staleArraysBegin = other.m_staleArraysBegin;
+        m_staleArraysEnd = other.m_staleArraysEnd;
         return *this;
     }
 
@@ -81,6 +89,36 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
                               GeoDataCoordinates & currentAtDateline,
                               TessellationFlags f ) const;
 
+    /**
+     * Marks the nodes in [begin, end) as handed out for modification by
+     * reference, so m_arrays may no longer match them.
+     */
+    void markArraysStale( int begin, int end )
+    {
+        if ( m_staleArraysBegin >= m_staleArraysEnd ) {
+            m_staleArraysBegin = begin;
+            m_staleArraysEnd = end;
+        } else {
+            m_staleArraysBegin = qMin( m_staleArraysBegin, begin );
+            m_staleArraysEnd = qMax( m_staleArraysEnd, end );
+        }
+    }
+
+    /**
+     * Copies the nodes marked as stale into m_arrays. Every method that
+     * modifies m_vector calls this first and then applies the same change
+     * to m_arrays, so that const methods never need to write to them.
+     */
+    void updateArrays()
+    {
+        const int end = qMin( m_staleArraysEnd, m_vector.size() );
+        for ( int i = m_staleArraysBegin; i < end; ++i ) {
+            m_arrays.set( i, m_vector.at( i ) );
+        }
+        m_staleArraysBegin = 0;
+        m_staleArraysEnd = 0;
+    }
+
     GeoDataCoordinates findDateLine( const GeoDataCoordinates & previousCoords,
                        const GeoDataCoordinates & currentCoords,
                        int recursionCounter ) const;
@@ -94,6 +132,10 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
                                             // GeoDataPoints since the LatLonAltBox has 
                                             // been calculated. Saves performance. 
     TessellationFlags           m_tessellationFlags;
+
+    GeoDataCoordinateArrays<qreal> m_arrays; // the positions of m_vector
+    int                         m_staleArraysBegin;
+    int                         m_staleArraysEnd;
 };
 
 } // namespace Marble
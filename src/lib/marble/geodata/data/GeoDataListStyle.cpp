@@ -203,6 +203,8 @@ QVector<GeoDataItemIcon*>::ConstIterator GeoDataListStyle::constEnd() const
 void GeoDataListStyle::pack( QDataStream& stream ) const
 {
     GeoDataObject::pack( stream );
+    stream << int( d->m_listItemType );
+    stream << d->m_bgColor;
     stream << d->m_vector.count();
 
     for ( QVector <GeoDataItemIcon*>::const_iterator iterator = d->m_vector.constBegin();
@@ -218,15 +220,19 @@ void GeoDataListStyle::unpack( QDataStream& stream )
 {
     GeoDataObject::unpack( stream );
 
+    int listItemType;
+    stream >> listItemType;
+    d->m_listItemType = GeoDataListStyle::ListItemType( listItemType );
+    stream >> d->m_bgColor;
+
     int count;
     stream >> count;
 
-    int featureId;
-    stream >> featureId;
-
-    GeoDataItemIcon *itemIcon = new GeoDataItemIcon;
-    itemIcon->unpack( stream );
-    d->m_vector.append( itemIcon );
+    for ( int i = 0; i < count; ++i ) {
+        GeoDataItemIcon *itemIcon = new GeoDataItemIcon;
+        itemIcon->unpack( stream );
+        d->m_vector.append( itemIcon );
+    }
 }
 
 }
@@ -12,13 +12,12 @@
 #define MARBLE_GEODATAPOINTPRIVATE_H
 
 #include "GeoDataGeometry_p.h"
-#include "GeoDataCoordinates_p.h"
+#include "GeoDataCoordinates.h"
 
 namespace Marble
 {
 
-class GeoDataPointPrivate : public GeoDataGeometryPrivate,
-                            public GeoDataCoordinatesPrivate
+class GeoDataPointPrivate : public GeoDataGeometryPrivate
 {
 public:
     GeoDataCoordinates m_coordinates;
@@ -21,13 +21,18 @@ namespace Marble
 
 GeoLineStringGraphicsItem::GeoLineStringGraphicsItem( const GeoDataFeature *feature, const GeoDataLineString* lineString )
         : GeoGraphicsItem( feature ),
-          m_lineString( lineString )
+          m_lineString( lineString ),
+          m_penValid( false ),
+          m_penStyle( 0 ),
+          m_penRadius( 0 ),
+          m_penQuality( NormalQuality )
 {
 }
 
 void GeoLineStringGraphicsItem::setLineString( const GeoDataLineString* lineString )
 {
     m_lineString = lineString;
+    m_projectedLineString.clear();
 }
 
 const GeoDataLatLonAltBox& GeoLineStringGraphicsItem::latLonAltBox() const
@@ -37,6 +42,22 @@ const GeoDataLatLonAltBox& GeoLineStringGraphicsItem::latLonAltBox() const
 
 void GeoLineStringGraphicsItem::paint( GeoPainter* painter, const ViewportParams* viewport )
 {
+    // Immediately leave this method now if:
+    // - the object is not visible in the viewport or if
+    // - the size of the object is below the resolution of the viewport
+    if ( !viewport->viewLatLonAltBox().intersects( m_lineString->latLonAltBox() ) ||
+         !viewport->resolves( m_lineString->latLonAltBox() ) ) {
+        return;
+    }
+
+    if ( !m_projectedLineString.isValid( viewport, m_lineString ) ) {
+        QVector<QPolygonF*> polygons;
+        viewport->screenCoordinates( *m_lineString, polygons );
+        const bool translatable = !m_lineString->isClosed()
+                                  || m_lineString->latLonAltBox().width() < 2 * M_PI;
+        m_projectedLineString.setPolygons( viewport, m_lineString, polygons, translatable );
+    }
+
     LabelPositionFlags labelPositionFlags = NoLabel;
 
     painter->save();
@@ -45,40 +66,21 @@ void GeoLineStringGraphicsItem::paint( GeoPainter* painter, const ViewportParams
         painter->setPen( QPen() );
     }
     else {
-        QPen currentPen = painter->pen();
-
-        if ( currentPen.color() != style()->lineStyle().paintedColor() )
-            currentPen.setColor( style()->lineStyle().paintedColor() );
-
-        if ( currentPen.widthF() != style()->lineStyle().width() ||
-                style()->lineStyle().physicalWidth() != 0.0 ) {
-            if ( float( viewport->radius() ) / EARTH_RADIUS * style()->lineStyle().physicalWidth() < style()->lineStyle().width() )
-                currentPen.setWidthF( style()->lineStyle().width() );
-            else
-                currentPen.setWidthF( float( viewport->radius() ) / EARTH_RADIUS * style()->lineStyle().physicalWidth() );
-        }
-        else if ( style()->lineStyle().width() != 0.0 ) {
-            currentPen.setWidthF( style()->lineStyle().width() );
+        if ( !m_penValid
+             || m_penStyle != style()
+             || m_penRadius != viewport->radius()
+             || m_penQuality != painter->mapQuality()
+             || m_penBase != painter->pen() ) {
+            m_pen = linePen( painter, viewport );
+            m_penValid = true;
+            m_penStyle = style();
+            m_penRadius = viewport->radius();
+            m_penQuality = painter->mapQuality();
+            m_penBase = painter->pen();
         }
 
-        if ( currentPen.capStyle() != style()->lineStyle().capStyle() )
-            currentPen.setCapStyle( style()->lineStyle().capStyle() );
-
-        if ( currentPen.style() != style()->lineStyle().penStyle() )
-            currentPen.setStyle( style()->lineStyle().penStyle() );
-
-        if ( style()->lineStyle().penStyle() == Qt::CustomDashLine )
-            currentPen.setDashPattern( style()->lineStyle().dashPattern() );
-
-        if ( painter->mapQuality() != Marble::HighQuality
-                && painter->mapQuality() != Marble::PrintQuality ) {
-            QColor penColor = currentPen.color();
-            penColor.setAlpha( 255 );
-            currentPen.setColor( penColor );
-        }
-
-        if ( painter->pen() != currentPen )
-            painter->setPen( currentPen );
+        if ( painter->pen() != m_pen )
+            painter->setPen( m_pen );
 
         if ( style()->lineStyle().background() ) {
             QBrush brush = painter->background();
@@ -100,9 +102,46 @@ void GeoLineStringGraphicsItem::paint( GeoPainter* painter, const ViewportParams
         }
     }
 
-    painter->drawPolyline( *m_lineString, feature()->name(), labelPositionFlags );
+    painter->drawPolyline( m_projectedLineString.polygons(), feature()->name(), labelPositionFlags );
 
     painter->restore();
 }
 
+QPen GeoLineStringGraphicsItem::linePen( const GeoPainter *painter, const ViewportParams *viewport ) const
+{
+    QPen currentPen = painter->pen();
+
+    if ( currentPen.color() != style()->lineStyle().paintedColor() )
+        currentPen.setColor( style()->lineStyle().paintedColor() );
+
+    if ( currentPen.widthF() != style()->lineStyle().width() ||
+            style()->lineStyle().physicalWidth() != 0.0 ) {
+        if ( float( viewport->radius() ) / EARTH_RADIUS * style()->lineStyle().physicalWidth() < style()->lineStyle().width() )
+            currentPen.setWidthF( style()->lineStyle().width() );
+        else
+            currentPen.setWidthF( float( viewport->radius() ) / EARTH_RADIUS * style()->lineStyle().physicalWidth() );
+    }
+    else if ( style()->lineStyle().width() != 0.0 ) {
+        currentPen.setWidthF( style()->lineStyle().width() );
+    }
+
+    if ( currentPen.capStyle() != style()->lineStyle().capStyle() )
+        currentPen.setCapStyle( style()->lineStyle().capStyle() );
+
+    if ( currentPen.style() != style()->lineStyle().penStyle() )
+        currentPen.setStyle( style()->lineStyle().penStyle() );
+
+    if ( style()->lineStyle().penStyle() == Qt::CustomDashLine )
+        currentPen.setDashPattern( style()->lineStyle().dashPattern() );
+
+    if ( painter->mapQuality() != Marble::HighQuality
+            && painter->mapQuality() != Marble::PrintQuality ) {
+        QColor penColor = currentPen.color();
+        penColor.setAlpha( 255 );
+        currentPen.setColor( penColor );
+    }
+
+    return currentPen;
+}
+
 }
@@ -11,7 +11,11 @@
 #ifndef MARBLE_GEOLINESTRINGGRAPHICSITEM_H
 #define MARBLE_GEOLINESTRINGGRAPHICSITEM_H
 
+#include <QPen>
+
 #include "GeoGraphicsItem.h"
+#include "MarbleGlobal.h"
+#include "ProjectedGeometryCache.h"
 #include "marble_export.h"
 
 namespace Marble
@@ -19,6 +23,7 @@ namespace Marble
 
 class GeoDataLineString;
 class GeoDataLineStyle;
+class GeoDataStyle;
 
 class MARBLE_EXPORT GeoLineStringGraphicsItem : public GeoGraphicsItem
 {
@@ -33,6 +38,19 @@ public:
 
 protected:
     const GeoDataLineString *m_lineString;
+
+private:
+    QPen linePen( const GeoPainter *painter, const ViewportParams *viewport ) const;
+
+    ProjectedGeometryCache m_projectedLineString;
+
+    // the pen resolved from the style and the state it was resolved for
+    QPen m_pen;
+    bool m_penValid;
+    const GeoDataStyle *m_penStyle;
+    int m_penRadius;
+    MapQuality m_penQuality;
+    QPen m_penBase;
 };
 
 }
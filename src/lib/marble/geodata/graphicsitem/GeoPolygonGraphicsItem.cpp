@@ -22,14 +22,20 @@ namespace Marble
 GeoPolygonGraphicsItem::GeoPolygonGraphicsItem( const GeoDataFeature *feature, const GeoDataPolygon* polygon )
         : GeoGraphicsItem( feature ),
           m_polygon( polygon ),
-          m_ring( 0 )
+          m_ring( 0 ),
+          m_paintStateValid( false ),
+          m_paintStateStyle( 0 ),
+          m_paintStateQuality( NormalQuality )
 {
 }
 
 GeoPolygonGraphicsItem::GeoPolygonGraphicsItem( const GeoDataFeature *feature, const GeoDataLinearRing* ring )
         : GeoGraphicsItem( feature ),
           m_polygon( 0 ),
-          m_ring( ring )
+          m_ring( ring ),
+          m_paintStateValid( false ),
+          m_paintStateStyle( 0 ),
+          m_paintStateQuality( NormalQuality )
 {
 }
 
@@ -46,7 +52,24 @@ const GeoDataLatLonAltBox& GeoPolygonGraphicsItem::latLonAltBox() const
 
 void GeoPolygonGraphicsItem::paint( GeoPainter* painter, const ViewportParams* viewport )
 {
-    Q_UNUSED( viewport );
+    const GeoDataLinearRing *const outerBoundary = m_polygon ? &m_polygon->outerBoundary() : m_ring;
+    if ( !outerBoundary ) {
+        return;
+    }
+
+    // Immediately leave this method now if:
+    // - the object is not visible in the viewport or if
+    // - the size of the object is below the resolution of the viewport
+    if ( !viewport->viewLatLonAltBox().intersects( outerBoundary->latLonAltBox() ) ||
+         !viewport->resolves( outerBoundary->latLonAltBox() ) ) {
+        return;
+    }
+
+    // the annotate plugin edits polygons in place while nodes get dragged
+    const GeoDataGeometry *const geometry = m_polygon ? static_cast<const GeoDataGeometry *>( m_polygon ) : m_ring;
+    if ( !m_projectedPolygons.isValid( viewport, geometry ) || !m_projectedOutline.isValid( viewport, geometry ) ) {
+        updatePolygons( viewport, geometry );
+    }
 
     painter->save();
 
@@ -54,53 +77,130 @@ void GeoPolygonGraphicsItem::paint( GeoPainter* painter, const ViewportParams* v
         painter->setPen( QPen() );
     }
     else {
-        QPen currentPen = painter->pen();
+        updatePaintState( painter );
+
+        if ( painter->pen() != m_pen )
+            painter->setPen( m_pen );
 
-        if ( !style()->polyStyle().outline() ) {
-            currentPen.setColor( Qt::transparent );
+        if ( painter->brush() != m_brush )
+            painter->setBrush( m_brush );
+    }
+
+    // When inner boundaries exist, the outline of the polygon must be painted
+    // separately to avoid connections between the outer and inner boundaries.
+    // See GeoPainter::drawPolygon( const GeoDataPolygon& ).
+    const bool needOutlineWorkaround = !m_projectedOutline.polygons().isEmpty();
+    const QPen outlinePen = painter->pen();
+    if ( needOutlineWorkaround ) {
+        painter->setPen( QPen( Qt::NoPen ) );
+    }
+
+    foreach( const QPolygonF* polygon, m_projectedPolygons.polygons() ) {
+        painter->drawPolygon( *polygon );
+    }
+
+    if ( needOutlineWorkaround ) {
+        painter->setPen( outlinePen );
+        foreach( const QPolygonF* polygon, m_projectedOutline.polygons() ) {
+            painter->drawPolyline( *polygon );
         }
-        else {
-            if ( currentPen.color() != style()->lineStyle().paintedColor() ||
-                currentPen.widthF() != style()->lineStyle().width() ) {
-                currentPen.setColor( style()->lineStyle().paintedColor() );
-                currentPen.setWidthF( style()->lineStyle().width() );
-            }
+    }
+
+    painter->restore();
+}
+
+void GeoPolygonGraphicsItem::updatePolygons( const ViewportParams *viewport, const GeoDataGeometry *geometry )
+{
+    const GeoDataLinearRing &outerBoundary = m_polygon ? m_polygon->outerBoundary() : *m_ring;
+
+    // Rings spanning all longitudes get closed along the border of the
+    // viewport, which moves with the center of the map.
+    const bool translatable = outerBoundary.latLonAltBox().width() < 2 * M_PI;
+
+    QVector<QPolygonF*> outerPolygons;
+    viewport->screenCoordinates( outerBoundary, outerPolygons );
 
-            if ( currentPen.capStyle() != style()->lineStyle().capStyle() )
-                currentPen.setCapStyle( style()->lineStyle().capStyle() );
+    QVector<QPolygonF*> outline;
+    if ( m_polygon && !m_polygon->innerBoundaries().isEmpty() ) {
+        foreach( const QPolygonF* polygon, outerPolygons ) {
+            outline << new QPolygonF( *polygon );
+        }
 
-            if ( currentPen.style() != style()->lineStyle().penStyle() )
-                currentPen.setStyle( style()->lineStyle().penStyle() );
+        foreach( const GeoDataLinearRing& innerBoundary, m_polygon->innerBoundaries() ) {
+            QVector<QPolygonF*> innerPolygons;
+            viewport->screenCoordinates( innerBoundary, innerPolygons );
 
-            if ( painter->mapQuality() != Marble::HighQuality
-                    && painter->mapQuality() != Marble::PrintQuality ) {
-                QColor penColor = currentPen.color();
-                penColor.setAlpha( 255 );
-                currentPen.setColor( penColor );
+            foreach( QPolygonF* outerPolygon, outerPolygons ) {
+                foreach( const QPolygonF* innerPolygon, innerPolygons ) {
+                    *outerPolygon = outerPolygon->subtracted( *innerPolygon );
+                }
             }
+
+            // the outline takes over the inner polygons
+            outline << innerPolygons;
         }
+    }
 
-        if ( painter->pen() != currentPen )
-            painter->setPen( currentPen );
+    m_projectedPolygons.setPolygons( viewport, geometry, outerPolygons, translatable );
+    m_projectedOutline.setPolygons( viewport, geometry, outline, translatable );
+}
 
-        if ( !style()->polyStyle().fill() ) {
-            if ( painter->brush().color() != Qt::transparent )
-                painter->setBrush( QColor( Qt::transparent ) );
+void GeoPolygonGraphicsItem::updatePaintState( const GeoPainter *painter )
+{
+    if ( m_paintStateValid
+         && m_paintStateStyle == style()
+         && m_paintStateQuality == painter->mapQuality()
+         && m_paintStateBasePen == painter->pen()
+         && m_paintStateBaseBrush == painter->brush() ) {
+        return;
+    }
+
+    QPen currentPen = painter->pen();
+
+    if ( !style()->polyStyle().outline() ) {
+        currentPen.setColor( Qt::transparent );
+    }
+    else {
+        if ( currentPen.color() != style()->lineStyle().paintedColor() ||
+            currentPen.widthF() != style()->lineStyle().width() ) {
+            currentPen.setColor( style()->lineStyle().paintedColor() );
+            currentPen.setWidthF( style()->lineStyle().width() );
         }
-        else {
-            if ( painter->brush().color() != style()->polyStyle().paintedColor() ) {
-                painter->setBrush( style()->polyStyle().paintedColor() );
-            }
+
+        if ( currentPen.capStyle() != style()->lineStyle().capStyle() )
+            currentPen.setCapStyle( style()->lineStyle().capStyle() );
+
+        if ( currentPen.style() != style()->lineStyle().penStyle() )
+            currentPen.setStyle( style()->lineStyle().penStyle() );
+
+        if ( painter->mapQuality() != Marble::HighQuality
+                && painter->mapQuality() != Marble::PrintQuality ) {
+            QColor penColor = currentPen.color();
+            penColor.setAlpha( 255 );
+            currentPen.setColor( penColor );
         }
     }
 
-    if ( m_polygon ) {
-        painter->drawPolygon( *m_polygon );
-    } else if ( m_ring ) {
-        painter->drawPolygon( *m_ring );
+    QBrush currentBrush = painter->brush();
+
+    if ( !style()->polyStyle().fill() ) {
+        if ( currentBrush.color() != Qt::transparent )
+            currentBrush = QBrush( QColor( Qt::transparent ) );
+    }
+    else {
+        if ( currentBrush.color() != style()->polyStyle().paintedColor() ) {
+            currentBrush = QBrush( style()->polyStyle().paintedColor() );
+        }
     }
 
-    painter->restore();
+    m_pen = currentPen;
+    m_brush = currentBrush;
+
+    m_paintStateValid = true;
+    m_paintStateStyle = style();
+    m_paintStateQuality = painter->mapQuality();
+    m_paintStateBasePen = painter->pen();
+    m_paintStateBaseBrush = painter->brush();
 }
 
 }
@@ -11,14 +11,21 @@
 #ifndef MARBLE_GEOPOLYGONGRAPHICSITEM_H
 #define MARBLE_GEOPOLYGONGRAPHICSITEM_H
 
+#include <QBrush>
+#include <QPen>
+
 #include "GeoGraphicsItem.h"
+#include "MarbleGlobal.h"
+#include "ProjectedGeometryCache.h"
 #include "marble_export.h"
 
 namespace Marble
 {
 
+class GeoDataGeometry;
 class GeoDataLinearRing;
 class GeoDataPolygon;
+class GeoDataStyle;
 
 class MARBLE_EXPORT GeoPolygonGraphicsItem : public GeoGraphicsItem
 {
@@ -33,6 +40,24 @@ public:
 protected:
     const GeoDataPolygon *const m_polygon;
     const GeoDataLinearRing *const m_ring;
+
+private:
+    void updatePolygons( const ViewportParams *viewport, const GeoDataGeometry *geometry );
+    void updatePaintState( const GeoPainter *painter );
+
+    // the outer boundary with the inner boundaries cut away
+    ProjectedGeometryCache m_projectedPolygons;
+    // all boundaries, painted separately if there are inner boundaries
+    ProjectedGeometryCache m_projectedOutline;
+
+    // the pen and brush resolved from the style and the state they were resolved for
+    QPen m_pen;
+    QBrush m_brush;
+    bool m_paintStateValid;
+    const GeoDataStyle *m_paintStateStyle;
+    MapQuality m_paintStateQuality;
+    QPen m_paintStateBasePen;
+    QBrush m_paintStateBaseBrush;
 };
 
 }
@@ -0,0 +1,115 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "ProjectedGeometryCache.h"
+
+#include "AbstractProjection.h"
+#include "GeoDataGeometry.h"
+#include "ViewportParams.h"
+
+namespace Marble
+{
+
+ProjectedGeometryCache::ProjectedGeometryCache()
+    : m_valid( false ),
+      m_translatable( false ),
+      m_revision( 0 ),
+      m_radius( 0 ),
+      m_projection( Spherical )
+{
+}
+
+ProjectedGeometryCache::~ProjectedGeometryCache()
+{
+    qDeleteAll( m_polygons );
+}
+
+bool ProjectedGeometryCache::isValid( const ViewportParams *viewport, const GeoDataGeometry *geometry )
+{
+    if ( !m_valid
+         || m_revision != geometry->revision()
+         || m_size != viewport->size()
+         || m_radius != viewport->radius()
+         || m_projection != viewport->projection() ) {
+        return false;
+    }
+
+    if ( m_planetAxis == viewport->planetAxis() ) {
+        return true;
+    }
+
+    QPointF origin;
+    if ( !m_translatable || !isTranslatable( viewport, origin ) ) {
+        return false;
+    }
+
+    const QPointF offset = origin - m_origin;
+    foreach ( QPolygonF *polygon, m_polygons ) {
+        polygon->translate( offset );
+    }
+
+    m_planetAxis = viewport->planetAxis();
+    m_origin = origin;
+
+    return true;
+}
+
+void ProjectedGeometryCache::setPolygons( const ViewportParams *viewport, const GeoDataGeometry *geometry,
+                                          const QVector<QPolygonF *> &polygons, bool translatable )
+{
+    qDeleteAll( m_polygons );
+    m_polygons = polygons;
+
+    m_valid = true;
+    m_translatable = translatable && isTranslatable( viewport, m_origin );
+    m_revision = geometry->revision();
+    m_size = viewport->size();
+    m_radius = viewport->radius();
+    m_planetAxis = viewport->planetAxis();
+    m_projection = viewport->projection();
+}
+
+const QVector<QPolygonF *> &ProjectedGeometryCache::polygons() const
+{
+    return m_polygons;
+}
+
+void ProjectedGeometryCache::clear()
+{
+    qDeleteAll( m_polygons );
+    m_polygons.clear();
+    m_valid = false;
+}
+
+bool ProjectedGeometryCache::isTranslatable( const ViewportParams *viewport, QPointF &origin )
+{
+    if ( viewport->currentProjection()->surfaceType() != AbstractProjection::Cylindrical ) {
+        return false;
+    }
+
+    // Cylindrical projections repeat the polygons horizontally if the map
+    // is narrower than the viewport, depending on the center of the map.
+    qreal xWest;
+    qreal xEast;
+    qreal y;
+    viewport->screenCoordinates( -M_PI, 0.0, xWest, y );
+    viewport->screenCoordinates( +M_PI, 0.0, xEast, y );
+    if ( xWest > 0 || xEast < viewport->width() - 1 ) {
+        return false;
+    }
+
+    qreal x;
+    viewport->screenCoordinates( 0.0, 0.0, x, y );
+    origin = QPointF( x, y );
+
+    return true;
+}
+
+}
@@ -0,0 +1,92 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_PROJECTEDGEOMETRYCACHE_H
+#define MARBLE_PROJECTEDGEOMETRYCACHE_H
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QSize>
+#include <QVector>
+
+#include "MarbleGlobal.h"
+#include "Quaternion.h"
+
+namespace Marble
+{
+
+class GeoDataGeometry;
+class ViewportParams;
+
+/**
+ * @short Keeps the screen polygons of a geometry between repaints.
+ *
+ * The polygons stay valid as long as the projection, the radius, the
+ * rotation of the planet and the size of the viewport don't change and
+ * the geometry doesn't get edited, see GeoDataGeometry::revision().
+ *
+ * Cylindrical projections map a change of the center of the map onto a
+ * translation of all screen coordinates. If the map doesn't get repeated
+ * horizontally before and after the change, the polygons are translated
+ * instead of being projected again.
+ */
+class ProjectedGeometryCache
+{
+ public:
+    ProjectedGeometryCache();
+    ~ProjectedGeometryCache();
+
+    /**
+     * @brief Returns whether polygons() show @p geometry on @p viewport.
+     *
+     * Translates the polygons if the map has only been panned.
+     */
+    bool isValid( const ViewportParams *viewport, const GeoDataGeometry *geometry );
+
+    /**
+     * @brief Stores the @p polygons of @p geometry projected for @p viewport.
+     *
+     * Takes ownership of the polygons.
+     * @param translatable whether the polygons may be translated when the
+     *        map gets panned, which is not the case if the geometry spans
+     *        all longitudes and got closed along the border of the viewport.
+     */
+    void setPolygons( const ViewportParams *viewport, const GeoDataGeometry *geometry,
+                      const QVector<QPolygonF *> &polygons, bool translatable );
+
+    const QVector<QPolygonF *> &polygons() const;
+
+    void clear();
+
+ private:
+    Q_DISABLE_COPY( ProjectedGeometryCache )
+
+    /**
+     * Returns whether the screen coordinates of @p viewport only differ by
+     * a translation for different centers of the map. Sets @p origin to the
+     * screen position of lon = lat = 0 in that case.
+     */
+    static bool isTranslatable( const ViewportParams *viewport, QPointF &origin );
+
+    QVector<QPolygonF *> m_polygons;
+
+    bool m_valid;
+    bool m_translatable;
+    int m_revision;
+    QSize m_size;
+    int m_radius;
+    Quaternion m_planetAxis;
+    Projection m_projection;
+    QPointF m_origin;
+};
+
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
 #include "ServerLayout.h"
+#include "TileArchive.h"
 #include "TileId.h"
 
 #include <QImage>
@@ -132,12 +133,21 @@ QVector<QUrl> GeoSceneTiled::downloadUrls() const
 const QSize GeoSceneTiled::tileSize() const
 {
     if ( m_tileSize.isEmpty() ) {
-        const TileId id( 0, 0, 0, 0 );
-        QString const fileName = relativeTileFileName( id );
-        QFileInfo const dirInfo( fileName );
-        QString const path = dirInfo.isAbsolute() ? fileName : MarbleDirs::path( fileName );
+        // packed themes have no loose tile files
+        QImage testTile;
+        const TileArchive archive( TileArchive::themeFilePath( themeStr() ) );
+        if ( archive.isValid() ) {
+            testTile = QImage::fromData( archive.tileData( 0, 0, 0 ) );
+        }
+
+        if ( testTile.isNull() ) {
+            const TileId id( 0, 0, 0, 0 );
+            QString const fileName = relativeTileFileName( id );
+            QFileInfo const dirInfo( fileName );
+            QString const path = dirInfo.isAbsolute() ? fileName : MarbleDirs::path( fileName );
 
-        QImage testTile( path );
+            testTile = QImage( path );
+        }
 
         if ( testTile.isNull() ) {
             mDebug() << "Tile size is missing in dgml and no base tile found in " << themeStr();
@@ -253,13 +253,9 @@ bool GeometryLayer::render( GeoPainter *painter, ViewportParams *viewport,
     int maxZoomLevel = qMin<int>( qMax<int>( qLn( viewport->radius() *4 / 256 ) / qLn( 2.0 ), 1), GeometryLayerPrivate::maximumZoomLevel() );
     QList<GeoGraphicsItem*> items = d->m_scene.items( viewport->viewLatLonAltBox(), maxZoomLevel );
 
-    int painted = 0;
     foreach( GeoGraphicsItem* item, items )
     {
-        if ( item->latLonAltBox().intersects( viewport->viewLatLonAltBox() ) ) {
-            item->paint( painter, viewport );
-            ++painted;
-        }
+        item->paint( painter, viewport );
     }
 
     foreach( ScreenOverlayGraphicsItem* item, d->m_items ) {
@@ -267,9 +263,8 @@ bool GeometryLayer::render( GeoPainter *painter, ViewportParams *viewport,
     }
 
     painter->restore();
-    d->m_runtimeTrace = QString( "Geometries: %1 Drawn: %2 Zoom: %3")
+    d->m_runtimeTrace = QString( "Geometries: %1 Zoom: %2")
                 .arg( items.size() )
-                .arg( painted )
                 .arg( maxZoomLevel );
     return true;
 }
@@ -33,8 +33,10 @@
 #include "StackedTile.h"
 #include "StackedTileLoader.h"
 #include "SunLocator.h"
+#include "SunShadingOverlay.h"
 #include "TextureColorizer.h"
 #include "TileLoader.h"
+#include "TilePrefetcher.h"
 #include "ViewportParams.h"
 
 namespace Marble
@@ -53,6 +55,7 @@ public:
     void requestDelayedRepaint();
     void updateTextureLayers();
     void updateTile( const TileId &tileId, const QImage &tileImage );
+    void updateSunShading();
 
     void addGroundOverlays( QModelIndex parent, int first, int last );
     void removeGroundOverlays( QModelIndex parent, int first, int last );
@@ -68,6 +71,8 @@ public:
     TileLoader m_loader;
     MergedLayerDecorator m_layerDecorator;
     StackedTileLoader    m_tileLoader;
+    TilePrefetcher       m_prefetcher;
+    SunShadingOverlay    m_sunShading;
     GeoDataCoordinates m_centerCoordinates;
     int m_tileZoomLevel;
     TextureMapperInterface *m_texmapper;
@@ -80,6 +85,8 @@ public:
     // For scheduling repaints
     QTimer           m_repaintTimer;
     RenderState m_renderState;
+    bool m_showSunShading;
+    bool m_showCityLights;
 };
 
 TextureLayer::Private::Private( HttpDownloadManager *downloadManager,
@@ -91,12 +98,16 @@ TextureLayer::Private::Private( HttpDownloadManager *downloadManager,
     , m_loader( downloadManager, 0 )
     , m_layerDecorator( &m_loader, sunLocator )
     , m_tileLoader( &m_layerDecorator )
+    , m_prefetcher( &m_tileLoader )
+    , m_sunShading( sunLocator )
     , m_centerCoordinates()
     , m_tileZoomLevel( -1 )
     , m_texmapper( 0 )
     , m_texcolorizer( 0 )
     , m_textureLayerSettings( 0 )
     , m_repaintTimer()
+    , m_showSunShading( false )
+    , m_showCityLights( false )
 {
     m_groundOverlayModel.setSourceModel( groundOverlayModel );
     m_groundOverlayModel.setDynamicSortFilter( true );
@@ -147,6 +158,8 @@ void TextureLayer::Private::updateTextureLayers()
         }
     }
 
+    m_prefetcher.cancel();
+
     updateGroundOverlays();
 
     m_layerDecorator.setTextureLayers( result );
@@ -160,11 +173,22 @@ void TextureLayer::Private::updateTile( const TileId &tileId, const QImage &tile
     if ( tileImage.isNull() )
         return; // keep tiles in cache to improve performance
 
+    m_prefetcher.cancel();
     m_tileLoader.updateTile( tileId, tileImage );
 
     requestDelayedRepaint();
 }
 
+void TextureLayer::Private::updateSunShading()
+{
+    if ( m_showCityLights ) {
+        // the city lights are blended into the tiles by SunLightBlending
+        m_parent->reset();
+    } else {
+        emit m_parent->repaintNeeded();
+    }
+}
+
 bool TextureLayer::Private::drawOrderLessThan( const GeoDataGroundOverlay* o1, const GeoDataGroundOverlay* o2 )
 {
     return o1->drawOrder() < o2->drawOrder();
@@ -217,6 +241,8 @@ void TextureLayer::Private::resetGroundOverlaysCache()
 
 void TextureLayer::Private::updateGroundOverlays()
 {
+    m_prefetcher.cancel();
+
     if ( !m_texcolorizer ) {
         m_layerDecorator.updateGroundOverlays( m_groundOverlayCache );
     }
@@ -272,12 +298,12 @@ void TextureLayer::addLandDocument( const GeoDataDocument *landDocument )
 
 bool TextureLayer::showSunShading() const
 {
-    return d->m_layerDecorator.showSunShading();
+    return d->m_showSunShading;
 }
 
 bool TextureLayer::showCityLights() const
 {
-    return d->m_layerDecorator.showCityLights();
+    return d->m_showCityLights;
 }
 
 bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
@@ -303,7 +329,7 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
          d->m_centerCoordinates.latitude() != viewport->centerLatitude() ) {
         d->m_centerCoordinates.setLongitude( viewport->centerLongitude() );
         d->m_centerCoordinates.setLatitude( viewport->centerLatitude() );
-        d->m_texmapper->setRepaintNeeded();
+        d->m_texmapper->setViewportMoved();
     }
 
     // choose the smaller dimension for selecting the tile level, leading to higher-resolution results
@@ -329,8 +355,12 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
 
     const QRect dirtyRect = QRect( QPoint( 0, 0), viewport->size() );
     d->m_texmapper->mapTexture( painter, viewport, d->m_tileZoomLevel, dirtyRect, d->m_texcolorizer );
+    if ( d->m_showSunShading && !d->m_showCityLights ) {
+        d->m_sunShading.paint( painter, viewport );
+    }
+    d->m_prefetcher.prefetch( viewport, d->m_tileZoomLevel, d->m_layerDecorator.maximumTileLevel() );
     d->m_renderState.addChild( d->m_tileLoader.renderState() );
-    d->m_runtimeTrace = QString("Texture Cache: %1 ").arg(d->m_tileLoader.tileCount());
+    d->m_runtimeTrace = QString("Texture Cache: %1 %2").arg(d->m_tileLoader.tileCount()).arg(d->m_texmapper->runtimeTrace());
     return true;
 }
 
@@ -349,27 +379,30 @@ void TextureLayer::setShowRelief( bool show )
 void TextureLayer::setShowSunShading( bool show )
 {
     disconnect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
-                this, SLOT(reset()) );
+                this, SLOT(updateSunShading()) );
 
     if ( show ) {
         connect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
-                 this,       SLOT(reset()) );
+                 this,       SLOT(updateSunShading()) );
     }
 
-    d->m_layerDecorator.setShowSunShading( show );
+    // The shading is painted on top of the mapped texture, so neither
+    // the tiles nor the canvas of the texture mapper need to be updated.
+    d->m_showSunShading = show;
 
-    reset();
+    emit repaintNeeded();
 }
 
 void TextureLayer::setShowCityLights( bool show )
 {
-    d->m_layerDecorator.setShowCityLights( show );
+    d->m_showCityLights = show;
 
-    reset();
+    emit repaintNeeded();
 }
 
 void TextureLayer::setShowTileId( bool show )
 {
+    d->m_prefetcher.cancel();
     d->m_layerDecorator.setShowTileId( show );
 
     reset();
@@ -429,6 +462,7 @@ void TextureLayer::reset()
 {
     mDebug() << Q_FUNC_INFO;
 
+    d->m_prefetcher.cancel();
     d->m_tileLoader.clear();
     setNeedsUpdate();
 }
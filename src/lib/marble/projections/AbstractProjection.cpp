@@ -144,6 +144,71 @@ bool AbstractProjection::screenCoordinates( const GeoDataCoordinates &geopoint,
     return screenCoordinates( geopoint, viewport, x, y, globeHidesPoint );
 }
 
+void AbstractProjection::screenCoordinates( const GeoDataCoordinates *coordinates, int count,
+                                            const ViewportParams *viewport,
+                                            QPointF *points, bool *globeHidesPoint ) const
+{
+    for ( int i = 0; i < count; ++i ) {
+        qreal x = 0;
+        qreal y = 0;
+        bool hidden = false;
+        screenCoordinates( coordinates[i], viewport, x, y, hidden );
+        points[i] = QPointF( x, y );
+        if ( globeHidesPoint ) {
+            globeHidesPoint[i] = hidden;
+        }
+    }
+}
+
+QVector<GeoDataCoordinates> AbstractProjectionPrivate::resolvedNodes( const GeoDataLineString &lineString,
+                                                                      const ViewportParams *viewport )
+{
+    QVector<GeoDataCoordinates> nodes;
+    nodes.reserve( lineString.size() );
+
+    GeoDataLineString::ConstIterator itCoords = lineString.constBegin();
+    GeoDataLineString::ConstIterator itEnd = lineString.constEnd();
+
+    // Optimization for line strings with a big amount of nodes
+    const bool isLong = lineString.size() > 50;
+    if ( !isLong ) {
+        for ( ; itCoords != itEnd; ++itCoords ) {
+            nodes.append( *itCoords );
+        }
+        return nodes;
+    }
+
+    const int maximumDetail = ( viewport->radius() > 5000 ) ? 5 :
+                              ( viewport->radius() > 2500 ) ? 4 :
+                              ( viewport->radius() > 1000 ) ? 3 :
+                              ( viewport->radius() >  600 ) ? 2 :
+                              ( viewport->radius() >   50 ) ? 1 :
+                                                              0;
+
+    // Same manhattan length test as ViewportParams::resolves(), but on the
+    // coordinate arrays of the line string.
+    const GeoDataCoordinateArrays<qreal> arrays = lineString.coordinateArrays();
+    const qreal *const longitudes = arrays.longitudes();
+    const qreal *const latitudes = arrays.latitudes();
+    const int nodeCount = arrays.size();
+    const qreal angularResolution = viewport->angularResolution();
+
+    int previous = 0;
+    nodes.append( lineString.at( 0 ) );
+
+    for ( int i = 1; i < nodeCount; ++i ) {
+        const bool skipNode = qAbs( longitudes[i] - longitudes[previous] )
+                              + qAbs( latitudes[i] - latitudes[previous] ) < angularResolution
+                              || lineString.at( i ).detail() > maximumDetail;
+        if ( !skipNode ) {
+            nodes.append( lineString.at( i ) );
+            previous = i;
+        }
+    }
+
+    return nodes;
+}
+
 GeoDataLatLonAltBox AbstractProjection::latLonAltBox( const QRect& screenRect,
                                                       const ViewportParams *viewport ) const
 {
@@ -188,6 +188,27 @@ class MARBLE_EXPORT AbstractProjection
                             const ViewportParams *viewport,
                             QVector<QPolygonF*> &polygons ) const = 0;
 
+    /**
+     * @brief Get the screen coordinates of many geographical points at once.
+     *
+     * Does the same as calling screenCoordinates() for each of the points,
+     * but saves the virtual call per point and allows projections to hoist
+     * the viewport dependent terms out of a tight loop.
+     *
+     * @param coordinates the points on earth, including altitude.
+     * @param count   the number of points
+     * @param viewport the viewport parameters
+     * @param points  receives the screen position of each point; the position
+     *                of a point hidden by the globe is undefined
+     * @param globeHidesPoint  if not 0, receives for each point whether it gets
+     *                hidden on the far side of the earth
+     *
+     * @see ViewportParams
+     */
+    virtual void screenCoordinates( const GeoDataCoordinates *coordinates, int count,
+                                    const ViewportParams *viewport,
+                                    QPointF *points, bool *globeHidesPoint = 0 ) const;
+
     /**
      * @brief Get the earth coordinates corresponding to a pixel in the map.
      * @param x      the x coordinate of the pixel
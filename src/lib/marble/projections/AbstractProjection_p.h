@@ -12,10 +12,16 @@
 #define MARBLE_ABSTRACTPROJECTIONPRIVATE_H
 
 
+#include <QVector>
+
+#include "GeoDataCoordinates.h"
+
 namespace Marble
 {
 
 class AbstractProjection;
+class GeoDataLineString;
+class ViewportParams;
 
 class AbstractProjectionPrivate
 {
@@ -24,6 +30,15 @@ class AbstractProjectionPrivate
 
     virtual ~AbstractProjectionPrivate() { };
 
+    /**
+     * Returns the nodes of @p lineString that need to be projected for
+     * @p viewport. Nodes of long line strings are dropped if their detail
+     * level is too high or if they are too close to the previous node to
+     * be resolved.
+     */
+    static QVector<GeoDataCoordinates> resolvedNodes( const GeoDataLineString &lineString,
+                                                      const ViewportParams *viewport );
+
 
     qreal  m_maxLat;
     qreal  m_minLat;
@@ -340,8 +340,16 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
 
     polygons.append( new QPolygonF );
 
-    GeoDataLineString::ConstIterator itCoords = lineString.constBegin();
-    GeoDataLineString::ConstIterator itPreviousCoords = lineString.constBegin();
+    // Drop the nodes that can't be resolved first, so only the remaining
+    // ones need to be projected, all of them in one go.
+    const QVector<GeoDataCoordinates> nodes = resolvedNodes( lineString, viewport );
+
+    QVector<QPointF> points( nodes.size() );
+    QVector<bool> hiddenNodes( nodes.size() );
+    q->screenCoordinates( nodes.constData(), nodes.size(), viewport, points.data(), hiddenNodes.data() );
+
+    const int nodeCount = nodes.size();
+    int previousIndex = 0;
 
     // Some projections display the earth in a way so that there is a
     // foreside and a backside.
@@ -364,145 +372,120 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
     bool horizonOrphan = false;
     GeoDataCoordinates horizonOrphanCoords;
 
-    GeoDataLineString::ConstIterator itBegin = lineString.constBegin();
-    GeoDataLineString::ConstIterator itEnd = lineString.constEnd();
-
-    bool processingLastNode = false;
+    // We cover linestrings as well as linear rings:
+    // Linear rings require to tessellate the path from the last node to the first node,
+    // which gets processed once more at the end.
+    const int lastIndex = lineString.isClosed() ? nodeCount : nodeCount - 1;
 
-    // We use a while loop to be able to cover linestrings as well as linear rings:
-    // Linear rings require to tessellate the path from the last node to the first node
-    // which isn't really convenient to achieve with a for loop ...
-
-    const bool isLong = lineString.size() > 50;
-    const int maximumDetail = ( viewport->radius() > 5000 ) ? 5 :
-                              ( viewport->radius() > 2500 ) ? 4 :
-                              ( viewport->radius() > 1000 ) ? 3 :
-                              ( viewport->radius() >  600 ) ? 2 :
-                              ( viewport->radius() >   50 ) ? 1 :
-                                                              0;
-
-    while ( itCoords != itEnd )
+    for ( int i = 0; i <= lastIndex && nodeCount > 0; ++i )
     {
+        const int index = i < nodeCount ? i : 0;
+        const GeoDataCoordinates &coords = nodes[index];
+
+        // The position of hidden nodes is undefined, keep the one of the
+        // last node that has been visible
+        globeHidesPoint = hiddenNodes[index];
+        if ( !globeHidesPoint ) {
+            x = points[index].x();
+            y = points[index].y();
+        }
 
-        // Optimization for line strings with a big amount of nodes
-        bool skipNode = itCoords != itBegin && isLong && !processingLastNode &&
-                ( (*itCoords).detail() > maximumDetail
-                  || viewport->resolves( *itPreviousCoords, *itCoords ) );
-
-        if ( !skipNode ) {
-
-            q->screenCoordinates( *itCoords, viewport, x, y, globeHidesPoint );
-
-            // Initializing variables that store the values of the previous iteration
-            if ( !processingLastNode && itCoords == itBegin ) {
-                previousGlobeHidesPoint = globeHidesPoint;
-                itPreviousCoords = itCoords;
-                previousX = x;
-                previousY = y;
-            }
+        // Initializing variables that store the values of the previous iteration
+        if ( i == 0 ) {
+            previousGlobeHidesPoint = globeHidesPoint;
+            previousIndex = index;
+            previousX = x;
+            previousY = y;
+        }
 
-            // Check for the "horizon case" (which is present e.g. for the spherical projection
-            const bool isAtHorizon = ( globeHidesPoint || previousGlobeHidesPoint ) &&
-                                     ( globeHidesPoint !=  previousGlobeHidesPoint );
+        // Check for the "horizon case" (which is present e.g. for the spherical projection
+        const bool isAtHorizon = ( globeHidesPoint || previousGlobeHidesPoint ) &&
+                                 ( globeHidesPoint !=  previousGlobeHidesPoint );
 
-            if ( isAtHorizon ) {
-                // Handle the "horizon case"
-                horizonCoords = findHorizon( *itPreviousCoords, *itCoords, viewport, f );
+        if ( isAtHorizon ) {
+            // Handle the "horizon case"
+            horizonCoords = findHorizon( nodes[previousIndex], coords, viewport, f );
 
-                if ( lineString.isClosed() ) {
-                    if ( horizonPair ) {
-                        horizonToPolygon( viewport, horizonDisappearCoords, horizonCoords, polygons.last() );
-                        horizonPair = false;
+            if ( lineString.isClosed() ) {
+                if ( horizonPair ) {
+                    horizonToPolygon( viewport, horizonDisappearCoords, horizonCoords, polygons.last() );
+                    horizonPair = false;
+                }
+                else {
+                    if ( globeHidesPoint ) {
+                        horizonDisappearCoords = horizonCoords;
+                        horizonPair = true;
                     }
                     else {
-                        if ( globeHidesPoint ) {
-                            horizonDisappearCoords = horizonCoords;
-                            horizonPair = true;
-                        }
-                        else {
-                            horizonOrphanCoords = horizonCoords;
-                            horizonOrphan = true;
-                        }
+                        horizonOrphanCoords = horizonCoords;
+                        horizonOrphan = true;
                     }
                 }
+            }
 
-                q->screenCoordinates( horizonCoords, viewport, horizonX, horizonY );
+            q->screenCoordinates( horizonCoords, viewport, horizonX, horizonY );
 
-                // If the line appears on the visible half we need
-                // to add an interpolated point at the horizon as the previous point.
-                if ( previousGlobeHidesPoint ) {
-                    *polygons.last() << QPointF( horizonX, horizonY );
-                }
+            // If the line appears on the visible half we need
+            // to add an interpolated point at the horizon as the previous point.
+            if ( previousGlobeHidesPoint ) {
+                *polygons.last() << QPointF( horizonX, horizonY );
             }
+        }
 
-            // This if-clause contains the section that tessellates the line
-            // segments of a linestring. If you are about to learn how the code of
-            // this class works you can safely ignore this section for a start.
+        // This if-clause contains the section that tessellates the line
+        // segments of a linestring. If you are about to learn how the code of
+        // this class works you can safely ignore this section for a start.
 
-            if ( lineString.tessellate() /* && ( isVisible || previousIsVisible ) */ ) {
+        if ( lineString.tessellate() /* && ( isVisible || previousIsVisible ) */ ) {
 
-                if ( !isAtHorizon ) {
+            if ( !isAtHorizon ) {
 
-                    tessellateLineSegment( *itPreviousCoords, previousX, previousY,
-                                           *itCoords, x, y,
-                                           polygons, viewport,
-                                           f );
+                tessellateLineSegment( nodes[previousIndex], previousX, previousY,
+                                       coords, x, y,
+                                       polygons, viewport,
+                                       f );
 
-                }
-                else {
-                    // Connect the interpolated  point at the horizon with the
-                    // current or previous point in the line.
-                    if ( previousGlobeHidesPoint ) {
-                        tessellateLineSegment( horizonCoords, horizonX, horizonY,
-                                               *itCoords, x, y,
-                                               polygons, viewport,
-                                               f );
-                    }
-                    else {
-                        tessellateLineSegment( *itPreviousCoords, previousX, previousY,
-                                               horizonCoords, horizonX, horizonY,
-                                               polygons, viewport,
-                                               f );
-                    }
-                }
             }
             else {
-                if ( !globeHidesPoint ) {
-                    *polygons.last() << QPointF( x, y );
+                // Connect the interpolated  point at the horizon with the
+                // current or previous point in the line.
+                if ( previousGlobeHidesPoint ) {
+                    tessellateLineSegment( horizonCoords, horizonX, horizonY,
+                                           coords, x, y,
+                                           polygons, viewport,
+                                           f );
                 }
                 else {
-                    if ( !previousGlobeHidesPoint && isAtHorizon ) {
-                        *polygons.last() << QPointF( horizonX, horizonY );
-                    }
+                    tessellateLineSegment( nodes[previousIndex], previousX, previousY,
+                                           horizonCoords, horizonX, horizonY,
+                                           polygons, viewport,
+                                           f );
                 }
             }
-
-            if ( globeHidesPoint ) {
-                if (   !previousGlobeHidesPoint
-                    && !lineString.isClosed()
-                    ) {
-                    polygons.append( new QPolygonF );
+        }
+        else {
+            if ( !globeHidesPoint ) {
+                *polygons.last() << QPointF( x, y );
+            }
+            else {
+                if ( !previousGlobeHidesPoint && isAtHorizon ) {
+                    *polygons.last() << QPointF( horizonX, horizonY );
                 }
             }
-
-            previousGlobeHidesPoint = globeHidesPoint;
-            itPreviousCoords = itCoords;
-            previousX = x;
-            previousY = y;
         }
 
-        // Here we modify the condition to be able to process the
-        // first node after the last node in a LinearRing.
-
-        if ( processingLastNode ) {
-            break;
+        if ( globeHidesPoint ) {
+            if (   !previousGlobeHidesPoint
+                && !lineString.isClosed()
+                ) {
+                polygons.append( new QPolygonF );
+            }
         }
-        ++itCoords;
 
-        if ( itCoords == itEnd  && lineString.isClosed() ) {
-            itCoords = itBegin;
-            processingLastNode = true;
-        }
+        previousGlobeHidesPoint = globeHidesPoint;
+        previousIndex = index;
+        previousX = x;
+        previousY = y;
     }
 
     // In case of horizon crossings, make sure that we always get a
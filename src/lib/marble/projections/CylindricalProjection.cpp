@@ -278,84 +278,59 @@ bool CylindricalProjectionPrivate::lineStringToPolygon( const GeoDataLineString
 
     polygons.append( new QPolygonF );
 
-    GeoDataLineString::ConstIterator itCoords = lineString.constBegin();
-    GeoDataLineString::ConstIterator itPreviousCoords = lineString.constBegin();
+    // Drop the nodes that can't be resolved first, so only the remaining
+    // ones need to be projected, all of them in one go.
+    const QVector<GeoDataCoordinates> nodes = resolvedNodes( lineString, viewport );
 
-    GeoDataLineString::ConstIterator itBegin = lineString.constBegin();
-    GeoDataLineString::ConstIterator itEnd = lineString.constEnd();
-
-    bool processingLastNode = false;
+    QVector<QPointF> points( nodes.size() );
+    Q_Q( const CylindricalProjection );
+    q->screenCoordinates( nodes.constData(), nodes.size(), viewport, points.data() );
 
-    // We use a while loop to be able to cover linestrings as well as linear rings:
-    // Linear rings require to tessellate the path from the last node to the first node
-    // which isn't really convenient to achieve with a for loop ...
+    const int nodeCount = nodes.size();
+    int previousIndex = 0;
 
-    const bool isLong = lineString.size() > 50;
-    const int maximumDetail = ( viewport->radius() > 5000 ) ? 5 :
-                              ( viewport->radius() > 2500 ) ? 4 :
-                              ( viewport->radius() > 1000 ) ? 3 :
-                              ( viewport->radius() >  600 ) ? 2 :
-                              ( viewport->radius() >   50 ) ? 1 :
-                                                              0;
+    // We cover linestrings as well as linear rings:
+    // Linear rings require to tessellate the path from the last node to the first node,
+    // which gets processed once more at the end.
+    const int lastIndex = lineString.isClosed() ? nodeCount : nodeCount - 1;
 
-    while ( itCoords != itEnd )
+    for ( int i = 0; i <= lastIndex && nodeCount > 0; ++i )
     {
+        const int index = i < nodeCount ? i : 0;
+        const GeoDataCoordinates &coords = nodes[index];
 
-        // Optimization for line strings with a big amount of nodes
-        bool skipNode = itCoords != itBegin && isLong && !processingLastNode &&
-                ( (*itCoords).detail() > maximumDetail
-                  || viewport->resolves( *itPreviousCoords, *itCoords ) );
-
-        if ( !skipNode ) {
-
-
-            Q_Q( const CylindricalProjection );
-
-            q->screenCoordinates( *itCoords, viewport, x, y );
-
-            // Initializing variables that store the values of the previous iteration
-            if ( !processingLastNode && itCoords == itBegin ) {
-                itPreviousCoords = itCoords;
-                previousX = x;
-                previousY = y;
-            }
-
-            // This if-clause contains the section that tessellates the line
-            // segments of a linestring. If you are about to learn how the code of
-            // this class works you can safely ignore this section for a start.
+        x = points[index].x();
+        y = points[index].y();
 
-            if ( lineString.tessellate() ) {
-
-                mirrorCount = tessellateLineSegment( *itPreviousCoords, previousX, previousY,
-                                           *itCoords, x, y,
-                                           polygons, viewport,
-                                           f, mirrorCount, distance );
-            }
-
-            else {
-                // special case for polys which cross dateline but have no Tesselation Flag
-                // the expected rendering is a screen coordinates straight line between
-                // points, but in projections with repeatX things are not smooth
-                mirrorCount = crossDateLine( *itPreviousCoords, *itCoords, x, y, polygons, mirrorCount, distance );
-            }
-
-            itPreviousCoords = itCoords;
+        // Initializing variables that store the values of the previous iteration
+        if ( i == 0 ) {
+            previousIndex = index;
             previousX = x;
             previousY = y;
         }
 
-        // Here we modify the condition to be able to process the
-        // first node after the last node in a LinearRing.
+        // This if-clause contains the section that tessellates the line
+        // segments of a linestring. If you are about to learn how the code of
+        // this class works you can safely ignore this section for a start.
+
+        if ( lineString.tessellate() ) {
 
-        if ( processingLastNode ) {
-            break;
+            mirrorCount = tessellateLineSegment( nodes[previousIndex], previousX, previousY,
+                                       coords, x, y,
+                                       polygons, viewport,
+                                       f, mirrorCount, distance );
         }
-        ++itCoords;
 
-        if ( itCoords == itEnd  && lineString.isClosed() ) {
-            itCoords = itBegin;
-            processingLastNode = true;
+        else {
+            // special case for polys which cross dateline but have no Tesselation Flag
+            // the expected rendering is a screen coordinates straight line between
+            // points, but in projections with repeatX things are not smooth
+            mirrorCount = crossDateLine( nodes[previousIndex], coords, x, y, polygons, mirrorCount, distance );
         }
+
+        previousIndex = index;
+        previousX = x;
+        previousY = y;
     }
 
     GeoDataLatLonAltBox box = lineString.latLonAltBox();
@@ -89,6 +89,27 @@ bool EquirectProjection::screenCoordinates( const GeoDataCoordinates &geopoint,
                   || ( 0 <= x + 4 * radius && x + 4 * radius < width ) ) );
 }
 
+void EquirectProjection::screenCoordinates( const GeoDataCoordinates *coordinates, int count,
+                                            const ViewportParams *viewport,
+                                            QPointF *points, bool *globeHidesPoint ) const
+{
+    const qreal rad2Pixel = 2.0 * viewport->radius() / M_PI;
+    const qreal halfWidth = (qreal)(viewport->width()) / 2.0;
+    const qreal halfHeight = (qreal)(viewport->height()) / 2.0;
+    const qreal centerLon = viewport->centerLongitude();
+    const qreal centerLat = viewport->centerLatitude();
+
+    for ( int i = 0; i < count; ++i ) {
+        points[i] = QPointF( halfWidth  + rad2Pixel * ( coordinates[i].longitude() - centerLon ),
+                             halfHeight - rad2Pixel * ( coordinates[i].latitude() - centerLat ) );
+    }
+
+    // This projection doesn't hide any points.
+    for ( int i = 0; globeHidesPoint && i < count; ++i ) {
+        globeHidesPoint[i] = false;
+    }
+}
+
 bool EquirectProjection::screenCoordinates( const GeoDataCoordinates &coordinates,
                                             const ViewportParams *viewport,
                                             qreal *x, qreal &y,
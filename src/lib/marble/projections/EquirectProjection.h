@@ -84,6 +84,10 @@ class EquirectProjection : public CylindricalProjection
                             const QSizeF& size,
                             bool &globeHidesPoint ) const;
 
+    void screenCoordinates( const GeoDataCoordinates *coordinates, int count,
+                            const ViewportParams *viewport,
+                            QPointF *points, bool *globeHidesPoint = 0 ) const;
+
     using CylindricalProjection::screenCoordinates;
 
     /**
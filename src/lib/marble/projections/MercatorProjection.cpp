@@ -108,6 +108,32 @@ bool MercatorProjection::screenCoordinates( const GeoDataCoordinates &geopoint,
                   || ( 0 <= x + 4 * radius && x + 4 * radius < width ) ) );
 }
 
+void MercatorProjection::screenCoordinates( const GeoDataCoordinates *coordinates, int count,
+                                            const ViewportParams *viewport,
+                                            QPointF *points, bool *globeHidesPoint ) const
+{
+    const qreal rad2Pixel = 2 * viewport->radius() / M_PI;
+    const qreal halfWidth = (qreal)(viewport->width()) / 2;
+    const qreal halfHeight = (qreal)(viewport->height()) / 2;
+    const qreal centerLon = viewport->centerLongitude();
+    const qreal centerY = gdInv( viewport->centerLatitude() );
+
+    const qreal minLatitude = minLat();
+    const qreal maxLatitude = maxLat();
+
+    for ( int i = 0; i < count; ++i ) {
+        // Points beyond the latitude range get clamped to its border.
+        const qreal lat = qBound( minLatitude, coordinates[i].latitude(), maxLatitude );
+        points[i] = QPointF( halfWidth  + rad2Pixel * ( coordinates[i].longitude() - centerLon ),
+                             halfHeight - rad2Pixel * ( gdInv( lat ) - centerY ) );
+    }
+
+    // This projection doesn't hide any points.
+    for ( int i = 0; globeHidesPoint && i < count; ++i ) {
+        globeHidesPoint[i] = false;
+    }
+}
+
 bool MercatorProjection::screenCoordinates( const GeoDataCoordinates &coordinates,
                                             const ViewportParams *viewport,
                                             qreal *x, qreal &y, int &pointRepeatNum,
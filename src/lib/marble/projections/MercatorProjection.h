@@ -83,6 +83,10 @@ class MercatorProjection : public CylindricalProjection
                             const QSizeF& size,
                             bool &globeHidesPoint ) const;
 
+    void screenCoordinates( const GeoDataCoordinates *coordinates, int count,
+                            const ViewportParams *viewport,
+                            QPointF *points, bool *globeHidesPoint = 0 ) const;
+
     using CylindricalProjection::screenCoordinates;
 
    /**
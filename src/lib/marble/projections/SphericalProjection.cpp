@@ -124,6 +124,45 @@ bool SphericalProjection::screenCoordinates( const GeoDataCoordinates &coordinat
     return true;
 }
 
+void SphericalProjection::screenCoordinates( const GeoDataCoordinates *coordinates, int count,
+                                             const ViewportParams *viewport,
+                                             QPointF *points, bool *globeHidesPoint ) const
+{
+    const matrix &m = viewport->planetAxisMatrix();
+    const qreal radius = viewport->radius();
+    const qreal pixelsPerMeter = viewport->radius() / EARTH_RADIUS;
+    const qreal centerX = (qreal)(viewport->width()) / 2;
+    const qreal centerY = (qreal)(viewport->height()) / 2;
+
+    for ( int i = 0; i < count; ++i ) {
+        // Same operations as Quaternion::rotateAroundAxis(), but without
+        // copying the quaternion and calculating the unused w component.
+        const Quaternion &q = coordinates[i].quaternion();
+        const qreal qx = m[0][0] * q.v[Q_X] + m[1][0] * q.v[Q_Y] + m[2][0] * q.v[Q_Z];
+        const qreal qy = m[0][1] * q.v[Q_X] + m[1][1] * q.v[Q_Y] + m[2][1] * q.v[Q_Z];
+        const qreal qz = m[0][2] * q.v[Q_X] + m[1][2] * q.v[Q_Y] + m[2][2] * q.v[Q_Z];
+
+        const qreal altitude = coordinates[i].altitude();
+        const qreal pixelAltitude = pixelsPerMeter * ( altitude + EARTH_RADIUS );
+        const qreal earthCenteredX = pixelAltitude * qx;
+        const qreal earthCenteredY = pixelAltitude * qy;
+
+        // Points at the other side of the earth are hidden, high points
+        // (e.g. satellites) only if they are behind the disc of the earth.
+        const bool hidden = qz < 0
+                            && ( altitude < 10000
+                                 || earthCenteredX * earthCenteredX + earthCenteredY * earthCenteredY
+                                    < radius * radius );
+
+        if ( globeHidesPoint ) {
+            globeHidesPoint[i] = hidden;
+        }
+        if ( !hidden ) {
+            points[i] = QPointF( centerX + earthCenteredX, centerY - earthCenteredY );
+        }
+    }
+}
+
 bool SphericalProjection::screenCoordinates( const GeoDataCoordinates &coordinates,
                                              const ViewportParams *viewport,
                                              qreal *x, qreal &y,
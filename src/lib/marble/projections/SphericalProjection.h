@@ -81,6 +81,10 @@ class SphericalProjection : public AzimuthalProjection
                             const QSizeF& size,
                             bool &globeHidesPoint ) const;
 
+    virtual void screenCoordinates( const GeoDataCoordinates *coordinates, int count,
+                                    const ViewportParams *viewport,
+                                    QPointF *points, bool *globeHidesPoint = 0 ) const;
+
     using AbstractProjection::screenCoordinates;
 
     /**
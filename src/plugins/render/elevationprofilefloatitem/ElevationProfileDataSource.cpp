@@ -42,9 +42,11 @@ QList<QPointF> ElevationProfileDataSource::calculateElevationData( const GeoData
     QList<QPointF> result;
     qreal distance = 0;
 
+    const QVector<qreal> elevations = getElevations( lineString );
+
     //GeoDataLineString path;
     for ( int i = 0; i < lineString.size(); i++ ) {
-        const qreal ele = getElevation( lineString[i] );
+        const qreal ele = elevations[i];
 
         if ( i ) {
             distance += EARTH_RADIUS * distanceSphere( lineString[i-1], lineString[i] );
@@ -107,9 +109,15 @@ bool ElevationProfileTrackDataSource::isDataAvailable() const
     return !m_trackHash.isEmpty();
 }
 
-qreal ElevationProfileTrackDataSource::getElevation(const GeoDataCoordinates &coordinates) const
+QVector<qreal> ElevationProfileTrackDataSource::getElevations(const GeoDataLineString &lineString) const
 {
-    return coordinates.altitude();
+    QVector<qreal> result;
+    result.reserve( lineString.size() );
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        result.append( lineString[i].altitude() );
+    }
+
+    return result;
 }
 
 void ElevationProfileTrackDataSource::handleObjectAdded(GeoDataObject *object)
@@ -235,15 +243,22 @@ bool ElevationProfileRouteDataSource::isDataAvailable() const
     return m_routingModel && m_routingModel->rowCount() > 0;
 }
 
-qreal ElevationProfileRouteDataSource::getElevation(const GeoDataCoordinates &coordinates) const
+QVector<qreal> ElevationProfileRouteDataSource::getElevations(const GeoDataLineString &lineString) const
 {
-    const qreal lat = coordinates.latitude ( GeoDataCoordinates::Degree );
-    const qreal lon = coordinates.longitude( GeoDataCoordinates::Degree );
-    qreal ele = m_elevationModel->height( lon, lat );
-    if ( ele == invalidElevationData ) { // no data
-        ele = 0;
+    QVector<GeoDataCoordinates> coordinates;
+    coordinates.reserve( lineString.size() );
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        coordinates.append( lineString[i] );
     }
-    return ele;
+
+    QVector<qreal> result = m_elevationModel->heights( coordinates );
+    for ( int i = 0; i < result.size(); ++i ) {
+        if ( result[i] == invalidElevationData ) { // no data
+            result[i] = 0;
+        }
+    }
+
+    return result;
 }
 // end of impl of ElevationProfileRouteDataSource
 
@@ -89,6 +89,7 @@ void SatellitesModel::updateVisibility()
 {
     beginUpdateItems();
 
+    QVector<SatellitesTLEItem *> tleItems;
     foreach( TrackerPluginItem *obj, items() ) {
         SatellitesMSCItem *oItem = dynamic_cast<SatellitesMSCItem*>(obj);
         if( oItem != NULL ) {
@@ -108,14 +109,31 @@ void SatellitesModel::updateVisibility()
             eItem->setEnabled( enabled );
 
             if( enabled ) {
-                eItem->update();
+                tleItems.append( eItem );
             }
         }
     }
 
+    SatellitesTLEItem::updateItems( tleItems );
+
     endUpdateItems();
 }
 
+void SatellitesModel::updateItems()
+{
+    QVector<SatellitesTLEItem *> tleItems;
+    foreach( TrackerPluginItem *obj, items() ) {
+        SatellitesTLEItem *eItem = dynamic_cast<SatellitesTLEItem*>(obj);
+        if( eItem == NULL ) {
+            obj->update();
+        } else if( eItem->isEnabled() ) {
+            tleItems.append( eItem );
+        }
+    }
+
+    SatellitesTLEItem::updateItems( tleItems );
+}
+
 void SatellitesModel::parseFile( const QString &id,
                                  const QByteArray &data )
 {
@@ -37,6 +37,11 @@ public:
 
     void parseFile( const QString &id, const QByteArray &file );
 
+    /**
+     * Updates the satellites from two line elements sets in parallel.
+     */
+    void updateItems();
+
 protected:
     /**
      * Parse the Marble Satellite Catalog @p id with content @p data.
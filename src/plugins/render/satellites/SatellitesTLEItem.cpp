@@ -27,6 +27,9 @@
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QColor>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
 
 #include <cmath>
 #include <QDialog>
@@ -36,13 +39,55 @@ namespace Marble {
 
 #include "GeoDataPoint.h"
 
+namespace
+{
+
+// Number of items updated by one thread at a time
+const int itemsPerTask = 64;
+
+class UpdateTask : public QRunnable
+{
+public:
+    UpdateTask( const QVector<SatellitesTLEItem *> &items, int begin, int end, QSemaphore *finished )
+        : m_items( items ),
+          m_begin( begin ),
+          m_end( end ),
+          m_finished( finished )
+    {
+    }
+
+    void run()
+    {
+        for ( int i = m_begin; i < m_end; ++i ) {
+            m_items.at( i )->update();
+        }
+
+        m_finished->release();
+    }
+
+private:
+    const QVector<SatellitesTLEItem *> &m_items;
+    const int m_begin;
+    const int m_end;
+    QSemaphore *const m_finished;
+};
+
+QThreadPool *threadPool()
+{
+    static QThreadPool pool;
+    return &pool;
+}
+
+}
+
 SatellitesTLEItem::SatellitesTLEItem( const QString &name,
                                       elsetrec satrec,
                                       const MarbleClock *clock )
     : TrackerPluginItem( name ),
       m_satrec( satrec ),
       m_track( new GeoDataTrack() ),
-      m_clock( clock )
+      m_clock( clock ),
+      m_epochTime( timeAtEpoch().toTime_t() )
 {
     double tumin, mu, xke, j2, j3, j4, j3oj2;
     double radiusearthkm;
@@ -99,34 +144,75 @@ void SatellitesTLEItem::update()
     // time interval between each point in the track, in seconds
     double step = period() / 100.0;
 
-    for ( double i = startTime.toTime_t(); i < endTime.toTime_t(); i += step ) {
-        // No need to add points in this interval
-        if ( i >= m_track->firstWhen().toTime_t() ) {
-            i = m_track->lastWhen().toTime_t() + step;
+    // The remaining points are still valid, only extend the track at both ends
+    double i = startTime.toTime_t();
+    double const end = endTime.toTime_t();
+    if ( m_track->size() > 0 ) {
+        double const first = m_track->firstWhen().toTime_t();
+        for ( ; i < end && i < first; i += step ) {
+            addPointAt( QDateTime::fromTime_t( i ) );
         }
 
-        addPointAt( QDateTime::fromTime_t( i ) );
+        i = m_track->lastWhen().toTime_t() + step;
+    }
+
+    for ( ; i < end; i += step ) {
+        appendPointAt( QDateTime::fromTime_t( i ) );
     }
 }
 
-void SatellitesTLEItem::addPointAt( const QDateTime &dateTime )
+void SatellitesTLEItem::updateItems( const QVector<SatellitesTLEItem *> &items )
+{
+    // The calling thread takes the last share instead of just waiting
+    int const tasks = qMax( 0, items.size() - 1 ) / itemsPerTask;
+
+    QSemaphore finished;
+    for ( int i = 0; i < tasks; ++i ) {
+        threadPool()->start( new UpdateTask( items, i * itemsPerTask, ( i + 1 ) * itemsPerTask, &finished ) );
+    }
+
+    for ( int i = tasks * itemsPerTask; i < items.size(); ++i ) {
+        items.at( i )->update();
+    }
+
+    finished.acquire( tasks );
+}
+
+bool SatellitesTLEItem::coordinatesAt( const QDateTime &dateTime, GeoDataCoordinates &coordinates )
 {
     // in minutes
-    double timeSinceEpoch = (double)( dateTime.toTime_t() -
-        timeAtEpoch().toTime_t() ) / 60.0;
+    double timeSinceEpoch = ( (double)dateTime.toTime_t() - m_epochTime ) / 60.0;
 
     double r[3], v[3];
     sgp4( wgs84, m_satrec, timeSinceEpoch, r, v );
 
-    GeoDataCoordinates coordinates = fromTEME(
-        r[0], r[1], r[2], gmst( timeSinceEpoch ) );
-    if ( m_satrec.error != 0 ) {
+    coordinates = fromTEME( r[0], r[1], r[2], gmst( timeSinceEpoch ) );
+
+    return m_satrec.error == 0;
+}
+
+void SatellitesTLEItem::addPointAt( const QDateTime &dateTime )
+{
+    GeoDataCoordinates coordinates;
+    if ( !coordinatesAt( dateTime, coordinates ) ) {
         return;
     }
 
     m_track->addPoint( dateTime, coordinates);
 }
 
+void SatellitesTLEItem::appendPointAt( const QDateTime &dateTime )
+{
+    GeoDataCoordinates coordinates;
+    if ( !coordinatesAt( dateTime, coordinates ) ) {
+        return;
+    }
+
+    // addPoint() would search the whole track for the position of the point
+    m_track->appendWhen( dateTime );
+    m_track->appendCoordinates( coordinates );
+}
+
 QDateTime SatellitesTLEItem::timeAtEpoch() const
 {
     int year = m_satrec.epochyr + ( m_satrec.epochyr < 57 ? 2000 : 1900 );
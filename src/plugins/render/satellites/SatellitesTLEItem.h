@@ -18,6 +18,8 @@
 
 #include "sgp4/sgp4unit.h"
 
+#include <QVector>
+
 class QColor;
 
 namespace Marble {
@@ -38,6 +40,13 @@ public:
 
     void update();
 
+    /**
+     * Updates the enabled @p items like update(). The items are distributed
+     * over several threads, so they must not be accessed elsewhere until
+     * this method returns.
+     */
+    static void updateItems( const QVector<SatellitesTLEItem *> &items );
+
 private:
     double m_earthSemiMajorAxis; // in km
     elsetrec m_satrec;
@@ -46,14 +55,29 @@ private:
 
     const MarbleClock *m_clock;
 
+    uint m_epochTime; // in seconds since 1970-01-01T00:00:00 UTC
+
     void setDescription();
 
+    /**
+     * Determine the @p coordinates of the satellite at time @p dateTime
+     * from m_satrec.
+     * @return false if the orbit cannot be propagated to @p dateTime
+     */
+    bool coordinatesAt( const QDateTime &dateTime, GeoDataCoordinates &coordinates );
+
     /**
      * Add a point in the GeoDataTrack geometry of the placemark with time
      * dateTime and coordinates of the satellite determined from m_satrec.
      */
     void addPointAt( const QDateTime &dateTime );
 
+    /**
+     * Like addPointAt(), but @p dateTime must be later than the last point
+     * of the track.
+     */
+    void appendPointAt( const QDateTime &dateTime );
+
     /**
      * Create a GeoDataCoordinates object from the cartesian coordinates
      * @p x, @p y and @p z in km in the Earth-centered inertial frame known
@@ -54,9 +54,7 @@ public:
 
     void update()
     {
-        foreach( TrackerPluginItem *item, m_itemVector ) {
-            item->update();
-        }
+        m_parent->updateItems();
     }
 
     void updateDocument()
@@ -169,6 +167,13 @@ void TrackerPluginModel::parseFile( const QString &id, const QByteArray &file )
     Q_UNUSED( file );
 }
 
+void TrackerPluginModel::updateItems()
+{
+    foreach( TrackerPluginItem *item, d->m_itemVector ) {
+        item->update();
+    }
+}
+
 } // namespace Marble
 
 #include "TrackerPluginModel.moc"
@@ -94,6 +94,13 @@ public:
      */
     virtual void parseFile( const QString &id, const QByteArray &file );
 
+    /**
+     * This method is called regularly to update all items. The default
+     * implementation calls TrackerPluginItem::update() on one item after the
+     * other, reimplement it to update several items at once.
+     */
+    virtual void updateItems();
+
 Q_SIGNALS:
     void itemUpdateStarted();
     void itemUpdateEnded();
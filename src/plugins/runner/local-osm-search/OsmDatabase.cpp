@@ -20,9 +20,16 @@
 #include "PositionTracking.h"
 
 #include <QFile>
+#include <QAtomicInt>
+#include <QFileInfo>
 #include <QDataStream>
+#include <QHash>
+#include <QSemaphore>
 #include <QStringList>
 #include <QRegExp>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QThreadStorage>
 #include <QVariant>
 #include <QTime>
 
@@ -30,6 +37,8 @@
 #include <QSqlQuery>
 #include <QSqlError>
 
+#include <algorithm>
+
 namespace Marble {
 
 namespace {
@@ -69,8 +78,102 @@ private:
     const DatabaseQuery *const m_currentQuery;
 };
 
+/**
+ * Database connections of the current thread. Connections must only be used
+ * in the thread that created them. Runners and search tasks run in thread
+ * pools, so the connections of a thread get reused by later queries.
+ */
+class DatabaseConnections
+{
+public:
+    ~DatabaseConnections()
+    {
+        foreach ( const QString &name, m_names ) {
+            QSqlDatabase::database( name, false ).close();
+            QSqlDatabase::removeDatabase( name );
+        }
+    }
+
+    QSqlDatabase database( const QString &databaseFile )
+    {
+        // a replaced file gets a new connection
+        const QString key = databaseFile + '@' + QString::number( QFileInfo( databaseFile ).lastModified().toTime_t() );
+        QString name = m_names.value( key );
+        if ( !name.isEmpty() ) {
+            return QSqlDatabase::database( name );
+        }
+
+        static QAtomicInt connectionCount;
+        name = QString( "marble/local-osm-search-%1" ).arg( connectionCount.fetchAndAddOrdered( 1 ) );
+        m_names.insert( key, name );
+
+        QSqlDatabase database = QSqlDatabase::addDatabase( "QSQLITE", name );
+        database.setDatabaseName( databaseFile );
+        if ( !database.open() ) {
+            qWarning() << "Failed to connect to database" << databaseFile;
+        }
+
+        return database;
+    }
+
+private:
+    QHash<QString, QString> m_names;
+};
+
+QThreadStorage<DatabaseConnections *> s_connections;
+
+QSqlDatabase connection( const QString &databaseFile )
+{
+    if ( !s_connections.hasLocalData() ) {
+        s_connections.setLocalData( new DatabaseConnections );
+    }
+
+    return s_connections.localData()->database( databaseFile );
+}
+
+QThreadPool *threadPool()
+{
+    static QThreadPool pool;
+    return &pool;
+}
+
+bool hasSpatialIndex( const QSqlDatabase &database )
+{
+    // created by osm-addresses if SQLite supports R*Trees
+    return database.tables().contains( "placemarksTree" );
+}
+
 }
 
+class OsmDatabase::SearchTask : public QRunnable
+{
+public:
+    SearchTask( const QString &databaseFile, const DatabaseQuery *userQuery, QSemaphore *finished ) :
+        m_databaseFile( databaseFile ),
+        m_userQuery( userQuery ),
+        m_finished( finished )
+    {
+        setAutoDelete( false );
+    }
+
+    virtual void run()
+    {
+        m_result = OsmDatabase::find( m_databaseFile, *m_userQuery );
+        m_finished->release();
+    }
+
+    const QVector<OsmPlacemark> &result() const
+    {
+        return m_result;
+    }
+
+private:
+    const QString m_databaseFile;
+    const DatabaseQuery *const m_userQuery;
+    QSemaphore *const m_finished;
+    QVector<OsmPlacemark> m_result;
+};
+
 OsmDatabase::OsmDatabase( const QStringList &databaseFiles ) :
     m_databaseFiles( databaseFiles )
 {
@@ -82,141 +185,249 @@ QVector<OsmPlacemark> OsmDatabase::find( const DatabaseQuery &userQuery )
         return QVector<OsmPlacemark>();
     }
 
-    QSqlDatabase database = QSqlDatabase::addDatabase( "QSQLITE", QString( "marble/local-osm-search-%1" ).arg( reinterpret_cast<size_t>( this ) ) );
-
     QVector<OsmPlacemark> result;
     QTime timer;
     timer.start();
-    foreach( const QString &databaseFile, m_databaseFiles ) {
-        database.setDatabaseName( databaseFile );
-        if ( !database.open() ) {
-            qWarning() << "Failed to connect to database" << databaseFile;
+
+    if ( m_databaseFiles.size() == 1 ) {
+        result = find( m_databaseFiles.first(), userQuery );
+    } else {
+        // query all databases at once
+        QSemaphore finished;
+        QList<SearchTask *> tasks;
+        foreach( const QString &databaseFile, m_databaseFiles ) {
+            SearchTask *task = new SearchTask( databaseFile, &userQuery, &finished );
+            tasks << task;
+            threadPool()->start( task );
         }
 
-        QString regionRestriction;
-        if ( !userQuery.region().isEmpty() ) {
-            QTime regionTimer;
-            regionTimer.start();
-            // Nested set model to support region hierarchies, see http://en.wikipedia.org/wiki/Nested_set_model
-            const QString regionsQueryString = "SELECT lft, rgt FROM regions WHERE name LIKE '%" + userQuery.region() + "%';";
-            QSqlQuery regionsQuery( regionsQueryString, database );
-            if ( regionsQuery.lastError().isValid() ) {
-                qWarning() << regionsQuery.lastError() << "in" << databaseFile << "with query" << regionsQuery.lastQuery();
-            }
-            regionRestriction = " AND (";
-            int regionCount = 0;
-            while ( regionsQuery.next() ) {
-                if ( regionCount > 0 ) {
-                    regionRestriction += " OR ";
-                }
-                regionRestriction += " (regions.lft >= " + regionsQuery.value( 0 ).toString();
-                regionRestriction += " AND regions.lft <= " + regionsQuery.value( 1 ).toString() + ')';
-                regionCount++;
-            }
-            regionRestriction += ')';
+        finished.acquire( tasks.size() );
+
+        foreach( const SearchTask *task, tasks ) {
+            result << task->result();
+        }
+        qDeleteAll( tasks );
+    }
+
+    qSort( result.begin(), result.end() );
+    makeUnique( result );
+
+    // keep the best 50 results of all databases
+    const int count = qMin( 50, result.size() );
+    if ( userQuery.position().isValid() ) {
+        const PlacemarkSmallerDistance placemarkSmallerDistance( userQuery.position() );
+        std::partial_sort( result.begin(), result.begin() + count, result.end(), placemarkSmallerDistance );
+    } else {
+        const PlacemarkHigherScore placemarkHigherScore( &userQuery );
+        std::partial_sort( result.begin(), result.begin() + count, result.end(), placemarkHigherScore );
+    }
+    result.resize( count );
 
-            mDebug() << Q_FUNC_INFO << "region query in" << databaseFile << "with query" << regionsQueryString
-                     << "took" << regionTimer.elapsed() << "ms for" << regionCount << "results";
+    mDebug() << "Offline OSM search query took" << timer.elapsed() << "ms for" << result.count() << "results.";
+
+    return result;
+}
+
+QVector<OsmPlacemark> OsmDatabase::find( const QString &databaseFile, const DatabaseQuery &userQuery )
+{
+    QVector<OsmPlacemark> result;
 
-            if ( regionCount == 0 ) {
-                continue;
+    QSqlDatabase database = connection( databaseFile );
+    if ( !database.isOpen() ) {
+        return result;
+    }
+
+    QString regionRestriction;
+    if ( !userQuery.region().isEmpty() ) {
+        QTime regionTimer;
+        regionTimer.start();
+        // Nested set model to support region hierarchies, see http://en.wikipedia.org/wiki/Nested_set_model
+        QSqlQuery regionsQuery( database );
+        regionsQuery.setForwardOnly( true );
+        regionsQuery.prepare( "SELECT lft, rgt FROM regions WHERE name LIKE ?;" );
+        regionsQuery.addBindValue( '%' + userQuery.region() + '%' );
+        if ( !regionsQuery.exec() ) {
+            qWarning() << regionsQuery.lastError() << "in" << databaseFile << "with query" << regionsQuery.lastQuery();
+            return result;
+        }
+        regionRestriction = " AND (";
+        int regionCount = 0;
+        while ( regionsQuery.next() ) {
+            if ( regionCount > 0 ) {
+                regionRestriction += " OR ";
             }
+            regionRestriction += " (regions.lft >= " + QString::number( regionsQuery.value( 0 ).toInt() );
+            regionRestriction += " AND regions.lft <= " + QString::number( regionsQuery.value( 1 ).toInt() ) + ')';
+            regionCount++;
         }
+        regionRestriction += ')';
 
-        QString queryString;
-
-        queryString = " SELECT regions.name,"
-                " places.name, places.number,"
-                " places.category, places.lon, places.lat"
-                " FROM regions, places";
-
-        if ( userQuery.queryType() == DatabaseQuery::CategorySearch ) {
-            queryString += " WHERE regions.id = places.region";
-            if( userQuery.category() == OsmPlacemark::UnknownCategory ) {
-                // search for all pois which are not street nor address
-                queryString += " AND places.category <> 0 AND places.category <> 6";
-            } else {
-                // search for specific category
-                queryString += " AND places.category = %1";
-                queryString = queryString.arg( (qint32) userQuery.category() );
-            }
-            if ( userQuery.position().isValid() && userQuery.region().isEmpty() ) {
-                // sort by distance
-                queryString += " ORDER BY ((places.lat-%1)*(places.lat-%1)+(places.lon-%2)*(places.lon-%2))";
-                GeoDataCoordinates position = userQuery.position();
-                queryString = queryString.arg( position.latitude( GeoDataCoordinates::Degree ), 0, 'f', 8 )
-                        .arg( position.longitude( GeoDataCoordinates::Degree ), 0, 'f', 8 );
-            } else {
-                queryString += regionRestriction;
-            }
-        } else if ( userQuery.queryType() == DatabaseQuery::BroadSearch ) {
-            queryString += " WHERE regions.id = places.region"
-                    " AND places.name " + wildcardQuery( userQuery.searchTerm() );
-        } else {
-            queryString += " WHERE regions.id = places.region"
-                    "   AND places.name " + wildcardQuery( userQuery.street() );
-            if ( !userQuery.houseNumber().isEmpty() ) {
-                queryString += " AND places.number " + wildcardQuery( userQuery.houseNumber() );
-            } else {
-                queryString += " AND places.number IS NULL";
-            }
-            queryString += regionRestriction;
+        mDebug() << Q_FUNC_INFO << "region query in" << databaseFile << "with query" << regionsQuery.lastQuery()
+                 << "took" << regionTimer.elapsed() << "ms for" << regionCount << "results";
+
+        if ( regionCount == 0 ) {
+            return result;
         }
+    }
 
-        queryString += " LIMIT 50;";
+    if ( userQuery.queryType() == DatabaseQuery::CategorySearch
+         && userQuery.position().isValid() && userQuery.region().isEmpty()
+         && hasSpatialIndex( database ) ) {
+        return findNearby( database, userQuery );
+    }
 
-        /** @todo: sort/filter results from several databases */
+    QString queryString;
+    QVariantList bindValues;
 
-        QSqlQuery query( database );
-        query.setForwardOnly( true );
-        QTime queryTimer;
-        queryTimer.start();
-        if ( !query.exec( queryString ) ) {
-            qWarning() << query.lastError() << "in" << databaseFile << "with query" << query.lastQuery();
-            continue;
-        }
+    queryString = " SELECT regions.name,"
+            " places.name, places.number,"
+            " places.category, places.lon, places.lat"
+            " FROM regions, places";
 
-        int resultCount = 0;
-        while ( query.next() ) {
-            OsmPlacemark placemark;
-            if ( userQuery.resultFormat() == DatabaseQuery::DistanceFormat ) {
-                GeoDataCoordinates coordinates( query.value(4).toFloat(), query.value(5).toFloat(), 0.0, GeoDataCoordinates::Degree );
-                placemark.setAdditionalInformation( formatDistance( coordinates, userQuery.position() ) );
-            } else {
-                placemark.setAdditionalInformation( query.value( 0 ).toString() );
-            }
-            placemark.setName( query.value(1).toString() );
-            placemark.setHouseNumber( query.value(2).toString() );
-            placemark.setCategory( (OsmPlacemark::OsmCategory) query.value(3).toInt() );
-            placemark.setLongitude( query.value(4).toFloat() );
-            placemark.setLatitude( query.value(5).toFloat() );
-
-            result.push_back( placemark );
-            resultCount++;
+    if ( userQuery.queryType() == DatabaseQuery::CategorySearch ) {
+        queryString += " WHERE regions.id = places.region";
+        if( userQuery.category() == OsmPlacemark::UnknownCategory ) {
+            // search for all pois which are not street nor address
+            queryString += " AND places.category <> 0 AND places.category <> 6";
+        } else {
+            // search for specific category
+            queryString += " AND places.category = ?";
+            bindValues << (qint32) userQuery.category();
         }
+        if ( userQuery.position().isValid() && userQuery.region().isEmpty() ) {
+            // sort by distance
+            queryString += " ORDER BY ((places.lat-?)*(places.lat-?)+(places.lon-?)*(places.lon-?))";
+            const qreal lat = userQuery.position().latitude( GeoDataCoordinates::Degree );
+            const qreal lon = userQuery.position().longitude( GeoDataCoordinates::Degree );
+            bindValues << lat << lat << lon << lon;
+        } else {
+            queryString += regionRestriction;
+        }
+    } else if ( userQuery.queryType() == DatabaseQuery::BroadSearch ) {
+        queryString += " WHERE regions.id = places.region"
+                " AND places.name " + wildcardQuery( userQuery.searchTerm(), bindValues );
+    } else {
+        queryString += " WHERE regions.id = places.region"
+                "   AND places.name " + wildcardQuery( userQuery.street(), bindValues );
+        if ( !userQuery.houseNumber().isEmpty() ) {
+            queryString += " AND places.number " + wildcardQuery( userQuery.houseNumber(), bindValues );
+        } else {
+            queryString += " AND places.number IS NULL";
+        }
+        queryString += regionRestriction;
+    }
+
+    queryString += " LIMIT 50;";
 
-        mDebug() << Q_FUNC_INFO << "query in" << databaseFile << "with query" << queryString
-                 << "took" << queryTimer.elapsed() << "ms for" << resultCount << "results";
+    QSqlQuery query( database );
+    query.setForwardOnly( true );
+    QTime queryTimer;
+    queryTimer.start();
+    query.prepare( queryString );
+    foreach( const QVariant &value, bindValues ) {
+        query.addBindValue( value );
+    }
+    if ( !query.exec() ) {
+        qWarning() << query.lastError() << "in" << databaseFile << "with query" << query.lastQuery();
+        return result;
     }
 
-    mDebug() << "Offline OSM search query took" << timer.elapsed() << "ms for" << result.count() << "results.";
+    readPlacemarks( query, userQuery, result );
 
-    qSort( result.begin(), result.end() );
-    makeUnique( result );
+    mDebug() << Q_FUNC_INFO << "query in" << databaseFile << "with query" << queryString
+             << "took" << queryTimer.elapsed() << "ms for" << result.size() << "results";
 
-    if ( userQuery.position().isValid() ) {
-        const PlacemarkSmallerDistance placemarkSmallerDistance( userQuery.position() );
-        qSort( result.begin(), result.end(), placemarkSmallerDistance );
+    return result;
+}
+
+QVector<OsmPlacemark> OsmDatabase::findNearby( QSqlDatabase &database, const DatabaseQuery &userQuery )
+{
+    QString queryString = " SELECT regions.name,"
+            " names.name, placemarks.number,"
+            " placemarks.category, placemarks.lon, placemarks.lat"
+            " FROM placemarksTree"
+            " INNER JOIN placemarks ON placemarks.id = placemarksTree.id"
+            " INNER JOIN names ON names.id = placemarks.nameId"
+            " INNER JOIN regions ON regions.id = placemarks.regionId"
+            " WHERE placemarksTree.minLon >= ? AND placemarksTree.maxLon <= ?"
+            " AND placemarksTree.minLat >= ? AND placemarksTree.maxLat <= ?";
+    if( userQuery.category() == OsmPlacemark::UnknownCategory ) {
+        // search for all pois which are not street nor address
+        queryString += " AND placemarks.category <> 0 AND placemarks.category <> 6";
     } else {
-        const PlacemarkHigherScore placemarkHigherScore( &userQuery );
-        qSort( result.begin(), result.end(), placemarkHigherScore );
+        queryString += " AND placemarks.category = ?";
     }
+    queryString += " ORDER BY ((placemarks.lat-?)*(placemarks.lat-?)+(placemarks.lon-?)*(placemarks.lon-?))"
+            " LIMIT 50;";
+
+    QSqlQuery query( database );
+    query.setForwardOnly( true );
+    query.prepare( queryString );
+
+    const qreal lat = userQuery.position().latitude( GeoDataCoordinates::Degree );
+    const qreal lon = userQuery.position().longitude( GeoDataCoordinates::Degree );
+
+    // Search boxes of growing size around the position. The results are complete once the
+    // box contains 50 of them and the farthest one is closer than the border of the box.
+    QVector<OsmPlacemark> result;
+    for ( qreal radius = 0.05; ; radius *= 4 ) {
+        QTime queryTimer;
+        queryTimer.start();
+
+        query.addBindValue( lon - radius );
+        query.addBindValue( lon + radius );
+        query.addBindValue( lat - radius );
+        query.addBindValue( lat + radius );
+        if( userQuery.category() != OsmPlacemark::UnknownCategory ) {
+            query.addBindValue( (qint32) userQuery.category() );
+        }
+        query.addBindValue( lat );
+        query.addBindValue( lat );
+        query.addBindValue( lon );
+        query.addBindValue( lon );
+
+        result.clear();
+        if ( !query.exec() ) {
+            qWarning() << query.lastError() << "in" << database.databaseName() << "with query" << query.lastQuery();
+            return result;
+        }
+        readPlacemarks( query, userQuery, result );
 
-    if ( result.size() > 50 ) {
-        result.remove( 50, result.size()-50 );
+        mDebug() << Q_FUNC_INFO << "query in" << database.databaseName() << "within" << radius << "degrees"
+                 << "took" << queryTimer.elapsed() << "ms for" << result.size() << "results";
+
+        if ( radius >= 360 ) {
+            return result;
+        }
+
+        if ( result.size() == 50 ) {
+            const qreal dLat = result.last().latitude() - lat;
+            const qreal dLon = result.last().longitude() - lon;
+            if ( dLat * dLat + dLon * dLon <= radius * radius ) {
+                return result;
+            }
+        }
     }
+}
 
-    return result;
+void OsmDatabase::readPlacemarks( QSqlQuery &query, const DatabaseQuery &userQuery, QVector<OsmPlacemark> &placemarks )
+{
+    while ( query.next() ) {
+        OsmPlacemark placemark;
+        if ( userQuery.resultFormat() == DatabaseQuery::DistanceFormat ) {
+            GeoDataCoordinates coordinates( query.value(4).toFloat(), query.value(5).toFloat(), 0.0, GeoDataCoordinates::Degree );
+            placemark.setAdditionalInformation( formatDistance( coordinates, userQuery.position() ) );
+        } else {
+            placemark.setAdditionalInformation( query.value( 0 ).toString() );
+        }
+        placemark.setName( query.value(1).toString() );
+        placemark.setHouseNumber( query.value(2).toString() );
+        placemark.setCategory( (OsmPlacemark::OsmCategory) query.value(3).toInt() );
+        placemark.setLongitude( query.value(4).toFloat() );
+        placemark.setLatitude( query.value(5).toFloat() );
+
+        placemarks.push_back( placemark );
+    }
 }
 
 void OsmDatabase::makeUnique( QVector<OsmPlacemark> &placemarks )
@@ -297,13 +508,15 @@ qreal OsmDatabase::bearing( const GeoDataCoordinates &a, const GeoDataCoordinate
                        cos( lat1 ) * sin( lat2 ) - sin( lat1 ) * cos( lat2 ) * cos ( delta ) ), 2 * M_PI );
 }
 
-QString OsmDatabase::wildcardQuery( const QString &term )
+QString OsmDatabase::wildcardQuery( const QString &term, QVariantList &bindValues )
 {
     QString result = term;
     if ( term.contains( '*' ) ) {
-        return " LIKE '" + result.replace( '*', '%' ) + '\'';
+        bindValues << result.replace( '*', '%' );
+        return " LIKE ?";
     } else {
-        return " = '" + result + '\'';
+        bindValues << result;
+        return " = ?";
     }
 }
 
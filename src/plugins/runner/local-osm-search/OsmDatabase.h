@@ -16,6 +16,10 @@
 
 #include <QString>
 #include <QStringList>
+#include <QVariant>
+
+class QSqlDatabase;
+class QSqlQuery;
 
 namespace Marble {
 
@@ -33,7 +37,17 @@ public:
     QVector<OsmPlacemark> find( const DatabaseQuery &userQuery );
 
 private:
-    static QString wildcardQuery( const QString &term );
+    class SearchTask;
+
+    /** Search a single database file using the connection of the calling thread */
+    static QVector<OsmPlacemark> find( const QString &databaseFile, const DatabaseQuery &userQuery );
+
+    /** Nearest points of interest, using the spatial index of the database */
+    static QVector<OsmPlacemark> findNearby( QSqlDatabase &database, const DatabaseQuery &userQuery );
+
+    static void readPlacemarks( QSqlQuery &query, const DatabaseQuery &userQuery, QVector<OsmPlacemark> &placemarks );
+
+    static QString wildcardQuery( const QString &term, QVariantList &bindValues );
 
     static void makeUnique( QVector<OsmPlacemark> &placemarks );
 
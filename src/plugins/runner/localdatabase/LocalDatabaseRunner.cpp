@@ -12,18 +12,12 @@
 #include "LocalDatabaseRunner.h"
 
 #include "MarbleModel.h"
-#include "MarblePlacemarkModel.h"
-#include "GeoDataFeature.h"
+#include "PlacemarkSearchIndex.h"
 #include "GeoDataPlacemark.h"
-#include "GeoDataCoordinates.h"
 
-#include "MarbleDebug.h"
 #include <QString>
-#include <QStringList>
 #include <QVector>
 
-#include <QtDebug>
-
 namespace Marble
 {
 
@@ -42,28 +36,7 @@ void LocalDatabaseRunner::search( const QString &searchTerm, const GeoDataLatLon
     QVector<GeoDataPlacemark*> vector;
 
     if (model()) {
-        const QAbstractItemModel * placemarkModel = model()->placemarkModel();
-
-        if (placemarkModel) {
-            QModelIndexList resultList;
-            QModelIndex firstIndex = placemarkModel->index( 0, 0 );
-            resultList = placemarkModel->match( firstIndex,
-                                    Qt::DisplayRole, searchTerm, -1,
-                                    Qt::MatchStartsWith );
-
-            foreach ( const QModelIndex& index, resultList )
-            {
-                if( !index.isValid() ) {
-                    mDebug() << "invalid index!!!";
-                    continue;
-                }
-                GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>( index.data( MarblePlacemarkModel::ObjectPointerRole )));
-                if ( placemark &&
-                     ( preferred.isEmpty() || preferred.contains( placemark->coordinate() ) ) ) {
-                    vector.append( new GeoDataPlacemark( *placemark ));
-                }
-            }
-        }
+        vector = model()->placemarkSearchIndex()->search( searchTerm, preferred );
     }
 
     emit searchFinished( vector );
@@ -0,0 +1,114 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_OSMIDINDEX_H
+#define MARBLE_OSMIDINDEX_H
+
+#include <QtAlgorithms>
+#include <QVector>
+
+namespace Marble
+{
+
+/**
+ * @short Maps the ids of OpenStreetMap elements to values.
+ *
+ * OpenStreetMap files list the elements of each type sorted by id, so the
+ * entries are kept in a plain array in insertion order and looked up by
+ * binary search. Should the ids arrive unsorted, the array gets sorted
+ * once on the next lookup. Compared to a QMap or QHash this saves one
+ * allocation per entry and keeps the entries close together in memory.
+ *
+ * If an id is inserted several times, value() returns the value inserted
+ * last, but values() still contains all of them.
+ */
+template<typename T>
+class OsmIdIndex
+{
+ public:
+    OsmIdIndex() :
+        m_sorted( true )
+    {
+    }
+
+    void reserve( int size )
+    {
+        m_entries.reserve( size );
+    }
+
+    void insert( quint64 id, const T &value )
+    {
+        if ( m_sorted && !m_entries.isEmpty() && id <= m_entries.last().id ) {
+            m_sorted = false;
+        }
+        m_entries.append( Entry( id, value ) );
+    }
+
+    /**
+     * Returns the value inserted last for @p id, or a default-constructed
+     * value if there is none.
+     */
+    T value( quint64 id ) const
+    {
+        if ( !m_sorted ) {
+            // stable, so that equal ids stay in insertion order
+            qStableSort( m_entries.begin(), m_entries.end() );
+            m_sorted = true;
+        }
+
+        const typename QVector<Entry>::const_iterator it =
+                qUpperBound( m_entries.constBegin(), m_entries.constEnd(), Entry( id, T() ) );
+        if ( it == m_entries.constBegin() || ( it - 1 )->id != id ) {
+            return T();
+        }
+
+        return ( it - 1 )->value;
+    }
+
+    QVector<T> values() const
+    {
+        QVector<T> result;
+        result.reserve( m_entries.size() );
+        for ( int i = 0; i < m_entries.size(); ++i ) {
+            result << m_entries.at( i ).value;
+        }
+        return result;
+    }
+
+    int size() const
+    {
+        return m_entries.size();
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_sorted = true;
+    }
+
+ private:
+    struct Entry
+    {
+        Entry() : id( 0 ), value() {}
+        Entry( quint64 id_, const T &value_ ) : id( id_ ), value( value_ ) {}
+
+        bool operator<( const Entry &other ) const { return id < other.id; }
+
+        quint64 id;
+        T value;
+    };
+
+    mutable QVector<Entry> m_entries;
+    mutable bool m_sorted;
+};
+
+}
+
+#endif
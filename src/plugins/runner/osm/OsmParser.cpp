@@ -19,51 +19,20 @@ namespace Marble {
 const QColor OsmParser::backgroundColor( 0xF1, 0xEE, 0xE8 );
 
 OsmParser::OsmParser()
-    : GeoParser( 0 )
+    : GeoParser( 0 ),
+      m_areaTags( areaTags() )
 {
-    // All these tags can be found updated at
-    // http://wiki.openstreetmap.org/wiki/Map_Features#Landuse
-
-    m_areaTags.insert( "landuse=forest" );
-    m_areaTags.insert( "natural=wood" );
-    m_areaTags.insert( "area=yes" );
-    m_areaTags.insert( "waterway=riverbank" );
-    m_areaTags.insert( "building=yes" );
-    m_areaTags.insert( "amenity=parking" );
-    m_areaTags.insert( "leisure=park" );
-
-    m_areaTags.insert( "landuse=allotments" );
-    m_areaTags.insert( "landuse=basin" );
-    m_areaTags.insert( "landuse=brownfield" );
-    m_areaTags.insert( "landuse=cemetery" );
-    m_areaTags.insert( "landuse=commercial" );
-    m_areaTags.insert( "landuse=construction" );
-    m_areaTags.insert( "landuse=farm" );
-    m_areaTags.insert( "landuse=farmland" );
-    m_areaTags.insert( "landuse=farmyard" );
-    m_areaTags.insert( "landuse=garages" );
-    m_areaTags.insert( "landuse=greenfield" );
-    m_areaTags.insert( "landuse=industrial" );
-    m_areaTags.insert( "landuse=landfill" );
-    m_areaTags.insert( "landuse=meadow" );
-    m_areaTags.insert( "landuse=military" );
-    m_areaTags.insert( "landuse=orchard" );
-    m_areaTags.insert( "landuse=quarry" );
-    m_areaTags.insert( "landuse=railway" );
-    m_areaTags.insert( "landuse=reservoir" );
-    m_areaTags.insert( "landuse=residential" );
-    m_areaTags.insert( "landuse=retail" );
 }
 
 OsmParser::~OsmParser()
 {
     qDeleteAll( m_dummyPlacemarks );
-    qDeleteAll( m_nodes );
+    qDeleteAll( m_nodes.values() );
 }
 
 void OsmParser::setNode( quint64 id, GeoDataPoint *point )
 {
-    m_nodes[id] = point;
+    m_nodes.insert( id, point );
 }
 
 GeoDataPoint *OsmParser::node( quint64 id )
@@ -73,7 +42,7 @@ GeoDataPoint *OsmParser::node( quint64 id )
 
 void OsmParser::setWay( quint64 id, GeoDataLineString *way )
 {
-    m_ways[id] = way;
+    m_ways.insert( id, way );
 }
 
 GeoDataLineString *OsmParser::way( quint64 id )
@@ -83,7 +52,7 @@ GeoDataLineString *OsmParser::way( quint64 id )
 
 void OsmParser::setPolygon( quint64 id, GeoDataPolygon *polygon )
 {
-    m_polygons[id] = polygon;
+    m_polygons.insert( id, polygon );
 }
 
 GeoDataPolygon *OsmParser::polygon( quint64 id )
@@ -96,6 +65,46 @@ bool OsmParser::tagNeedArea( const QString &keyValue ) const
     return m_areaTags.contains( keyValue );
 }
 
+QSet<QString> OsmParser::areaTags()
+{
+    QSet<QString> areaTags;
+
+    // All these tags can be found updated at
+    // http://wiki.openstreetmap.org/wiki/Map_Features#Landuse
+
+    areaTags.insert( "landuse=forest" );
+    areaTags.insert( "natural=wood" );
+    areaTags.insert( "area=yes" );
+    areaTags.insert( "waterway=riverbank" );
+    areaTags.insert( "building=yes" );
+    areaTags.insert( "amenity=parking" );
+    areaTags.insert( "leisure=park" );
+
+    areaTags.insert( "landuse=allotments" );
+    areaTags.insert( "landuse=basin" );
+    areaTags.insert( "landuse=brownfield" );
+    areaTags.insert( "landuse=cemetery" );
+    areaTags.insert( "landuse=commercial" );
+    areaTags.insert( "landuse=construction" );
+    areaTags.insert( "landuse=farm" );
+    areaTags.insert( "landuse=farmland" );
+    areaTags.insert( "landuse=farmyard" );
+    areaTags.insert( "landuse=garages" );
+    areaTags.insert( "landuse=greenfield" );
+    areaTags.insert( "landuse=industrial" );
+    areaTags.insert( "landuse=landfill" );
+    areaTags.insert( "landuse=meadow" );
+    areaTags.insert( "landuse=military" );
+    areaTags.insert( "landuse=orchard" );
+    areaTags.insert( "landuse=quarry" );
+    areaTags.insert( "landuse=railway" );
+    areaTags.insert( "landuse=reservoir" );
+    areaTags.insert( "landuse=residential" );
+    areaTags.insert( "landuse=retail" );
+
+    return areaTags;
+}
+
 void OsmParser::addDummyPlacemark( GeoDataPlacemark *placemark )
 {
     m_dummyPlacemarks << placemark;
@@ -14,10 +14,10 @@
 #define OSMPARSER_H
 
 #include "GeoParser.h"
+#include "OsmIdIndex.h"
 
 #include <QColor>
 #include <QList>
-#include <QMap>
 #include <QSet>
 
 namespace Marble {
@@ -43,6 +43,12 @@ public:
     GeoDataPolygon *polygon( quint64 id );
 
     bool tagNeedArea( const QString &keyValue ) const;
+
+    /**
+     * Returns the "key=value" pairs of tags which turn ways into areas.
+     */
+    static QSet<QString> areaTags();
+
     void addDummyPlacemark( GeoDataPlacemark *placemark );
 
     static const QColor backgroundColor;
@@ -53,9 +59,9 @@ private:
 
     virtual GeoDocument* createDocument() const;
 
-    QMap<quint64, GeoDataPoint *> m_nodes;
-    QMap<quint64, GeoDataPolygon *> m_polygons;
-    QMap<quint64, GeoDataLineString *> m_ways;
+    OsmIdIndex<GeoDataPoint *> m_nodes;
+    OsmIdIndex<GeoDataPolygon *> m_polygons;
+    OsmIdIndex<GeoDataLineString *> m_ways;
     QSet<QString> m_areaTags;
     QList<GeoDataPlacemark *> m_dummyPlacemarks;
 };
@@ -56,7 +56,11 @@ QString OsmPlugin::fileFormatDescription() const
 
 QStringList OsmPlugin::fileExtensions() const
 {
+#ifdef MARBLE_HAVE_PROTOBUF
+    return QStringList() << "osm" << "pbf" << "osm.pbf";
+#else
     return QStringList() << "osm";
+#endif
 }
 
 ParsingRunner* OsmPlugin::newRunner() const
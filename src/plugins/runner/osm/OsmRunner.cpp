@@ -12,7 +12,12 @@
 #include "GeoDataDocument.h"
 #include "OsmParser.h"
 
+#ifdef MARBLE_HAVE_PROTOBUF
+#include "OsmPbfParser.h"
+#endif
+
 #include <QFile>
+#include <QFileInfo>
 
 namespace Marble
 {
@@ -38,6 +43,24 @@ void OsmRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
     // Open file in right mode
     file.open( QIODevice::ReadOnly );
 
+#ifdef MARBLE_HAVE_PROTOBUF
+    if ( QFileInfo( fileName ).suffix().toLower() == "pbf" ) {
+        OsmPbfParser parser;
+        if ( !parser.read( &file ) ) {
+            emit parsingFinished( 0, parser.errorString() );
+            return;
+        }
+        GeoDataDocument* doc = parser.releaseDocument();
+        Q_ASSERT( doc );
+        doc->setDocumentRole( role );
+        doc->setFileName( fileName );
+
+        file.close();
+        emit parsingFinished( doc );
+        return;
+    }
+#endif
+
     OsmParser parser;
 
     if ( !parser.read( &file ) ) {
@@ -0,0 +1,204 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "OsmPbfBlock.h"
+
+#include "fileformat.pb.h"
+#include "osmformat.pb.h"
+
+#include <QtEndian>
+
+#include <string.h>
+
+namespace Marble
+{
+
+OsmPbfBlockDecoder::OsmPbfBlockDecoder( const QByteArray &blob ) :
+    m_blob( blob )
+{
+}
+
+void OsmPbfBlockDecoder::run()
+{
+    QByteArray data;
+    m_error = uncompress( m_blob, data );
+    m_blob.clear();
+    if ( !m_error.isEmpty() ) {
+        return;
+    }
+
+    OSMPBF::PrimitiveBlock primitiveBlock;
+    if ( !primitiveBlock.ParseFromArray( data.constData(), data.size() ) ) {
+        m_error = QString( "Failed to parse PrimitiveBlock" );
+        return;
+    }
+    data.clear();
+
+    // Convert each string once, the tags of all elements share them
+    const OSMPBF::StringTable &stringTable = primitiveBlock.stringtable();
+    QVector<QString> strings( stringTable.s_size() );
+    for ( int i = 0; i < stringTable.s_size(); ++i ) {
+        const std::string &s = stringTable.s( i );
+        strings[i] = QString::fromUtf8( s.data(), s.size() );
+    }
+
+    // coordinates are stored in units of granularity nanodegrees
+    const qreal granularity = 1e-9 * primitiveBlock.granularity();
+    const qreal latOffset = 1e-9 * primitiveBlock.lat_offset();
+    const qreal lonOffset = 1e-9 * primitiveBlock.lon_offset();
+
+    for ( int g = 0; g < primitiveBlock.primitivegroup_size(); ++g ) {
+        const OSMPBF::PrimitiveGroup &group = primitiveBlock.primitivegroup( g );
+
+        for ( int i = 0; i < group.nodes_size(); ++i ) {
+            const OSMPBF::Node &input = group.nodes( i );
+            OsmPbfNode node;
+            node.id = input.id();
+            node.lat = latOffset + granularity * input.lat();
+            node.lon = lonOffset + granularity * input.lon();
+            for ( int t = 0; t < input.keys_size() && t < input.vals_size(); ++t ) {
+                node.tags << qMakePair( strings.value( input.keys( t ) ), strings.value( input.vals( t ) ) );
+            }
+            m_block.nodes << node;
+        }
+
+        if ( group.has_dense() ) {
+            // ids and coordinates are delta coded, the tags of all nodes
+            // are stored as ( ( key value )* 0 )*
+            const OSMPBF::DenseNodes &dense = group.dense();
+            if ( dense.lat_size() != dense.id_size() || dense.lon_size() != dense.id_size() ) {
+                m_error = QString( "Inconsistent DenseNodes: %1 ids, %2 latitudes, %3 longitudes" )
+                          .arg( dense.id_size() ).arg( dense.lat_size() ).arg( dense.lon_size() );
+                return;
+            }
+            m_block.nodes.reserve( m_block.nodes.size() + dense.id_size() );
+            qint64 id = 0;
+            qint64 lat = 0;
+            qint64 lon = 0;
+            int tag = 0;
+            for ( int i = 0; i < dense.id_size(); ++i ) {
+                id += dense.id( i );
+                lat += dense.lat( i );
+                lon += dense.lon( i );
+
+                OsmPbfNode node;
+                node.id = id;
+                node.lat = latOffset + granularity * lat;
+                node.lon = lonOffset + granularity * lon;
+                while ( tag < dense.keys_vals_size() ) {
+                    const int key = dense.keys_vals( tag );
+                    ++tag;
+                    if ( key == 0 || tag >= dense.keys_vals_size() ) {
+                        break;
+                    }
+                    node.tags << qMakePair( strings.value( key ), strings.value( dense.keys_vals( tag ) ) );
+                    ++tag;
+                }
+                m_block.nodes << node;
+            }
+        }
+
+        m_block.ways.reserve( m_block.ways.size() + group.ways_size() );
+        for ( int i = 0; i < group.ways_size(); ++i ) {
+            const OSMPBF::Way &input = group.ways( i );
+            OsmPbfWay way;
+            way.id = input.id();
+            for ( int t = 0; t < input.keys_size() && t < input.vals_size(); ++t ) {
+                way.tags << qMakePair( strings.value( input.keys( t ) ), strings.value( input.vals( t ) ) );
+            }
+            way.nodes.reserve( input.refs_size() );
+            qint64 ref = 0;
+            for ( int r = 0; r < input.refs_size(); ++r ) {
+                ref += input.refs( r );
+                way.nodes << ref;
+            }
+            m_block.ways << way;
+        }
+
+        for ( int i = 0; i < group.relations_size(); ++i ) {
+            const OSMPBF::Relation &input = group.relations( i );
+            OsmPbfRelation relation;
+            relation.id = input.id();
+            for ( int t = 0; t < input.keys_size() && t < input.vals_size(); ++t ) {
+                relation.tags << qMakePair( strings.value( input.keys( t ) ), strings.value( input.vals( t ) ) );
+            }
+            relation.members.reserve( input.memids_size() );
+            qint64 memberId = 0;
+            for ( int m = 0; m < input.memids_size() && m < input.types_size(); ++m ) {
+                memberId += input.memids( m );
+                OsmPbfMember member;
+                member.id = memberId;
+                switch ( input.types( m ) ) {
+                case OSMPBF::Relation::NODE:
+                    member.type = OsmPbfMember::Node;
+                    break;
+                case OSMPBF::Relation::WAY:
+                    member.type = OsmPbfMember::Way;
+                    break;
+                case OSMPBF::Relation::RELATION:
+                    member.type = OsmPbfMember::Relation;
+                    break;
+                }
+                if ( m < input.roles_sid_size() ) {
+                    member.role = strings.value( input.roles_sid( m ) );
+                }
+                relation.members << member;
+            }
+            m_block.relations << relation;
+        }
+    }
+}
+
+const OsmPbfBlock &OsmPbfBlockDecoder::block() const
+{
+    return m_block;
+}
+
+QString OsmPbfBlockDecoder::error() const
+{
+    return m_error;
+}
+
+QString OsmPbfBlockDecoder::uncompress( const QByteArray &blob, QByteArray &data )
+{
+    OSMPBF::Blob message;
+    if ( !message.ParseFromArray( blob.constData(), blob.size() ) ) {
+        return QString( "Failed to parse Blob" );
+    }
+
+    if ( message.has_raw() ) {
+        data = QByteArray( message.raw().data(), message.raw().size() );
+        return QString();
+    }
+
+    if ( message.has_zlib_data() ) {
+        // same limit as for the size of the compressed blob
+        if ( message.raw_size() < 0 || message.raw_size() > 32 * 1024 * 1024 ) {
+            return QString( "Invalid uncompressed Blob size %1" ).arg( message.raw_size() );
+        }
+
+        // qUncompress() expects the size of the uncompressed data in
+        // front of the zlib stream
+        const std::string &zlibData = message.zlib_data();
+        QByteArray compressed( 4 + zlibData.size(), Qt::Uninitialized );
+        qToBigEndian<quint32>( message.raw_size(), reinterpret_cast<uchar*>( compressed.data() ) );
+        memcpy( compressed.data() + 4, zlibData.data(), zlibData.size() );
+
+        data = qUncompress( compressed );
+        if ( data.size() != message.raw_size() ) {
+            return QString( "Failed to uncompress Blob" );
+        }
+        return QString();
+    }
+
+    return QString( "Unsupported compression of Blob" );
+}
+
+}
@@ -0,0 +1,114 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_OSMPBFBLOCK_H
+#define MARBLE_OSMPBFBLOCK_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QRunnable>
+#include <QString>
+#include <QVector>
+
+namespace Marble
+{
+
+typedef QList< QPair<QString, QString> > OsmPbfTags;
+
+struct OsmPbfNode
+{
+    qint64 id;
+    qreal lon; // degree
+    qreal lat; // degree
+    OsmPbfTags tags;
+};
+
+struct OsmPbfWay
+{
+    qint64 id;
+    QVector<qint64> nodes;
+    OsmPbfTags tags;
+};
+
+struct OsmPbfMember
+{
+    enum Type {
+        Node,
+        Way,
+        Relation
+    };
+
+    qint64 id;
+    Type type;
+    QString role;
+};
+
+struct OsmPbfRelation
+{
+    qint64 id;
+    QVector<OsmPbfMember> members;
+    OsmPbfTags tags;
+};
+
+/**
+ * The elements of one PrimitiveBlock of a .pbf file, converted to Qt types.
+ */
+struct OsmPbfBlock
+{
+    QVector<OsmPbfNode> nodes;
+    QVector<OsmPbfWay> ways;
+    QVector<OsmPbfRelation> relations;
+};
+
+/**
+ * @short Decodes one OSMData blob of a .pbf file.
+ *
+ * Decompressing and decoding the blobs takes most of the time needed to
+ * read a .pbf file. The blobs don't depend on each other, so OsmPbfParser
+ * runs one decoder per blob in a thread pool.
+ *
+ * See http://wiki.openstreetmap.org/wiki/PBF_Format
+ */
+class OsmPbfBlockDecoder : public QRunnable
+{
+ public:
+    /**
+     * @param blob the serialized Blob message
+     */
+    explicit OsmPbfBlockDecoder( const QByteArray &blob );
+
+    /**
+     * @reimp
+     */
+    void run();
+
+    /**
+     * Returns the decoded elements. Only valid if error() is empty.
+     */
+    const OsmPbfBlock &block() const;
+
+    QString error() const;
+
+    /**
+     * Decompresses the serialized Blob message @p blob into @p data.
+     * Returns an error message on failure and an empty string otherwise.
+     */
+    static QString uncompress( const QByteArray &blob, QByteArray &data );
+
+ private:
+    QByteArray m_blob;
+    OsmPbfBlock m_block;
+    QString m_error;
+};
+
+}
+
+#endif
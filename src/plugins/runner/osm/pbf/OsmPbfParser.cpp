@@ -0,0 +1,436 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "OsmPbfParser.h"
+
+#include "OsmParser.h"
+#include "fileformat.pb.h"
+#include "osmformat.pb.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "MarbleDebug.h"
+
+#include <QIODevice>
+#include <QThreadPool>
+#include <QtAlgorithms>
+#include <QtEndian>
+
+namespace Marble
+{
+
+OsmPbfParser::OsmPbfParser() :
+    m_coordinatesSorted( true ),
+    m_areaTags( OsmParser::areaTags() ),
+    m_document( 0 )
+{
+}
+
+OsmPbfParser::~OsmPbfParser()
+{
+    delete m_document;
+}
+
+bool OsmPbfParser::read( QIODevice *device )
+{
+    QByteArray type;
+    QByteArray blob;
+    if ( !readBlob( device, type, blob ) ) {
+        return false;
+    }
+
+    if ( type != "OSMHeader" ) {
+        m_error = QString( "Not an OpenStreetMap .pbf file" );
+        return false;
+    }
+
+    if ( !readHeader( blob ) ) {
+        return false;
+    }
+
+    // Decode a bounded number of blocks at once to limit the memory
+    // needed for the decoded elements which are not merged yet.
+    QThreadPool threadPool;
+    const int batchSize = 4 * threadPool.maxThreadCount();
+    QList<OsmPbfBlockDecoder *> decoders;
+
+    while ( !device->atEnd() ) {
+        while ( decoders.size() < batchSize && !device->atEnd() ) {
+            if ( !readBlob( device, type, blob ) ) {
+                threadPool.waitForDone();
+                qDeleteAll( decoders );
+                return false;
+            }
+
+            // unknown blob types are meant to be skipped
+            if ( type != "OSMData" ) {
+                mDebug() << "Skipping blob of type" << type;
+                continue;
+            }
+
+            OsmPbfBlockDecoder *decoder = new OsmPbfBlockDecoder( blob );
+            decoder->setAutoDelete( false );
+            decoders << decoder;
+            threadPool.start( decoder );
+        }
+
+        threadPool.waitForDone();
+
+        // merge in file order
+        foreach ( const OsmPbfBlockDecoder *decoder, decoders ) {
+            if ( !decoder->error().isEmpty() ) {
+                m_error = decoder->error();
+                qDeleteAll( decoders );
+                return false;
+            }
+            addBlock( decoder->block() );
+        }
+        qDeleteAll( decoders );
+        decoders.clear();
+    }
+
+    createDocument();
+
+    return true;
+}
+
+GeoDataDocument *OsmPbfParser::releaseDocument()
+{
+    GeoDataDocument *document = m_document;
+    m_document = 0;
+    return document;
+}
+
+QString OsmPbfParser::errorString() const
+{
+    return m_error;
+}
+
+bool OsmPbfParser::readBlob( QIODevice *device, QByteArray &type, QByteArray &blob )
+{
+    // Each blob is preceded by the size of its BlobHeader in network byte
+    // order and the BlobHeader itself. The limits are the ones given by
+    // the format specification.
+    uchar sizeData[4];
+    if ( device->read( reinterpret_cast<char*>( sizeData ), 4 ) != 4 ) {
+        m_error = QString( "Unexpected end of file" );
+        return false;
+    }
+
+    const quint32 headerSize = qFromBigEndian<quint32>( sizeData );
+    if ( headerSize > 64 * 1024 ) {
+        m_error = QString( "Invalid BlobHeader size %1" ).arg( headerSize );
+        return false;
+    }
+
+    const QByteArray headerData = device->read( headerSize );
+    OSMPBF::BlobHeader header;
+    if ( headerData.size() != int( headerSize ) || !header.ParseFromArray( headerData.constData(), headerData.size() ) ) {
+        m_error = QString( "Failed to parse BlobHeader" );
+        return false;
+    }
+
+    if ( header.datasize() < 0 || header.datasize() > 32 * 1024 * 1024 ) {
+        m_error = QString( "Invalid Blob size %1" ).arg( header.datasize() );
+        return false;
+    }
+
+    type = QByteArray( header.type().data(), header.type().size() );
+    blob = device->read( header.datasize() );
+    if ( blob.size() != header.datasize() ) {
+        m_error = QString( "Unexpected end of file" );
+        return false;
+    }
+
+    return true;
+}
+
+bool OsmPbfParser::readHeader( const QByteArray &blob )
+{
+    QByteArray data;
+    m_error = OsmPbfBlockDecoder::uncompress( blob, data );
+    if ( !m_error.isEmpty() ) {
+        return false;
+    }
+
+    OSMPBF::HeaderBlock headerBlock;
+    if ( !headerBlock.ParseFromArray( data.constData(), data.size() ) ) {
+        m_error = QString( "Failed to parse HeaderBlock" );
+        return false;
+    }
+
+    for ( int i = 0; i < headerBlock.required_features_size(); ++i ) {
+        const std::string &feature = headerBlock.required_features( i );
+        if ( feature != "OsmSchema-V0.6" && feature != "DenseNodes" ) {
+            m_error = QString( "Unsupported feature %1" ).arg( QString::fromUtf8( feature.data(), feature.size() ) );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void OsmPbfParser::addBlock( const OsmPbfBlock &block )
+{
+    m_coordinates.reserve( m_coordinates.size() + block.nodes.size() );
+    foreach ( const OsmPbfNode &node, block.nodes ) {
+        NodeCoordinates const coordinates = { node.id, node.lon, node.lat };
+        if ( m_coordinatesSorted && !m_coordinates.isEmpty() && !( m_coordinates.last() < coordinates ) ) {
+            m_coordinatesSorted = false;
+        }
+        m_coordinates << coordinates;
+
+        if ( !node.tags.isEmpty() ) {
+            m_taggedNodes << node;
+        }
+    }
+
+    m_ways << block.ways;
+    m_relations << block.relations;
+}
+
+void OsmPbfParser::createDocument()
+{
+    // Files are usually sorted by type and id, which allows to look the
+    // nodes up without building a hash table of all of them.
+    if ( !m_coordinatesSorted ) {
+        qSort( m_coordinates );
+    }
+
+    delete m_document;
+    m_document = new GeoDataDocument;
+
+    foreach ( const OsmPbfNode &node, m_taggedNodes ) {
+        createPoint( node );
+    }
+    m_taggedNodes.clear();
+
+    m_wayGeometries.reserve( m_ways.size() );
+    foreach ( const OsmPbfWay &way, m_ways ) {
+        createWay( way );
+    }
+    m_ways.clear();
+    m_coordinates.clear();
+
+    m_relationGeometries.reserve( m_relations.size() );
+    foreach ( const OsmPbfRelation &relation, m_relations ) {
+        createRelation( relation );
+    }
+    m_relations.clear();
+
+    m_wayGeometries.clear();
+    m_relationGeometries.clear();
+}
+
+void OsmPbfParser::createPoint( const OsmPbfNode &node )
+{
+    // Like OsmTagTagHandler, only create placemarks for named nodes and
+    // points of interest
+    bool isPoi = false;
+    foreach ( const OsmPbfTags::value_type &tag, node.tags ) {
+        if ( tag.first == "name"
+             || GeoDataFeature::OsmVisualCategory( tag.first + '=' + tag.second ) ) {
+            isPoi = true;
+            break;
+        }
+    }
+
+    if ( !isPoi ) {
+        return;
+    }
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    placemark->setGeometry( new GeoDataPoint( node.lon, node.lat, 0, GeoDataCoordinates::Degree ) );
+    placemark->setVisible( false );
+    placemark->setZoomLevel( 18 );
+    m_document->append( placemark );
+
+    applyTags( placemark, node.tags, true );
+}
+
+void OsmPbfParser::createWay( const OsmPbfWay &way )
+{
+    GeoDataLineString line;
+    GeoDataCoordinates nodeCoordinates;
+    foreach ( qint64 id, way.nodes ) {
+        if ( coordinates( id, nodeCoordinates ) ) {
+            line.append( nodeCoordinates );
+        }
+    }
+
+    bool isArea = false;
+    foreach ( const OsmPbfTags::value_type &tag, way.tags ) {
+        if ( m_areaTags.contains( tag.first + '=' + tag.second ) ) {
+            isArea = true;
+            break;
+        }
+    }
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    if ( isArea ) {
+        GeoDataPolygon *polygon = new GeoDataPolygon;
+        polygon->setOuterBoundary( GeoDataLinearRing( line ) );
+        placemark->setGeometry( polygon );
+        m_wayGeometries.insert( way.id, &polygon->outerBoundary() );
+    } else {
+        GeoDataLineString *lineString = new GeoDataLineString( line );
+        placemark->setGeometry( lineString );
+        m_wayGeometries.insert( way.id, lineString );
+    }
+
+    // The tags decide whether the placemark gets displayed
+    placemark->setVisible( false );
+    m_document->append( placemark );
+
+    applyTags( placemark, way.tags, false );
+}
+
+void OsmPbfParser::createRelation( const OsmPbfRelation &relation )
+{
+    GeoDataPolygon *polygon = new GeoDataPolygon;
+
+    // see OsmMemberTagHandler
+    foreach ( const OsmPbfMember &member, relation.members ) {
+        if ( member.type == OsmPbfMember::Way ) {
+            const GeoDataLineString *way = m_wayGeometries.value( member.id );
+            if ( !way ) {
+                continue;
+            }
+
+            if ( member.role == "outer" || member.role.isEmpty() ) {
+                appendOuterWay( polygon, *way );
+            } else if ( member.role == "inner" ) {
+                polygon->appendInnerBoundary( GeoDataLinearRing( *way ) );
+            }
+        } else if ( member.type == OsmPbfMember::Relation ) {
+            if ( member.role == "inner" || member.role == "subarea" || member.role.isEmpty() ) {
+                if ( const GeoDataPolygon *other = m_relationGeometries.value( member.id ) ) {
+                    polygon->appendInnerBoundary( other->outerBoundary() );
+                }
+            }
+        }
+    }
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    placemark->setGeometry( polygon );
+    placemark->setVisible( false );
+    m_document->append( placemark );
+    m_relationGeometries.insert( relation.id, polygon );
+
+    applyTags( placemark, relation.tags, false );
+}
+
+void OsmPbfParser::applyTags( GeoDataPlacemark *placemark, const OsmPbfTags &tags, bool isNode )
+{
+    // see OsmTagTagHandler
+    foreach ( const OsmPbfTags::value_type &tag, tags ) {
+        const QString &key = tag.first;
+        const QString &value = tag.second;
+
+        if ( key == "created_by" ) {
+            continue;
+        }
+
+        if ( key == "name" ) {
+            placemark->setName( value );
+            continue;
+        }
+
+        if ( !isNode && key == "building" && value == "yes"
+             && placemark->visualCategory() == GeoDataFeature::Default ) {
+            placemark->setVisualCategory( GeoDataFeature::Building );
+            placemark->setVisible( true );
+        }
+
+        GeoDataFeature::GeoDataVisualCategory category = GeoDataFeature::OsmVisualCategory( key + '=' + value );
+        bool isCategoryTaken = placemark->visualCategory() != GeoDataFeature::Default
+                               && placemark->visualCategory() != GeoDataFeature::Building;
+        if ( !category ) {
+            category = GeoDataFeature::OsmVisualCategory( key );
+            isCategoryTaken = placemark->visualCategory() != GeoDataFeature::Default;
+        }
+
+        if ( !category ) {
+            continue;
+        }
+
+        if ( isCategoryTaken ) {
+            // one placemark per category
+            GeoDataPlacemark *newPlacemark = new GeoDataPlacemark( *placemark );
+            newPlacemark->setVisualCategory( category );
+            newPlacemark->setStyle( 0 );
+            newPlacemark->setVisible( true );
+            m_document->append( newPlacemark );
+        } else {
+            placemark->setStyle( 0 );
+            placemark->setVisualCategory( category );
+            placemark->setVisible( true );
+        }
+    }
+}
+
+bool OsmPbfParser::coordinates( qint64 id, GeoDataCoordinates &coordinates ) const
+{
+    NodeCoordinates const key = { id, 0, 0 };
+    QVector<NodeCoordinates>::const_iterator const it = qLowerBound( m_coordinates.constBegin(), m_coordinates.constEnd(), key );
+    if ( it == m_coordinates.constEnd() || it->id != id ) {
+        return false;
+    }
+
+    coordinates = GeoDataCoordinates( it->lon, it->lat, 0, GeoDataCoordinates::Degree );
+    return true;
+}
+
+void OsmPbfParser::appendOuterWay( GeoDataPolygon *polygon, const GeoDataLineString &way )
+{
+    // Same as in OsmMemberTagHandler: the ways of the outer boundary may
+    // point in different directions, and the node shared by two ways must
+    // not be repeated.
+    if ( way.isEmpty() ) {
+        return;
+    }
+
+    GeoDataLinearRing envelope = polygon->outerBoundary();
+
+    if ( envelope.isEmpty() ) {
+        envelope = GeoDataLinearRing( way );
+    } else if ( way.first() == envelope.first() ) {
+        GeoDataLinearRing reversed( envelope.tessellationFlags() );
+        for ( int i = envelope.size() - 1; i >= 0; --i ) {
+            reversed.append( envelope.at( i ) );
+        }
+        envelope = reversed;
+        envelope.remove( envelope.size() - 1 );
+        envelope << way;
+    } else if ( way.first() == envelope.last() ) {
+        envelope.remove( envelope.size() - 1 );
+        envelope << way;
+    } else if ( way.last() == envelope.first() ) {
+        GeoDataLinearRing reversed( envelope.tessellationFlags() );
+        for ( int i = envelope.size() - 1; i >= 0; --i ) {
+            reversed.append( envelope.at( i ) );
+        }
+        envelope = reversed;
+        for ( int i = way.size() - 2; i >= 0; --i ) {
+            envelope.append( way.at( i ) );
+        }
+    } else if ( way.last() == envelope.last() ) {
+        for ( int i = way.size() - 2; i >= 0; --i ) {
+            envelope.append( way.at( i ) );
+        }
+    }
+
+    polygon->setOuterBoundary( envelope );
+}
+
+}
@@ -0,0 +1,101 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_OSMPBFPARSER_H
+#define MARBLE_OSMPBFPARSER_H
+
+#include "OsmIdIndex.h"
+#include "OsmPbfBlock.h"
+
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+namespace Marble
+{
+
+class GeoDataCoordinates;
+class GeoDataDocument;
+class GeoDataLineString;
+class GeoDataPlacemark;
+class GeoDataPolygon;
+
+/**
+ * @short Reads OpenStreetMap .pbf files.
+ *
+ * The blobs of the file are read sequentially and decoded in parallel by
+ * OsmPbfBlockDecoder. Node coordinates are kept in an array sorted by id,
+ * the nodes of the ways get resolved once all blocks are read. The
+ * resulting document contains the same placemarks that OsmParser creates
+ * for the equivalent .osm file.
+ */
+class OsmPbfParser
+{
+ public:
+    OsmPbfParser();
+    ~OsmPbfParser();
+
+    /**
+     * Reads the .pbf file from @p device. Returns false on failure, in
+     * which case errorString() tells what went wrong.
+     */
+    bool read( QIODevice *device );
+
+    /**
+     * Returns the document read and passes its ownership to the caller.
+     */
+    GeoDataDocument *releaseDocument();
+
+    QString errorString() const;
+
+ private:
+    Q_DISABLE_COPY( OsmPbfParser )
+
+    struct NodeCoordinates
+    {
+        qint64 id;
+        qreal lon;
+        qreal lat;
+
+        bool operator<( const NodeCoordinates &other ) const { return id < other.id; }
+    };
+
+    bool readBlob( QIODevice *device, QByteArray &type, QByteArray &blob );
+    bool readHeader( const QByteArray &blob );
+    void addBlock( const OsmPbfBlock &block );
+
+    void createDocument();
+    void createPoint( const OsmPbfNode &node );
+    void createWay( const OsmPbfWay &way );
+    void createRelation( const OsmPbfRelation &relation );
+    void applyTags( GeoDataPlacemark *placemark, const OsmPbfTags &tags, bool isNode );
+
+    bool coordinates( qint64 id, GeoDataCoordinates &coordinates ) const;
+    static void appendOuterWay( GeoDataPolygon *polygon, const GeoDataLineString &way );
+
+    QVector<NodeCoordinates> m_coordinates;
+    bool m_coordinatesSorted;
+    QVector<OsmPbfNode> m_taggedNodes;
+    QVector<OsmPbfWay> m_ways;
+    QVector<OsmPbfRelation> m_relations;
+
+    OsmIdIndex<const GeoDataLineString *> m_wayGeometries;
+    OsmIdIndex<const GeoDataPolygon *> m_relationGeometries;
+    const QSet<QString> m_areaTags;
+
+    GeoDataDocument *m_document;
+    QString m_error;
+};
+
+}
+
+#endif
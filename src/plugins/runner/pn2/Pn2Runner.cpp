@@ -154,7 +154,7 @@ void Pn2Runner::parseForVersion1(const QString& fileName, DocumentRole role)
     quint32 ID, nrAbsoluteNodes;
     quint8 flag, prevFlag = -1;
 
-    GeoDataStyle *style =0;
+    QString styleUrl;
     GeoDataPolygon *polygon = new GeoDataPolygon;
 
     for ( quint32 currentPoly = 1; ( currentPoly <= m_fileHeaderPolygons ) && ( !error ) && ( !m_stream.atEnd() ); currentPoly++ ) {
@@ -165,12 +165,12 @@ void Pn2Runner::parseForVersion1(const QString& fileName, DocumentRole role)
 
             GeoDataPlacemark *placemark = new GeoDataPlacemark;
             placemark->setGeometry( polygon );
+            document->append( placemark );
             if ( m_isMapColorField ) {
-                if ( style ) {
-                    placemark->setStyle( style );
+                if ( !styleUrl.isEmpty() ) {
+                    placemark->setStyleUrl( styleUrl );
                 }
             }
-            document->append( placemark );
         }
 
         if ( flag == LINESTRING ) {
@@ -186,10 +186,11 @@ void Pn2Runner::parseForVersion1(const QString& fileName, DocumentRole role)
             if ( flag == OUTERBOUNDARY && m_isMapColorField ) {
                 quint8 colorIndex;
                 m_stream >> colorIndex;
-                style = new GeoDataStyle;
+                GeoDataStyle style;
                 GeoDataPolyStyle polyStyle;
                 polyStyle.setColorIndex( colorIndex );
-                style->setPolyStyle( polyStyle );
+                style.setPolyStyle( polyStyle );
+                styleUrl = '#' + document->addSharedStyle( style );
             }
 
             GeoDataLinearRing* linearring = new GeoDataLinearRing;
@@ -220,13 +221,13 @@ void Pn2Runner::parseForVersion1(const QString& fileName, DocumentRole role)
 
     if ( prevFlag == INNERBOUNDARY || prevFlag == OUTERBOUNDARY ) {
         GeoDataPlacemark *placemark = new GeoDataPlacemark;
+        placemark->setGeometry( polygon );
+        document->append( placemark );
         if ( m_isMapColorField ) {
-            if ( style ) {
-                placemark->setStyle( style );
+            if ( !styleUrl.isEmpty() ) {
+                placemark->setStyleUrl( styleUrl );
             }
         }
-        placemark->setGeometry( polygon );
-        document->append( placemark );
     }
 
     if ( error ) {
@@ -253,7 +254,6 @@ void Pn2Runner::parseForVersion2( const QString &fileName, DocumentRole role )
     quint8 flag, prevFlag = -1;
 
     GeoDataPolygon *polygon = new GeoDataPolygon;
-    GeoDataStyle *style =0;
     GeoDataPlacemark *placemark =0; // new GeoDataPlacemark;
 
     quint32 currentPoly;
@@ -279,20 +279,19 @@ void Pn2Runner::parseForVersion2( const QString &fileName, DocumentRole role )
          */
         if ( placemarkCurrentID != placemarkPrevID ) {
             placemark = new GeoDataPlacemark;
+            document->append( placemark );
 
             // Handle the color index
             if( m_isMapColorField ) {
                 quint8 colorIndex;
                 m_stream >> colorIndex;
-                style = new GeoDataStyle;
+                GeoDataStyle style;
                 GeoDataPolyStyle polyStyle;
                 polyStyle.setColorIndex( colorIndex );
                 polyStyle.setFill( true );
-                style->setPolyStyle( polyStyle );
-                placemark->setStyle( style );
+                style.setPolyStyle( polyStyle );
+                placemark->setStyleUrl( '#' + document->addSharedStyle( style ) );
             }
-
-            document->append( placemark );
         }
 
         placemarkPrevID = placemarkCurrentID;
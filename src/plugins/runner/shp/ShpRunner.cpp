@@ -91,16 +91,16 @@ void ShpRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
 
         double mapColor = DBFReadDoubleAttribute( dbfhandle, i, mapColorField );
         if ( mapColor ) {
-            GeoDataStyle *style = new GeoDataStyle;
+            GeoDataStyle style;
             if ( mapColor >= 0 && mapColor <=255 ) {
                 quint8 colorIndex = quint8( mapColor );
-                style->polyStyle().setColorIndex( colorIndex );
+                style.polyStyle().setColorIndex( colorIndex );
             }
             else {
                 quint8 colorIndex = 0;     // mapColor is undefined in this case
-                style->polyStyle().setColorIndex( colorIndex );
+                style.polyStyle().setColorIndex( colorIndex );
             }
-            placemark->setStyle( style );
+            placemark->setStyleUrl( '#' + document->addSharedStyle( style ) );
         }
 
         switch ( shapeType ) {
@@ -13,6 +13,7 @@
 #include "AbstractDataPluginModel.h"
 
 #include "AbstractDataPluginItem.h"
+#include "GeoDataCoordinates.h"
 #include "MarbleModel.h"
 #include "ViewportParams.h"
 
@@ -32,6 +33,7 @@ public:
     {}
 
     void setInitialized( bool initialized ) { m_initialized = initialized; }
+    void emitUpdated() { emit updated(); }
 
     bool initialized() const { return m_initialized; }
     bool operator<( const AbstractDataPluginItem *other ) const { return this < other; }
@@ -92,6 +94,12 @@ public:
 
     void itemsVersusSetSticky();
 
+    void itemsVersusViewport();
+
+    void itemsVersusCollision();
+
+    void removeItem();
+
  private:
     const MarbleModel m_marbleModel;
     static const ViewportParams fullViewport;
@@ -341,6 +349,67 @@ void AbstractDataPluginModelTest::itemsVersusSetSticky()
     QVERIFY( !model.items( &fullViewport, 1 ).contains( item ) );
 }
 
+void AbstractDataPluginModelTest::itemsVersusViewport()
+{
+    const ViewportParams zoomedViewport( Equirectangular, 0, 0, 10000, QSize( 230, 230 ) );
+
+    TestDataPluginItem *item = new TestDataPluginItem;
+    item->setInitialized( true );
+    item->setCoordinate( GeoDataCoordinates( 10.0, 0.0, 0.0, GeoDataCoordinates::Degree ) );
+
+    TestDataPluginModel model( &m_marbleModel );
+    model.addItemToList( item );
+
+    QVERIFY( !model.items( &zoomedViewport, 1 ).contains( item ) );
+    QVERIFY( model.items( &fullViewport, 1 ).contains( item ) );
+
+    item->setCoordinate( GeoDataCoordinates( 0.1, 0.0, 0.0, GeoDataCoordinates::Degree ) );
+    item->emitUpdated();
+
+    QVERIFY( model.items( &zoomedViewport, 1 ).contains( item ) );
+}
+
+void AbstractDataPluginModelTest::itemsVersusCollision()
+{
+    const ViewportParams zoomedViewport( Equirectangular, 0, 0, 10000, QSize( 230, 230 ) );
+
+    QList<AbstractDataPluginItem *> items;
+    const qreal longitudes[] = { 0.0, 0.0, 0.5 };
+    for ( int i = 0; i < 3; ++i ) {
+        TestDataPluginItem *item = new TestDataPluginItem;
+        item->setInitialized( true );
+        item->setId( QString::number( i ) );
+        item->setSize( QSizeF( 20, 20 ) );
+        item->setCoordinate( GeoDataCoordinates( longitudes[i], 0.0, 0.0, GeoDataCoordinates::Degree ) );
+        items << item;
+    }
+
+    TestDataPluginModel model( &m_marbleModel );
+    model.addItemsToList( items );
+
+    const QList<AbstractDataPluginItem *> visible = model.items( &zoomedViewport, 10 );
+    QCOMPARE( visible.size(), 2 );
+    QVERIFY( visible.contains( items[0] ) != visible.contains( items[1] ) );
+    QVERIFY( visible.contains( items[2] ) );
+}
+
+void AbstractDataPluginModelTest::removeItem()
+{
+    TestDataPluginItem *item = new TestDataPluginItem;
+    item->setInitialized( true );
+    item->setId( "foo" );
+
+    TestDataPluginModel model( &m_marbleModel );
+    model.addItemToList( item );
+
+    QVERIFY( model.items( &fullViewport, 1 ).contains( item ) );
+
+    delete item;
+
+    QVERIFY( !model.itemExists( "foo" ) );
+    QVERIFY( model.items( &fullViewport, 1 ).isEmpty() );
+}
+
 QTEST_MAIN( AbstractDataPluginModelTest )
 
 #include "AbstractDataPluginModelTest.moc"
@@ -0,0 +1,224 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "DocumentSnapshot.h"
+#include "GeoDataBalloonStyle.h"
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataFolder.h"
+#include "GeoDataIconStyle.h"
+#include "GeoDataItemIcon.h"
+#include "GeoDataLineString.h"
+#include "GeoDataLineStyle.h"
+#include "GeoDataListStyle.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataStyle.h"
+#include "GeoDataStyleMap.h"
+#include "GeoDataTrack.h"
+#include "GeoDataTypes.h"
+#include "TestUtils.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
+namespace Marble
+{
+
+class DocumentSnapshotTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void init();
+    void cleanup();
+
+    void testRoundTrip();
+    void testModifiedSource();
+    void testUnsupportedDocument();
+
+ private:
+    static GeoDataDocument *createDocument();
+
+    QString m_directory;
+    QTemporaryFile m_source;
+};
+
+void DocumentSnapshotTest::init()
+{
+    m_directory = QDir::tempPath() + "/marble-document-snapshot-test";
+    QVERIFY( QDir().mkpath( m_directory ) );
+
+    QVERIFY( m_source.open() );
+    m_source.write( "<kml/>" );
+    m_source.flush();
+}
+
+void DocumentSnapshotTest::cleanup()
+{
+    m_source.close();
+
+    QDir directory( m_directory );
+    foreach ( const QString &file, directory.entryList( QDir::Files ) ) {
+        directory.remove( file );
+    }
+    QDir().rmdir( m_directory );
+}
+
+void DocumentSnapshotTest::testRoundTrip()
+{
+    GeoDataDocument *const document = createDocument();
+
+    const DocumentSnapshot snapshot( m_source.fileName(), m_directory );
+    QVERIFY( !snapshot.isCurrent() );
+    QVERIFY( snapshot.save( *document ) );
+    QVERIFY( snapshot.isCurrent() );
+    QVERIFY( QFile::exists( snapshot.fileName() ) );
+
+    GeoDataDocument *const loaded = DocumentSnapshot( m_source.fileName(), m_directory ).load();
+    QVERIFY( loaded );
+    QCOMPARE( loaded->name(), document->name() );
+    QCOMPARE( loaded->size(), 1 );
+    QCOMPARE( loaded->styleMaps().size(), 1 );
+    QCOMPARE( loaded->styleMap( "highlight" ).value( "normal" ), QString( "#red" ) );
+
+    QCOMPARE( loaded->child( 0 )->nodeType(), GeoDataTypes::GeoDataFolderType );
+    const GeoDataFolder *const folder = static_cast<const GeoDataFolder *>( loaded->child( 0 ) );
+    QVERIFY( folder->parent() == loaded );
+    QCOMPARE( folder->size(), 2 );
+
+    const GeoDataPlacemark *const city = static_cast<const GeoDataPlacemark *>( folder->child( 0 ) );
+    QCOMPARE( city->name(), QString( "City" ) );
+    QCOMPARE( city->visualCategory(), GeoDataFeature::MediumCity );
+    QCOMPARE( city->coordinate(), GeoDataCoordinates( 8.4, 49.0, 0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( city->extendedData().value( "population" ).value().toInt(), 300000 );
+
+    const GeoDataPlacemark *const river = static_cast<const GeoDataPlacemark *>( folder->child( 1 ) );
+    QCOMPARE( river->styleUrl(), QString( "#red" ) );
+    QCOMPARE( river->style()->lineStyle().color(), QColor( Qt::red ) );
+
+    const GeoDataStyle *const style = river->style();
+    QCOMPARE( style->iconStyle().iconPath(), QString( "bitmaps/river.png" ) );
+    QCOMPARE( style->balloonStyle().backgroundColor(), QColor( 255, 255, 0, 128 ) );
+    QCOMPARE( style->balloonStyle().textColor(), QColor( Qt::blue ) );
+    QCOMPARE( style->balloonStyle().text(), QString( "$[name]" ) );
+    QCOMPARE( style->balloonStyle().displayMode(), GeoDataBalloonStyle::Hide );
+    QCOMPARE( style->listStyle().listItemType(), GeoDataListStyle::RadioFolder );
+    QCOMPARE( style->listStyle().backgroundColor(), QColor( Qt::gray ) );
+    QCOMPARE( style->listStyle().size(), 2 );
+    QCOMPARE( style->listStyle().at( 0 ).state(), GeoDataItemIcon::ItemIconStates( GeoDataItemIcon::Open ) );
+    QCOMPARE( style->listStyle().at( 0 ).iconPath(), QString( "bitmaps/open.png" ) );
+    QCOMPARE( style->listStyle().at( 1 ).state(), GeoDataItemIcon::ItemIconStates( GeoDataItemIcon::Closed | GeoDataItemIcon::Error ) );
+    QCOMPARE( style->listStyle().at( 1 ).iconPath(), QString( "bitmaps/closed.png" ) );
+    QVERIFY( *style == document->style( "red" ) );
+    QCOMPARE( river->geometry()->nodeType(), GeoDataTypes::GeoDataLineStringType );
+    QVERIFY( river->geometry()->parent() == river );
+
+    const GeoDataFolder *const originalFolder = static_cast<const GeoDataFolder *>( document->child( 0 ) );
+    const GeoDataPlacemark *const originalRiver = static_cast<const GeoDataPlacemark *>( originalFolder->child( 1 ) );
+    const GeoDataLineString *const original = static_cast<const GeoDataLineString *>( originalRiver->geometry() );
+    const GeoDataLineString *const lineString = static_cast<const GeoDataLineString *>( river->geometry() );
+    QCOMPARE( lineString->size(), original->size() );
+    for ( int i = 0; i < lineString->size(); ++i ) {
+        QCOMPARE( lineString->at( i ), original->at( i ) );
+        QCOMPARE( lineString->at( i ).detail(), original->at( i ).detail() );
+    }
+
+    delete loaded;
+    delete document;
+}
+
+void DocumentSnapshotTest::testModifiedSource()
+{
+    GeoDataDocument *const document = createDocument();
+    QVERIFY( DocumentSnapshot( m_source.fileName(), m_directory ).save( *document ) );
+    delete document;
+
+    m_source.write( "<kml></kml>" );
+    m_source.flush();
+
+    const DocumentSnapshot snapshot( m_source.fileName(), m_directory );
+    QVERIFY( !snapshot.isCurrent() );
+    QVERIFY( !snapshot.load() );
+}
+
+void DocumentSnapshotTest::testUnsupportedDocument()
+{
+    GeoDataDocument document;
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    placemark->setGeometry( new GeoDataTrack );
+    document.append( placemark );
+
+    QVERIFY( !DocumentSnapshot::isSupported( document ) );
+
+    const DocumentSnapshot snapshot( m_source.fileName(), m_directory );
+    QVERIFY( !snapshot.save( document ) );
+    QVERIFY( !QFile::exists( snapshot.fileName() ) );
+}
+
+GeoDataDocument *DocumentSnapshotTest::createDocument()
+{
+    GeoDataDocument *document = new GeoDataDocument;
+    document->setName( "Snapshot" );
+
+    GeoDataStyle style;
+    style.setId( "red" );
+    style.setLineStyle( GeoDataLineStyle( Qt::red ) );
+    style.iconStyle().setIconPath( "bitmaps/river.png" );
+    style.balloonStyle().setBackgroundColor( QColor( 255, 255, 0, 128 ) );
+    style.balloonStyle().setTextColor( Qt::blue );
+    style.balloonStyle().setText( "$[name]" );
+    style.balloonStyle().setDisplayMode( GeoDataBalloonStyle::Hide );
+    style.listStyle().setListItemType( GeoDataListStyle::RadioFolder );
+    style.listStyle().setBackgroundColor( Qt::gray );
+
+    GeoDataItemIcon *open = new GeoDataItemIcon;
+    open->setState( GeoDataItemIcon::Open );
+    open->setIconPath( "bitmaps/open.png" );
+    style.listStyle().append( open );
+
+    GeoDataItemIcon *closed = new GeoDataItemIcon;
+    closed->setState( GeoDataItemIcon::Closed | GeoDataItemIcon::Error );
+    closed->setIconPath( "bitmaps/closed.png" );
+    style.listStyle().append( closed );
+
+    document->addStyle( style );
+
+    GeoDataStyleMap styleMap;
+    styleMap.setId( "highlight" );
+    styleMap.insert( "normal", "#red" );
+    document->addStyleMap( styleMap );
+
+    GeoDataFolder *folder = new GeoDataFolder;
+    document->append( folder );
+
+    GeoDataPlacemark *city = new GeoDataPlacemark( "City" );
+    city->setCoordinate( 8.4, 49.0, 0, GeoDataCoordinates::Degree );
+    city->setVisualCategory( GeoDataFeature::MediumCity );
+    city->extendedData().addValue( GeoDataData( "population", 300000 ) );
+    folder->append( city );
+
+    GeoDataPlacemark *river = new GeoDataPlacemark( "River" );
+    GeoDataLineString *lineString = new GeoDataLineString;
+    for ( int i = 0; i < 100; ++i ) {
+        *lineString << GeoDataCoordinates( 0.001 * i, 0.0005 * ( i % 7 ), 0, GeoDataCoordinates::Radian, i % 6 );
+    }
+    river->setGeometry( lineString );
+    folder->append( river );
+    river->setStyleUrl( "#red" );
+
+    return document;
+}
+
+}
+
+QTEST_MAIN( Marble::DocumentSnapshotTest )
+
+#include "DocumentSnapshotTest.moc"
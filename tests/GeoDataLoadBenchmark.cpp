@@ -0,0 +1,112 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "GeoDataDocument.h"
+#include "MarbleDirs.h"
+#include "ParsingRunnerManager.h"
+#include "PluginManager.h"
+#include "TestUtils.h"
+
+#include <QFile>
+#include <QTime>
+
+namespace Marble
+{
+
+/**
+ * Measures how long it takes to load large documents and how much memory
+ * they occupy afterwards. Most of that memory is taken up by the
+ * GeoDataCoordinates of the placemarks and line strings.
+ */
+class GeoDataLoadBenchmark : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+
+    void loadDocument_data();
+    void loadDocument();
+
+ private:
+    /**
+     * Returns the resident set size of this process in kilobytes, or 0 if
+     * it isn't known on this platform.
+     */
+    static qint64 residentSetSize();
+
+    PluginManager m_pluginManager;
+};
+
+void GeoDataLoadBenchmark::initTestCase()
+{
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+}
+
+void GeoDataLoadBenchmark::loadDocument_data()
+{
+    QTest::addColumn<QString>( "fileName" );
+
+    // cityplacemarks.cache is the binary form of cityplacemarks.kml
+    addNamedRow("cities") << QString( MARBLE_SRC_DIR ).append( "/data/placemarks/cityplacemarks.cache" );
+    addNamedRow("countries") << QString( MARBLE_SRC_DIR ).append( "/data/naturalearth/ne_50m_admin_0_countries.pn2" );
+    addNamedRow("rivers") << QString( MARBLE_SRC_DIR ).append( "/data/naturalearth/ne_10m_rivers_lake_centerlines.pn2" );
+}
+
+void GeoDataLoadBenchmark::loadDocument()
+{
+    QFETCH( QString, fileName );
+
+    QVERIFY( QFile::exists( fileName ) );
+
+    ParsingRunnerManager runnerManager( &m_pluginManager );
+
+    const qint64 rssBefore = residentSetSize();
+    QTime timer;
+    timer.start();
+
+    GeoDataDocument *document = runnerManager.openFile( fileName );
+
+    const int elapsed = timer.elapsed();
+    const qint64 rssAfter = residentSetSize();
+
+    QVERIFY( document != 0 );
+
+    qDebug() << fileName << "loaded in" << elapsed << "ms,"
+             << "resident set grew by" << ( rssAfter - rssBefore ) << "kB";
+
+    delete document;
+}
+
+qint64 GeoDataLoadBenchmark::residentSetSize()
+{
+    QFile status( "/proc/self/status" );
+    if ( !status.open( QIODevice::ReadOnly ) ) {
+        return 0;
+    }
+
+    QByteArray line = status.readLine();
+    while ( !line.isEmpty() ) {
+        if ( line.startsWith( "VmRSS:" ) ) {
+            // "VmRSS:     12345 kB"
+            return line.mid( 6 ).trimmed().split( ' ' ).first().toLongLong();
+        }
+        line = status.readLine();
+    }
+
+    return 0;
+}
+
+}
+
+QTEST_MAIN( Marble::GeoDataLoadBenchmark )
+
+#include "GeoDataLoadBenchmark.moc"
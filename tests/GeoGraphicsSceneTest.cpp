@@ -0,0 +1,186 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "GeoGraphicsScene.h"
+
+#include "GeoDataLatLonAltBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoGraphicsItem.h"
+#include "TestUtils.h"
+
+namespace Marble
+{
+
+class TestGraphicsItem : public GeoGraphicsItem
+{
+ public:
+    TestGraphicsItem( const GeoDataFeature *feature, const GeoDataLatLonBox &box, qreal zValue, int minZoomLevel = 0 )
+        : GeoGraphicsItem( feature )
+    {
+        setLatLonAltBox( GeoDataLatLonAltBox( box, 0, 0 ) );
+        setZValue( zValue );
+        setMinZoomLevel( minZoomLevel );
+    }
+
+    virtual void paint( GeoPainter *painter, const ViewportParams *viewport )
+    {
+        Q_UNUSED( painter );
+        Q_UNUSED( viewport );
+    }
+};
+
+class GeoGraphicsSceneTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testOrder();
+    void testEqualZValue();
+    void testCulling();
+    void testDateLine();
+    void testRemoveItem();
+
+    void benchmarkItems();
+
+ private:
+    static GeoDataLatLonBox box( qreal north, qreal south, qreal east, qreal west )
+    {
+        return GeoDataLatLonBox( north, south, east, west, GeoDataCoordinates::Degree );
+    }
+};
+
+void GeoGraphicsSceneTest::testOrder()
+{
+    GeoDataPlacemark placemark;
+    GeoGraphicsScene scene;
+
+    // a large item stored at a coarse level and small ones stored deeper
+    GeoGraphicsItem *item1 = new TestGraphicsItem( &placemark, box( 60, -60, 120, -120 ), 2 );
+    GeoGraphicsItem *item2 = new TestGraphicsItem( &placemark, box( 10.1, 10, 10.1, 10 ), 1, 10 );
+    GeoGraphicsItem *item3 = new TestGraphicsItem( &placemark, box( -20, -20.1, -30, -30.1 ), 3, 10 );
+    GeoGraphicsItem *item4 = new TestGraphicsItem( &placemark, box( 40.1, 40, 50.1, 50 ), 1, 10 );
+    GeoGraphicsItem *item5 = new TestGraphicsItem( &placemark, box( 10.1, 10, 10.1, 10 ), 0, 10 );
+    scene.addItem( item1 );
+    scene.addItem( item2 );
+    scene.addItem( item3 );
+    scene.addItem( item4 );
+    scene.addItem( item5 );
+
+    const QList<GeoGraphicsItem *> items = scene.items( box( 90, -90, 180, -180 ), 10 );
+
+    // items of equal z value are returned newest first, so the oldest one is painted on top
+    QCOMPARE( items, QList<GeoGraphicsItem *>() << item5 << item4 << item2 << item1 << item3 );
+
+    // items are only returned once the zoom level reaches their minimum zoom level
+    QCOMPARE( scene.items( box( 90, -90, 180, -180 ), 9 ), QList<GeoGraphicsItem *>() << item1 );
+}
+
+void GeoGraphicsSceneTest::testEqualZValue()
+{
+    GeoDataPlacemark placemark;
+    GeoGraphicsScene scene;
+
+    GeoGraphicsItem *item1 = new TestGraphicsItem( &placemark, box( 1, 0, 1, 0 ), 1 );
+    GeoGraphicsItem *item2 = new TestGraphicsItem( &placemark, box( 1, 0, 1, 0 ), 1 );
+    GeoGraphicsItem *item3 = new TestGraphicsItem( &placemark, box( 1, 0, 1, 0 ), 0 );
+    GeoGraphicsItem *item4 = new TestGraphicsItem( &placemark, box( 1, 0, 1, 0 ), 1 );
+    scene.addItem( item1 );
+    scene.addItem( item2 );
+    scene.addItem( item3 );
+    scene.addItem( item4 );
+
+    const QList<GeoGraphicsItem *> expected = QList<GeoGraphicsItem *>() << item3 << item4 << item2 << item1;
+    QCOMPARE( scene.items( box( 90, -90, 180, -180 ), 5 ), expected );
+
+    // queries don't change the order
+    QCOMPARE( scene.items( box( 90, -90, 180, -180 ), 5 ), expected );
+}
+
+void GeoGraphicsSceneTest::testCulling()
+{
+    GeoDataPlacemark placemark;
+    GeoGraphicsScene scene;
+
+    GeoGraphicsItem *inside = new TestGraphicsItem( &placemark, box( 45, 44, 8, 7 ), 0 );
+    GeoGraphicsItem *outside = new TestGraphicsItem( &placemark, box( 45, 44, 12, 11 ), 0 );
+    GeoGraphicsItem *hidden = new TestGraphicsItem( &placemark, box( 45, 44, 8, 7 ), 0 );
+    hidden->setVisible( false );
+    scene.addItem( inside );
+    scene.addItem( outside );
+    scene.addItem( hidden );
+
+    QCOMPARE( scene.items( box( 46, 43, 9, 6 ), 5 ), QList<GeoGraphicsItem *>() << inside );
+}
+
+void GeoGraphicsSceneTest::testDateLine()
+{
+    GeoDataPlacemark placemark;
+    GeoGraphicsScene scene;
+
+    // items next to the IDL are stored in tiles on either side of it,
+    // the one crossing it only fits into the tile of level 0
+    GeoGraphicsItem *west = new TestGraphicsItem( &placemark, box( 1, 0, -178, -179 ), 0, 8 );
+    GeoGraphicsItem *east = new TestGraphicsItem( &placemark, box( 1, 0, 179, 178 ), 1, 8 );
+    GeoGraphicsItem *crossing = new TestGraphicsItem( &placemark, box( 1, 0, -179, 179 ), 2, 8 );
+    GeoGraphicsItem *far = new TestGraphicsItem( &placemark, box( 1, 0, 1, 0 ), 3, 8 );
+    scene.addItem( west );
+    scene.addItem( east );
+    scene.addItem( crossing );
+    scene.addItem( far );
+
+    for ( int zoomLevel = 8; zoomLevel <= 10; ++zoomLevel ) {
+        QCOMPARE( scene.items( box( 10, -10, -170, 170 ), zoomLevel ),
+                  QList<GeoGraphicsItem *>() << west << east << crossing );
+    }
+}
+
+void GeoGraphicsSceneTest::testRemoveItem()
+{
+    GeoDataPlacemark placemark1;
+    GeoDataPlacemark placemark2;
+    GeoGraphicsScene scene;
+
+    GeoGraphicsItem *item1 = new TestGraphicsItem( &placemark1, box( 1, 0, 1, 0 ), 0 );
+    GeoGraphicsItem *item2 = new TestGraphicsItem( &placemark2, box( 1, 0, 1, 0 ), 0 );
+    GeoGraphicsItem *item3 = new TestGraphicsItem( &placemark1, box( 50, 40, 50, 40 ), 0 );
+    scene.addItem( item1 );
+    scene.addItem( item2 );
+    scene.addItem( item3 );
+
+    scene.removeItem( &placemark1 );
+
+    QCOMPARE( scene.items( box( 90, -90, 180, -180 ), 5 ), QList<GeoGraphicsItem *>() << item2 );
+}
+
+void GeoGraphicsSceneTest::benchmarkItems()
+{
+    GeoDataPlacemark placemark;
+    GeoGraphicsScene scene;
+
+    // small features spread over central Europe, like a large OSM file
+    qsrand( 42 );
+    for ( int i = 0; i < 500000; ++i ) {
+        const qreal lon = 5.0 + 10.0 * qrand() / RAND_MAX;
+        const qreal lat = 45.0 + 10.0 * qrand() / RAND_MAX;
+        scene.addItem( new TestGraphicsItem( &placemark, box( lat + 0.001, lat, lon + 0.001, lon ), i % 16, 13 ) );
+    }
+
+    QList<GeoGraphicsItem *> items;
+    QBENCHMARK {
+        items = scene.items( box( 50.1, 50, 10.2, 10 ), 17 );
+    }
+    QVERIFY( !items.isEmpty() );
+}
+
+}
+
+QTEST_MAIN( Marble::GeoGraphicsSceneTest )
+
+#include "GeoGraphicsSceneTest.moc"
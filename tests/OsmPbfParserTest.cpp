@@ -0,0 +1,190 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataTypes.h"
+#include "MarbleDirs.h"
+#include "ParseRunnerPlugin.h"
+#include "ParsingRunner.h"
+#include "PluginManager.h"
+#include "TestUtils.h"
+
+#include <QSignalSpy>
+
+namespace Marble
+{
+
+/**
+ * Parses the same small data set from an .osm.pbf file and from an .osm file
+ * and checks that both parsers create the same placemarks. The .pbf file
+ * stores nodes both as DenseNodes and as plain nodes, uses compressed and
+ * raw blobs and contains ways, an area and a multipolygon with a hole.
+ */
+class OsmPbfParserTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+
+    void compareWithOsm();
+
+ private:
+    GeoDataDocument *parse( const QString &fileName ) const;
+
+    /**
+     * Returns one line per placemark with its name, category, visibility,
+     * geometry type and coordinates, sorted so that the order in which the
+     * parsers append the placemarks doesn't matter.
+     */
+    static QStringList summary( const GeoDataDocument *document );
+    static QString coordinates( const GeoDataLineString &lineString );
+
+    static const GeoDataPlacemark *placemark( const GeoDataDocument *document, const QString &name );
+
+    PluginManager m_pluginManager;
+    const ParseRunnerPlugin *m_plugin;
+};
+
+void OsmPbfParserTest::initTestCase()
+{
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    qRegisterMetaType<GeoDataDocument*>( "GeoDataDocument*" );
+
+    m_plugin = 0;
+    foreach ( const ParseRunnerPlugin *plugin, m_pluginManager.parsingRunnerPlugins() ) {
+        if ( plugin->nameId() == "Osm" ) {
+            m_plugin = plugin;
+        }
+    }
+
+    QVERIFY( m_plugin != 0 );
+
+    if ( !m_plugin->fileExtensions().contains( "pbf" ) ) {
+#if QT_VERSION < 0x050000
+        QSKIP( "The OpenStreetMap plugin was built without protobuf support", SkipAll );
+#else
+        QSKIP( "The OpenStreetMap plugin was built without protobuf support" );
+#endif
+    }
+}
+
+void OsmPbfParserTest::compareWithOsm()
+{
+    GeoDataDocument *const pbfDocument = parse( TESTSRCDIR "/data/Karlsruhe.osm.pbf" );
+    GeoDataDocument *const osmDocument = parse( TESTSRCDIR "/data/Karlsruhe.osm" );
+
+    QVERIFY( pbfDocument != 0 );
+    QVERIFY( osmDocument != 0 );
+
+    QCOMPARE( summary( pbfDocument ), summary( osmDocument ) );
+
+    const GeoDataPlacemark *city = placemark( pbfDocument, "Karlsruhe" );
+    QVERIFY( city != 0 );
+    QCOMPARE( city->geometry()->nodeType(), GeoDataTypes::GeoDataPointType );
+    QCOMPARE( qRound( city->coordinate().longitude( GeoDataCoordinates::Degree ) * 1e4 ), 84036 );
+    QCOMPARE( qRound( city->coordinate().latitude( GeoDataCoordinates::Degree ) * 1e4 ), 490094 );
+
+    const GeoDataPlacemark *street = placemark( pbfDocument, QString::fromUtf8( "Kaiserstraße" ) );
+    QVERIFY( street != 0 );
+    QCOMPARE( street->geometry()->nodeType(), GeoDataTypes::GeoDataLineStringType );
+    QCOMPARE( static_cast<const GeoDataLineString *>( street->geometry() )->size(), 2 );
+
+    const GeoDataPlacemark *forest = placemark( pbfDocument, "Hardtwald" );
+    QVERIFY( forest != 0 );
+    QCOMPARE( forest->geometry()->nodeType(), GeoDataTypes::GeoDataPolygonType );
+    const GeoDataPolygon *polygon = static_cast<const GeoDataPolygon *>( forest->geometry() );
+    QCOMPARE( polygon->innerBoundaries().size(), 1 );
+
+    delete pbfDocument;
+    delete osmDocument;
+}
+
+GeoDataDocument *OsmPbfParserTest::parse( const QString &fileName ) const
+{
+    ParsingRunner *const runner = m_plugin->newRunner();
+    QSignalSpy spy( runner, SIGNAL(parsingFinished(GeoDataDocument*,QString)) );
+
+    runner->parseFile( fileName, UserDocument );
+    delete runner;
+
+    if ( spy.count() != 1 ) {
+        return 0;
+    }
+
+    return qvariant_cast<GeoDataDocument*>( spy.first().first() );
+}
+
+QStringList OsmPbfParserTest::summary( const GeoDataDocument *document )
+{
+    QStringList result;
+
+    foreach ( const GeoDataPlacemark *placemark, document->placemarkList() ) {
+        QString line = QString( "%1 %2 %3 %4:" ).arg( placemark->name() )
+                                                .arg( placemark->visualCategory() )
+                                                .arg( placemark->isVisible() )
+                                                .arg( placemark->geometry()->nodeType() );
+
+        const GeoDataGeometry *geometry = placemark->geometry();
+        if ( geometry->nodeType() == GeoDataTypes::GeoDataPointType ) {
+            const GeoDataCoordinates point = static_cast<const GeoDataPoint *>( geometry )->coordinates();
+            line += QString( " %1,%2" ).arg( qRound( point.longitude( GeoDataCoordinates::Degree ) * 1e7 ) )
+                                       .arg( qRound( point.latitude( GeoDataCoordinates::Degree ) * 1e7 ) );
+        } else if ( geometry->nodeType() == GeoDataTypes::GeoDataLineStringType ) {
+            line += coordinates( *static_cast<const GeoDataLineString *>( geometry ) );
+        } else if ( geometry->nodeType() == GeoDataTypes::GeoDataPolygonType ) {
+            const GeoDataPolygon *polygon = static_cast<const GeoDataPolygon *>( geometry );
+            line += coordinates( polygon->outerBoundary() );
+            foreach ( const GeoDataLinearRing &ring, polygon->innerBoundaries() ) {
+                line += " |" + coordinates( ring );
+            }
+        }
+
+        result << line;
+    }
+
+    result.sort();
+    return result;
+}
+
+QString OsmPbfParserTest::coordinates( const GeoDataLineString &lineString )
+{
+    QString result;
+
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        result += QString( " %1,%2" ).arg( qRound( lineString.at( i ).longitude( GeoDataCoordinates::Degree ) * 1e7 ) )
+                                     .arg( qRound( lineString.at( i ).latitude( GeoDataCoordinates::Degree ) * 1e7 ) );
+    }
+
+    return result;
+}
+
+const GeoDataPlacemark *OsmPbfParserTest::placemark( const GeoDataDocument *document, const QString &name )
+{
+    foreach ( const GeoDataPlacemark *placemark, document->placemarkList() ) {
+        if ( placemark->name() == name ) {
+            return placemark;
+        }
+    }
+
+    return 0;
+}
+
+}
+
+QTEST_MAIN( Marble::OsmPbfParserTest )
+
+#include "OsmPbfParserTest.moc"
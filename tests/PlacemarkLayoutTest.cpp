@@ -0,0 +1,96 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "PlacemarkLayout.h"
+#include "GeoDataDocument.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTreeModel.h"
+#include "MarbleModel.h"
+#include "ViewportParams.h"
+#include "VisiblePlacemark.h"
+#include "TestUtils.h"
+
+namespace Marble
+{
+
+class PlacemarkLayoutTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testRemoveDocument();
+
+ private:
+    static GeoDataDocument *createDocument( const QString &name, qreal lon, qreal lat );
+    static QVector<const GeoDataFeature *> placemarks( const QVector<VisiblePlacemark *> &layout );
+};
+
+void PlacemarkLayoutTest::testRemoveDocument()
+{
+    MarbleModel model;
+    PlacemarkLayout layout( model.placemarkModel(), model.placemarkSelectionModel(), model.clock() );
+    const ViewportParams viewport( Equirectangular, 0, 0, 200, QSize( 800, 400 ) );
+
+    GeoDataDocument *const karlsruhe = createDocument( "Karlsruhe", 8.4, 49.0 );
+    GeoDataDocument *const tokyo = createDocument( "Tokyo", 139.7, 35.7 );
+    model.treeModel()->addDocument( karlsruhe );
+    model.treeModel()->addDocument( tokyo );
+
+    const GeoDataFeature *const removed = karlsruhe->child( 0 );
+    const GeoDataFeature *const kept = tokyo->child( 0 );
+
+    const QVector<VisiblePlacemark *> before = layout.generateLayout( &viewport );
+    QVERIFY( placemarks( before ).contains( removed ) );
+    QVERIFY( placemarks( before ).contains( kept ) );
+
+    const QPoint position = before.at( placemarks( before ).indexOf( removed ) )->labelRect().center().toPoint();
+    QVERIFY( layout.whichPlacemarkAt( position ).contains( removed ) );
+
+    model.treeModel()->removeDocument( karlsruhe );
+    delete karlsruhe;
+
+    // repainting with an unchanged viewport must not reuse the layout of the deleted placemark
+    QVERIFY( layout.whichPlacemarkAt( position ).isEmpty() );
+
+    const QVector<const GeoDataFeature *> after = placemarks( layout.generateLayout( &viewport ) );
+    QVERIFY( !after.contains( removed ) );
+    QVERIFY( after.contains( kept ) );
+    QVERIFY( layout.whichPlacemarkAt( position ).isEmpty() );
+
+    model.treeModel()->removeDocument( tokyo );
+    delete tokyo;
+}
+
+GeoDataDocument *PlacemarkLayoutTest::createDocument( const QString &name, qreal lon, qreal lat )
+{
+    GeoDataPlacemark *placemark = new GeoDataPlacemark( name );
+    placemark->setCoordinate( lon, lat, 0, GeoDataCoordinates::Degree );
+
+    GeoDataDocument *document = new GeoDataDocument;
+    document->append( placemark );
+
+    return document;
+}
+
+QVector<const GeoDataFeature *> PlacemarkLayoutTest::placemarks( const QVector<VisiblePlacemark *> &layout )
+{
+    QVector<const GeoDataFeature *> result;
+    foreach ( const VisiblePlacemark *mark, layout ) {
+        result << mark->placemark();
+    }
+
+    return result;
+}
+
+}
+
+QTEST_MAIN( Marble::PlacemarkLayoutTest )
+
+#include "PlacemarkLayoutTest.moc"
@@ -0,0 +1,234 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "PlacemarkSearchIndex.h"
+#include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTreeModel.h"
+#include "TestUtils.h"
+
+namespace Marble
+{
+
+class PlacemarkSearchIndexTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testNormalized_data();
+    void testNormalized();
+
+    void testSearch();
+    void testPreferred();
+    void testRemoveDocument();
+    void testLargeDocument();
+    void testUpdateFeature();
+
+ private:
+    static GeoDataDocument *createDocument();
+    static QStringList names( const QVector<GeoDataPlacemark *> &placemarks );
+};
+
+void PlacemarkSearchIndexTest::testNormalized_data()
+{
+    QTest::addColumn<QString>( "name" );
+    QTest::addColumn<QString>( "expected" );
+
+    addRow() << QString( "Karlsruhe" ) << QString( "karlsruhe" );
+    addRow() << QString::fromUtf8( "Zürich" ) << QString( "zurich" );
+    addRow() << QString::fromUtf8( "São Paulo" ) << QString( "sao paulo" );
+    addRow() << QString() << QString();
+}
+
+void PlacemarkSearchIndexTest::testNormalized()
+{
+    QFETCH( QString, name );
+    QFETCH( QString, expected );
+
+    QCOMPARE( PlacemarkSearchIndex::normalized( name ), expected );
+}
+
+void PlacemarkSearchIndexTest::testSearch()
+{
+    GeoDataTreeModel treeModel;
+    const PlacemarkSearchIndex index( &treeModel );
+    treeModel.addDocument( createDocument() );
+    QCOMPARE( index.size(), 5 );
+
+    QVector<GeoDataPlacemark *> result = index.search( "zur", GeoDataLatLonBox() );
+    QCOMPARE( names( result ), QStringList() << QString::fromUtf8( "Zürich" ) << "Zurzach" << "Bad Zurzach" );
+    qDeleteAll( result );
+
+    result = index.search( "KARL", GeoDataLatLonBox() );
+    QCOMPARE( names( result ), QStringList() << "Karlsruhe" );
+    qDeleteAll( result );
+
+    // too short for the trigram index, only prefixes match
+    result = index.search( "ch", GeoDataLatLonBox() );
+    QVERIFY( result.isEmpty() );
+
+    result = index.search( "berlin", GeoDataLatLonBox() );
+    QVERIFY( result.isEmpty() );
+}
+
+void PlacemarkSearchIndexTest::testPreferred()
+{
+    GeoDataTreeModel treeModel;
+    const PlacemarkSearchIndex index( &treeModel );
+    treeModel.addDocument( createDocument() );
+
+    const GeoDataLatLonBox switzerland( 48.0, 45.8, 10.5, 5.9, GeoDataCoordinates::Degree );
+    QVector<GeoDataPlacemark *> result = index.search( "zur", switzerland );
+    QCOMPARE( names( result ), QStringList() << QString::fromUtf8( "Zürich" ) << "Bad Zurzach" );
+    qDeleteAll( result );
+}
+
+void PlacemarkSearchIndexTest::testRemoveDocument()
+{
+    GeoDataTreeModel treeModel;
+    const PlacemarkSearchIndex index( &treeModel );
+
+    GeoDataDocument *const first = createDocument();
+    GeoDataDocument *const second = createDocument();
+    treeModel.addDocument( first );
+    treeModel.addDocument( second );
+    QCOMPARE( index.size(), 10 );
+
+    QVector<GeoDataPlacemark *> result = index.search( "zurz", GeoDataLatLonBox() );
+    QCOMPARE( result.size(), 4 );
+    qDeleteAll( result );
+
+    treeModel.removeDocument( first );
+    delete first;
+    QCOMPARE( index.size(), 5 );
+
+    result = index.search( "zurz", GeoDataLatLonBox() );
+    QCOMPARE( names( result ), QStringList() << "Zurzach" << "Bad Zurzach" );
+    qDeleteAll( result );
+
+    treeModel.removeDocument( second );
+    delete second;
+    QCOMPARE( index.size(), 0 );
+    QVERIFY( index.search( "zurz", GeoDataLatLonBox() ).isEmpty() );
+}
+
+void PlacemarkSearchIndexTest::testLargeDocument()
+{
+    GeoDataTreeModel treeModel;
+    const PlacemarkSearchIndex index( &treeModel );
+
+    GeoDataDocument *const small = createDocument();
+    treeModel.addDocument( small );
+
+    // too many placemarks to be inserted one by one
+    GeoDataDocument *const large = new GeoDataDocument;
+    for ( int i = 0; i < 100; ++i ) {
+        large->append( new GeoDataPlacemark( QString( "Zurich %1" ).arg( i, 2, 10, QChar( '0' ) ) ) );
+    }
+    treeModel.addDocument( large );
+    QCOMPARE( index.size(), 105 );
+
+    QVector<GeoDataPlacemark *> result = index.search( "zurich 4", GeoDataLatLonBox() );
+    QCOMPARE( result.size(), 10 );
+    QCOMPARE( result.first()->name(), QString( "Zurich 40" ) );
+    QCOMPARE( result.last()->name(), QString( "Zurich 49" ) );
+    qDeleteAll( result );
+
+    treeModel.removeDocument( large );
+    delete large;
+    QCOMPARE( index.size(), 5 );
+
+    result = index.search( "zurich", GeoDataLatLonBox() );
+    QCOMPARE( names( result ), QStringList() << QString::fromUtf8( "Zürich" ) );
+    qDeleteAll( result );
+
+    treeModel.removeDocument( small );
+    delete small;
+}
+
+void PlacemarkSearchIndexTest::testUpdateFeature()
+{
+    GeoDataTreeModel treeModel;
+    const PlacemarkSearchIndex index( &treeModel );
+
+    GeoDataDocument *const document = createDocument();
+    treeModel.addDocument( document );
+
+    GeoDataPlacemark *const karlsruhe = static_cast<GeoDataPlacemark *>( document->child( 0 ) );
+    karlsruhe->setName( "Basel" );
+    treeModel.updateFeature( karlsruhe );
+    QCOMPARE( index.size(), 5 );
+
+    QVERIFY( index.search( "karl", GeoDataLatLonBox() ).isEmpty() );
+    QVERIFY( index.search( "ruhe", GeoDataLatLonBox() ).isEmpty() );
+
+    QVector<GeoDataPlacemark *> result = index.search( "bas", GeoDataLatLonBox() );
+    QCOMPARE( names( result ), QStringList() << "Basel" );
+    qDeleteAll( result );
+
+    result = index.search( "ase", GeoDataLatLonBox() );
+    QCOMPARE( names( result ), QStringList() << "Basel" );
+    qDeleteAll( result );
+
+    treeModel.removeDocument( document );
+    delete document;
+}
+
+GeoDataDocument *PlacemarkSearchIndexTest::createDocument()
+{
+    GeoDataDocument *document = new GeoDataDocument;
+
+    GeoDataPlacemark *karlsruhe = new GeoDataPlacemark( "Karlsruhe" );
+    karlsruhe->setCoordinate( 8.4, 49.0, 0, GeoDataCoordinates::Degree );
+    document->append( karlsruhe );
+
+    GeoDataFolder *folder = new GeoDataFolder;
+    document->append( folder );
+
+    GeoDataPlacemark *zurich = new GeoDataPlacemark( QString::fromUtf8( "Zürich" ) );
+    zurich->setCoordinate( 8.55, 47.37, 0, GeoDataCoordinates::Degree );
+    folder->append( zurich );
+
+    GeoDataPlacemark *badZurzach = new GeoDataPlacemark( "Bad Zurzach" );
+    badZurzach->setCoordinate( 8.29, 47.59, 0, GeoDataCoordinates::Degree );
+    folder->append( badZurzach );
+
+    // just across the border
+    GeoDataPlacemark *zurzach = new GeoDataPlacemark( "Zurzach" );
+    zurzach->setCoordinate( 8.29, 48.2, 0, GeoDataCoordinates::Degree );
+    folder->append( zurzach );
+
+    GeoDataPlacemark *bern = new GeoDataPlacemark( "Bern" );
+    bern->setCoordinate( 7.45, 46.95, 0, GeoDataCoordinates::Degree );
+    folder->append( bern );
+
+    // not indexed
+    folder->append( new GeoDataPlacemark );
+
+    return document;
+}
+
+QStringList PlacemarkSearchIndexTest::names( const QVector<GeoDataPlacemark *> &placemarks )
+{
+    QStringList result;
+    foreach ( const GeoDataPlacemark *placemark, placemarks ) {
+        result << placemark->name();
+    }
+
+    return result;
+}
+
+}
+
+QTEST_MAIN( Marble::PlacemarkSearchIndexTest )
+
+#include "PlacemarkSearchIndexTest.moc"
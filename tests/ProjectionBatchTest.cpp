@@ -0,0 +1,124 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "AbstractProjection.h"
+#include "GeoDataLineString.h"
+#include "ViewportParams.h"
+#include "TestUtils.h"
+
+#include <qmath.h>
+
+namespace Marble
+{
+
+class ProjectionBatchTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void batchMatchesSinglePoints_data();
+    void batchMatchesSinglePoints();
+
+    void benchmarkLineString_data();
+    void benchmarkLineString();
+
+ private:
+    static GeoDataLineString coastline( int nodeCount );
+};
+
+void ProjectionBatchTest::batchMatchesSinglePoints_data()
+{
+    QTest::addColumn<int>( "projection" );
+    QTest::addColumn<qreal>( "centerLon" );
+    QTest::addColumn<qreal>( "centerLat" );
+
+    addNamedRow("spherical") << int( Spherical ) << qreal( 0.3 ) << qreal( 0.7 );
+    addNamedRow("equirect") << int( Equirectangular ) << qreal( -2.5 ) << qreal( -0.4 );
+    addNamedRow("mercator") << int( Mercator ) << qreal( 3.0 ) << qreal( 1.2 );
+}
+
+void ProjectionBatchTest::batchMatchesSinglePoints()
+{
+    QFETCH( int, projection );
+    QFETCH( qreal, centerLon );
+    QFETCH( qreal, centerLat );
+
+    ViewportParams viewport( Projection( projection ), centerLon, centerLat, 400, QSize( 800, 600 ) );
+    const AbstractProjection *const proj = viewport.currentProjection();
+
+    // a grid over the whole planet, including points beyond the latitude
+    // range of the Mercator projection and high altitude points
+    QVector<GeoDataCoordinates> coordinates;
+    for ( int lon = -180; lon <= 180; lon += 15 ) {
+        for ( int lat = -90; lat <= 90; lat += 5 ) {
+            const qreal altitude = ( lon + lat ) % 2 == 0 ? 0.0 : 20000000.0;
+            coordinates << GeoDataCoordinates( lon, lat, altitude, GeoDataCoordinates::Degree );
+        }
+    }
+
+    QVector<QPointF> points( coordinates.size() );
+    QVector<bool> hidden( coordinates.size() );
+    proj->screenCoordinates( coordinates.constData(), coordinates.size(), &viewport, points.data(), hidden.data() );
+
+    for ( int i = 0; i < coordinates.size(); ++i ) {
+        qreal x = 0;
+        qreal y = 0;
+        bool globeHidesPoint = false;
+        proj->screenCoordinates( coordinates[i], &viewport, x, y, globeHidesPoint );
+
+        QCOMPARE( hidden[i], globeHidesPoint );
+        if ( !globeHidesPoint ) {
+            QCOMPARE( points[i].x(), x );
+            QCOMPARE( points[i].y(), y );
+        }
+    }
+}
+
+void ProjectionBatchTest::benchmarkLineString_data()
+{
+    QTest::addColumn<int>( "projection" );
+
+    addNamedRow("spherical") << int( Spherical );
+    addNamedRow("equirect") << int( Equirectangular );
+    addNamedRow("mercator") << int( Mercator );
+}
+
+void ProjectionBatchTest::benchmarkLineString()
+{
+    QFETCH( int, projection );
+
+    const GeoDataLineString lineString = coastline( 200000 );
+    ViewportParams viewport( Projection( projection ), 0.2, 0.1, 5000, QSize( 1920, 1080 ) );
+
+    QBENCHMARK {
+        QVector<QPolygonF *> polygons;
+        viewport.screenCoordinates( lineString, polygons );
+        qDeleteAll( polygons );
+    }
+}
+
+GeoDataLineString ProjectionBatchTest::coastline( int nodeCount )
+{
+    // a wiggly line around the globe, dense enough for most nodes to be resolved
+    GeoDataLineString lineString;
+    for ( int i = 0; i < nodeCount; ++i ) {
+        const qreal lon = -M_PI + 2 * M_PI * i / nodeCount;
+        const qreal lat = 0.3 * qSin( 40 * lon ) + 0.01 * qSin( 997 * lon );
+        lineString << GeoDataCoordinates( lon, lat );
+    }
+
+    return lineString;
+}
+
+}
+
+QTEST_MAIN( Marble::ProjectionBatchTest )
+
+#include "ProjectionBatchTest.moc"
@@ -0,0 +1,199 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "SatellitesTLEItem.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTrack.h"
+#include "MarbleClock.h"
+#include "TestUtils.h"
+
+#include "sgp4/sgp4io.h"
+
+#include <locale.h>
+
+namespace Marble
+{
+
+class SatellitesTLEItemTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+
+    void testTrack();
+    void testIncrementalUpdate();
+    void testUpdateItems();
+
+    void benchmarkUpdateItems_data();
+    void benchmarkUpdateItems();
+
+ private:
+    SatellitesTLEItem *createItem() const;
+    static const GeoDataTrack *track( SatellitesTLEItem *item );
+
+    elsetrec m_satrec;
+    MarbleClock m_clock;
+};
+
+void SatellitesTLEItemTest::initTestCase()
+{
+    char line1[130] = "1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927";
+    char line2[130] = "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537";
+    double startmfe, stopmfe, deltamin;
+
+    // twoline2rv uses sscanf
+    setlocale( LC_NUMERIC, "C" );
+    twoline2rv( line1, line2, 'c', 'd', 'i', wgs84, startmfe, stopmfe, deltamin, m_satrec );
+    setlocale( LC_NUMERIC, "" );
+
+    QCOMPARE( m_satrec.error, 0 );
+}
+
+void SatellitesTLEItemTest::testTrack()
+{
+    const QDateTime now( QDate( 2008, 9, 20 ), QTime( 13, 0 ), Qt::UTC );
+    m_clock.setDateTime( now );
+
+    SatellitesTLEItem *const item = createItem();
+    item->update();
+
+    const QList<QDateTime> when = track( item )->whenList();
+    const QList<GeoDataCoordinates> coordinates = track( item )->coordinatesList();
+    QVERIFY( when.size() > 100 );
+    QCOMPARE( coordinates.size(), when.size() );
+
+    // one orbit of about 92 minutes, starting two minutes ago
+    QVERIFY( when.first() >= now.addSecs( -2 * 60 ) );
+    QVERIFY( when.last() <= now.addSecs( 90 * 60 ) );
+    QVERIFY( when.last() >= now.addSecs( 88 * 60 ) );
+    QVERIFY( when.contains( now ) );
+
+    for ( int i = 1; i < when.size(); ++i ) {
+        QVERIFY( when.at( i - 1 ) < when.at( i ) );
+    }
+
+    foreach ( const GeoDataCoordinates &point, coordinates ) {
+        QVERIFY( point.altitude() > 300000 );
+        QVERIFY( point.altitude() < 400000 );
+        QVERIFY( qAbs( point.latitude( GeoDataCoordinates::Degree ) ) < 52 );
+    }
+
+    delete item;
+}
+
+void SatellitesTLEItemTest::testIncrementalUpdate()
+{
+    const QDateTime start( QDate( 2008, 9, 20 ), QTime( 13, 0 ), Qt::UTC );
+    m_clock.setDateTime( start );
+
+    SatellitesTLEItem *const item = createItem();
+    item->update();
+
+    const QDateTime later = start.addSecs( 10 * 60 );
+    m_clock.setDateTime( later );
+    item->update();
+
+    SatellitesTLEItem *const reference = createItem();
+    reference->update();
+
+    const QList<QDateTime> when = track( item )->whenList();
+    QVERIFY( when.first() >= later.addSecs( -2 * 60 ) );
+    QVERIFY( when.last() <= later.addSecs( 90 * 60 ) );
+    QVERIFY( when.last() >= later.addSecs( 88 * 60 ) );
+
+    // no gaps at either end of the track
+    for ( int i = 1; i < when.size(); ++i ) {
+        QVERIFY( when.at( i - 1 ) < when.at( i ) );
+        QVERIFY( when.at( i - 1 ).secsTo( when.at( i ) ) <= 56 );
+    }
+
+    QCOMPARE( track( item )->coordinatesAt( later ), track( reference )->coordinatesAt( later ) );
+
+    delete reference;
+    delete item;
+}
+
+void SatellitesTLEItemTest::testUpdateItems()
+{
+    m_clock.setDateTime( QDateTime( QDate( 2008, 9, 20 ), QTime( 13, 0 ), Qt::UTC ) );
+
+    QVector<SatellitesTLEItem *> items;
+    for ( int i = 0; i < 200; ++i ) {
+        items << createItem();
+        items.last()->setEnabled( i % 3 != 0 );
+    }
+
+    SatellitesTLEItem *const reference = createItem();
+    reference->update();
+
+    SatellitesTLEItem::updateItems( items );
+
+    for ( int i = 0; i < items.size(); ++i ) {
+        if ( items.at( i )->isEnabled() ) {
+            QCOMPARE( track( items.at( i ) )->whenList(), track( reference )->whenList() );
+            QCOMPARE( track( items.at( i ) )->coordinatesList(), track( reference )->coordinatesList() );
+        } else {
+            QCOMPARE( track( items.at( i ) )->size(), 0 );
+        }
+    }
+
+    delete reference;
+    qDeleteAll( items );
+}
+
+void SatellitesTLEItemTest::benchmarkUpdateItems_data()
+{
+    QTest::addColumn<int>( "seconds" );
+
+    QTest::newRow( "clock tick" ) << 1;
+    QTest::newRow( "new orbit" ) << 6000;
+}
+
+void SatellitesTLEItemTest::benchmarkUpdateItems()
+{
+    QFETCH( int, seconds );
+
+    m_clock.setDateTime( QDateTime( QDate( 2008, 9, 20 ), QTime( 13, 0 ), Qt::UTC ) );
+
+    QVector<SatellitesTLEItem *> items;
+    for ( int i = 0; i < 2000; ++i ) {
+        items << createItem();
+    }
+
+    SatellitesTLEItem::updateItems( items );
+
+    QBENCHMARK {
+        m_clock.setDateTime( m_clock.dateTime().addSecs( seconds ) );
+        SatellitesTLEItem::updateItems( items );
+    }
+
+    qDeleteAll( items );
+}
+
+SatellitesTLEItem *SatellitesTLEItemTest::createItem() const
+{
+    SatellitesTLEItem *item = new SatellitesTLEItem( "ISS (ZARYA)", m_satrec, &m_clock );
+    item->setEnabled( true );
+    item->setTrackVisible( true );
+
+    return item;
+}
+
+const GeoDataTrack *SatellitesTLEItemTest::track( SatellitesTLEItem *item )
+{
+    return static_cast<const GeoDataTrack *>( item->placemark()->geometry() );
+}
+
+}
+
+QTEST_MAIN( Marble::SatellitesTLEItemTest )
+
+#include "SatellitesTLEItemTest.moc"
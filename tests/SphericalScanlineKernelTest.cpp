@@ -0,0 +1,166 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "SphericalScanlineKernel.h"
+#include "MarbleGlobal.h"
+#include "TestUtils.h"
+
+#include <QVector>
+
+Q_DECLARE_METATYPE( Marble::SphericalScanlineKernel::Implementation )
+
+namespace Marble
+{
+
+class SphericalScanlineKernelTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testIdenticalToScalar_data();
+    void testIdenticalToScalar();
+
+    void testStep_data();
+    void testStep();
+
+    void benchmarkScanlines_data();
+    void benchmarkScanlines();
+
+ private:
+    static void addImplementationRows();
+};
+
+void SphericalScanlineKernelTest::addImplementationRows()
+{
+    QTest::addColumn<SphericalScanlineKernel::Implementation>( "implementation" );
+
+    QTest::newRow( "Scalar" ) << SphericalScanlineKernel::Scalar;
+    QTest::newRow( "SSE2" ) << SphericalScanlineKernel::Sse2;
+    QTest::newRow( "AVX" ) << SphericalScanlineKernel::Avx;
+}
+
+void SphericalScanlineKernelTest::testIdenticalToScalar_data()
+{
+    addImplementationRows();
+}
+
+void SphericalScanlineKernelTest::testIdenticalToScalar()
+{
+    QFETCH( SphericalScanlineKernel::Implementation, implementation );
+
+    // Unsupported implementations fall back to the scalar one
+    for ( int pitch = -180; pitch < 180; pitch += 45 ) {
+        for ( int roll = -180; roll < 180; roll += 45 ) {
+            matrix planetAxisMatrix;
+            Quaternion::fromEuler( pitch * DEG2RAD, 0.3, roll * DEG2RAD ).toMatrix( planetAxisMatrix );
+
+            const SphericalScanlineKernel reference( planetAxisMatrix, SphericalScanlineKernel::Scalar );
+            const SphericalScanlineKernel kernel( planetAxisMatrix, implementation );
+
+            const int radius = 257;
+            const qreal inverseRadius = 1.0 / radius;
+
+            for ( int y = -radius; y <= radius; y += 3 ) {
+                const qreal qy = inverseRadius * y;
+                // odd count and pixels outside of the disc exercise the remainder
+                // and clamping code paths
+                const int count = 2 * radius + 7;
+                const int xOffset = -radius - 3;
+
+                QVector<qreal> expectedLon( count );
+                QVector<qreal> expectedLat( count );
+                QVector<qreal> lon( count );
+                QVector<qreal> lat( count );
+
+                reference.sphericalCoordinates( qy, inverseRadius, xOffset, count, 1, expectedLon.data(), expectedLat.data() );
+                kernel.sphericalCoordinates( qy, inverseRadius, xOffset, count, 1, lon.data(), lat.data() );
+
+                QCOMPARE( lon, expectedLon );
+                QCOMPARE( lat, expectedLat );
+            }
+        }
+    }
+}
+
+void SphericalScanlineKernelTest::testStep_data()
+{
+    addImplementationRows();
+}
+
+void SphericalScanlineKernelTest::testStep()
+{
+    QFETCH( SphericalScanlineKernel::Implementation, implementation );
+
+    matrix planetAxisMatrix;
+    Quaternion::fromEuler( 0.4, 0.3, 0.2 ).toMatrix( planetAxisMatrix );
+    const SphericalScanlineKernel kernel( planetAxisMatrix, implementation );
+
+    const int radius = 257;
+    const qreal inverseRadius = 1.0 / radius;
+    const int xOffset = -radius - 3;
+    const int count = 2 * radius + 7;
+
+    for ( int step = 2; step <= 8; ++step ) {
+        const int anchors = count / step;
+
+        for ( int y = -radius; y <= radius; y += 17 ) {
+            const qreal qy = inverseRadius * y;
+
+            QVector<qreal> expectedLon( count );
+            QVector<qreal> expectedLat( count );
+            QVector<qreal> lon( anchors );
+            QVector<qreal> lat( anchors );
+
+            kernel.sphericalCoordinates( qy, inverseRadius, xOffset, count, 1, expectedLon.data(), expectedLat.data() );
+            kernel.sphericalCoordinates( qy, inverseRadius, xOffset + step - 1, anchors, step, lon.data(), lat.data() );
+
+            for ( int i = 0; i < anchors; ++i ) {
+                QCOMPARE( lon[i], expectedLon[i * step + step - 1] );
+                QCOMPARE( lat[i], expectedLat[i * step + step - 1] );
+            }
+        }
+    }
+}
+
+void SphericalScanlineKernelTest::benchmarkScanlines_data()
+{
+    addImplementationRows();
+}
+
+void SphericalScanlineKernelTest::benchmarkScanlines()
+{
+    QFETCH( SphericalScanlineKernel::Implementation, implementation );
+
+    matrix planetAxisMatrix;
+    Quaternion::fromEuler( 0.4, 0.3, 0.2 ).toMatrix( planetAxisMatrix );
+    const SphericalScanlineKernel kernel( planetAxisMatrix, implementation );
+
+    // a globe filling a 4K screen
+    const int width = 3840;
+    const int height = 2160;
+    const int radius = height / 2;
+    const qreal inverseRadius = 1.0 / radius;
+
+    QVector<qreal> lon( width );
+    QVector<qreal> lat( width );
+
+    QBENCHMARK {
+        for ( int y = 0; y < height; ++y ) {
+            kernel.sphericalCoordinates( inverseRadius * ( height / 2 - y ), inverseRadius,
+                                         -width / 2, width, 1, lon.data(), lat.data() );
+        }
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::SphericalScanlineKernelTest )
+
+#include "SphericalScanlineKernelTest.moc"
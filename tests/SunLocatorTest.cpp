@@ -0,0 +1,103 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "SunLocator.h"
+
+#include "MarbleClock.h"
+#include "MarbleGlobal.h"
+#include "Planet.h"
+#include "PlanetFactory.h"
+#include "TestUtils.h"
+
+#include <QDateTime>
+
+#include <cmath>
+
+namespace Marble
+{
+
+class SunLocatorTest : public QObject
+{
+    Q_OBJECT
+
+ public:
+    SunLocatorTest();
+
+ private slots:
+    void initTestCase();
+
+    void testSubSolarPoint();
+    void testShadingForms_data();
+    void testShadingForms();
+
+ private:
+    MarbleClock m_clock;
+    Planet m_planet;
+    SunLocator m_sunLocator;
+};
+
+SunLocatorTest::SunLocatorTest() :
+    m_clock(),
+    m_planet( PlanetFactory::construct( "earth" ) ),
+    m_sunLocator( &m_clock, &m_planet )
+{
+}
+
+void SunLocatorTest::initTestCase()
+{
+    m_clock.setDateTime( QDateTime( QDate( 2014, 6, 1 ), QTime( 9, 30 ), Qt::UTC ) );
+    m_sunLocator.setPlanet( &m_planet );
+    m_sunLocator.update();
+}
+
+void SunLocatorTest::testSubSolarPoint()
+{
+    const qreal lon = m_sunLocator.getLon() * DEG2RAD;
+    const qreal lat = m_sunLocator.getLat() * DEG2RAD;
+
+    QCOMPARE( m_sunLocator.shading( lon, lat ), qreal( 1.0 ) );
+    QCOMPARE( m_sunLocator.shading( lon + M_PI, -lat ), qreal( 0.0 ) );
+}
+
+void SunLocatorTest::testShadingForms_data()
+{
+    QTest::addColumn<qreal>( "lon" );
+    QTest::addColumn<qreal>( "lat" );
+
+    for ( int lat = -85; lat <= 85; lat += 17 ) {
+        for ( int lon = -180; lon < 180; lon += 9 ) {
+            QTest::newRow( QString( "%1 %2" ).arg( lon ).arg( lat ).toLatin1() ) << qreal( lon * DEG2RAD ) << qreal( lat * DEG2RAD );
+        }
+    }
+}
+
+void SunLocatorTest::testShadingForms()
+{
+    QFETCH( qreal, lon );
+    QFETCH( qreal, lat );
+
+    // The tile based form expects the longitude counted from the date line
+    // and the latitude counted from the north pole downwards, as used by
+    // SunLightBlending.
+    const qreal tileLon = lon + M_PI;
+    const qreal tileLat = lat - M_PI;
+    const qreal a = sin( ( tileLat + DEG2RAD * m_sunLocator.getLat() ) / 2.0 );
+    const qreal c = cos( tileLat ) * cos( -DEG2RAD * m_sunLocator.getLat() );
+
+    const qreal expected = m_sunLocator.shading( tileLon, a, c );
+
+    QVERIFY( fabs( m_sunLocator.shading( lon, lat ) - expected ) < 1e-9 );
+}
+
+}
+
+QTEST_MAIN( Marble::SunLocatorTest )
+
+#include "SunLocatorTest.moc"
@@ -19,6 +19,7 @@
 #include "GeoDataTypes.h"
 #include "GeoDataStyle.h"
 #include "GeoDataIconStyle.h"
+#include "GeoDataPolyStyle.h"
 #include "GeoDataStyleMap.h"
 #include "MarbleDebug.h"
 
@@ -31,6 +32,7 @@ class TestGeoData : public QObject
  private slots:
     void nodeTypeTest();
     void parentingTest();
+    void sharedStyleTest();
 };
 
 /// test the nodeType function through various construction tests
@@ -132,6 +134,47 @@ void TestGeoData::parentingTest()
     QCOMPARE( placemark2->style()->iconStyle().iconPath(), QString( "myicon.png" ) );
 }
 
+void TestGeoData::sharedStyleTest()
+{
+    GeoDataDocument document;
+    GeoDataPlacemark *first = new GeoDataPlacemark;
+    GeoDataPlacemark *second = new GeoDataPlacemark;
+    GeoDataPlacemark *third = new GeoDataPlacemark;
+    document.append( first );
+    document.append( second );
+    document.append( third );
+
+    GeoDataStyle style;
+    style.polyStyle().setColorIndex( 3 );
+    const QString id = document.addSharedStyle( style );
+    QVERIFY( !id.isEmpty() );
+
+    /// equal styles are stored once, regardless of their id
+    style.setId( "other" );
+    QCOMPARE( document.addSharedStyle( style ), id );
+    QCOMPARE( document.styles().size(), 1 );
+
+    style.polyStyle().setColorIndex( 4 );
+    const QString otherId = document.addSharedStyle( style );
+    QVERIFY( otherId != id );
+    QCOMPARE( document.styles().size(), 2 );
+
+    first->setStyleUrl( '#' + id );
+    second->setStyleUrl( '#' + id );
+    third->setStyleUrl( '#' + otherId );
+    QCOMPARE( first->style(), second->style() );
+    QVERIFY( first->style() != third->style() );
+    QCOMPARE( first->style()->polyStyle().colorIndex(), quint8( 3 ) );
+    QCOMPARE( third->style()->polyStyle().colorIndex(), quint8( 4 ) );
+    QVERIFY( document.styleMaps().isEmpty() );
+
+    /// removed styles are not handed out again
+    document.removeStyle( otherId );
+    const QString newId = document.addSharedStyle( style );
+    QCOMPARE( document.style( newId ).polyStyle().colorIndex(), quint8( 4 ) );
+    QCOMPARE( document.styles().size(), 2 );
+}
+
 }
 
 QTEST_MAIN( Marble::TestGeoData )
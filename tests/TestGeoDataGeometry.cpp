@@ -26,6 +26,8 @@ private slots:
     void deleteAndDetachTest1();
     void deleteAndDetachTest2();
     void deleteAndDetachTest3();
+    void coordinateArraysTest();
+    void assignDetailLevelsTest();
 };
 
 void TestGeoDataGeometry::downcastPointTest_data()
@@ -85,6 +87,85 @@ void TestGeoDataGeometry::deleteAndDetachTest3()
     line2 << GeoDataCoordinates();
 }
 
+void TestGeoDataGeometry::coordinateArraysTest()
+{
+    GeoDataLineString line;
+    line << GeoDataCoordinates( 10, 20, 100, GeoDataCoordinates::Degree )
+         << GeoDataCoordinates( 30, 40, 200, GeoDataCoordinates::Degree );
+
+    const GeoDataCoordinateArrays<qreal> arrays = line.coordinateArrays();
+    QCOMPARE( arrays.size(), 2 );
+    QCOMPARE( arrays.longitudes()[1], line.at( 1 ).longitude() );
+    QCOMPARE( arrays.latitudes()[1], line.at( 1 ).latitude() );
+    QCOMPARE( arrays.altitudes()[1], 200.0 );
+    QVERIFY( arrays.toVector() == QVector<GeoDataCoordinates>() << line.at( 0 ) << line.at( 1 ) );
+
+    // the arrays follow changes of the line string, but not of its copies
+    GeoDataLineString copy = line;
+    copy << GeoDataCoordinates( 50, 60, 0, GeoDataCoordinates::Degree );
+    QCOMPARE( copy.coordinateArrays().size(), 3 );
+    QCOMPARE( line.coordinateArrays().size(), 2 );
+
+    copy.insert( 1, GeoDataCoordinates( 20, 30, 0, GeoDataCoordinates::Degree ) );
+    copy.remove( 0 );
+    QVERIFY( copy.coordinateArrays().toVector() == QVector<GeoDataCoordinates>() << copy.at( 0 ) << copy.at( 1 ) << copy.at( 2 ) );
+
+    // nodes modified through a reference are picked up before and after the next change
+    line[0].setAltitude( 300 );
+    QCOMPARE( line.coordinateArrays().altitude( 0 ), 300.0 );
+    line.last().setAltitude( 400 );
+    line << GeoDataCoordinates( 50, 60, 500, GeoDataCoordinates::Degree );
+    QCOMPARE( line.coordinateArrays().altitude( 0 ), 300.0 );
+    QCOMPARE( line.coordinateArrays().altitude( 1 ), 400.0 );
+    QCOMPARE( line.coordinateArrays().altitude( 2 ), 500.0 );
+
+    line.erase( line.begin() + 1, line.end() );
+    QCOMPARE( line.coordinateArrays().size(), 1 );
+    QCOMPARE( line.coordinateArrays().altitude( 0 ), 300.0 );
+
+    const GeoDataCoordinateArrays<float> floats( copy.coordinateArrays().toVector() );
+    QCOMPARE( floats.size(), 3 );
+    QCOMPARE( floats.latitude( 2 ), float( 60 * DEG2RAD ) );
+}
+
+void TestGeoDataGeometry::assignDetailLevelsTest()
+{
+    // an L-shaped line: 50 nodes along the equator, then 50 nodes northwards
+    GeoDataLineString line;
+    for ( int i = 0; i <= 50; ++i ) {
+        line << GeoDataCoordinates( 0.1 * i, 0, 0, GeoDataCoordinates::Degree );
+    }
+    for ( int i = 1; i <= 50; ++i ) {
+        line << GeoDataCoordinates( 5, 0.1 * i, 0, GeoDataCoordinates::Degree );
+    }
+
+    GeoDataLineString copy = line;
+    line.assignDetailLevels();
+
+    // only the end points and the corner are needed at low zoom
+    QCOMPARE( line.at( 0 ).detail(), 0 );
+    QCOMPARE( line.at( 50 ).detail(), 0 );
+    QCOMPARE( line.at( 100 ).detail(), 0 );
+    QCOMPARE( line.at( 25 ).detail(), 5 );
+    QCOMPARE( line.at( 75 ).detail(), 5 );
+
+    // copies are not affected
+    QCOMPARE( copy.at( 25 ).detail(), 0 );
+
+    // existing detail levels are kept
+    GeoDataLineString preset = copy;
+    preset[25].setDetail( 2 );
+    preset.assignDetailLevels();
+    QCOMPARE( preset.at( 25 ).detail(), 2 );
+    QCOMPARE( preset.at( 75 ).detail(), 0 );
+
+    // short lines are not simplified by the projections anyway
+    GeoDataLineString shortLine;
+    shortLine << GeoDataCoordinates( 0, 0 ) << GeoDataCoordinates( 0.1, 0 ) << GeoDataCoordinates( 0.2, 0 );
+    shortLine.assignDetailLevels();
+    QCOMPARE( shortLine.at( 1 ).detail(), 0 );
+}
+
 QTEST_MAIN( TestGeoDataGeometry )
 #include "TestGeoDataGeometry.moc"
 
@@ -54,6 +54,12 @@ private slots:
      */
     void testPolygon();
 
+    /**
+     * @brief testRevision shows that editing a geometry in place, as well as
+     * detaching a copy of it, changes its revision.
+     */
+    void testRevision();
+
 private:
     GeoDataCoordinates m_coords1;
     GeoDataCoordinates m_coords2;
@@ -128,6 +134,30 @@ void TestGeometryDetach::testPolygon()
     QVERIFY(poly3.innerBoundaries().size() == 1);
 }
 
+void TestGeometryDetach::testRevision()
+{
+    GeoDataPolygon poly1;
+    poly1.outerBoundary().append(m_coords1);
+    const int revision1 = poly1.revision();
+    QCOMPARE(poly1.revision(), revision1);
+
+    poly1.outerBoundary()[0] = m_coords2;
+    QVERIFY(poly1.revision() != revision1);
+
+    const GeoDataPolygon poly2 = poly1;
+    QCOMPARE(poly2.revision(), poly1.revision());
+
+    const int revision2 = poly1.revision();
+    poly1.outerBoundary().append(m_coords1);
+    QVERIFY(poly1.revision() != revision2);
+    QCOMPARE(poly2.revision(), revision2);
+
+    GeoDataLineString lineString;
+    const int revision3 = lineString.revision();
+    lineString.setTessellationFlags(Tessellate);
+    QVERIFY(lineString.revision() != revision3);
+}
+
 }
 
 QTEST_MAIN( Marble::TestGeometryDetach )
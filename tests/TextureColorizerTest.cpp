@@ -0,0 +1,141 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "TextureColorizer.h"
+#include "GeoDataDocument.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+#include "TestUtils.h"
+
+#include <QImage>
+
+Q_DECLARE_METATYPE( Marble::Projection )
+
+namespace Marble
+{
+
+class TextureColorizerTest : public QObject
+{
+    Q_OBJECT
+
+ public:
+    TextureColorizerTest();
+
+ private slots:
+    void testSeaOnly();
+
+    void benchmarkColorize_data();
+    void benchmarkColorize();
+
+ private:
+    GeoDataDocument m_landDocument;
+};
+
+TextureColorizerTest::TextureColorizerTest()
+{
+    // a continent in the middle of the map, so the benchmark covers
+    // land, sea and the blended coast line
+    GeoDataPolygon *polygon = new GeoDataPolygon( Tessellate );
+    polygon->outerBoundary() << GeoDataCoordinates( -60, -40, 0, GeoDataCoordinates::Degree )
+                             << GeoDataCoordinates(  60, -40, 0, GeoDataCoordinates::Degree )
+                             << GeoDataCoordinates(  60,  40, 0, GeoDataCoordinates::Degree )
+                             << GeoDataCoordinates( -60,  40, 0, GeoDataCoordinates::Degree );
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    placemark->setGeometry( polygon );
+    m_landDocument.append( placemark );
+}
+
+void TextureColorizerTest::testSeaOnly()
+{
+    TextureColorizer colorizer( MARBLE_SRC_DIR "/data/seacolors.leg", MARBLE_SRC_DIR "/data/landcolors.leg" );
+
+    const ViewportParams viewport( Spherical, 0, 0, 100, QSize( 300, 200 ) );
+
+    const uchar grey = 100;
+    const QRgb background = qRgb( 1, 2, 3 );
+    QImage image( viewport.size(), QImage::Format_ARGB32_Premultiplied );
+    image.fill( background );
+    for ( int y = 0; y < image.height(); ++y ) {
+        for ( int x = 50; x < 250; ++x ) {
+            image.setPixel( x, y, qRgb( grey, grey, grey ) );
+        }
+    }
+
+    colorizer.colorize( &image, &viewport, NormalQuality );
+
+    const QRgb water = qRgb( 0, 0, 255 );
+    QRgb expected;
+    colorizer.setPixel( &water, &expected, 8, grey );
+
+    QCOMPARE( image.pixel( 150, 100 ), expected );
+    QCOMPARE( image.pixel( 60, 100 ), expected );
+    QCOMPARE( image.pixel( 150, 5 ), expected );
+
+    // outside of the globe
+    QCOMPARE( image.pixel( 0, 0 ), background );
+    QCOMPARE( image.pixel( 299, 199 ), background );
+    QCOMPARE( image.pixel( 55, 5 ), qRgb( grey, grey, grey ) );
+}
+
+void TextureColorizerTest::benchmarkColorize_data()
+{
+    QTest::addColumn<QString>( "palette" );
+    QTest::addColumn<Projection>( "projection" );
+    QTest::addColumn<bool>( "showRelief" );
+
+    // the palettes of the topographic and the temperature themes
+    QTest::newRow( "topographic, globe" ) << QString( "sea" ) << Spherical << false;
+    QTest::newRow( "topographic, globe, relief" ) << QString( "sea" ) << Spherical << true;
+    QTest::newRow( "topographic, flat, relief" ) << QString( "sea" ) << Equirectangular << true;
+    QTest::newRow( "temperature, flat" ) << QString( "temp" ) << Equirectangular << false;
+}
+
+void TextureColorizerTest::benchmarkColorize()
+{
+    QFETCH( QString, palette );
+    QFETCH( Projection, projection );
+    QFETCH( bool, showRelief );
+
+    const QString seaFile = QString( MARBLE_SRC_DIR "/data/%1colors.leg" ).arg( palette );
+    const QString landFile = palette == "sea" ? QString( MARBLE_SRC_DIR "/data/landcolors.leg" ) : seaFile;
+
+    TextureColorizer colorizer( seaFile, landFile );
+    colorizer.addLandDocument( &m_landDocument );
+    colorizer.setShowRelief( showRelief );
+
+    const ViewportParams viewport( projection, 0, 0, 500, QSize( 1920, 1080 ) );
+
+    // a height field with some structure for the emboss effect
+    QImage heightField( viewport.size(), QImage::Format_ARGB32_Premultiplied );
+    for ( int y = 0; y < heightField.height(); ++y ) {
+        for ( int x = 0; x < heightField.width(); ++x ) {
+            const int grey = ( x * 7 + y * 3 ) % 256;
+            heightField.setPixel( x, y, qRgb( grey, grey, grey ) );
+        }
+    }
+
+    QImage image;
+
+    QBENCHMARK {
+        image = heightField;
+        image.detach();
+        colorizer.colorize( &image, &viewport, NormalQuality );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::TextureColorizerTest )
+
+#include "TextureColorizerTest.moc"
@@ -0,0 +1,145 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      Marble Developers <marble-devel@kde.org>
+//
+
+#include "TileArchive.h"
+#include "GeoSceneTextureTile.h"
+#include "TestUtils.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QImage>
+#include <QTemporaryFile>
+
+namespace Marble
+{
+
+class TileArchiveTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testWriteAndRead();
+    void testEmptyArchive();
+    void testInvalidFile();
+    void testThemeTileSize();
+};
+
+void TileArchiveTest::testWriteAndRead()
+{
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    file.close();
+
+    {
+        TileArchiveWriter writer( file.fileName() );
+        QVERIFY( writer.open() );
+
+        // tiles are added in no particular order
+        for ( int level = 2; level >= 0; --level ) {
+            for ( int y = 0; y < ( 1 << level ); ++y ) {
+                for ( int x = 2 * ( 1 << level ) - 1; x >= 0; --x ) {
+                    const QByteArray data = QString( "%1/%2/%3" ).arg( level ).arg( y ).arg( x ).toLatin1();
+                    QVERIFY( writer.addTile( level, x, y, data ) );
+                }
+            }
+        }
+
+        QVERIFY( writer.finish() );
+    }
+
+    const TileArchive archive( file.fileName() );
+    QVERIFY( archive.isValid() );
+    QCOMPARE( archive.tileCount(), quint32( 2 + 8 + 32 ) );
+    QCOMPARE( archive.maximumTileLevel(), 2 );
+
+    for ( int level = 0; level <= 2; ++level ) {
+        for ( int y = 0; y < ( 1 << level ); ++y ) {
+            for ( int x = 0; x < 2 * ( 1 << level ); ++x ) {
+                const QByteArray expected = QString( "%1/%2/%3" ).arg( level ).arg( y ).arg( x ).toLatin1();
+                QVERIFY( archive.contains( level, x, y ) );
+                QCOMPARE( archive.tileData( level, x, y ), expected );
+            }
+        }
+    }
+
+    QVERIFY( !archive.contains( 3, 0, 0 ) );
+    QVERIFY( !archive.contains( 1, 4, 0 ) );
+    QVERIFY( !archive.contains( 0, 0, 1 ) );
+    QVERIFY( !archive.contains( -1, 0, 0 ) );
+    QVERIFY( archive.tileData( 1, 0, 2 ).isEmpty() );
+}
+
+void TileArchiveTest::testEmptyArchive()
+{
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    file.close();
+
+    TileArchiveWriter writer( file.fileName() );
+    QVERIFY( writer.open() );
+    QVERIFY( writer.finish() );
+
+    const TileArchive archive( file.fileName() );
+    QVERIFY( archive.isValid() );
+    QCOMPARE( archive.tileCount(), quint32( 0 ) );
+    QCOMPARE( archive.maximumTileLevel(), -1 );
+    QVERIFY( !archive.contains( 0, 0, 0 ) );
+}
+
+void TileArchiveTest::testInvalidFile()
+{
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    file.write( "0/000000/000000_000000.jpg is not an archive" );
+    file.close();
+
+    const TileArchive archive( file.fileName() );
+    QVERIFY( !archive.isValid() );
+    QVERIFY( !archive.contains( 0, 0, 0 ) );
+
+    const TileArchive missing( file.fileName() + ".missing" );
+    QVERIFY( !missing.isValid() );
+}
+
+void TileArchiveTest::testThemeTileSize()
+{
+    // a packed theme has no loose tile files, see TileCreator::setTileArchive()
+    const QString themeDir = QDir::tempPath() + "/marble-tile-archive-test";
+    QVERIFY( QDir().mkpath( themeDir ) );
+    const QString fileName = TileArchive::themeFilePath( themeDir );
+    QCOMPARE( fileName, themeDir + '/' + TileArchive::themeFileName() );
+
+    QImage tile( 64, 32, QImage::Format_RGB32 );
+    tile.fill( Qt::red );
+    QByteArray data;
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::WriteOnly ) );
+    QVERIFY( tile.save( &buffer, "PNG" ) );
+
+    {
+        TileArchiveWriter writer( fileName );
+        QVERIFY( writer.open() );
+        QVERIFY( writer.addTile( 0, 0, 0, data ) );
+        QVERIFY( writer.finish() );
+    }
+
+    GeoSceneTextureTile texture( "test" );
+    texture.setSourceDir( themeDir );
+    QCOMPARE( texture.tileSize(), QSize( 64, 32 ) );
+
+    QVERIFY( QFile::remove( fileName ) );
+    QVERIFY( QDir().rmdir( themeDir ) );
+}
+
+}
+
+QTEST_MAIN( Marble::TileArchiveTest )
+
+#include "TileArchiveTest.moc"
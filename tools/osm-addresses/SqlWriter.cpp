@@ -31,12 +31,14 @@ SqlWriter::SqlWriter( const QString &filename, QObject* parent ) :
 
     execQuery( "DROP TABLE IF EXISTS placemarks;" );
     execQuery( "CREATE TABLE placemarks ("
+               " id INTEGER PRIMARY KEY,"
                " regionId INTEGER,"
                " nameId INTEGER,"
                " number VARCHAR(8),"
                " category INTEGER,"
                " lon FLOAT(8),"
                " lat FLOAT(8) )" );
+    execQuery( "DROP TABLE IF EXISTS placemarksTree" );
     execQuery( "DROP TABLE IF EXISTS names" );
     execQuery( "CREATE TABLE names ("
                " id INTEGER PRIMARY KEY,"
@@ -71,6 +73,15 @@ SqlWriter::~SqlWriter()
     execQuery( "CREATE INDEX namesIndex ON names(name)" );
     execQuery( "CREATE INDEX placemarksIndex ON placemarks(regionId,nameId,category)" );
     execQuery( "CREATE INDEX regionsIndex ON regions(name,parent,lft,rgt)" );
+
+    // Spatial index for nearby searches. The R*Tree module is optional in SQLite,
+    // the search plugin falls back to a full scan without it.
+    QSqlQuery treeQuery( "CREATE VIRTUAL TABLE placemarksTree USING rtree(id, minLon, maxLon, minLat, maxLat)" );
+    if ( treeQuery.lastError().isValid() ) {
+        qDebug() << "No spatial index created:" << treeQuery.lastError();
+    } else {
+        execQuery( "INSERT INTO placemarksTree SELECT id, lon, lon, lat, lat FROM placemarks" );
+    }
 }
 
 void SqlWriter::addOsmRegion( const OsmRegion &region )
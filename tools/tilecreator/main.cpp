@@ -23,8 +23,9 @@ int main(int argc, char *argv[])
             INSTALLMAP: this is the map that you want to install - in the form MAPNAME/MAPNAME.jpg
             DEM: Digital Elevation Model(grayscale) set to "true" for srtm sources set to "false" else
             TARGETDIR: the directory where the output should go to
+            --archive: pack the tiles into a single tile archive file
             */
-        qDebug() << "Syntax: tilecreator PREFIX INSTALLMAP DEM TARGETDIR";
+        qDebug() << "Syntax: tilecreator PREFIX INSTALLMAP DEM TARGETDIR [--archive]";
         return -1;
     } else {
         return app.exec();